@@ -0,0 +1,708 @@
+/*************************************************************************************************/
+/*  Headless benchmarks with reproducible scenes and JSON results                                */
+/*************************************************************************************************/
+
+#include <datoviz/datoviz.h>
+#include <stdlib.h>
+
+#if !OS_WIN32
+#include <sys/resource.h>
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define BENCH_WIDTH       1024
+#define BENCH_HEIGHT      768
+#define BENCH_FRAMES      100
+#define BENCH_WARMUP      5
+#define BENCH_MAX_VISUALS 64
+#define BENCH_LABEL_SIZE  16
+#define BENCH_MB          (1024.0 * 1024.0)
+#define BENCH_SEED        0
+
+
+
+/*************************************************************************************************/
+/*  Typedefs                                                                                     */
+/*************************************************************************************************/
+
+typedef struct BenchScenario BenchScenario;
+typedef struct BenchContext BenchContext;
+typedef struct BenchTimes BenchTimes;
+
+typedef void (*BenchSetup)(BenchContext* bench);
+
+
+
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
+
+// A scenario creates a scene with `count` items, split in `groups` groups when relevant (lines,
+// polygons, panels).
+struct BenchScenario
+{
+    const char* name;
+    BenchSetup setup;
+    uint32_t count;
+    uint32_t groups;
+};
+
+
+
+// CPU time spent in the scene updates and in the data transfers during a frame.
+struct BenchTimes
+{
+    double normalize, bake, transfers;
+};
+
+
+
+struct BenchContext
+{
+    const BenchScenario* scenario;
+
+    DvzApp* app;
+    DvzGpu* gpu;
+    DvzCanvas* canvas;
+    DvzScene* scene;
+
+    uint32_t visual_count;
+    DvzVisual* visuals[BENCH_MAX_VISUALS];
+
+    // Data passed to the visuals, and explicit texture uploads.
+    VkDeviceSize data_size;
+    VkDeviceSize texture_size;
+    double texture_time;
+
+    // Streaming: number of items appended to the first visual at every frame.
+    uint32_t append_count;
+    uint64_t appended;
+};
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+static double _now(DvzClock* clock) { return _clock_get(clock); }
+
+
+
+static void _random_pos(dvec3 pos)
+{
+    pos[0] = .25 * dvz_rand_normal();
+    pos[1] = .25 * dvz_rand_normal();
+    pos[2] = .25 * dvz_rand_normal();
+}
+
+
+
+static int _compare_double(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+
+
+// Write a JSON string, escaping the quotes, the backslashes, and the control characters.
+static void _json_string(FILE* out, const char* str)
+{
+    ASSERT(out != NULL);
+    ASSERT(str != NULL);
+    fputc('"', out);
+    for (const char* c = str; *c != 0; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            fprintf(out, "\\%c", *c);
+        else if ((unsigned char)*c < 0x20)
+            fprintf(out, "\\u%04x", (unsigned char)*c);
+        else
+            fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+
+
+// Percentile of a sorted array, with linear interpolation.
+static double _percentile(const double* sorted, uint32_t count, double q)
+{
+    ASSERT(sorted != NULL);
+    if (count == 0)
+        return 0;
+    double k = q * (count - 1);
+    uint32_t i = (uint32_t)floor(k);
+    uint32_t j = MIN(i + 1, count - 1);
+    return sorted[i] + (k - i) * (sorted[j] - sorted[i]);
+}
+
+
+
+// Peak resident set size of the process, in bytes.
+static uint64_t _peak_rss(void)
+{
+#if !OS_WIN32
+    struct rusage usage = {0};
+    getrusage(RUSAGE_SELF, &usage);
+#if OS_MACOS
+    return (uint64_t)usage.ru_maxrss;
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+
+
+// Device memory allocated for the buffers and images of the GPU context.
+static VkDeviceSize _device_memory(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    DvzContext* ctx = gpu->context;
+    ASSERT(ctx != NULL);
+    VkDeviceSize size = 0;
+
+    DvzContainerIterator iter = dvz_container_iterator(&ctx->buffers);
+    DvzBuffer* buffer = NULL;
+    while (iter.item != NULL)
+    {
+        buffer = (DvzBuffer*)iter.item;
+        if (dvz_obj_is_created(&buffer->obj))
+            size += buffer->allocated_size;
+        dvz_container_iter(&iter);
+    }
+
+    iter = dvz_container_iterator(&ctx->images);
+    DvzImages* images = NULL;
+    VkMemoryRequirements req = {0};
+    while (iter.item != NULL)
+    {
+        images = (DvzImages*)iter.item;
+        if (dvz_obj_is_created(&images->obj))
+        {
+            for (uint32_t i = 0; i < images->count; i++)
+            {
+                vkGetImageMemoryRequirements(gpu->device, images->images[i], &req);
+                size += req.size;
+            }
+        }
+        dvz_container_iter(&iter);
+    }
+
+    return size;
+}
+
+
+
+// Sum of the normalize, bake, and transfers CPU scopes of the last recorded frame.
+static BenchTimes _last_frame_times(DvzProfiler* profiler)
+{
+    ASSERT(profiler != NULL);
+    BenchTimes times = {0};
+    uint32_t n = dvz_profiler_frame_count(profiler);
+    if (n == 0)
+        return times;
+    DvzProfilerFrame* frame = dvz_profiler_frame(profiler, n - 1);
+    DvzProfilerScope* scope = NULL;
+    for (uint32_t i = 0; i < frame->scope_count; i++)
+    {
+        scope = &frame->scopes[i];
+        if (scope->domain != DVZ_PROFILER_DOMAIN_CPU)
+            continue;
+        if (strcmp(scope->name, "normalize") == 0)
+            times.normalize += scope->end - scope->start;
+        else if (strcmp(scope->name, "bake") == 0)
+            times.bake += scope->end - scope->start;
+        else if (strcmp(scope->name, "transfers") == 0)
+            times.transfers += scope->end - scope->start;
+    }
+    return times;
+}
+
+
+
+static void _add_visual(BenchContext* bench, DvzVisual* visual)
+{
+    ASSERT(bench != NULL);
+    ASSERT(visual != NULL);
+    ASSERT(bench->visual_count < BENCH_MAX_VISUALS);
+    bench->visuals[bench->visual_count++] = visual;
+}
+
+
+
+static void _visual_data(
+    BenchContext* bench, DvzVisual* visual, DvzPropType type, uint32_t count,
+    VkDeviceSize item_size, const void* data)
+{
+    dvz_visual_data(visual, type, 0, count, data);
+    bench->data_size += count * item_size;
+}
+
+
+
+/*************************************************************************************************/
+/*  Scenarios                                                                                    */
+/*************************************************************************************************/
+
+static void _random_markers(BenchContext* bench, DvzPanel* panel, uint32_t count)
+{
+    ASSERT(bench != NULL);
+    ASSERT(panel != NULL);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_MARKER, 0);
+    _add_visual(bench, visual);
+    if (count == 0)
+        return;
+
+    dvec3* pos = calloc(count, sizeof(dvec3));
+    cvec4* color = calloc(count, sizeof(cvec4));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        _random_pos(pos[i]);
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, i, 0, count, color[i]);
+    }
+    _visual_data(bench, visual, DVZ_PROP_POS, count, sizeof(dvec3), pos);
+    _visual_data(bench, visual, DVZ_PROP_COLOR, count, sizeof(cvec4), color);
+    float size = 5;
+    dvz_visual_data(visual, DVZ_PROP_MARKER_SIZE, 0, 1, &size);
+    FREE(pos);
+    FREE(color);
+}
+
+
+
+static void _setup_markers(BenchContext* bench)
+{
+    DvzPanel* panel = dvz_scene_panel(bench->scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    _random_markers(bench, panel, bench->scenario->count);
+}
+
+
+
+static void _setup_line_strips(BenchContext* bench)
+{
+    DvzPanel* panel = dvz_scene_panel(bench->scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_LINE_STRIP, 0);
+    _add_visual(bench, visual);
+
+    // Random walks, one per group.
+    uint32_t n_lines = bench->scenario->groups;
+    uint32_t n = bench->scenario->count / n_lines;
+    uint32_t count = n * n_lines;
+    dvec3* pos = calloc(count, sizeof(dvec3));
+    cvec4* color = calloc(count, sizeof(cvec4));
+    uint32_t* length = calloc(n_lines, sizeof(uint32_t));
+    for (uint32_t l = 0; l < n_lines; l++)
+    {
+        length[l] = n;
+        double y = -1 + 2 * (double)l / MAX(1, n_lines - 1);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            pos[l * n + i][0] = -1 + 2 * (double)i / MAX(1, n - 1);
+            pos[l * n + i][1] = (i > 0 ? pos[l * n + i - 1][1] : y) + .01 * dvz_rand_normal();
+            dvz_colormap_scale(DVZ_CMAP_HSV, l, 0, n_lines, color[l * n + i]);
+        }
+    }
+    _visual_data(bench, visual, DVZ_PROP_POS, count, sizeof(dvec3), pos);
+    _visual_data(bench, visual, DVZ_PROP_COLOR, count, sizeof(cvec4), color);
+    _visual_data(bench, visual, DVZ_PROP_LENGTH, n_lines, sizeof(uint32_t), length);
+    FREE(pos);
+    FREE(color);
+    FREE(length);
+}
+
+
+
+static void _setup_polygons(BenchContext* bench)
+{
+    DvzPanel* panel = dvz_scene_panel(bench->scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_POLYGON, 0);
+    _add_visual(bench, visual);
+
+    // Regular polygons on a grid, with `count` vertices in total.
+    uint32_t n_polys = bench->scenario->groups;
+    uint32_t n = bench->scenario->count / n_polys;
+    uint32_t count = n * n_polys;
+    uint32_t side = (uint32_t)ceil(sqrt(n_polys));
+    double r = .8 / side;
+    dvec3* pos = calloc(count, sizeof(dvec3));
+    cvec4* color = calloc(n_polys, sizeof(cvec4));
+    uint32_t* length = calloc(n_polys, sizeof(uint32_t));
+    for (uint32_t p = 0; p < n_polys; p++)
+    {
+        length[p] = n;
+        double x = -1 + 2 * (p % side + .5) / side;
+        double y = -1 + 2 * (p / side + .5) / side;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            pos[p * n + i][0] = x + r * cos(M_2PI * i / n);
+            pos[p * n + i][1] = y + r * sin(M_2PI * i / n);
+        }
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, p, 0, n_polys, color[p]);
+    }
+    _visual_data(bench, visual, DVZ_PROP_POS, count, sizeof(dvec3), pos);
+    _visual_data(bench, visual, DVZ_PROP_LENGTH, n_polys, sizeof(uint32_t), length);
+    _visual_data(bench, visual, DVZ_PROP_COLOR, n_polys, sizeof(cvec4), color);
+    FREE(pos);
+    FREE(color);
+    FREE(length);
+}
+
+
+
+static void _setup_text(BenchContext* bench)
+{
+    DvzPanel* panel = dvz_scene_panel(bench->scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+
+    // The text labels are rendered with the glyph pipeline of the axes visual.
+    DvzVisual* visual =
+        dvz_scene_visual(panel, DVZ_VISUAL_AXES_2D, DVZ_VISUAL_FLAGS_TRANSFORM_NONE);
+    _add_visual(bench, visual);
+
+    DvzFontAtlas* atlas = &bench->gpu->context->font_atlas;
+    ASSERT(strlen(atlas->font_str) > 0);
+    dvz_visual_texture(visual, DVZ_SOURCE_TYPE_FONT_ATLAS, 0, atlas->texture);
+    DvzGraphicsTextParams params = {0};
+    params.grid_size[0] = (int32_t)atlas->rows;
+    params.grid_size[1] = (int32_t)atlas->cols;
+    params.tex_size[0] = (int32_t)atlas->width;
+    params.tex_size[1] = (int32_t)atlas->height;
+    dvz_visual_data_source(visual, DVZ_SOURCE_TYPE_PARAM, 0, 0, 1, 1, &params);
+
+    uint32_t count = bench->scenario->count;
+    double* pos = calloc(count, sizeof(double));
+    char* buffer = calloc(count, BENCH_LABEL_SIZE);
+    char** text = calloc(count, sizeof(char*));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        pos[i] = -1 + 2 * (double)i / MAX(1, count - 1);
+        text[i] = &buffer[i * BENCH_LABEL_SIZE];
+        snprintf(text[i], BENCH_LABEL_SIZE, "label %u", i);
+        bench->data_size += strlen(text[i]);
+    }
+    dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MAJOR, count, pos);
+    dvz_visual_data(visual, DVZ_PROP_TEXT, 0, count, text);
+    bench->data_size += count * sizeof(double);
+    FREE(pos);
+    FREE(buffer);
+    FREE(text);
+}
+
+
+
+static void _setup_image(BenchContext* bench)
+{
+    DvzPanel* panel = dvz_scene_panel(bench->scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_IMAGE, 0);
+    _add_visual(bench, visual);
+
+    // Square RGBA image with `count` pixels per side.
+    uint32_t side = bench->scenario->count;
+    VkDeviceSize size = (VkDeviceSize)side * side * 4;
+    uint8_t* pixels = calloc(size, 1);
+    for (uint32_t i = 0; i < side; i++)
+    {
+        for (uint32_t j = 0; j < side; j++)
+        {
+            pixels[4 * (i * side + j) + 0] = (uint8_t)(j % 256);
+            pixels[4 * (i * side + j) + 1] = (uint8_t)(i % 256);
+            pixels[4 * (i * side + j) + 2] = (uint8_t)(255 * j / side);
+            pixels[4 * (i * side + j) + 3] = 255;
+        }
+    }
+
+    uvec3 shape = {side, side, 1};
+    DvzTexture* texture = dvz_ctx_texture(bench->gpu->context, 2, shape, VK_FORMAT_R8G8B8A8_UNORM);
+    DvzClock clock = {0};
+    _clock_init(&clock);
+    dvz_texture_upload(texture, DVZ_ZERO_OFFSET, shape, size, pixels);
+    bench->texture_time = _now(&clock);
+    bench->texture_size = size;
+    dvz_visual_texture(visual, DVZ_SOURCE_TYPE_IMAGE, 0, texture);
+
+    // Top left, top right, bottom right, bottom left
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, 1, (dvec3[]){{-1, +1, 0}});
+    dvz_visual_data(visual, DVZ_PROP_POS, 1, 1, (dvec3[]){{+1, +1, 0}});
+    dvz_visual_data(visual, DVZ_PROP_POS, 2, 1, (dvec3[]){{+1, -1, 0}});
+    dvz_visual_data(visual, DVZ_PROP_POS, 3, 1, (dvec3[]){{-1, -1, 0}});
+    dvz_visual_data(visual, DVZ_PROP_TEXCOORDS, 0, 1, (vec2[]){{0, 0}});
+    dvz_visual_data(visual, DVZ_PROP_TEXCOORDS, 1, 1, (vec2[]){{1, 0}});
+    dvz_visual_data(visual, DVZ_PROP_TEXCOORDS, 2, 1, (vec2[]){{1, 1}});
+    dvz_visual_data(visual, DVZ_PROP_TEXCOORDS, 3, 1, (vec2[]){{0, 1}});
+    FREE(pixels);
+}
+
+
+
+static void _append_markers(DvzCanvas* canvas, DvzEvent ev)
+{
+    BenchContext* bench = (BenchContext*)ev.user_data;
+    ASSERT(bench != NULL);
+    ASSERT(bench->visual_count > 0);
+    uint32_t count = bench->append_count;
+
+    dvec3* pos = calloc(count, sizeof(dvec3));
+    cvec4* color = calloc(count, sizeof(cvec4));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        _random_pos(pos[i]);
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, i, 0, count, color[i]);
+    }
+    dvz_visual_data_append(bench->visuals[0], DVZ_PROP_POS, 0, count, pos);
+    dvz_visual_data_append(bench->visuals[0], DVZ_PROP_COLOR, 0, count, color);
+    bench->appended += count;
+    FREE(pos);
+    FREE(color);
+}
+
+
+
+static void _setup_append(BenchContext* bench)
+{
+    DvzPanel* panel = dvz_scene_panel(bench->scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    _random_markers(bench, panel, bench->scenario->count);
+    bench->append_count = bench->scenario->groups;
+    dvz_event_callback(
+        bench->canvas, DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _append_markers, bench);
+}
+
+
+
+static void _setup_grid(BenchContext* bench)
+{
+    // groups x groups panels, each with `count` markers.
+    uint32_t n = bench->scenario->groups;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        for (uint32_t j = 0; j < n; j++)
+        {
+            DvzPanel* panel = dvz_scene_panel(bench->scene, i, j, DVZ_CONTROLLER_PANZOOM, 0);
+            _random_markers(bench, panel, bench->scenario->count);
+        }
+    }
+}
+
+
+
+static BenchScenario SCENARIOS[] = {
+    {"markers_10k", _setup_markers, 10000, 1},                //
+    {"markers_100k", _setup_markers, 100000, 1},              //
+    {"markers_1M", _setup_markers, 1000000, 1},               //
+    {"line_strips_100x1k", _setup_line_strips, 100000, 100},  //
+    {"line_strips_1kx1k", _setup_line_strips, 1000000, 1000}, //
+    {"polygons_1k", _setup_polygons, 16000, 1000},            //
+    {"polygons_10k", _setup_polygons, 160000, 10000},         //
+    {"text_1k", _setup_text, 1000, 1},                        //
+    {"text_10k", _setup_text, 10000, 1},                      //
+    {"image_1k", _setup_image, 1024, 1},                      //
+    {"image_4k", _setup_image, 4096, 1},                      //
+    {"append_1k", _setup_append, 10000, 1000},                //
+    {"append_10k", _setup_append, 10000, 10000},              //
+    {"grid_4x4", _setup_grid, 10000, 4},                      //
+    {"grid_8x8", _setup_grid, 10000, 8},                      //
+};
+static uint32_t N_SCENARIOS = sizeof(SCENARIOS) / sizeof(BenchScenario);
+
+
+
+/*************************************************************************************************/
+/*  Benchmark runner                                                                             */
+/*************************************************************************************************/
+
+static void _run(const BenchScenario* scenario, uint32_t n_frames, uint32_t n_warmup, FILE* out)
+{
+    ASSERT(scenario != NULL);
+    ASSERT(out != NULL);
+    log_info("benchmark %s", scenario->name);
+
+    // Reproducible data.
+    srand(BENCH_SEED);
+
+    BenchContext bench = {0};
+    bench.scenario = scenario;
+    bench.app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    bench.gpu = dvz_gpu(bench.app, 0);
+    bench.canvas = dvz_canvas(bench.gpu, BENCH_WIDTH, BENCH_HEIGHT, 0);
+    DvzProfiler* profiler = dvz_canvas_profiler(bench.canvas);
+    bench.scene = dvz_scene(
+        bench.canvas, scenario->setup == _setup_grid ? scenario->groups : 1,
+        scenario->setup == _setup_grid ? scenario->groups : 1);
+
+    DvzClock clock = {0};
+    _clock_init(&clock);
+
+    // Scene creation.
+    double t0 = _now(&clock);
+    scenario->setup(&bench);
+    double setup = _now(&clock) - t0;
+
+    // The first frame normalizes, bakes, and uploads all data.
+    // NOTE: dvz_app_run() waits for the GPU before returning, so that the frame times include
+    // the rendering.
+    t0 = _now(&clock);
+    dvz_app_run(bench.app, 1);
+    double first = _now(&clock) - t0;
+    BenchTimes first_times = _last_frame_times(profiler);
+
+    for (uint32_t i = 0; i < n_warmup; i++)
+        dvz_app_run(bench.app, 1);
+    uint64_t appended = bench.appended;
+
+    // Measured frames.
+    double* frames = calloc(n_frames, sizeof(double));
+    BenchTimes times = {0}, cur = {0};
+    double total = 0;
+    for (uint32_t i = 0; i < n_frames; i++)
+    {
+        t0 = _now(&clock);
+        dvz_app_run(bench.app, 1);
+        frames[i] = _now(&clock) - t0;
+        total += frames[i];
+        cur = _last_frame_times(profiler);
+        times.normalize += cur.normalize;
+        times.bake += cur.bake;
+    }
+    appended = bench.appended - appended;
+    qsort(frames, n_frames, sizeof(double), _compare_double);
+
+    // The initial upload throughput, from the transfers processed during the first frame.
+    double upload_size = (bench.data_size + bench.texture_size) / BENCH_MB;
+    double upload_time = first_times.transfers + bench.texture_time;
+
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"name\": ");
+    _json_string(out, scenario->name);
+    fprintf(out, ",\n");
+    fprintf(out, "      \"count\": %u,\n", scenario->count);
+    fprintf(out, "      \"groups\": %u,\n", scenario->groups);
+    fprintf(out, "      \"setup_ms\": %.3f,\n", 1000 * setup);
+    fprintf(out, "      \"first_frame_ms\": %.3f,\n", 1000 * first);
+    fprintf(
+        out,
+        "      \"frame_ms\": {\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+        "\"max\": %.3f},\n",
+        n_frames > 0 ? 1000 * total / n_frames : 0, 1000 * _percentile(frames, n_frames, .5),
+        1000 * _percentile(frames, n_frames, .9), 1000 * _percentile(frames, n_frames, .99),
+        n_frames > 0 ? 1000 * frames[n_frames - 1] : 0);
+    fprintf(out, "      \"fps\": %.3f,\n", total > 0 ? n_frames / total : 0);
+    fprintf(
+        out,
+        "      \"first_normalize_ms\": %.3f,\n      \"first_bake_ms\": %.3f,\n"
+        "      \"first_transfers_ms\": %.3f,\n",
+        1000 * first_times.normalize, 1000 * first_times.bake, 1000 * first_times.transfers);
+    fprintf(
+        out, "      \"normalize_ms\": %.3f,\n      \"bake_ms\": %.3f,\n",
+        n_frames > 0 ? 1000 * times.normalize / n_frames : 0,
+        n_frames > 0 ? 1000 * times.bake / n_frames : 0);
+    fprintf(out, "      \"upload_mb\": %.3f,\n", upload_size);
+    fprintf(
+        out, "      \"upload_mbps\": %.3f,\n", upload_time > 0 ? upload_size / upload_time : 0);
+    fprintf(out, "      \"append_items_per_s\": %.3f,\n", total > 0 ? appended / total : 0);
+    fprintf(out, "      \"peak_rss_mb\": %.3f,\n", _peak_rss() / BENCH_MB);
+    fprintf(out, "      \"device_mb\": %.3f\n", _device_memory(bench.gpu) / BENCH_MB);
+    fprintf(out, "    }");
+
+    FREE(frames);
+    dvz_scene_destroy(bench.scene);
+    dvz_app_destroy(bench.app);
+}
+
+
+
+/*************************************************************************************************/
+/*  Main function                                                                                */
+/*************************************************************************************************/
+
+static void _usage(void)
+{
+    printf("usage: datoviz_bench [--frames N] [--warmup N] [--output FILE] [--list] [FILTER]\n");
+}
+
+
+
+int main(int argc, char** argv)
+{
+    log_set_level_env();
+
+    uint32_t n_frames = BENCH_FRAMES;
+    uint32_t n_warmup = BENCH_WARMUP;
+    const char* output = NULL;
+    const char* filter = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            n_frames = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            n_warmup = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if (strcmp(argv[i], "--list") == 0)
+        {
+            for (uint32_t k = 0; k < N_SCENARIOS; k++)
+                printf("%s\n", SCENARIOS[k].name);
+            return 0;
+        }
+        else if (argv[i][0] == '-')
+        {
+            _usage();
+            return 1;
+        }
+        else
+            filter = argv[i];
+    }
+
+    FILE* out = stdout;
+    if (output != NULL)
+    {
+        out = fopen(output, "w");
+        if (out == NULL)
+        {
+            log_error("unable to open %s for writing", output);
+            return 1;
+        }
+    }
+
+    // Device information, to compare results obtained on the same machine only.
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    fprintf(out, "{\n");
+    fprintf(out, "  \"gpu\": ");
+    _json_string(out, gpu->name);
+    fprintf(out, ",\n");
+    fprintf(out, "  \"width\": %d,\n  \"height\": %d,\n", BENCH_WIDTH, BENCH_HEIGHT);
+    fprintf(out, "  \"frames\": %u,\n  \"warmup\": %u,\n", n_frames, n_warmup);
+    fprintf(out, "  \"seed\": %d,\n", BENCH_SEED);
+    fprintf(out, "  \"scenarios\": [\n");
+    dvz_app_destroy(app);
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < N_SCENARIOS; i++)
+    {
+        if (filter != NULL && strstr(SCENARIOS[i].name, filter) == NULL)
+            continue;
+        if (count > 0)
+            fprintf(out, ",\n");
+        _run(&SCENARIOS[i], n_frames, n_warmup, out);
+        fflush(out);
+        count++;
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout)
+        fclose(out);
+    if (count == 0)
+    {
+        log_error("no benchmark matching %s", filter);
+        return 1;
+    }
+    return 0;
+}
@@ -227,8 +227,11 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_VISUAL_AXES_2D = 28
         DVZ_VISUAL_AXES_3D = 29
         DVZ_VISUAL_COLORMAP = 30
-        DVZ_VISUAL_COUNT = 31
-        DVZ_VISUAL_CUSTOM = 32
+        DVZ_VISUAL_MARKER_CMAP = 31
+        DVZ_VISUAL_MESH_INSTANCED = 32
+        DVZ_VISUAL_DENSITY = 33
+        DVZ_VISUAL_COUNT = 34
+        DVZ_VISUAL_CUSTOM = 35
 
     ctypedef enum DvzAxisLevel:
         DVZ_AXES_LEVEL_MINOR = 0
@@ -248,6 +251,11 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_CANVAS_FLAGS_NONE = 0x0000
         DVZ_CANVAS_FLAGS_IMGUI = 0x0001
         DVZ_CANVAS_FLAGS_FPS = 0x0003
+        DVZ_CANVAS_FLAGS_PICK = 0x0010
+        DVZ_CANVAS_FLAGS_ON_DEMAND = 0x0020
+        DVZ_CANVAS_FLAGS_MSAA_2 = 0x0100
+        DVZ_CANVAS_FLAGS_MSAA_4 = 0x0200
+        DVZ_CANVAS_FLAGS_MSAA_8 = 0x0300
         DVZ_CANVAS_FLAGS_DPI_SCALE_050 = 0x1000
         DVZ_CANVAS_FLAGS_DPI_SCALE_100 = 0x2000
         DVZ_CANVAS_FLAGS_DPI_SCALE_150 = 0x3000
@@ -328,11 +336,18 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_EVENT_PRE_SEND = 20
         DVZ_EVENT_POST_SEND = 21
         DVZ_EVENT_DESTROY = 22
+        DVZ_EVENT_PICK = 23
+        DVZ_EVENT_COUNT = 24
 
     ctypedef enum DvzEventMode:
         DVZ_EVENT_MODE_SYNC = 0
         DVZ_EVENT_MODE_ASYNC = 1
 
+    ctypedef enum DvzEventPriority:
+        DVZ_EVENT_PRIORITY_LOW = 0
+        DVZ_EVENT_PRIORITY_NORMAL = 1
+        DVZ_EVENT_PRIORITY_HIGH = 2
+
     ctypedef enum DvzKeyModifiers:
         DVZ_KEY_MODIFIER_NONE = 0x00000000
         DVZ_KEY_MODIFIER_SHIFT = 0x00000001
@@ -748,6 +763,10 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_VISUAL_FLAGS_TRANSFORM_AUTO = 0x0000
         DVZ_VISUAL_FLAGS_TRANSFORM_NONE = 0x0010
         DVZ_VISUAL_FLAGS_TRANSFORM_BOX_INIT = 0x0020
+        DVZ_VISUAL_FLAGS_LOD = 0x0040
+        DVZ_VISUAL_FLAGS_CULLING = 0x0080
+        DVZ_VISUAL_FLAGS_TILED = 0x0200
+        DVZ_VISUAL_FLAGS_BRICKED = 0x2000
 
     ctypedef enum DvzSceneUpdateType:
         DVZ_SCENE_UPDATE_NONE = 0
@@ -842,6 +861,10 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_PROP_INDEX = 30
         DVZ_PROP_SCALE = 31
         DVZ_PROP_TRANSFORM = 32
+        DVZ_PROP_VALUE = 33
+        DVZ_PROP_ROTATION = 34
+        DVZ_PROP_BIN_COUNT = 35
+        DVZ_PROP_NORMALIZATION = 36
 
     ctypedef enum DvzSourceKind:
         DVZ_SOURCE_KIND_NONE = 0
@@ -866,7 +889,10 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_SOURCE_TYPE_COLOR_TEXTURE = 9
         DVZ_SOURCE_TYPE_FONT_ATLAS = 10
         DVZ_SOURCE_TYPE_OTHER = 11
-        DVZ_SOURCE_TYPE_COUNT = 12
+        DVZ_SOURCE_TYPE_INSTANCE = 12
+        DVZ_SOURCE_TYPE_SAMPLES = 13
+        DVZ_SOURCE_TYPE_COUNTS = 14
+        DVZ_SOURCE_TYPE_COUNT = 15
 
     ctypedef enum DvzSourceOrigin:
         DVZ_SOURCE_ORIGIN_NONE = 0
@@ -882,6 +908,11 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_VISUAL_REQUEST_SET = 0x0001
         DVZ_VISUAL_REQUEST_UPLOAD = 0x0002
 
+    ctypedef enum DvzDensityNorm:
+        DVZ_DENSITY_NORM_LINEAR = 0
+        DVZ_DENSITY_NORM_LOG = 1
+        DVZ_DENSITY_NORM_EQ_HIST = 2
+
     # from file: vklite.h
 
     ctypedef enum DvzQueueType:
@@ -927,8 +958,12 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_GRAPHICS_MESH = 15
         DVZ_GRAPHICS_FAKE_SPHERE = 16
         DVZ_GRAPHICS_VOLUME = 17
-        DVZ_GRAPHICS_COUNT = 18
-        DVZ_GRAPHICS_CUSTOM = 19
+        DVZ_GRAPHICS_MARKER_CMAP = 18
+        DVZ_GRAPHICS_MESH_INSTANCED = 19
+        DVZ_GRAPHICS_HISTOGRAM = 20
+        DVZ_GRAPHICS_DENSITY = 21
+        DVZ_GRAPHICS_COUNT = 22
+        DVZ_GRAPHICS_CUSTOM = 23
 
     ctypedef enum DvzTextureAxis:
         DVZ_TEXTURE_AXIS_U = 0
@@ -963,6 +998,7 @@ cdef extern from "<datoviz/datoviz.h>":
         uvec2 size_framebuffer
         DvzViewportClip clip
         int32_t interact_axis
+        uint32_t pick_id
 
     ctypedef struct DvzMouseButtonEvent:
         DvzMouseButton button
@@ -1095,6 +1131,8 @@ cdef extern from "<datoviz/datoviz.h>":
 
     ctypedef void (*DvzEventCallback)(DvzCanvas*, DvzEvent)
     void dvz_colormap_array(DvzColormap cmap, uint32_t count, double* values, double vmin, double vmax, cvec4* out);
+    void dvz_colormap_array_float(DvzColormap cmap, uint32_t count, const float* values, double vmin, double vmax, uint32_t stride, void* out)
+    void dvz_colormap_array_double(DvzColormap cmap, uint32_t count, const double* values, double vmin, double vmax, uint32_t stride, void* out)
     void dvz_colormap_packuv(cvec3 color, vec2 uv)
     void dvz_colormap_custom(uint8_t cmap, uint32_t color_count, cvec4* colors)
     void dvz_context_colormap(DvzContext* context)
@@ -1109,6 +1147,7 @@ cdef extern from "<datoviz/datoviz.h>":
     void dvz_canvas_clear_color(DvzCanvas* canvas, float red, float green, float blue)
     void dvz_event_callback(DvzCanvas* canvas, DvzEventType type, double param, DvzEventMode mode, DvzEventCallback callback, void* user_data)
     void dvz_canvas_to_close(DvzCanvas* canvas)
+    void dvz_canvas_redraw(DvzCanvas* canvas)
     void dvz_screenshot_file(DvzCanvas* canvas, const char* png_path)
     void dvz_canvas_video(DvzCanvas* canvas, int framerate, int bitrate, const char* path, bint record)
     void dvz_canvas_pause(DvzCanvas* canvas, bint record)
@@ -1134,6 +1173,9 @@ cdef extern from "<datoviz/datoviz.h>":
     void dvz_mesh_normals(DvzMesh* mesh)
     DvzMesh dvz_mesh_grid(uint32_t row_count, uint32_t col_count, const vec3* positions, const vec2* texcoords)
     DvzMesh dvz_mesh_obj(const char* file_path)
+    int dvz_mesh_save(DvzMesh* mesh, const char* path)
+    DvzMesh dvz_mesh_load(const char* path)
+    DvzMesh dvz_mesh_obj_cached(const char* file_path)
 
     # from file: panel.h
     void dvz_panel_transpose(DvzPanel* panel, DvzCDSTranspose transpose)
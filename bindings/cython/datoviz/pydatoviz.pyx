@@ -93,11 +93,15 @@ _EVENTS ={
 _VISUALS = {
     'point': cv.DVZ_VISUAL_POINT,
     'marker': cv.DVZ_VISUAL_MARKER,
+    'marker_cmap': cv.DVZ_VISUAL_MARKER_CMAP,
     'mesh': cv.DVZ_VISUAL_MESH,
+    'mesh_instanced': cv.DVZ_VISUAL_MESH_INSTANCED,
     'path': cv.DVZ_VISUAL_PATH,
     'polygon': cv.DVZ_VISUAL_POLYGON,
     'image': cv.DVZ_VISUAL_IMAGE,
     'image_cmap': cv.DVZ_VISUAL_IMAGE_CMAP,
+    'histogram': cv.DVZ_VISUAL_HISTOGRAM,
+    'density': cv.DVZ_VISUAL_DENSITY,
     'volume': cv.DVZ_VISUAL_VOLUME,
     'volume_slice': cv.DVZ_VISUAL_VOLUME_SLICE,
     'line_strip': cv.DVZ_VISUAL_LINE_STRIP,
@@ -137,12 +141,16 @@ _PROPS = {
     'range': cv.DVZ_PROP_RANGE,
     'length': cv.DVZ_PROP_LENGTH,
     'scale': cv.DVZ_PROP_SCALE,
+    'rotation': cv.DVZ_PROP_ROTATION,
     'cap_type': cv.DVZ_PROP_CAP_TYPE,
     'light_params': cv.DVZ_PROP_LIGHT_PARAMS,
     'light_pos': cv.DVZ_PROP_LIGHT_POS,
     'texcoefs': cv.DVZ_PROP_TEXCOEFS,
     'linewidth': cv.DVZ_PROP_LINE_WIDTH,
     'colormap': cv.DVZ_PROP_COLORMAP,
+    'value': cv.DVZ_PROP_VALUE,
+    'bin_count': cv.DVZ_PROP_BIN_COUNT,
+    'normalization': cv.DVZ_PROP_NORMALIZATION,
     'transferx': cv.DVZ_PROP_TRANSFER_X,
     'transfery': cv.DVZ_PROP_TRANSFER_Y,
     'clip': cv.DVZ_PROP_CLIP,
@@ -547,7 +555,11 @@ cdef _add_event_callback(
 # Public functions
 # -------------------------------------------------------------------------------------------------
 
-def colormap(np.ndarray[DOUBLE, ndim=1] values, vmin=None, vmax=None, cmap=None, alpha=None):
+def colormap(np.ndarray values, vmin=None, vmax=None, cmap=None, alpha=None):
+    # NOTE: float32 values are mapped without conversion, other dtypes are converted to float64.
+    if values.dtype != np.float32:
+        values = values.astype(np.float64)
+    values = np.ascontiguousarray(values.ravel())
     N = values.size
     if cmap in _COLORMAPS:
         cmap_ = _COLORMAPS[cmap]
@@ -561,7 +573,12 @@ def colormap(np.ndarray[DOUBLE, ndim=1] values, vmin=None, vmax=None, cmap=None,
         vmin = values.min()
     if vmax is None:
         vmax = values.max()
-    cv.dvz_colormap_array(cmap_, N, <double*>&values.data[0], vmin, vmax, <cv.cvec4*>&out.data[0])
+    if values.dtype == np.float32:
+        cv.dvz_colormap_array_float(
+            cmap_, N, <float*>&values.data[0], vmin, vmax, 0, &out.data[0])
+    else:
+        cv.dvz_colormap_array_double(
+            cmap_, N, <double*>&values.data[0], vmin, vmax, 0, &out.data[0])
     if alpha is not None:
         if not isinstance(alpha, np.ndarray):
             alpha = np.array(alpha)
@@ -602,11 +619,17 @@ cdef class App:
 
     def canvas(
             self, int width=DEFAULT_WIDTH, int height=DEFAULT_HEIGHT, int rows=1, int cols=1,
-            bint show_fps=False, clear_color=None):
+            bint show_fps=False, clear_color=None, int msaa=1):
         cdef int fps = 0
         if show_fps:
             fps = cv.DVZ_CANVAS_FLAGS_FPS
         fps |= cv.DVZ_CANVAS_FLAGS_IMGUI
+        if msaa >= 8:
+            fps |= cv.DVZ_CANVAS_FLAGS_MSAA_8
+        elif msaa >= 4:
+            fps |= cv.DVZ_CANVAS_FLAGS_MSAA_4
+        elif msaa >= 2:
+            fps |= cv.DVZ_CANVAS_FLAGS_MSAA_2
         c_canvas = cv.dvz_canvas(self._c_gpu, width, height, fps)
 
         # Canvas clear color.
@@ -813,7 +836,7 @@ cdef class Panel:
     def col(self):
         return self._c_panel.col
 
-    def visual(self, vtype, depth_test=None, transform='auto'):
+    def visual(self, vtype, depth_test=None, transform='auto', lod=False, culling=False):
         visual_type = _VISUALS.get(vtype, 0)
         if not visual_type:
             raise ValueError("unknown visual type")
@@ -826,6 +849,12 @@ cdef class Panel:
         # changes
         elif transform == 'init':
             flags |= cv.DVZ_VISUAL_FLAGS_TRANSFORM_BOX_INIT
+        # Min/max decimation of line strips and paths with many more points than pixels
+        if lod:
+            flags |= cv.DVZ_VISUAL_FLAGS_LOD
+        # GPU culling of the markers and points outside of the viewport
+        if culling:
+            flags |= cv.DVZ_VISUAL_FLAGS_CULLING
         c_visual = cv.dvz_scene_visual(self._c_panel, visual_type, flags)
         if c_visual is NULL:
             raise MemoryError()
@@ -23,7 +23,9 @@
 static TestCase TEST_CASES[] = {
 
     // common tests
-    CASE_FIXTURE_NONE(test_container),
+    CASE_FIXTURE_NONE(test_container),  //
+    CASE_FIXTURE_NONE(test_parallel),   //
+    CASE_FIXTURE_NONE(test_cache_path), //
 
     // vklite2
     CASE_FIXTURE_NONE(test_vklite_app),            //
@@ -50,27 +52,57 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_fifo_2), //
     CASE_FIXTURE_NONE(test_fifo_3), //
 
+    // decimation pyramid
+    CASE_FIXTURE_NONE(test_lod_1), //
+
+    // tiled images
+    CASE_FIXTURE_NONE(test_tiles_1),   //
+    CASE_FIXTURE_NONE(test_tiles_npy), //
+
+    // bricked volumes
+    CASE_FIXTURE_NONE(test_bricks_1), //
+
+    // profiler
+    CASE_FIXTURE_NONE(test_profiler_1), //
+
+    // NPY files
+    CASE_FIXTURE_NONE(test_npy_1), //
+
+    // Colormaps
+    CASE_FIXTURE_NONE(test_colormap_batch), //
+
+    // Meshes
+    CASE_FIXTURE_NONE(test_mesh_parallel), //
+    CASE_FIXTURE_NONE(test_mesh_cache),    //
+    CASE_FIXTURE_NONE(test_mesh_obj),      //
+
     // context
     CASE_FIXTURE_NONE(test_default_app),      //
     CASE_FIXTURE_NONE(test_context_colormap), //
 
     // canvas
-    CASE_FIXTURE_NONE(test_canvas_transfer_buffer),  //
-    CASE_FIXTURE_NONE(test_canvas_transfer_texture), //
-    CASE_FIXTURE_NONE(test_canvas_1),                //
-    CASE_FIXTURE_NONE(test_canvas_2),                //
-    CASE_FIXTURE_NONE(test_canvas_3),                //
-    CASE_FIXTURE_NONE(test_canvas_4),                //
-    CASE_FIXTURE_NONE(test_canvas_5),                //
-    CASE_FIXTURE_NONE(test_canvas_6),                //
-    CASE_FIXTURE_NONE(test_canvas_7),                //
-    CASE_FIXTURE_NONE(test_canvas_8),                //
-    CASE_FIXTURE_NONE(test_canvas_depth),            //
-    CASE_FIXTURE_NONE(test_canvas_append),           //
-    CASE_FIXTURE_NONE(test_canvas_particles),        //
-    CASE_FIXTURE_NONE(test_canvas_offscreen),        //
-    CASE_FIXTURE_NONE(test_canvas_gui_1),            //
-    CASE_FIXTURE_NONE(test_canvas_screencast),       //
+    CASE_FIXTURE_NONE(test_canvas_transfer_buffer),   //
+    CASE_FIXTURE_NONE(test_canvas_transfer_texture),  //
+    CASE_FIXTURE_NONE(test_canvas_transfer_uniforms), //
+    CASE_FIXTURE_NONE(test_canvas_1),                 //
+    CASE_FIXTURE_NONE(test_canvas_2),                 //
+    CASE_FIXTURE_NONE(test_canvas_3),                 //
+    CASE_FIXTURE_NONE(test_canvas_4),                 //
+    CASE_FIXTURE_NONE(test_canvas_5),                 //
+    CASE_FIXTURE_NONE(test_canvas_6),                 //
+    CASE_FIXTURE_NONE(test_canvas_7),                 //
+    CASE_FIXTURE_NONE(test_canvas_8),                 //
+    CASE_FIXTURE_NONE(test_canvas_depth),             //
+    CASE_FIXTURE_NONE(test_canvas_append),            //
+    CASE_FIXTURE_NONE(test_canvas_particles),         //
+    CASE_FIXTURE_NONE(test_canvas_offscreen),         //
+    CASE_FIXTURE_NONE(test_canvas_msaa),              //
+    CASE_FIXTURE_NONE(test_canvas_on_demand),         //
+    CASE_FIXTURE_NONE(test_canvas_parallel),          //
+    CASE_FIXTURE_NONE(test_canvas_events),            //
+    CASE_FIXTURE_NONE(test_canvas_gui_1),             //
+    CASE_FIXTURE_NONE(test_canvas_screencast),        //
+    CASE_FIXTURE_NONE(test_canvas_batch),             //
 
     // graphics
     CASE_FIXTURE_NONE(test_graphics_dynamic), //
@@ -127,6 +159,7 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_visuals_3), //
     CASE_FIXTURE_NONE(test_visuals_4), //
     CASE_FIXTURE_NONE(test_visuals_5), //
+    CASE_FIXTURE_NONE(test_visuals_6), //
 
     // interact
     CASE_FIXTURE_NONE(test_interact_1),       //
@@ -148,6 +181,7 @@ static TestCase TEST_CASES[] = {
 #endif
 
     CASE_FIXTURE_NONE(test_visuals_marker),         //
+    CASE_FIXTURE_NONE(test_visuals_marker_cmap),    //
     CASE_FIXTURE_NONE(test_visuals_polygon),        //
     CASE_FIXTURE_NONE(test_visuals_path),           //
     CASE_FIXTURE_NONE(test_visuals_image_1),        //
@@ -155,21 +189,32 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_visuals_axes_2D_1),      //
     CASE_FIXTURE_NONE(test_visuals_axes_2D_update), //
 
-    CASE_FIXTURE_NONE(test_visuals_mesh),         //
-    CASE_FIXTURE_NONE(test_visuals_volume_1),     //
-    CASE_FIXTURE_NONE(test_visuals_volume_slice), //
+    CASE_FIXTURE_NONE(test_visuals_mesh),           //
+    CASE_FIXTURE_NONE(test_visuals_mesh_instanced), //
+    CASE_FIXTURE_NONE(test_visuals_histogram),      //
+    CASE_FIXTURE_NONE(test_visuals_volume_1),       //
+    CASE_FIXTURE_NONE(test_visuals_volume_slice),   //
 
     // axes
     CASE_FIXTURE_NONE(test_axes_1), //
     CASE_FIXTURE_NONE(test_axes_2), //
     CASE_FIXTURE_NONE(test_axes_3), //
+    CASE_FIXTURE_NONE(test_axes_4), //
 
     // scene
-    CASE_FIXTURE_NONE(test_scene_0),        //
-    CASE_FIXTURE_NONE(test_scene_1),        //
-    CASE_FIXTURE_NONE(test_scene_mesh),     //
-    CASE_FIXTURE_NONE(test_scene_axes),     //
-    CASE_FIXTURE_NONE(test_scene_logistic), //
+    CASE_FIXTURE_NONE(test_scene_0),          //
+    CASE_FIXTURE_NONE(test_scene_1),          //
+    CASE_FIXTURE_NONE(test_scene_mesh),       //
+    CASE_FIXTURE_NONE(test_scene_axes),       //
+    CASE_FIXTURE_NONE(test_scene_logistic),   //
+    CASE_FIXTURE_NONE(test_scene_lod),        //
+    CASE_FIXTURE_NONE(test_scene_culling),    //
+    CASE_FIXTURE_NONE(test_scene_density),    //
+    CASE_FIXTURE_NONE(test_scene_tiles),      //
+    CASE_FIXTURE_NONE(test_scene_bricks),     //
+    CASE_FIXTURE_NONE(test_scene_profiler),   //
+    CASE_FIXTURE_NONE(test_scene_bake_async), //
+    CASE_FIXTURE_NONE(test_scene_pick),       //
 
 };
 static uint32_t N_TESTS = sizeof(TEST_CASES) / sizeof(TestCase);
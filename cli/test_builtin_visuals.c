@@ -175,6 +175,51 @@ int test_visuals_marker(TestContext* context)
 
 
 
+int test_visuals_marker_cmap(TestContext* context)
+{
+    INIT;
+
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_MARKER_CMAP, 0);
+
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    float* value = calloc(N, sizeof(float));
+    float t = 0;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        t = -1 + 2 * i / (float)(N - 1);
+        pos[i][0] = t;
+        pos[i][1] = .25 * sin(M_2PI * t);
+        pos[i][1] += .25 * dvz_rand_normal();
+        value[i] = 100 * t;
+    }
+
+    // Set visual data, the colors are computed on the GPU.
+    dvz_visual_data(&visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(&visual, DVZ_PROP_VALUE, 0, N, value);
+    dvz_visual_data(&visual, DVZ_PROP_MARKER_SIZE, 0, 1, (float[]){20});
+    dvz_visual_data(&visual, DVZ_PROP_COLORMAP, 0, 1, (int[]){DVZ_CMAP_HSV});
+    dvz_visual_data(&visual, DVZ_PROP_RANGE, 0, 1, (vec2){-100, 100});
+
+    RUN;
+
+    // Changing the color limits only updates the params uniform, not the vertex buffer.
+    dvz_visual_data(&visual, DVZ_PROP_RANGE, 0, 1, (vec2){-50, 50});
+    AT(dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0)->obj.request !=
+       DVZ_VISUAL_REQUEST_UPLOAD);
+    AT(dvz_source_get(&visual, DVZ_SOURCE_TYPE_PARAM, 0)->obj.request ==
+       DVZ_VISUAL_REQUEST_UPLOAD);
+    dvz_app_run(app, N_FRAMES);
+
+    SCREENSHOT("marker_cmap")
+    FREE(pos);
+    FREE(value);
+    END;
+}
+
+
+
 int test_visuals_line(TestContext* context)
 {
     INIT;
@@ -794,6 +839,168 @@ int test_visuals_mesh(TestContext* context)
     END;
 }
 
+int test_visuals_mesh_instanced(TestContext* context)
+{
+    INIT;
+
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_MESH_INSTANCED, 0);
+
+    // Base mesh, shared by all instances.
+    DvzMesh mesh = dvz_mesh_cube();
+    uint32_t nv = mesh.vertices.item_count;
+    uint32_t ni = mesh.indices.item_count;
+    dvz_visual_data_source(&visual, DVZ_SOURCE_TYPE_VERTEX, 0, 0, nv, nv, mesh.vertices.data);
+    dvz_visual_data_source(&visual, DVZ_SOURCE_TYPE_INDEX, 0, 0, ni, ni, mesh.indices.data);
+
+    // One instance per point of a 3D grid.
+    const uint32_t n = 10;
+    const uint32_t N = n * n * n;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    vec4* rotation = calloc(N, sizeof(vec4));
+    vec3* scale = calloc(N, sizeof(vec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        for (uint32_t j = 0; j < n; j++)
+        {
+            for (uint32_t l = 0; l < n; l++)
+            {
+                k = n * n * i + n * j + l;
+                pos[k][0] = -.9 + 1.8 * i / (double)(n - 1);
+                pos[k][1] = -.9 + 1.8 * j / (double)(n - 1);
+                pos[k][2] = -.9 + 1.8 * l / (double)(n - 1);
+                glm_quatv(rotation[k], M_2PI * k / (double)N, (vec3){1, 1, 0});
+                glm_vec3_fill(scale[k], .05 + .05 * l / (double)n);
+                dvz_colormap_scale(DVZ_CMAP_RAINBOW, k, 0, N, color[k]);
+            }
+        }
+    }
+    dvz_visual_data(&visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(&visual, DVZ_PROP_ROTATION, 0, N, rotation);
+    dvz_visual_data(&visual, DVZ_PROP_SCALE, 0, N, scale);
+    dvz_visual_data(&visual, DVZ_PROP_COLOR, 0, N, color);
+
+    DvzGraphicsMeshParams params = default_graphics_mesh_params(DVZ_CAMERA_EYE);
+    dvz_visual_data(&visual, DVZ_PROP_LIGHT_PARAMS, 0, 1, &params.lights_params_0);
+    dvz_visual_data(&visual, DVZ_PROP_LIGHT_POS, 0, 1, &params.lights_pos_0);
+    dvz_visual_data(&visual, DVZ_PROP_TEXCOEFS, 0, 1, &params.tex_coefs);
+
+    DvzInteract interact = dvz_interact_builtin(canvas, DVZ_INTERACT_ARCBALL);
+    visual.user_data = &interact;
+    dvz_event_callback(canvas, DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _update_interact, &visual);
+
+    DvzArcball* arcball = &interact.u.a;
+    versor q;
+    glm_quatv(q, +M_PI / 6, (vec3){1, 0, 0});
+    glm_quat_mul(arcball->rotation, q, arcball->rotation);
+    glm_quatv(q, +M_PI / 6, (vec3){0, 1, 0});
+    glm_quat_mul(arcball->rotation, q, arcball->rotation);
+    arcball->camera.eye[2] = 4;
+    _arcball_update_mvp(canvas->viewport, arcball, &interact.mvp);
+
+    RUN;
+    FREE(pos);
+    FREE(rotation);
+    FREE(scale);
+    FREE(color);
+    dvz_mesh_destroy(&mesh);
+    SCREENSHOT("mesh_instanced")
+    END;
+}
+
+
+
+/*************************************************************************************************/
+/* Histogram visual tests                                                                        */
+/*************************************************************************************************/
+
+static void _bin_histogram(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    DvzVisual* visual = (DvzVisual*)ev.user_data;
+    ASSERT(visual != NULL);
+    dvz_visual_bin(visual);
+}
+
+int test_visuals_histogram(TestContext* context)
+{
+    INIT;
+
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_HISTOGRAM, 0);
+
+    // Normally distributed samples, binned on the GPU. The samples are at the center of the bins,
+    // so that the expected counts do not depend on the rounding of the GPU.
+    const uint32_t N = 1000000;
+    const uint32_t n = 100;
+    float* samples = calloc(N, sizeof(float));
+    uint32_t* expected = calloc(1 + n, sizeof(uint32_t));
+    int64_t b = 0;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        b = (int64_t)floor((dvz_rand_normal() + 4) / 8 * n);
+        b = CLIP(b, 0, (int64_t)n - 1);
+        samples[i] = -4 + 8 * (b + .5f) / n;
+        expected[1 + b]++;
+    }
+    for (uint32_t i = 0; i < n; i++)
+        expected[0] = MAX(expected[0], expected[1 + i]);
+    dvz_visual_data(&visual, DVZ_PROP_VALUE, 0, N, samples);
+
+    dvz_visual_data(&visual, DVZ_PROP_BIN_COUNT, 0, 1, &n);
+    dvz_visual_data(&visual, DVZ_PROP_RANGE, 0, 1, (vec2){-4, 4});
+
+    cvec4* color = calloc(n, sizeof(cvec4));
+    for (uint32_t i = 0; i < n; i++)
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, i, 0, n, color[i]);
+    dvz_visual_data(&visual, DVZ_PROP_COLOR, 0, n, color);
+
+    dvz_event_callback(
+        canvas, DVZ_EVENT_PRE_SEND, 0, DVZ_EVENT_MODE_SYNC, _bin_histogram, &visual);
+
+    RUN;
+    SCREENSHOT("histogram")
+
+    // NOTE: the canvas is destroyed at the end of the interactive mode.
+    if (N_FRAMES != 0)
+    {
+        // The maximum count and the bin counts match the CPU histogram.
+        uint32_t* counts = calloc(1 + n, sizeof(uint32_t));
+        dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_RENDER);
+        download_region(
+            canvas, visual.binning->br_counts, 0, 0, (1 + n) * sizeof(uint32_t), counts);
+        AT(memcmp(counts, expected, (1 + n) * sizeof(uint32_t)) == 0);
+
+        // Overwrite the samples on the GPU, behind the back of the visual, with samples uniformly
+        // distributed in [0, 8]. If changing the range uploaded the samples again, the counts
+        // would be those of the normal samples.
+        for (uint32_t i = 0; i < N; i++)
+            samples[i] = 8 * ((i % n) + .5f) / n;
+        DvzSource* source = dvz_source_get(&visual, DVZ_SOURCE_TYPE_SAMPLES, 0);
+        dvz_upload_buffers(canvas, source->u.br, 0, N * sizeof(float), samples);
+
+        dvz_visual_data(&visual, DVZ_PROP_RANGE, 0, 1, (vec2){0, 8});
+        dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+        dvz_canvas_to_refill(canvas);
+        dvz_app_run(app, 5);
+
+        dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_RENDER);
+        download_region(
+            canvas, visual.binning->br_counts, 0, 0, (1 + n) * sizeof(uint32_t), counts);
+        AT(counts[0] == N / n);
+        for (uint32_t i = 0; i < n; i++)
+            AT(counts[1 + i] == N / n);
+        FREE(counts);
+    }
+
+    FREE(samples);
+    FREE(expected);
+    FREE(color);
+    END;
+}
+
 
 
 /*************************************************************************************************/
@@ -26,6 +26,7 @@ int test_visuals_triangle_fan(TestContext* context);
 
 // 2D visuals.
 int test_visuals_marker(TestContext* context);
+int test_visuals_marker_cmap(TestContext* context);
 int test_visuals_axes_2D_1(TestContext* context);
 int test_visuals_axes_2D_update(TestContext* context);
 int test_visuals_path(TestContext* context);
@@ -35,6 +36,8 @@ int test_visuals_image_cmap(TestContext* context);
 
 // 3D visuals.
 int test_visuals_mesh(TestContext* context);
+int test_visuals_mesh_instanced(TestContext* context);
+int test_visuals_histogram(TestContext* context);
 int test_visuals_volume_1(TestContext* context);
 int test_visuals_volume_slice(TestContext* context);
 
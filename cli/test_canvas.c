@@ -61,6 +61,62 @@ int test_canvas_transfer_buffer(TestContext* context)
 
 
 
+static void _uniforms_frame(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    DvzBufferRegions* br = (DvzBufferRegions*)ev.user_data;
+    ASSERT(br != NULL);
+    float value = (float)ev.u.f.idx;
+    dvz_update_uniforms(canvas, *br, 0, sizeof(float), &value);
+
+    // One-off change, for all swapchain images.
+    if (ev.u.f.idx == 2)
+    {
+        value = 7;
+        dvz_upload_uniforms(canvas, *br, sizeof(float), sizeof(float), &value);
+    }
+}
+
+int test_canvas_transfer_uniforms(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+
+    uint32_t n = canvas->swapchain.img_count;
+    DvzBufferRegions br =
+        dvz_ctx_buffers(gpu->context, DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE, n, sizeof(vec4));
+    AT(br.count == n);
+
+    // Before the event loop, all regions are written.
+    vec4 data = {1, 2, 3, 4};
+    vec4 data2 = {0};
+    dvz_update_uniforms(canvas, br, 0, sizeof(vec4), data);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        dvz_buffer_download(br.buffer, br.offsets[i], sizeof(vec4), data2);
+        AT(memcmp(data, data2, sizeof(vec4)) == 0);
+    }
+
+    // In the event loop, the region of the current swapchain image is written at every frame.
+    dvz_event_callback(canvas, DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _uniforms_frame, &br);
+    dvz_app_run(app, 5);
+    dvz_buffer_download(br.buffer, br.offsets[canvas->swapchain.img_idx], sizeof(vec4), data2);
+    AT(data2[0] == canvas->frame_idx - 1);
+
+    // The one-off change has been written in all regions.
+    for (uint32_t i = 0; i < n; i++)
+    {
+        dvz_buffer_download(br.buffer, br.offsets[i], sizeof(vec4), data2);
+        AT(data2[1] == 7);
+        AT(data2[2] == 3);
+    }
+
+    TEST_END
+}
+
+
+
 int test_canvas_transfer_texture(TestContext* context)
 {
     DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
@@ -1165,6 +1221,232 @@ int test_canvas_offscreen(TestContext* context)
 
 
 
+int test_canvas_msaa(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, DVZ_CANVAS_FLAGS_MSAA_4);
+    AT(canvas != NULL);
+
+    // The sample count falls back to what the device supports.
+    AT(canvas->samples >= VK_SAMPLE_COUNT_1_BIT && canvas->samples <= VK_SAMPLE_COUNT_4_BIT);
+    bool msaa = canvas->samples > VK_SAMPLE_COUNT_1_BIT;
+    AT(dvz_obj_is_created(&canvas->msaa_image.obj) == msaa);
+    AT(canvas->framebuffers.attachment_count == (msaa ? 3 : 2));
+
+    TestVisual visual = {0};
+    _make_triangle2(canvas, &visual, "");
+    dvz_event_callback(
+        canvas, DVZ_EVENT_REFILL, 0, DVZ_EVENT_MODE_SYNC, _triangle_refill, &visual);
+    dvz_app_run(app, 3);
+
+    // The multisampled image is resolved into the image that is read back.
+    uint8_t* rgb = dvz_screenshot(canvas, false);
+    AT(rgb != NULL);
+    uint32_t nonzero = 0;
+    for (uint32_t i = 0; i < TEST_WIDTH * TEST_HEIGHT * 3; i++)
+        nonzero += rgb[i] != 0;
+    AT(nonzero > 0);
+    FREE(rgb);
+
+    dvz_graphics_destroy(&visual.graphics);
+    destroy_visual(&visual);
+    TEST_END
+}
+
+
+
+/*************************************************************************************************/
+/*  Canvas on-demand rendering                                                                   */
+/*************************************************************************************************/
+
+static void _on_demand_timer(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(ev.user_data != NULL);
+    uint32_t* count = (uint32_t*)ev.user_data;
+    (*count)++;
+}
+
+int test_canvas_on_demand(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, DVZ_CANVAS_FLAGS_ON_DEMAND);
+    AT(canvas != NULL);
+    AT(canvas->on_demand);
+
+    TestVisual visual = {0};
+    _make_triangle2(canvas, &visual, "");
+    dvz_event_callback(
+        canvas, DVZ_EVENT_REFILL, 0, DVZ_EVENT_MODE_SYNC, _triangle_refill, &visual);
+
+    // The first frame is always rendered.
+    dvz_app_run(app, 1);
+    AT(canvas->frame_idx == 1);
+
+    // An explicit request renders a single frame.
+    dvz_canvas_redraw(canvas);
+    dvz_app_run(app, 1);
+    AT(canvas->frame_idx == 2);
+
+    // So does a refill request.
+    dvz_canvas_to_refill(canvas);
+    dvz_app_run(app, 1);
+    AT(canvas->frame_idx == 3);
+
+    // A due TIMER callback triggers a new frame, which calls it. The idle iterations between two
+    // frames do not count in the number of frames.
+    uint32_t count = 0;
+    dvz_event_callback(
+        canvas, DVZ_EVENT_TIMER, .05, DVZ_EVENT_MODE_SYNC, _on_demand_timer, &count);
+    dvz_app_run(app, 5);
+    AT(canvas->frame_idx == 8);
+    AT(count > 0);
+    AT(count <= 5);
+
+    dvz_graphics_destroy(&visual.graphics);
+    destroy_visual(&visual);
+    TEST_END
+}
+
+
+
+/*************************************************************************************************/
+/*  Canvas parallel                                                                              */
+/*************************************************************************************************/
+
+static void _parallel_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(ev.user_data != NULL);
+    uint32_t* count = (uint32_t*)ev.user_data;
+    (*count)++;
+}
+
+int test_canvas_parallel(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    dvz_app_parallel(app, true);
+
+    // Several canvases sharing the same GPU context, each processing its frames in its own thread.
+    const uint32_t n = 3;
+    DvzCanvas* canvases[3] = {0};
+    uint32_t counts[3] = {0};
+    for (uint32_t i = 0; i < n; i++)
+    {
+        canvases[i] = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+        dvz_canvas_clear_color(canvases[i], .25 * i, 0, 0);
+        dvz_event_callback(
+            canvases[i], DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _parallel_callback,
+            &counts[i]);
+    }
+
+    dvz_app_run(app, 10);
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        AT(canvases[i]->frame_idx == 10);
+        AT(counts[i] == 10);
+        AT(!dvz_obj_is_created(&canvases[i]->frame_thread.obj));
+    }
+
+    TEST_END
+}
+
+
+
+/*************************************************************************************************/
+/*  Canvas event scheduling                                                                      */
+/*************************************************************************************************/
+
+typedef struct TestEvents TestEvents;
+
+struct TestEvents
+{
+    uint32_t count;
+    DvzEventType types[16];
+    float wheel;
+    uint64_t frame;
+};
+
+static void _events_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(ev.user_data != NULL);
+    TestEvents* events = (TestEvents*)ev.user_data;
+    // Slow callback, new events arrive in the meantime.
+    if (ev.type == DVZ_EVENT_MOUSE_PRESS)
+        dvz_sleep(100);
+    if (ev.type == DVZ_EVENT_MOUSE_WHEEL)
+        events->wheel += ev.u.w.dir[1];
+    if (ev.type == DVZ_EVENT_FRAME)
+        events->frame = ev.u.f.idx;
+    events->types[events->count++] = ev.type;
+}
+
+int test_canvas_events(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+
+    TestEvents events = {0};
+    DvzEventType types[] = {
+        DVZ_EVENT_MOUSE_PRESS, DVZ_EVENT_MOUSE_WHEEL,   DVZ_EVENT_KEY_PRESS,
+        DVZ_EVENT_FRAME,       DVZ_EVENT_MOUSE_RELEASE, DVZ_EVENT_MOUSE_MOVE};
+    for (uint32_t i = 0; i < 6; i++)
+        dvz_event_callback(canvas, types[i], 0, DVZ_EVENT_MODE_ASYNC, _events_callback, &events);
+
+    // Events raised while the event thread is busy.
+    dvz_event_mouse_press(canvas, DVZ_MOUSE_BUTTON_LEFT, 0);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        dvz_event_frame(canvas, i + 1, 0, 0);
+        dvz_event_mouse_wheel(canvas, (vec2){0, 0}, (vec2){0, 1}, 0);
+    }
+    dvz_event_key_press(canvas, DVZ_KEY_A, 0);
+
+    // The wheel and frame events are merged.
+    AT(dvz_event_pending(canvas, DVZ_EVENT_MOUSE_WHEEL) == 1);
+    AT(dvz_event_pending(canvas, DVZ_EVENT_FRAME) == 1);
+    AT(dvz_event_pending(canvas, DVZ_EVENT_KEY_PRESS) == 1);
+
+    for (uint32_t i = 0; i < 100 && events.count < 4; i++)
+        dvz_sleep(10);
+
+    // The input events are processed before the frame event, which was raised earlier.
+    AT(events.count == 4);
+    AT(events.types[0] == DVZ_EVENT_MOUSE_PRESS);
+    AT(events.types[1] == DVZ_EVENT_MOUSE_WHEEL);
+    AT(events.types[2] == DVZ_EVENT_KEY_PRESS);
+    AT(events.types[3] == DVZ_EVENT_FRAME);
+    AC(events.wheel, 3, 1e-6);
+    AT(events.frame == 3);
+
+    // The moves are not merged across a button event, the merged move takes the latest time.
+    events.count = 0;
+    dvz_event_mouse_press(canvas, DVZ_MOUSE_BUTTON_LEFT, 0);
+    dvz_event_mouse_move(canvas, (vec2){10, 10}, 0);
+    dvz_sleep(2);
+    dvz_event_mouse_release(canvas, DVZ_MOUSE_BUTTON_LEFT, 0);
+    dvz_sleep(2);
+    dvz_event_mouse_move(canvas, (vec2){20, 20}, 0);
+    dvz_event_mouse_move(canvas, (vec2){30, 30}, 0);
+    AT(dvz_event_pending(canvas, DVZ_EVENT_MOUSE_MOVE) == 2);
+
+    for (uint32_t i = 0; i < 100 && events.count < 4; i++)
+        dvz_sleep(10);
+    AT(events.count == 4);
+    AT(events.types[0] == DVZ_EVENT_MOUSE_PRESS);
+    AT(events.types[1] == DVZ_EVENT_MOUSE_MOVE);
+    AT(events.types[2] == DVZ_EVENT_MOUSE_RELEASE);
+    AT(events.types[3] == DVZ_EVENT_MOUSE_MOVE);
+
+    TEST_END
+}
+
+
+
 /*************************************************************************************************/
 /*  Canvas GUI                                                                                   */
 /*************************************************************************************************/
@@ -1251,3 +1533,50 @@ int test_canvas_screencast(TestContext* context)
     dvz_app_run(app, N_FRAMES);
     TEST_END
 }
+
+
+
+/*************************************************************************************************/
+/*  Canvas batch rendering                                                                       */
+/*************************************************************************************************/
+
+static void _batch_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    // Change the background at every rendered image.
+    float x = (ev.u.f.idx % 8) / 8.0f;
+    dvz_canvas_clear_color(canvas, x, 0, 1 - x);
+}
+
+int test_canvas_batch(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    dvz_event_callback(canvas, DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _batch_callback, NULL);
+
+    DvzBatch* batch = dvz_batch(canvas, 3);
+    AT(batch != NULL);
+    AT(batch->slot_count == 3);
+
+    const uint32_t n = 16;
+    char path[1024];
+    for (uint32_t i = 0; i < n; i++)
+    {
+        snprintf(path, sizeof(path), "%s/batch_%02d.ppm", ARTIFACTS_DIR, i);
+        AT(dvz_batch_render(batch, DVZ_IMAGE_FORMAT_PPM, path) == i);
+    }
+    AT(dvz_batch_wait(batch) == 0);
+    AT(batch->rendered == n);
+    AT(batch->written == n);
+    AT(canvas->frame_idx == n);
+    log_info("batch rendering at %.1f FPS", dvz_batch_fps(batch));
+    AT(dvz_batch_fps(batch) > 0);
+
+    // Check the last image.
+    FILE* fp = fopen(path, "rb");
+    AT(fp != NULL);
+    fclose(fp);
+
+    dvz_batch_destroy(batch);
+    TEST_END
+}
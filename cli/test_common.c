@@ -1,5 +1,12 @@
 #include "test_common.h"
+#include "../include/datoviz/bricks.h"
+#include "../include/datoviz/colormaps.h"
 #include "../include/datoviz/common.h"
+#include "../include/datoviz/lod.h"
+#include "../include/datoviz/mesh.h"
+#include "../include/datoviz/npy.h"
+#include "../include/datoviz/profiler.h"
+#include "../include/datoviz/tiles.h"
 
 
 
@@ -106,6 +113,72 @@ int test_container(TestContext* context)
 
 
 
+static void _parallel_mark(uint64_t first, uint64_t count, uint32_t thread_idx, void* user_data)
+{
+    uint8_t* marks = (uint8_t*)user_data;
+    ASSERT(marks != NULL);
+    ASSERT(count > 0);
+    for (uint64_t i = first; i < first + count; i++)
+        marks[i] += (uint8_t)(thread_idx + 1);
+}
+
+int test_parallel(TestContext* context)
+{
+    const uint32_t N = 1000003;
+    uint8_t* marks = (uint8_t*)calloc(N, 1);
+
+    AT(dvz_parallel(0, 1, 4, _parallel_mark, marks) == 0);
+
+    // Too few items for several threads.
+    AT(dvz_parallel(100, 1000, 4, _parallel_mark, marks) == 1);
+    for (uint32_t i = 0; i < 100; i++)
+        AT(marks[i] == 1);
+    memset(marks, 0, N);
+
+    // Every item is processed once, the ranges are in increasing order of the thread index.
+    uint32_t n_threads = dvz_parallel(N, 1000, 7, _parallel_mark, marks);
+    AT(n_threads == 7);
+    AT(marks[0] == 1);
+    AT(marks[N - 1] == n_threads);
+    for (uint32_t i = 1; i < N; i++)
+    {
+        AT(marks[i] >= 1);
+        AT(marks[i] == marks[i - 1] || marks[i] == marks[i - 1] + 1);
+    }
+
+    FREE(marks);
+    return 0;
+}
+
+
+
+int test_cache_path(TestContext* context)
+{
+#if !OS_WIN32
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s/cache", ARTIFACTS_DIR);
+    setenv("DVZ_CACHE_DIR", dir, 1);
+
+    // The directory is created on demand.
+    char path[1024];
+    AT(dvz_cache_path("test.bin", path, sizeof(path)) == 0);
+    AT(strncmp(path, dir, strlen(dir)) == 0);
+    AT(strcmp(path + strlen(dir), "/test.bin") == 0);
+    FILE* fp = fopen(path, "wb");
+    AT(fp != NULL);
+    fclose(fp);
+    remove(path);
+
+    // A directory that cannot be created disables the cache.
+    setenv("DVZ_CACHE_DIR", "/nonexistent/datoviz", 1);
+    AT(dvz_cache_path("test.bin", path, sizeof(path)) != 0);
+    unsetenv("DVZ_CACHE_DIR");
+#endif
+    return 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  FIFO queue                                                                                   */
 /*************************************************************************************************/
@@ -232,3 +305,761 @@ int test_fifo_3(TestContext* context)
     dvz_fifo_destroy(&fifo);
     return 0;
 }
+
+
+
+/*************************************************************************************************/
+/*  Decimation pyramid                                                                           */
+/*************************************************************************************************/
+
+int test_lod_1(TestContext* context)
+{
+    const uint32_t N = 1000000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos[i][0] = -1 + 2 * i / (double)(N - 1);
+        pos[i][1] = .5 * sin(i * .01);
+    }
+    // Isolated spikes that must survive the decimation.
+    pos[N / 3][1] = 10;
+    pos[2 * N / 3][1] = -10;
+
+    DvzLod* lod = dvz_lod();
+    dvz_lod_data(lod, N, pos);
+
+    // Subsampled preview while the pyramid is being built.
+    DvzLodWindow window = dvz_lod_window(lod, -1, 1, 1000);
+    AT(window.count > 0);
+    AT(window.count < N);
+
+    while (!dvz_lod_ready(lod))
+        dvz_sleep(1);
+    AT(lod->level_count >= 3);
+
+    // Full view: a few points per pixel, the spikes are kept.
+    window = dvz_lod_window(lod, -1, 1, 1000);
+    AT(window.level > 0);
+    AT(window.stride == 1);
+    AT(window.count < N / 10);
+    dvec3* out = calloc(window.count, sizeof(dvec3));
+    uint32_t* idx = calloc(window.count, sizeof(uint32_t));
+    dvz_lod_copy(lod, window, out, idx);
+    double ymin = 0, ymax = 0;
+    for (uint32_t i = 0; i < window.count; i++)
+    {
+        ymin = MIN(ymin, out[i][1]);
+        ymax = MAX(ymax, out[i][1]);
+        if (i > 0)
+            AT(idx[i] > idx[i - 1]);
+    }
+    AT(ymin == -10);
+    AT(ymax == 10);
+    AT(dvz_lod_covers(lod, window, -.9, .9, 1000));
+    FREE(out);
+    FREE(idx);
+
+    // Zoomed view: full resolution.
+    window = dvz_lod_window(lod, 0, .0001, 1000);
+    AT(window.level == 0);
+    AT(!dvz_lod_covers(lod, window, -1, 1, 1000));
+
+    dvz_lod_destroy(lod);
+    FREE(pos);
+    return 0;
+}
+
+
+
+/*************************************************************************************************/
+/*  Tiled images                                                                                 */
+/*************************************************************************************************/
+
+int test_tiles_1(TestContext* context)
+{
+    const uint32_t W = 3000, H = 2000;
+    uint8_t* pixels = calloc(W * H * 4, 1);
+    for (uint32_t y = 0; y < H; y++)
+    {
+        for (uint32_t x = 0; x < W; x++)
+        {
+            pixels[4 * (y * W + x) + 0] = x % 256;
+            pixels[4 * (y * W + x) + 1] = y % 256;
+            pixels[4 * (y * W + x) + 3] = 255;
+        }
+    }
+
+    DvzTiles* tiles = dvz_tiles();
+    dvz_tiles_data(tiles, W, H, 4, pixels);
+    while (!dvz_tiles_ready(tiles))
+        dvz_sleep(1);
+
+    // 3000, 1500, 750, 375, 188 texels wide.
+    AT(tiles->level_count == 5);
+    AT(tiles->levels[1].width == 1500);
+    AT(tiles->levels[1].pixels[0] == 1); // mean of 0, 1, 0, 1
+    AT(tiles->levels[4].cols == 1);
+    AT(tiles->levels[4].rows == 1);
+
+    // Full view on 1000 pixels: 1.5 texel per pixel at level 1.
+    dvec4 box = {0, 0, 1, 1};
+    dvec2 scale = {1000, 667};
+    AT(dvz_tiles_level(tiles, scale) == 1);
+    uint32_t n = dvz_tiles_visible(tiles, 1, box, 0, NULL);
+    AT(n == 6 * 4);
+
+    // The tiles are loaded progressively, within the per-frame upload budget.
+    uint32_t k = 0;
+    while (dvz_tiles_changed(tiles, box, scale))
+    {
+        dvz_tiles_update(tiles, box, scale);
+        AT(tiles->upload_count <= DVZ_TILES_MAX_UPLOADS);
+        k++;
+    }
+    AT(k == 3);
+    AT(tiles->quad_count == n);
+    for (uint32_t i = 0; i < tiles->quad_count; i++)
+    {
+        for (uint32_t j = 0; j < 4; j++)
+        {
+            AT(0 <= tiles->quads[i].uv[j] && tiles->quads[i].uv[j] <= 1);
+            AT(0 <= tiles->quads[i].box[j] && tiles->quads[i].box[j] <= 1);
+        }
+    }
+
+    // The first tile slot starts with the gutter, a copy of the first texel.
+    uint8_t* slot = dvz_tiles_slot_pixels(tiles, 0);
+    AT(slot[0] == tiles->levels[1].pixels[0]);
+    AT(slot[4 * (DVZ_TILES_SLOT_SIZE + 1)] == tiles->levels[1].pixels[0]);
+
+    // Zoom in: the missing full-resolution tiles are replaced by their resident ancestors.
+    box[2] = box[3] = .5;
+    scale[0] = scale[1] = 4000;
+    AT(dvz_tiles_changed(tiles, box, scale));
+    AT(dvz_tiles_level(tiles, scale) == 0);
+    n = dvz_tiles_visible(tiles, 0, box, 0, NULL);
+    AT(n > DVZ_TILES_MAX_UPLOADS);
+    dvz_tiles_update(tiles, box, scale);
+    AT(tiles->upload_count == DVZ_TILES_MAX_UPLOADS);
+    AT(tiles->quad_count == n);
+    AT(!tiles->is_complete);
+
+    dvz_tiles_destroy(tiles);
+    FREE(pixels);
+    return 0;
+}
+
+
+
+int test_tiles_npy(TestContext* context)
+{
+    const uint32_t W = 1000, H = 600;
+    uint8_t* pixels = calloc(W * H, 1);
+    for (uint32_t y = 0; y < H; y++)
+    {
+        for (uint32_t x = 0; x < W; x++)
+            pixels[y * W + x] = (x + y) % 256;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/test_tiles.npy", ARTIFACTS_DIR);
+    write_npy(
+        path, "{'descr': '|u1', 'fortran_order': False, 'shape': (600, 1000), }", W * H, pixels);
+
+    // The original image is read from the mapped file, the coarser levels from scratch files.
+    DvzNpy* npy = dvz_npy(path);
+    AT(npy != NULL);
+    DvzTiles* tiles = dvz_tiles();
+    AT(dvz_tiles_npy(tiles, npy) == 0);
+    while (!dvz_tiles_ready(tiles))
+        dvz_sleep(1);
+
+    // 1000, 500, 250 texels wide.
+    AT(tiles->level_count == 3);
+    AT(tiles->channels == 1);
+#if !OS_WIN32
+    AT(tiles->levels[1].is_mapped);
+    AT(tiles->levels[2].is_mapped);
+#endif
+    // The released pages are read again from the files.
+    AT(tiles->levels[1].pixels[0] == 1);              // mean of 0, 1, 1, 2
+    AT(tiles->levels[1].pixels[150 * 500 + 2] == 49); // mean of 48, 49, 49, 50
+
+    // Full resolution tiles, copied from the original image.
+    dvec4 box = {0, 0, 1, 1};
+    dvec2 scale = {2000, 1200};
+    AT(dvz_tiles_level(tiles, scale) == 0);
+    while (dvz_tiles_changed(tiles, box, scale))
+        dvz_tiles_update(tiles, box, scale);
+    AT(tiles->quad_count == 4 * 3);
+    uint8_t* slot = dvz_tiles_slot_pixels(tiles, 0);
+    AT(slot[DVZ_TILES_SLOT_SIZE + 1] == pixels[0]);
+    AT(slot[2 * DVZ_TILES_SLOT_SIZE + 3] == pixels[W + 2]);
+
+    // Only uint8 images are supported.
+    float values[4] = {0};
+    write_npy(path, "{'descr': '<f4', 'fortran_order': False, 'shape': (2, 2), }", 16, values);
+    DvzNpy* npy_float = dvz_npy(path);
+    AT(npy_float != NULL);
+    AT(dvz_tiles_npy(tiles, npy_float) != 0);
+    dvz_npy_destroy(npy_float);
+
+    dvz_tiles_destroy(tiles);
+    dvz_npy_destroy(npy);
+    FREE(pixels);
+    return 0;
+}
+
+
+
+/*************************************************************************************************/
+/*  Bricked volumes                                                                              */
+/*************************************************************************************************/
+
+int test_bricks_1(TestContext* context)
+{
+    // Empty volume, except a cube within the first brick.
+    const uint32_t W = 100, H = 80, D = 70;
+    uint16_t* voxels = calloc(W * H * D, sizeof(uint16_t));
+    for (uint32_t z = 0; z < 29; z++)
+    {
+        for (uint32_t y = 0; y < 29; y++)
+        {
+            for (uint32_t x = 0; x < 29; x++)
+                voxels[(z * H + y) * W + x] = 1000;
+        }
+    }
+
+    DvzBricks* bricks = dvz_bricks();
+    dvz_bricks_data(bricks, W, H, D, sizeof(uint16_t), voxels);
+    while (!dvz_bricks_ready(bricks))
+        dvz_sleep(1);
+
+    // 100x80x70, 50x40x35, 25x20x18 voxels.
+    AT(bricks->level_count == 3);
+    AT(bricks->levels[0].brick_count == 4 * 3 * 3);
+    AT(bricks->levels[0].range[0].min == 0);
+    AT(bricks->levels[0].range[0].max == 1000);
+    AT(bricks->levels[0].range[1].max == 0);
+    AT(bricks->levels[1].voxels[0] == 1000);
+    AT(bricks->levels[2].brick_count == 1);
+
+    // Only the coarsest brick and the first brick are loaded.
+    AT(dvz_bricks_update(bricks));
+    AT(bricks->level == 0);
+    AT(bricks->levels[0].filled_count == 1);
+    AT(bricks->upload_count == 2);
+    AT(bricks->levels[2].slot[0] == (int32_t)bricks->uploads[0]);
+    AT(bricks->is_complete);
+    uint8_t* page = dvz_bricks_page(bricks);
+    AT(page[3] == 255);
+    for (uint32_t i = 1; i < bricks->levels[0].brick_count; i++)
+        AT(page[4 * i + 3] == 0);
+    uint16_t* slot = dvz_bricks_slot_voxels(bricks, bricks->uploads[1]);
+    AT(slot[0] == 1000);                        // clamped gutter
+    AT(slot[DVZ_BRICKS_SLOT_SIZE - 1] == 0);    // x = 30, in the gutter
+    AT(slot[DVZ_BRICKS_SLOT_SIZE - 3] == 1000); // x = 28
+    AT(!dvz_bricks_update(bricks));
+
+    // The transfer function hides the low values: all bricks are skipped.
+    dvz_bricks_transfer(bricks, (vec2){.5, 1}, 0, NULL);
+    AT(dvz_bricks_update(bricks));
+    AT(bricks->levels[0].filled_count == 0);
+    page = dvz_bricks_page(bricks);
+    AT(page[3] == 0);
+
+    // The brick is still resident when it becomes visible again.
+    dvz_bricks_transfer(bricks, (vec2){0, 0}, 0, NULL);
+    AT(dvz_bricks_update(bricks));
+    AT(bricks->upload_count == 0);
+    AT(dvz_bricks_page(bricks)[3] == 255);
+
+    // Step transfer function.
+    float transfer[4] = {0, 0, 1, 1};
+    dvz_bricks_transfer(bricks, (vec2){0, .02}, 4, transfer);
+    AT(dvz_bricks_update(bricks));
+    AT(bricks->levels[0].filled_count == 1);
+    transfer[2] = transfer[3] = 0;
+    dvz_bricks_transfer(bricks, (vec2){0, .02}, 4, transfer);
+    AT(dvz_bricks_update(bricks));
+    AT(bricks->levels[0].filled_count == 0);
+
+    // 8-bit volume.
+    uint8_t* voxels8 = calloc(W * H * D, 1);
+    voxels8[(45 * H + 45) * W + 75] = 255;
+    dvz_bricks_transfer(bricks, (vec2){0, 0}, 0, NULL);
+    dvz_bricks_data(bricks, W, H, D, sizeof(uint8_t), voxels8);
+    while (!dvz_bricks_ready(bricks))
+        dvz_sleep(1);
+    AT(dvz_bricks_update(bricks));
+    AT(bricks->levels[0].filled_count == 1);
+    AT(bricks->levels[0].range[(1 * 3 + 1) * 4 + 2].max == 65535);
+
+    // Full volume: the bricks beyond the upload budget are drawn with the coarsest brick.
+    for (uint32_t i = 0; i < W * H * D; i++)
+        voxels[i] = 1000;
+    dvz_bricks_data(bricks, W, H, D, sizeof(uint16_t), voxels);
+    while (!dvz_bricks_ready(bricks))
+        dvz_sleep(1);
+    AT(dvz_bricks_update(bricks));
+    AT(bricks->level == 0);
+    AT(bricks->upload_count == DVZ_BRICKS_MAX_UPLOADS);
+    AT(!bricks->is_complete);
+    page = dvz_bricks_page(bricks);
+    uint32_t n = bricks->levels[0].brick_count;
+    AT(page[3] == 255);
+    AT(page[4 * (n - 1) + 3] == 2);
+    uvec3 offset = {0};
+    dvz_bricks_slot_offset((uint32_t)bricks->levels[2].slot[0], offset);
+    AT(page[4 * (n - 1) + 0] == offset[0] / DVZ_BRICKS_SLOT_SIZE);
+    AT(page[4 * (n - 1) + 1] == offset[1] / DVZ_BRICKS_SLOT_SIZE);
+    AT(page[4 * (n - 1) + 2] == offset[2] / DVZ_BRICKS_SLOT_SIZE);
+
+    // The remaining bricks are loaded at the next update, the coarsest brick stays resident.
+    AT(dvz_bricks_update(bricks));
+    AT(bricks->is_complete);
+    page = dvz_bricks_page(bricks);
+    for (uint32_t i = 0; i < n; i++)
+        AT(page[4 * i + 3] == 255);
+    AT(bricks->levels[2].slot[0] >= 0);
+
+    dvz_bricks_destroy(bricks);
+    FREE(voxels);
+    FREE(voxels8);
+    return 0;
+}
+
+
+
+/*************************************************************************************************/
+/*  Profiler                                                                                     */
+/*************************************************************************************************/
+
+int test_profiler_1(TestContext* context)
+{
+    DvzProfiler* profiler = dvz_profiler();
+
+    // Nested CPU scopes, outside scopes are ignored.
+    dvz_profiler_begin(profiler, "ignored");
+    dvz_profiler_frame_begin(profiler, 10);
+    dvz_profiler_begin(profiler, "frame callbacks");
+    dvz_profiler_begin(profiler, "scene update");
+    dvz_sleep(2);
+    dvz_profiler_end(profiler);
+    dvz_profiler_end(profiler);
+    dvz_profiler_begin(profiler, "submit");
+    dvz_profiler_gpu_reset(profiler, 1, DVZ_PROFILER_CMDS_RENDER);
+    AT(dvz_profiler_gpu_begin(profiler, 1, DVZ_PROFILER_CMDS_RENDER, "panel 0") == 0);
+    AT(dvz_profiler_gpu_begin(profiler, 1, DVZ_PROFILER_CMDS_RENDER, "panel 1") == 1);
+    dvz_profiler_gpu_submit(profiler, 1);
+    // The open scopes are closed at the end of the frame.
+    dvz_profiler_frame_end(profiler);
+    AT(dvz_profiler_frame_count(profiler) == 1);
+
+    DvzProfilerFrame* frame = dvz_profiler_frame(profiler, 0);
+    AT(frame->frame_idx == 10);
+    AT(frame->scope_count == 3);
+    AT(strcmp(frame->scopes[1].name, "scene update") == 0);
+    AT(frame->scopes[1].depth == 1);
+    AT(frame->scopes[1].end - frame->scopes[1].start >= .001);
+    AT(frame->scopes[0].start <= frame->scopes[1].start);
+    AT(frame->scopes[0].end >= frame->scopes[1].end);
+    AT(frame->scopes[2].end >= frame->scopes[2].start);
+
+    // GPU timestamps resolved after the frame, with 1 us per tick.
+    uint64_t timestamps[DVZ_PROFILER_IMAGE_QUERIES] = {0};
+    timestamps[dvz_profiler_gpu_query(0, DVZ_PROFILER_CMDS_RENDER, 0, false)] = 1000;
+    timestamps[dvz_profiler_gpu_query(0, DVZ_PROFILER_CMDS_RENDER, 0, true)] = 1500;
+    timestamps[dvz_profiler_gpu_query(0, DVZ_PROFILER_CMDS_RENDER, 1, false)] = 1500;
+    timestamps[dvz_profiler_gpu_query(0, DVZ_PROFILER_CMDS_RENDER, 1, true)] = 3000;
+    dvz_profiler_gpu_resolve(profiler, 1, timestamps, 1000);
+    AT(frame->scope_count == 5);
+    AT(frame->scopes[4].domain == DVZ_PROFILER_DOMAIN_GPU);
+    AC(frame->scopes[4].end - frame->scopes[4].start, .0015, 1e-9);
+    AC(frame->scopes[4].start - frame->scopes[3].start, .0005, 1e-9);
+    double max = 0;
+    AC(dvz_profiler_stats(profiler, DVZ_PROFILER_DOMAIN_GPU, "panel 1", &max), .0015, 1e-9);
+    AC(max, .0015, 1e-9);
+    AT(dvz_profiler_stats(profiler, DVZ_PROFILER_DOMAIN_CPU, "panel 1", NULL) == 0);
+
+    // Already resolved.
+    dvz_profiler_gpu_resolve(profiler, 1, timestamps, 1000);
+    AT(frame->scope_count == 5);
+
+    // Ring buffer.
+    for (uint32_t i = 0; i < DVZ_PROFILER_MAX_FRAMES + 10; i++)
+    {
+        dvz_profiler_frame_begin(profiler, 100 + i);
+        dvz_profiler_begin(profiler, "interact");
+        dvz_profiler_end(profiler);
+    }
+    dvz_profiler_frame_end(profiler);
+    AT(dvz_profiler_frame_count(profiler) == DVZ_PROFILER_MAX_FRAMES);
+    AT(dvz_profiler_frame(profiler, 0)->frame_idx == 110);
+    AT(dvz_profiler_frame(profiler, DVZ_PROFILER_MAX_FRAMES - 1)->frame_idx ==
+       100 + DVZ_PROFILER_MAX_FRAMES + 9);
+
+    // Scopes of frames which are no longer recorded are discarded.
+    dvz_profiler_scope(profiler, 10, DVZ_PROFILER_DOMAIN_GPU, "late", 0, 1);
+    AT(dvz_profiler_stats(profiler, DVZ_PROFILER_DOMAIN_GPU, "late", NULL) == 0);
+
+    // Chrome trace export.
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/profiler.json", ARTIFACTS_DIR);
+    AT(dvz_profiler_export(profiler, path) == 0);
+    size_t size = 0;
+    char* json = (char*)dvz_read_file(path, &size);
+    AT(json != NULL);
+    AT(size > 0);
+    AT(strncmp(json, "{\"traceEvents\":[", 16) == 0);
+    FREE(json);
+
+    dvz_profiler_destroy(profiler);
+    return 0;
+}
+
+
+
+int test_npy_1(TestContext* context)
+{
+    float values[30] = {0};
+    for (uint32_t i = 0; i < 30; i++)
+        values[i] = i;
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/test.npy", ARTIFACTS_DIR);
+    write_npy(
+        path, "{'descr': '<f4', 'fortran_order': False, 'shape': (10, 3), }", sizeof(values),
+        values);
+
+    // Header parsing and mapped payload.
+    DvzNpy* npy = dvz_npy(path);
+    AT(npy != NULL);
+    AT(npy->version == 1);
+    AT(strcmp(npy->descr, "<f4") == 0);
+    AT(npy->dtype == DVZ_DTYPE_FLOAT);
+    AT(npy->item_size == 4);
+    AT(!npy->fortran_order);
+    AT(npy->ndims == 2);
+    AT(npy->shape[0] == 10);
+    AT(npy->shape[1] == 3);
+    AT(npy->item_count == 30);
+    AT(npy->size == sizeof(values));
+    AT(*(const float*)dvz_npy_item(npy, 29) == 29);
+
+    // The released pages are read again from the file.
+    dvz_npy_prefetch(npy, 0, npy->size);
+    dvz_npy_release(npy, 0, npy->size);
+    AT(memcmp(npy->data, values, sizeof(values)) == 0);
+    dvz_npy_destroy(npy);
+
+    // Copy of the payload.
+    size_t size = 0;
+    float* copy = (float*)dvz_read_npy(path, &size);
+    AT(size == sizeof(values));
+    AT(copy[12] == 12);
+    FREE(copy);
+
+    // Raw binary file, skipping the NPY header.
+    npy = dvz_npy_raw(path, DVZ_DTYPE_VEC3, 128);
+    AT(npy != NULL);
+    AT(npy->item_count == 10);
+    AT(((const float*)dvz_npy_item(npy, 3))[1] == 10);
+    dvz_npy_destroy(npy);
+
+    // Structured dtype, in Fortran order.
+    write_npy(
+        path,
+        "{'descr': [('pos', '<f4', (3,)), ('color', '|u1', (4,))], 'fortran_order': True, "
+        "'shape': (5,), }",
+        5 * 16, values);
+    npy = dvz_npy(path);
+    AT(npy != NULL);
+    AT(npy->dtype == DVZ_DTYPE_CUSTOM);
+    AT(npy->descr[0] == '[');
+    AT(npy->fortran_order);
+    AT(npy->item_size == 16);
+    AT(npy->item_count == 5);
+    dvz_npy_destroy(npy);
+
+    // Unsupported byte order and truncated payload.
+    write_npy(path, "{'descr': '>f4', 'fortran_order': False, 'shape': (10,), }", 40, values);
+    AT(dvz_npy(path) == NULL);
+    write_npy(path, "{'descr': '<f4', 'fortran_order': False, 'shape': (100,), }", 40, values);
+    AT(dvz_npy(path) == NULL);
+
+    return 0;
+}
+
+
+
+/*************************************************************************************************/
+/*  Colormaps                                                                                    */
+/*************************************************************************************************/
+
+typedef struct TestColorVertex TestColorVertex;
+struct TestColorVertex
+{
+    vec3 pos;
+    cvec4 color;
+    float size;
+};
+
+int test_colormap_batch(TestContext* context)
+{
+    // Large enough to be processed by several threads.
+    const uint32_t N = 4 * DVZ_COLORMAP_THREAD_MIN + 3;
+    double* values = calloc(N, sizeof(double));
+    float* values_f = calloc(N, sizeof(float));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        values[i] = -.1 + 1.2 * dvz_rand_float();
+        values_f[i] = (float)values[i];
+    }
+    values[0] = NAN;
+    values_f[0] = NAN;
+
+    // Packed colors from float64 values.
+    cvec4* colors = calloc(N, sizeof(cvec4));
+    DvzClock clock = {0};
+    _clock_init(&clock);
+    dvz_colormap_array_double(DVZ_CMAP_VIRIDIS, N, values, 0, 1, 0, colors);
+    double dt = MAX(_clock_get(&clock), 1e-6);
+    log_debug("colormap of %d values: %.1f M values/s", N, N / dt / 1e6);
+
+    cvec4 expected = {0};
+    dvz_colormap(DVZ_CMAP_VIRIDIS, 0, expected);
+    AT(memcmp(colors[0], expected, sizeof(cvec4)) == 0);
+    for (uint32_t i = 1; i < N; i++)
+    {
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, values[i], 0, 1, expected);
+        AT(memcmp(colors[i], expected, sizeof(cvec4)) == 0);
+    }
+
+    // Strided colors from float32 values, written in the color field of a vertex array.
+    TestColorVertex* vertices = calloc(N, sizeof(TestColorVertex));
+    for (uint32_t i = 0; i < N; i++)
+        vertices[i].size = i;
+    dvz_colormap_array_float(
+        DVZ_CMAP_HSV, N, values_f, 0, 1, sizeof(TestColorVertex), &vertices[0].color);
+    for (uint32_t i = 1; i < N; i++)
+    {
+        dvz_colormap_scale(DVZ_CMAP_HSV, values_f[i], 0, 1, expected);
+        AT(memcmp(vertices[i].color, expected, sizeof(cvec4)) == 0);
+        AT(vertices[i].size == i);
+    }
+
+    // Non-unit range, with values exactly on the bin edges and on both bounds.
+    double vmin = -3.5, vmax = 9.25;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        values[i] = vmin + (vmax - vmin) * (i % 257) / 256.0;
+        values_f[i] = (float)values[i];
+    }
+    dvz_colormap_array_double(DVZ_CMAP_VIRIDIS, N, values, vmin, vmax, 0, colors);
+    for (uint32_t i = 0; i < N; i++)
+    {
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, values[i], vmin, vmax, expected);
+        AT(memcmp(colors[i], expected, sizeof(cvec4)) == 0);
+    }
+    dvz_colormap_array_float(DVZ_CMAP_VIRIDIS, N, values_f, vmin, vmax, 0, colors);
+    for (uint32_t i = 0; i < N; i++)
+    {
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, values_f[i], vmin, vmax, expected);
+        AT(memcmp(colors[i], expected, sizeof(cvec4)) == 0);
+    }
+
+    FREE(values);
+    FREE(values_f);
+    FREE(colors);
+    FREE(vertices);
+    return 0;
+}
+
+
+
+/*************************************************************************************************/
+/*  Meshes                                                                                       */
+/*************************************************************************************************/
+
+int test_mesh_parallel(TestContext* context)
+{
+    // Large enough for several threads.
+    DvzMesh mesh = dvz_mesh_sphere(400, 400);
+    uint32_t nv = mesh.vertices.item_count;
+    uint32_t nf = mesh.indices.item_count / 3;
+    AT(nv > 2 * DVZ_MESH_THREAD_MIN);
+    DvzGraphicsMeshVertex* vertices = (DvzGraphicsMeshVertex*)mesh.vertices.data;
+    DvzIndex* indices = (DvzIndex*)mesh.indices.data;
+
+    // Serial reference normals.
+    vec3* normals = calloc(nv, sizeof(vec3));
+    vec3 u, v, n;
+    DvzIndex i0, i1, i2;
+    for (uint32_t i = 0; i < nf; i++)
+    {
+        i0 = indices[3 * i + 0];
+        i1 = indices[3 * i + 1];
+        i2 = indices[3 * i + 2];
+        glm_vec3_sub(vertices[i1].pos, vertices[i0].pos, u);
+        glm_vec3_sub(vertices[i2].pos, vertices[i0].pos, v);
+        glm_vec3_crossn(u, v, n);
+        glm_vec3_add(normals[i0], n, normals[i0]);
+        glm_vec3_add(normals[i1], n, normals[i1]);
+        glm_vec3_add(normals[i2], n, normals[i2]);
+    }
+    for (uint32_t i = 0; i < nv; i++)
+        glm_vec3_normalize(normals[i]);
+
+    // The parallel normals are accumulated in the same order.
+    for (uint32_t i = 0; i < nv; i++)
+        glm_vec3_zero(vertices[i].normal);
+    dvz_mesh_normals(&mesh);
+    for (uint32_t i = 0; i < nv; i++)
+        AT(glm_vec3_distance(vertices[i].normal, normals[i]) < 1e-5);
+
+    // Transformation: the normals are transformed by the inverse transpose.
+    vec3* pos = calloc(nv, sizeof(vec3));
+    for (uint32_t i = 0; i < nv; i++)
+        glm_vec3_copy(vertices[i].pos, pos[i]);
+    dvz_mesh_scale(&mesh, (vec3){2, 1, .5});
+    dvz_mesh_rotate(&mesh, M_PI / 3, (vec3){0, 1, 0});
+    mat4 tr, tr_normal;
+    glm_mat4_copy(mesh.transform, tr);
+    glm_mat4_inv(tr, tr_normal);
+    glm_mat4_transpose(tr_normal);
+    dvz_mesh_transform(&mesh);
+    vec3 p = {0};
+    for (uint32_t i = 0; i < nv; i++)
+    {
+        glm_mat4_mulv3(tr, pos[i], 1, p);
+        AT(glm_vec3_distance(p, vertices[i].pos) < 1e-5);
+        glm_mat4_mulv3(tr_normal, normals[i], 1, p);
+        AT(glm_vec3_distance(p, vertices[i].normal) < 1e-5);
+    }
+
+    FREE(normals);
+    FREE(pos);
+    dvz_mesh_destroy(&mesh);
+    return 0;
+}
+
+
+
+int test_mesh_cache(TestContext* context)
+{
+    DvzMesh mesh = dvz_mesh_sphere(20, 30);
+    uint32_t nv = mesh.vertices.item_count;
+    uint32_t ni = mesh.indices.item_count;
+    AT(nv > 0);
+    AT(ni > 0);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/test.dvzmesh", ARTIFACTS_DIR);
+    AT(dvz_mesh_save(&mesh, path) == 0);
+
+    // The loaded arrays point to the file mapping, and can be modified in place.
+    DvzMesh loaded = dvz_mesh_load(path);
+    AT(loaded.file != NULL);
+    AT(loaded.vertices.item_count == nv);
+    AT(loaded.indices.item_count == ni);
+    AT(memcmp(loaded.vertices.data, mesh.vertices.data, nv * sizeof(DvzGraphicsMeshVertex)) == 0);
+    AT(memcmp(loaded.indices.data, mesh.indices.data, ni * sizeof(DvzIndex)) == 0);
+    dvz_mesh_translate(&loaded, (vec3){1, 0, 0});
+    dvz_mesh_transform(&loaded);
+    dvz_mesh_destroy(&loaded);
+
+    // The file is unchanged.
+    loaded = dvz_mesh_load(path);
+    AT(memcmp(loaded.vertices.data, mesh.vertices.data, nv * sizeof(DvzGraphicsMeshVertex)) == 0);
+    dvz_mesh_destroy(&loaded);
+
+    // A truncated file is rejected.
+    size_t size = 0;
+    uint32_t* contents = dvz_read_file(path, &size);
+    AT(contents != NULL);
+    AT(size > 0);
+    FILE* fp = fopen(path, "wb");
+    AT(fp != NULL);
+    AT(fwrite(contents, 1, size - 1, fp) == size - 1);
+    fclose(fp);
+    FREE(contents);
+    loaded = dvz_mesh_load(path);
+    AT(loaded.file == NULL);
+    AT(loaded.vertices.item_count == 0);
+    dvz_mesh_destroy(&loaded);
+
+    dvz_mesh_destroy(&mesh);
+    return 0;
+}
+
+
+
+static void _write_obj(const char* path, const char* contents)
+{
+    FILE* fp = fopen(path, "w");
+    ASSERT(fp != NULL);
+    fputs(contents, fp);
+    fclose(fp);
+}
+
+int test_mesh_obj(TestContext* context)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/test_mesh.obj", ARTIFACTS_DIR);
+    char cache_path[1024];
+    snprintf(cache_path, sizeof(cache_path), "%s.dvzmesh", path);
+    remove(cache_path);
+
+    // A quad and two triangles. The first position is used with two texture coordinates.
+    _write_obj(
+        path, "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 2 0 0\n"
+              "vn 0 0 1\n"
+              "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+              "f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+              "f 2/2/1 5/1/1 3/3/1\n"
+              "f 1/3/1 5/2/1 4/4/1\n");
+
+    // The quad is triangulated, and the vertices with the same position, normal and texture
+    // coordinates are shared.
+    DvzMesh mesh = dvz_mesh_obj_cached(path);
+    AT(mesh.file == NULL);
+    AT(mesh.indices.item_count == 12);
+    AT(mesh.vertices.item_count == 7);
+    DvzGraphicsMeshVertex* vertices = (DvzGraphicsMeshVertex*)mesh.vertices.data;
+    DvzIndex* indices = (DvzIndex*)mesh.indices.data;
+    for (uint32_t i = 0; i < 6; i++)
+        AT(indices[i] < 4);
+    uint32_t shared = 0;
+    for (uint32_t i = 0; i < mesh.vertices.item_count; i++)
+    {
+        AT(vertices[i].normal[2] == 1);
+        if (glm_vec3_eqv(vertices[i].pos, vertices[0].pos))
+            shared++;
+    }
+    AT(shared == 2);
+
+    // The second time, the mesh is loaded from the cache.
+    DvzMesh cached = dvz_mesh_obj_cached(path);
+    AT(cached.file != NULL);
+    AT(cached.vertices.item_count == mesh.vertices.item_count);
+    AT(cached.indices.item_count == mesh.indices.item_count);
+    AT(memcmp(cached.vertices.data, vertices, 7 * sizeof(DvzGraphicsMeshVertex)) == 0);
+    AT(memcmp(cached.indices.data, indices, 12 * sizeof(DvzIndex)) == 0);
+    dvz_mesh_destroy(&cached);
+
+    // The cache is not used when the OBJ file has changed, even within the same second.
+    FILE* fp = fopen(path, "a");
+    AT(fp != NULL);
+    fputs("# changed\n", fp);
+    fclose(fp);
+    cached = dvz_mesh_obj_cached(path);
+    AT(cached.file == NULL);
+    dvz_mesh_destroy(&cached);
+    cached = dvz_mesh_obj_cached(path);
+    AT(cached.file != NULL);
+    dvz_mesh_destroy(&cached);
+
+    dvz_mesh_destroy(&mesh);
+    return 0;
+}
@@ -12,6 +12,10 @@
 
 int test_container(TestContext* context);
 
+int test_parallel(TestContext* context);
+
+int test_cache_path(TestContext* context);
+
 
 
 /*************************************************************************************************/
@@ -24,4 +28,65 @@ int test_fifo_3(TestContext* context);
 
 
 
+/*************************************************************************************************/
+/*  Decimation pyramid                                                                           */
+/*************************************************************************************************/
+
+int test_lod_1(TestContext* context);
+
+
+
+/*************************************************************************************************/
+/*  Tiled images                                                                                 */
+/*************************************************************************************************/
+
+int test_tiles_1(TestContext* context);
+int test_tiles_npy(TestContext* context);
+
+
+
+/*************************************************************************************************/
+/*  Bricked volumes                                                                              */
+/*************************************************************************************************/
+
+int test_bricks_1(TestContext* context);
+
+
+
+/*************************************************************************************************/
+/*  Profiler                                                                                     */
+/*************************************************************************************************/
+
+int test_profiler_1(TestContext* context);
+
+
+
+/*************************************************************************************************/
+/*  NPY files                                                                                    */
+/*************************************************************************************************/
+
+int test_npy_1(TestContext* context);
+
+
+
+/*************************************************************************************************/
+/*  Colormaps                                                                                    */
+/*************************************************************************************************/
+
+int test_colormap_batch(TestContext* context);
+
+
+
+/*************************************************************************************************/
+/*  Meshes                                                                                       */
+/*************************************************************************************************/
+
+int test_mesh_parallel(TestContext* context);
+
+int test_mesh_cache(TestContext* context);
+
+int test_mesh_obj(TestContext* context);
+
+
+
 #endif
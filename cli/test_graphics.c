@@ -756,6 +756,13 @@ int test_graphics_text(TestContext* context)
     // Font atlas
     DvzFontAtlas* atlas = &gpu->context->font_atlas;
 
+    // The glyph table must match the position of the characters in the atlas string.
+    for (uint32_t c = 1; c < 256; c++)
+    {
+        char cs[2] = {(char)c, 0};
+        AT(atlas->glyph_map[c] == strcspn(atlas->font_str, cs));
+    }
+
     DvzGraphicsTextParams params = {0};
     params.grid_size[0] = (int32_t)atlas->rows;
     params.grid_size[1] = (int32_t)atlas->cols;
@@ -108,6 +108,76 @@ int test_axes_3(TestContext* context)
 
 
 
+int test_axes_4(TestContext* context)
+{
+    DvzAxesContext ctx = {0};
+    ctx.coord = DVZ_AXES_COORD_X;
+    ctx.size_viewport = 1000;
+    ctx.size_glyph = 10;
+    ctx.extensions = 1;
+
+    // Nearby ranges share the same memoized computation.
+    DvzAxesTicksCache cache = {0};
+    DvzAxesTicks* t0 = dvz_ticks_cached(&cache, -2.123, 2.456, ctx);
+    DvzAxesTicks* t1 = dvz_ticks_cached(&cache, -2.121, 2.457, ctx);
+    AT(t0 == t1);
+    AT(cache.hits == 1);
+    AT(cache.misses == 1);
+
+    // The ticks returned for nearby ranges always cover the requested range.
+    DvzAxesTicks* t = NULL;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        t = dvz_ticks_cached(&cache, -2.123 + .001 * i, 2.456 + .001 * i, ctx);
+        AT(t->lmin_in < -2.123 + .001 * i);
+        AT(t->lmax_in > 2.456 + .001 * i);
+    }
+    uint32_t misses = cache.misses;
+
+    // A different viewport size requires a new computation.
+    ctx.size_viewport = 500;
+    DvzAxesTicks* t2 = dvz_ticks_cached(&cache, -2.123, 2.456, ctx);
+    AT(t2 != t0);
+    AT(cache.misses == misses + 1);
+
+    // The cache evicts the least recently used computations.
+    for (uint32_t i = 0; i < 2 * DVZ_TICKS_CACHE_SIZE; i++)
+        dvz_ticks_cached(&cache, i, i + 10, ctx);
+    AT(cache.count == DVZ_TICKS_CACHE_SIZE);
+
+    // Shifting the ticks when panning yields the same labels as a full formatting.
+    ctx.size_viewport = 1000;
+    DvzAxesTicks ticks = {0};
+    dvz_ticks_copy(dvz_ticks_cached(&cache, -2.123, 2.456, ctx), &ticks);
+    DvzAxesTicks expected = {0};
+    dvz_ticks_copy(&ticks, &expected);
+    uint32_t n = ticks.value_count;
+    for (int32_t shift = -3; shift <= 3; shift += 2)
+    {
+        dvz_ticks_shift(&ticks, shift);
+        dvz_ticks_shift(&expected, shift);
+        // Recompute all labels of the expected ticks.
+        expected.lmin_ex = expected.lmax_ex;
+        make_labels(&expected, &ctx, true);
+        AT(ticks.value_count == n);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            AC(ticks.values[i], expected.values[i], 1e-9);
+            AT(strcmp(
+                   &ticks.labels[i * MAX_GLYPHS_PER_TICK],
+                   &expected.labels[i * MAX_GLYPHS_PER_TICK]) == 0);
+        }
+        AT(!duplicate_labels(&ticks, &ctx));
+    }
+
+    dvz_ticks_destroy(&ticks);
+    dvz_ticks_destroy(&expected);
+    dvz_ticks_cache_destroy(&cache);
+    return 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  Scene tests                                                                                  */
 /*************************************************************************************************/
@@ -461,3 +531,486 @@ int test_scene_logistic(TestContext* context)
     dvz_scene_destroy(scene);
     TEST_END
 }
+
+
+
+int test_scene_lod(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+    DvzContext* ctx = gpu->context;
+    ASSERT(ctx != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_AXES_2D, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_LINE_STRIP, DVZ_VISUAL_FLAGS_LOD);
+    AT(visual->lod != NULL);
+
+    // Long noisy signal, far more samples than pixels.
+    const uint32_t N = 10000000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos[i][0] = i / 1000.0;
+        pos[i][1] = sin(i * .0001) + .1 * dvz_rand_normal();
+    }
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(visual, DVZ_PROP_COLOR, 0, 1, (cvec4[]){{255, 255, 255, 255}});
+
+    // Same signal in normalized coordinates, in a visual that is not transformed.
+    DvzVisual* visual_ndc = dvz_scene_visual(
+        panel, DVZ_VISUAL_LINE_STRIP, DVZ_VISUAL_FLAGS_LOD | DVZ_VISUAL_FLAGS_TRANSFORM_NONE);
+    AT(visual_ndc->lod != NULL);
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos[i][0] = -1 + 2.0 * i / N;
+        pos[i][1] *= .5;
+    }
+    dvz_visual_data(visual_ndc, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(visual_ndc, DVZ_PROP_COLOR, 0, 1, (cvec4[]){{255, 0, 0, 255}});
+
+    dvz_app_run(app, N_FRAMES);
+
+    // Only the decimated window has been uploaded.
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(source->arr.item_count < N);
+    AT(visual_ndc->lod->sample_count == N);
+    source = dvz_source_get(visual_ndc, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(source->arr.item_count < N);
+
+    dvz_visual_destroy(visual_ndc);
+    dvz_visual_destroy(visual);
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    TEST_END
+}
+
+
+
+int test_scene_culling(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+    DvzContext* ctx = gpu->context;
+    ASSERT(ctx != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    // NOTE: the positions are not renormalized, so that we know which markers are visible.
+    DvzVisual* visual = dvz_scene_visual(
+        panel, DVZ_VISUAL_MARKER, DVZ_VISUAL_FLAGS_CULLING | DVZ_VISUAL_FLAGS_TRANSFORM_NONE);
+    AT(visual->culling != NULL);
+    AT(visual->culling->size_offset > 0);
+
+    // Many markers, a quarter of them in the initial view, the others far outside of it.
+    const uint32_t N = 1000000;
+    const uint32_t N_visible = N / 4;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos[i][0] = -.5 + dvz_rand_float();
+        pos[i][1] = -.5 + dvz_rand_float();
+        if (i >= N_visible)
+            pos[i][i % 2] += i % 4 < 2 ? +10 : -10;
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, i, 0, N, color[i]);
+    }
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(visual, DVZ_PROP_COLOR, 0, N, color);
+    float size = 5;
+    dvz_visual_data(visual, DVZ_PROP_MARKER_SIZE, 0, 1, &size);
+
+    dvz_app_run(app, N_FRAMES);
+
+    // The index regions have been allocated by the culling pass.
+    AT(visual->culling->capacity >= N);
+    AT(visual->culling->br_index.count == canvas->swapchain.img_count);
+
+    // The culling pass of every swapchain image has kept the visible markers only.
+    VkDrawIndexedIndirectCommand cmd = {0};
+    uint32_t* indices = calloc(N, sizeof(uint32_t));
+    for (uint32_t i = 0; i < canvas->swapchain.img_count; i++)
+    {
+        download_region(canvas, visual->culling->br_indirect, i, 0, sizeof(cmd), &cmd);
+        AT(cmd.index_count == N_visible);
+        AT(cmd.instance_count == 1);
+
+        download_region(
+            canvas, visual->culling->br_index, i, 0, N_visible * sizeof(uint32_t), indices);
+        for (uint32_t j = 0; j < N_visible; j++)
+            AT(indices[j] < N_visible);
+    }
+
+    dvz_visual_destroy(visual);
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    FREE(color);
+    FREE(indices);
+    TEST_END
+}
+
+
+
+int test_scene_density(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+    DvzContext* ctx = gpu->context;
+    ASSERT(ctx != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_DENSITY, 0);
+
+    // The density image covers the panel viewport, in framebuffer pixels.
+    DvzViewport viewport = dvz_panel_viewport(panel);
+    const uint32_t W = (uint32_t)viewport.viewport.width;
+    const uint32_t H = (uint32_t)viewport.viewport.height;
+    AT(W >= 128 && H >= 64);
+
+    // Many overplotted points at the center of the pixels of a 64x32 block, so that the pixels
+    // do not depend on the rounding of the GPU, with weights exact in fixed point. The two last
+    // points fall in the same pixel and their sum saturates.
+    const uint32_t N = 100000;
+    dvec3* pos = calloc(N + 2, sizeof(dvec3));
+    float* weight = calloc(N + 2, sizeof(float));
+    uint64_t* expected = calloc(W * H, sizeof(uint64_t));
+    uint32_t px = 0, py = 0;
+    for (uint32_t i = 0; i < N + 2; i++)
+    {
+        px = i < N ? W / 4 + i % 64 : 1;
+        py = i < N ? H / 4 + (i / 64) % 32 : 1;
+        weight[i] = i < N ? .25f * (i % 5 + 1) : 2e8f;
+        // NOTE: identity MVP, and the y axis goes down in the Vulkan framebuffer.
+        pos[i][0] = +(2 * (px + .5) / W - 1);
+        pos[i][1] = -(2 * (py + .5) / H - 1);
+        expected[py * W + px] += (uint64_t)(weight[i] * 16);
+    }
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N + 2, pos);
+    dvz_visual_data(visual, DVZ_PROP_VALUE, 0, N + 2, weight);
+    DvzDensityNorm norm = DVZ_DENSITY_NORM_EQ_HIST;
+    dvz_visual_data(visual, DVZ_PROP_NORMALIZATION, 0, 1, &norm);
+
+    dvz_app_run(app, 5);
+
+    // The density image has been allocated and filled by the accumulation pass.
+    DvzVisualDensity* density = visual->density;
+    AT(density != NULL);
+    AT(density->norm == DVZ_DENSITY_NORM_EQ_HIST);
+    AT(density->capacity >= W * H);
+    AT(density->count == N + 2);
+    AT(density->br_density.count == 1);
+
+    // The density image matches the CPU accumulation, the pixel values saturate at UINT32_MAX.
+    const uint32_t header = 4 + 256;
+    uint32_t* data = calloc(header + W * H, sizeof(uint32_t));
+    dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_RENDER);
+    download_region(
+        canvas, density->br_density, 0, 0, (header + W * H) * sizeof(uint32_t), data);
+    AT(data[0] == UINT32_MAX);
+    AT(data[1] == DVZ_DENSITY_NORM_EQ_HIST);
+    AT(data[2] == W);
+    AT(data[3] == H);
+    for (uint32_t i = 0; i < W * H; i++)
+        AT(data[header + i] == (uint32_t)MIN(expected[i], UINT32_MAX));
+
+    // The points are not accumulated again while the data, the MVP, and the viewport are the
+    // same, only when the data changes.
+    uint64_t accumulate_count = density->accumulate_count;
+    AT(accumulate_count > 0);
+    dvz_app_run(app, 5);
+    AT(density->accumulate_count == accumulate_count);
+
+    dvz_visual_data(visual, DVZ_PROP_VALUE, 0, N + 2, weight);
+    dvz_app_run(app, 5);
+    AT(density->accumulate_count > accumulate_count);
+
+    dvz_visual_destroy(visual);
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    FREE(weight);
+    FREE(expected);
+    FREE(data);
+    TEST_END
+}
+
+
+
+int test_scene_tiles(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+    DvzContext* ctx = gpu->context;
+    ASSERT(ctx != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_IMAGE, DVZ_VISUAL_FLAGS_TILED);
+    AT(visual->tiles != NULL);
+
+    // Large RGBA gradient image, much larger than the tile cache.
+    const uint32_t W = 8192, H = 4096;
+    uint8_t* pixels = calloc(W * H, 4);
+    for (uint32_t i = 0; i < H; i++)
+    {
+        for (uint32_t j = 0; j < W; j++)
+        {
+            pixels[4 * (i * W + j) + 0] = (uint8_t)(j % 256);
+            pixels[4 * (i * W + j) + 1] = (uint8_t)(i % 256);
+            pixels[4 * (i * W + j) + 2] = (uint8_t)(255 * j / W);
+            pixels[4 * (i * W + j) + 3] = 255;
+        }
+    }
+    dvz_tiles_data(visual->tiles, W, H, 4, pixels);
+
+    // Top left, top right, bottom right, bottom left
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, 1, (dvec3[]){{-2, +1, 0}});
+    dvz_visual_data(visual, DVZ_PROP_POS, 1, 1, (dvec3[]){{+2, +1, 0}});
+    dvz_visual_data(visual, DVZ_PROP_POS, 2, 1, (dvec3[]){{+2, -1, 0}});
+    dvz_visual_data(visual, DVZ_PROP_POS, 3, 1, (dvec3[]){{-2, -1, 0}});
+
+    dvz_app_run(app, N_FRAMES);
+
+    // The visible tiles are drawn, possibly as coarser fallback tiles.
+    AT(visual->tiles->quad_count > 0);
+    AT(visual->tiles->quad_count <= DVZ_TILES_MAX_VISIBLE);
+
+    dvz_visual_destroy(visual);
+    dvz_scene_destroy(scene);
+    FREE(pixels);
+    TEST_END
+}
+
+
+
+int test_scene_bricks(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+    DvzContext* ctx = gpu->context;
+    ASSERT(ctx != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_ARCBALL, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_VOLUME, DVZ_VISUAL_FLAGS_BRICKED);
+    AT(visual->bricks != NULL);
+
+    // Sphere in an otherwise empty 16-bit volume.
+    const uint32_t N = 256;
+    uint16_t* voxels = calloc(N * N * N, sizeof(uint16_t));
+    double r = 0;
+    for (uint32_t z = 0; z < N; z++)
+    {
+        for (uint32_t y = 0; y < N; y++)
+        {
+            for (uint32_t x = 0; x < N; x++)
+            {
+                r = sqrt(pow(x - N / 2., 2) + pow(y - N / 2., 2) + pow(z - N / 2., 2));
+                if (r < N / 4.)
+                    voxels[(z * N + y) * N + x] = (uint16_t)(65535 * (1 - 4 * r / N));
+            }
+        }
+    }
+    dvz_bricks_data(visual->bricks, N, N, N, sizeof(uint16_t), voxels);
+    while (!dvz_bricks_ready(visual->bricks))
+        dvz_sleep(1);
+
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, 1, (dvec3[]){{-1, -1, -1}});
+    dvz_visual_data(visual, DVZ_PROP_POS, 1, 1, (dvec3[]){{+1, +1, +1}});
+    dvz_visual_data(visual, DVZ_PROP_LENGTH, 0, 1, (vec3){2, 2, 2});
+    dvz_visual_data(visual, DVZ_PROP_TRANSFER_X, 0, 1, (vec2){0, 1});
+    dvz_visual_texture(visual, DVZ_SOURCE_TYPE_COLOR_TEXTURE, 0, ctx->color_texture.texture);
+
+    dvz_app_run(app, N_FRAMES);
+
+    // Only the bricks intersecting the sphere are resident, the others are skipped.
+    DvzBricksLevel* level = &visual->bricks->levels[visual->bricks->level];
+    AT(visual->bricks->level == 0);
+    AT(level->filled_count > 0);
+    AT(level->filled_count < level->brick_count);
+
+    dvz_visual_destroy(visual);
+    dvz_scene_destroy(scene);
+    FREE(voxels);
+    TEST_END
+}
+
+
+
+int test_scene_profiler(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+    DvzProfiler* profiler = dvz_canvas_profiler(canvas);
+    AT(profiler != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_MARKER, DVZ_VISUAL_FLAGS_CULLING);
+
+    const uint32_t N = 100000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos[i][0] = dvz_rand_normal();
+        pos[i][1] = dvz_rand_normal();
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, i, 0, N, color[i]);
+    }
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(visual, DVZ_PROP_COLOR, 0, N, color);
+
+    dvz_app_run(app, N_FRAMES);
+
+    // CPU scopes of every frame.
+    AT(dvz_profiler_frame_count(profiler) > 0);
+    AT(dvz_profiler_stats(profiler, DVZ_PROFILER_DOMAIN_CPU, "refill", NULL) > 0);
+    AT(dvz_profiler_stats(profiler, DVZ_PROFILER_DOMAIN_CPU, "scene", NULL) > 0);
+
+    // GPU scopes, if the GPU supports timestamp queries.
+    double max = 0;
+    if (dvz_obj_is_created(&canvas->queries.obj))
+    {
+        AT(dvz_profiler_stats(profiler, DVZ_PROFILER_DOMAIN_GPU, "panel 0,0", &max) > 0);
+        AT(max > 0);
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/profiler_scene.json", ARTIFACTS_DIR);
+    AT(dvz_profiler_export(profiler, path) == 0);
+
+    dvz_visual_destroy(visual);
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    FREE(color);
+    TEST_END
+}
+
+
+
+int test_scene_bake_async(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_MARKER, DVZ_VISUAL_FLAGS_BAKE_ASYNC);
+
+    const uint32_t N = 1000000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    for (uint32_t i = 0; i < N; i++)
+    {
+        pos[i][0] = dvz_rand_normal();
+        pos[i][1] = dvz_rand_normal();
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, i, 0, N, color[i]);
+    }
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(visual, DVZ_PROP_COLOR, 0, N, color);
+
+    // The frames are rendered while the visual is baked in the background.
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(source != NULL);
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        dvz_app_run(app, 1);
+        if (!source->is_baking && source->arr.item_count == N &&
+            visual->obj.request != DVZ_VISUAL_REQUEST_UPLOAD)
+            break;
+    }
+    AT(atomic_load(&visual->bake.state) == DVZ_VISUAL_BAKE_NONE);
+    AT(!source->is_baking);
+    AT(source->arr.item_count == N);
+
+    // New data while the previous data remains visible.
+    for (uint32_t i = 0; i < N; i++)
+        pos[i][0] *= 2;
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_app_run(app, N_FRAMES);
+    dvz_visual_bake_wait(visual);
+    AT(source->arr.item_count == N);
+
+    dvz_visual_destroy(visual);
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    FREE(color);
+    TEST_END
+}
+
+
+
+static void _pick_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(ev.user_data != NULL);
+    DvzPickEvent* pick = (DvzPickEvent*)ev.user_data;
+    *pick = ev.u.p;
+    log_debug("picked visual %d, item %d", pick->visual, pick->item);
+}
+
+int test_scene_pick(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas =
+        dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS | DVZ_CANVAS_FLAGS_PICK);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+    AT(visual->pick_id > 0);
+
+    // Three points along the diagonal, the second one is at the center of the canvas.
+    dvec3 pos[] = {{-1, -1, 0}, {0, 0, 0}, {1, 1, 0}};
+    float size = 20;
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, 3, pos);
+    dvz_visual_data(visual, DVZ_PROP_COLOR, 0, 1, (cvec4[]){{255, 255, 255, 255}});
+    dvz_visual_data(visual, DVZ_PROP_MARKER_SIZE, 0, 1, &size);
+
+    DvzPickEvent pick = {0};
+    dvz_event_callback(canvas, DVZ_EVENT_PICK, 0, DVZ_EVENT_MODE_SYNC, _pick_callback, &pick);
+    dvz_app_run(app, 5);
+
+    // The PICK event is raised a few frames after the request, without stalling the rendering.
+    uvec2 size_screen = {0};
+    dvz_canvas_size(canvas, DVZ_CANVAS_SIZE_SCREEN, size_screen);
+    pick.item = UINT32_MAX;
+    dvz_canvas_pick(canvas, (vec2){size_screen[0] / 2.0f, size_screen[1] / 2.0f}, 8);
+    for (uint32_t i = 0; i < 100 && pick.item == UINT32_MAX; i++)
+        dvz_app_run(app, 1);
+    AT(pick.visual == visual->pick_id);
+    AT(pick.item == 1);
+
+    // Nothing in the top left corner of the canvas.
+    pick.item = UINT32_MAX;
+    dvz_canvas_pick(canvas, (vec2){1, 1}, 1);
+    for (uint32_t i = 0; i < 100 && pick.item == UINT32_MAX; i++)
+        dvz_app_run(app, 1);
+    AT(pick.visual == 0);
+
+    // An opaque triangle drawn after the points hides the point at the center.
+    DvzVisual* triangle = dvz_scene_visual(panel, DVZ_VISUAL_TRIANGLE, 0);
+    dvz_visual_data(triangle, DVZ_PROP_POS, 0, 1, (dvec3[]){{-.5, -.5, 0}});
+    dvz_visual_data(triangle, DVZ_PROP_POS, 1, 1, (dvec3[]){{+.5, -.5, 0}});
+    dvz_visual_data(triangle, DVZ_PROP_POS, 2, 1, (dvec3[]){{0, +.5, 0}});
+    dvz_visual_data(triangle, DVZ_PROP_COLOR, 0, 1, (cvec4[]){{255, 0, 0, 255}});
+    dvz_app_run(app, 5);
+
+    pick.item = UINT32_MAX;
+    dvz_canvas_pick(canvas, (vec2){size_screen[0] / 2.0f, size_screen[1] / 2.0f}, 8);
+    for (uint32_t i = 0; i < 100 && pick.item == UINT32_MAX; i++)
+        dvz_app_run(app, 1);
+    AT(pick.visual == 0);
+
+    dvz_visual_destroy(triangle);
+    dvz_visual_destroy(visual);
+    dvz_scene_destroy(scene);
+    TEST_END
+}
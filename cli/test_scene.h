@@ -12,12 +12,21 @@
 int test_axes_1(TestContext* context);
 int test_axes_2(TestContext* context);
 int test_axes_3(TestContext* context);
+int test_axes_4(TestContext* context);
 
 int test_scene_0(TestContext* context);
 int test_scene_1(TestContext* context);
 int test_scene_mesh(TestContext* context);
 int test_scene_axes(TestContext* context);
 int test_scene_logistic(TestContext* context);
+int test_scene_lod(TestContext* context);
+int test_scene_culling(TestContext* context);
+int test_scene_density(TestContext* context);
+int test_scene_tiles(TestContext* context);
+int test_scene_bricks(TestContext* context);
+int test_scene_profiler(TestContext* context);
+int test_scene_bake_async(TestContext* context);
+int test_scene_pick(TestContext* context);
 
 
 
@@ -366,3 +366,70 @@ int test_visuals_5(TestContext* context)
     dvz_visual_destroy(&visual);
     TEST_END
 }
+
+
+
+int test_visuals_6(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    DvzVisual visual = dvz_visual(canvas);
+    _marker_visual(&visual);
+
+    // Vertex data, written to a NPY file with a structured dtype matching the vertex struct.
+    const uint32_t N = 10;
+    DvzVertex vertices[10] = {0};
+    for (uint32_t i = 0; i < N; i++)
+    {
+        vertices[i].pos[0] = i;
+        vertices[i].color[0] = (uint8_t)(10 * i);
+        vertices[i].color[3] = 255;
+    }
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/test_stream.npy", ARTIFACTS_DIR);
+    write_npy(
+        path,
+        "{'descr': [('pos', '<f4', (3,)), ('color', '|u1', (4,))], 'fortran_order': False, "
+        "'shape': (10,), }",
+        sizeof(vertices), vertices);
+    DvzNpy* npy = dvz_npy(path);
+    AT(npy != NULL);
+
+    // Stream the file in chunks of 4 items, the last chunk is partial.
+    dvz_visual_npy(&visual, DVZ_SOURCE_TYPE_VERTEX, 0, npy);
+    DvzSource* source = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(source->stream_npy == npy);
+    AT(source->stream_count == N);
+    source->stream_chunk = 4;
+
+    uint32_t counts[] = {4, 8, 10};
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        AT(dvz_visual_stream(&visual));
+        AT(source->arr.item_count == counts[i]);
+    }
+    // The pages of the last chunk are released once it has been uploaded.
+    AT(!dvz_visual_stream(&visual));
+    AT(source->stream_released == N);
+
+    // The GPU buffer matches the file payload.
+    DvzVertex downloaded[10] = {0};
+    download_region(canvas, source->u.br, 0, 0, sizeof(downloaded), downloaded);
+    AT(memcmp(downloaded, vertices, sizeof(vertices)) == 0);
+    AT(memcmp(npy->data, vertices, sizeof(vertices)) == 0);
+    dvz_npy_destroy(npy);
+
+    // Multidimensional arrays in Fortran order are not streamed.
+    write_npy(
+        path, "{'descr': '<f4', 'fortran_order': True, 'shape': (10, 4), }", sizeof(vertices),
+        vertices);
+    npy = dvz_npy(path);
+    AT(npy != NULL);
+    dvz_visual_npy(&visual, DVZ_SOURCE_TYPE_VERTEX, 0, npy);
+    AT(source->stream_npy != npy);
+    dvz_npy_destroy(npy);
+
+    dvz_visual_destroy(&visual);
+    TEST_END
+}
@@ -658,19 +658,54 @@ int test_shader_compile(TestContext* context)
     dvz_gpu_queue(gpu, 0, DVZ_QUEUE_RENDER);
     dvz_gpu_create(gpu, VK_NULL_HANDLE);
 
-    VkShaderModule module = dvz_shader_compile(
-        gpu,
-        "#version 450\n"
-        "layout (location = 0) in vec3 pos;\n"
-        "layout (location = 1) in vec4 color;\n"
-        "layout (location = 0) out vec4 out_color;\n"
-        "void main() {\n"
-        "    gl_Position = vec4(pos, 1.0);\n"
-        "    out_color = color;\n"
-        "}",
-        VK_SHADER_STAGE_VERTEX_BIT);
+    const char* code = "#version 450\n"
+                       "layout (location = 0) in vec3 pos;\n"
+                       "layout (location = 1) in vec4 color;\n"
+                       "layout (location = 0) out vec4 out_color;\n"
+                       "void main() {\n"
+                       "    gl_Position = vec4(pos, 1.0);\n"
+                       "    out_color = color;\n"
+                       "}";
+    dvz_shader_cache_clear();
+    VkShaderModule module = dvz_shader_compile(gpu, code, VK_SHADER_STAGE_VERTEX_BIT);
+#if HAS_GLSLANG
+    AT(module != VK_NULL_HANDLE);
+    AT(dvz_shader_cache_count() == 1);
+#endif
     vkDestroyShaderModule(gpu->device, module, NULL);
 
+#if HAS_GLSLANG
+    // The second compilation of the same shader hits the cache.
+    uint64_t compile_count = dvz_shader_compile_count();
+    module = dvz_shader_compile(gpu, code, VK_SHADER_STAGE_VERTEX_BIT);
+    AT(module != VK_NULL_HANDLE);
+    AT(dvz_shader_cache_count() == 1);
+    AT(dvz_shader_compile_count() == compile_count);
+    vkDestroyShaderModule(gpu->device, module, NULL);
+
+    // Another stage is another cache entry.
+    module = dvz_shader_compile(
+        gpu, "#version 450\nvoid main() {}", VK_SHADER_STAGE_COMPUTE_BIT);
+    AT(module != VK_NULL_HANDLE);
+    AT(dvz_shader_cache_count() == 2);
+    vkDestroyShaderModule(gpu->device, module, NULL);
+
+    // After clearing the memory cache, the shader is loaded from the disk cache, without invoking
+    // the compiler.
+    dvz_shader_cache_clear();
+    AT(dvz_shader_cache_count() == 0);
+    compile_count = dvz_shader_compile_count();
+    module = dvz_shader_compile(gpu, code, VK_SHADER_STAGE_VERTEX_BIT);
+    AT(module != VK_NULL_HANDLE);
+    AT(dvz_shader_cache_count() == 1);
+    const char* disk_cache = getenv("DVZ_SHADER_CACHE");
+    char cache_path[1024];
+    if ((disk_cache == NULL || strcmp(disk_cache, "0") != 0) &&
+        dvz_cache_path("", cache_path, sizeof(cache_path)) == 0)
+        AT(dvz_shader_compile_count() == compile_count);
+    vkDestroyShaderModule(gpu->device, module, NULL);
+#endif
+
     TEST_END
 }
 
@@ -339,6 +339,40 @@ static void print_end(int index, int res)
 }
 
 
+// Download one of the regions of a set of buffer regions, once the app event loop has stopped.
+static void download_region(
+    DvzCanvas* canvas, DvzBufferRegions br, uint32_t idx, VkDeviceSize offset, VkDeviceSize size,
+    void* data)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(idx < br.count);
+    DvzBufferRegions region = br;
+    region.count = 1;
+    region.offsets[0] = br.offsets[idx];
+    dvz_download_buffers(canvas, region, offset, size, data);
+}
+
+
+
+// Write a NPY 1.0 file with the passed header dictionary and payload.
+static void write_npy(const char* path, const char* dict, uint32_t size, const void* data)
+{
+    // NPY 1.0 header, padded with spaces and a newline to a multiple of 64 bytes.
+    char header[128] = {0};
+    uint16_t len = (uint16_t)(128 - 10);
+    memset(header, ' ', sizeof(header));
+    memcpy(header, "\x93NUMPY\x01\x00", 8);
+    memcpy(&header[8], &len, 2);
+    memcpy(&header[10], dict, strlen(dict));
+    header[127] = '\n';
+
+    FILE* f = fopen(path, "wb");
+    fwrite(header, 1, sizeof(header), f);
+    fwrite(data, 1, size, f);
+    fclose(f);
+}
+
+
 
 /*************************************************************************************************/
 /*  Testing infrastructure                                                                       */
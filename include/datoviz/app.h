@@ -68,11 +68,14 @@ static inline void _clock_init(DvzClock* clock) { gettimeofday(&clock->start, NU
 
 
 
+// NOTE: the clock is not modified, so that it can be read from other threads than the one
+// calling _clock_set().
 static inline double _clock_get(DvzClock* clock)
 {
-    gettimeofday(&clock->current, NULL);
-    double elapsed = (clock->current.tv_sec - clock->start.tv_sec) +
-                     (clock->current.tv_usec - clock->start.tv_usec) / 1000000.0;
+    struct timeval current = {0};
+    gettimeofday(&current, NULL);
+    double elapsed = (current.tv_sec - clock->start.tv_sec) +
+                     (current.tv_usec - clock->start.tv_usec) / 1000000.0;
     return elapsed;
 }
 
@@ -81,7 +84,9 @@ static inline double _clock_get(DvzClock* clock)
 static inline void _clock_set(DvzClock* clock)
 {
     // Typically called at every frame.
-    double elapsed = _clock_get(clock);
+    gettimeofday(&clock->current, NULL);
+    double elapsed = (clock->current.tv_sec - clock->start.tv_sec) +
+                     (clock->current.tv_usec - clock->start.tv_usec) / 1000000.0;
     clock->interval = elapsed - clock->elapsed;
     clock->elapsed = elapsed;
 }
@@ -103,6 +108,7 @@ struct DvzApp
     // Global clock
     DvzClock clock;
     bool is_running;
+    bool is_parallel; // one frame thread per canvas, see dvz_app_parallel()
 
     // Vulkan objects.
     VkInstance instance;
@@ -115,6 +121,11 @@ struct DvzApp
 
     // Threads.
     DvzThread timer_thread;
+
+    // Wait of the idle main loop with on-demand rendering, see dvz_canvas_redraw().
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle_cond;
+    uint64_t idle_seq; // incremented at every wake-up
 };
 
 
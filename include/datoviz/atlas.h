@@ -5,6 +5,8 @@
 #ifndef DVZ_FONT_ATLAS_HEADER
 #define DVZ_FONT_ATLAS_HEADER
 
+#include <sys/stat.h>
+
 #include "common.h"
 #include "context.h"
 
@@ -25,19 +27,44 @@ static const char DVZ_FONT_ATLAS_STRING[] =
 
 
 
-static size_t _font_atlas_glyph(DvzFontAtlas* atlas, const char* str, uint32_t idx)
+// Decoded font atlas cache file in the user cache directory, so that the PNG is only decoded once.
+#define DVZ_FONT_ATLAS_CACHE_MAGIC 0x41544c44 // "DLTA"
+
+typedef struct DvzFontAtlasCacheHeader DvzFontAtlasCacheHeader;
+
+struct DvzFontAtlasCacheHeader
+{
+    uint32_t magic;
+    uint32_t width, height;
+    uint32_t reserved;
+};
+
+
+
+// Build the table mapping every byte to its glyph index in the atlas, so that the glyph lookup
+// does not depend on the length of the atlas string.
+static void _font_atlas_map(DvzFontAtlas* atlas)
 {
     ASSERT(atlas != NULL);
-    ASSERT(atlas->rows > 0);
-    ASSERT(atlas->cols > 0);
-    ASSERT(str != NULL);
-    ASSERT(strlen(str) > 0);
-    ASSERT(idx < strlen(str));
     ASSERT(atlas->font_str != NULL);
-    ASSERT(strlen(atlas->font_str) > 0);
+    uint32_t n = (uint32_t)strlen(atlas->font_str);
+    ASSERT(n > 0);
+    ASSERT(n < 256);
+
+    // NOTE: characters missing from the atlas are mapped to the index past the last glyph, like
+    // strcspn() used to do.
+    memset(atlas->glyph_map, (int)n, sizeof(atlas->glyph_map));
+    for (int32_t i = (int32_t)n - 1; i >= 0; i--)
+        atlas->glyph_map[(uint8_t)atlas->font_str[i]] = (uint8_t)i;
+}
+
+
 
-    char c[2] = {str[idx], 0};
-    return strcspn(atlas->font_str, c);
+static inline size_t _font_atlas_glyph(DvzFontAtlas* atlas, const char* str, uint32_t idx)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(str != NULL);
+    return atlas->glyph_map[(uint8_t)str[idx]];
 }
 
 
@@ -71,24 +98,108 @@ static DvzTexture* _font_texture(DvzContext* ctx, DvzFontAtlas* atlas)
 
 
 
+// Load the decoded atlas from the cache file, if it is more recent than the PNG file.
+static uint8_t* _font_atlas_cache_load(const char* path, const char* cache_path, int* w, int* h)
+{
+    ASSERT(path != NULL);
+    ASSERT(cache_path != NULL);
+
+    struct stat png_stat, cache_stat;
+    if (stat(cache_path, &cache_stat) != 0)
+        return NULL;
+    if (stat(path, &png_stat) == 0 && png_stat.st_mtime > cache_stat.st_mtime)
+        return NULL;
+
+    FILE* fp = fopen(cache_path, "rb");
+    if (fp == NULL)
+        return NULL;
+    DvzFontAtlasCacheHeader header = {0};
+    uint8_t* pixels = NULL;
+    if (fread(&header, sizeof(header), 1, fp) == 1 &&
+        header.magic == DVZ_FONT_ATLAS_CACHE_MAGIC && header.width > 0 && header.height > 0)
+    {
+        size_t size = (size_t)header.width * header.height * 4;
+        pixels = (uint8_t*)malloc(size);
+        if (fread(pixels, 1, size, fp) != size)
+        {
+            FREE(pixels);
+        }
+        else
+        {
+            *w = (int)header.width;
+            *h = (int)header.height;
+        }
+    }
+    fclose(fp);
+    return pixels;
+}
+
+
+
+static void _font_atlas_cache_save(const char* cache_path, int w, int h, const uint8_t* pixels)
+{
+    ASSERT(cache_path != NULL);
+    ASSERT(pixels != NULL);
+
+    // The file is written to a temporary file renamed at the end, so that another process never
+    // loads a file half written. The cache directory may be read-only, the cache is then simply
+    // not used.
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path);
+    FILE* fp = fopen(tmp_path, "wb");
+    if (fp == NULL)
+    {
+        log_debug("unable to write the font atlas cache %s", cache_path);
+        return;
+    }
+    DvzFontAtlasCacheHeader header = {DVZ_FONT_ATLAS_CACHE_MAGIC, (uint32_t)w, (uint32_t)h, 0};
+    size_t size = (size_t)w * h * 4;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(pixels, 1, size, fp) == size;
+    ok = fclose(fp) == 0 && ok;
+#if OS_WIN32
+    // NOTE: rename() does not replace an existing file on Windows.
+    if (ok)
+        remove(cache_path);
+#endif
+    if (!ok || rename(tmp_path, cache_path) != 0)
+    {
+        log_debug("unable to write the font atlas cache %s", cache_path);
+        remove(tmp_path);
+    }
+}
+
+
+
 static DvzFontAtlas dvz_font_atlas(DvzContext* ctx)
 {
     // Font texture
     char path[1024];
     snprintf(path, sizeof(path), "%s/textures/%s", DATA_DIR, "font_inconsolata.png");
-    ASSERT(path != NULL);
+    char cache_path[1024];
+    bool has_cache = dvz_cache_path("font_inconsolata.rgba", cache_path, sizeof(cache_path)) == 0;
 
-    int width, height, depth;
+    int width = 0, height = 0, depth = 4;
 
+    // NOTE: stbi_load() allocates with malloc() like the cache loader, so that the pixels are
+    // freed the same way.
     DvzFontAtlas atlas = {0};
-    atlas.font_texture = stbi_load(path, &width, &height, &depth, STBI_rgb_alpha);
+    if (has_cache)
+        atlas.font_texture = _font_atlas_cache_load(path, cache_path, &width, &height);
+    if (atlas.font_texture == NULL)
+    {
+        log_debug("decoding the font atlas %s", path);
+        atlas.font_texture = stbi_load(path, &width, &height, &depth, STBI_rgb_alpha);
+        ASSERT(atlas.font_texture != NULL);
+        if (has_cache)
+            _font_atlas_cache_save(cache_path, width, height, atlas.font_texture);
+    }
     ASSERT(width > 0);
     ASSERT(height > 0);
     ASSERT(depth > 0);
 
     // TODO: parameters
     atlas.font_str = DVZ_FONT_ATLAS_STRING;
-    ASSERT(strlen(atlas.font_str) > 0);
+    _font_atlas_map(&atlas);
     atlas.cols = 16;
     atlas.rows = 6;
 
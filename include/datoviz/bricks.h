@@ -0,0 +1,245 @@
+/*************************************************************************************************/
+/*  Bricked storage and brick cache for very large volumes                                       */
+/*************************************************************************************************/
+
+#ifndef DVZ_BRICKS_HEADER
+#define DVZ_BRICKS_HEADER
+
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+// NOTE: the brick sizes and the atlas layout must match graphics_volume.frag.
+#define DVZ_BRICKS_SIZE          30 // number of voxels per brick side
+#define DVZ_BRICKS_GUTTER        1  // voxels copied from the neighbor bricks on each side
+#define DVZ_BRICKS_SLOT_SIZE     (DVZ_BRICKS_SIZE + 2 * DVZ_BRICKS_GUTTER)
+#define DVZ_BRICKS_ATLAS_X       16 // number of brick slots along each axis of the atlas texture
+#define DVZ_BRICKS_ATLAS_Y       16
+#define DVZ_BRICKS_ATLAS_Z       4
+#define DVZ_BRICKS_SLOT_COUNT    (DVZ_BRICKS_ATLAS_X * DVZ_BRICKS_ATLAS_Y * DVZ_BRICKS_ATLAS_Z)
+#define DVZ_BRICKS_SLOT_VOXELS                                                                    \
+    (DVZ_BRICKS_SLOT_SIZE * DVZ_BRICKS_SLOT_SIZE * DVZ_BRICKS_SLOT_SIZE)
+#define DVZ_BRICKS_MAX_UPLOADS   32   // maximum number of bricks uploaded per frame
+#define DVZ_BRICKS_MAX_LEVELS    16
+#define DVZ_BRICKS_THREADS       4    // number of worker threads per pyramid level
+#define DVZ_BRICKS_TRANSFER_SIZE 256  // resolution of the CPU copy of the transfer function
+#define DVZ_BRICKS_TRANSFER_LOG  9    // log2(DVZ_BRICKS_TRANSFER_SIZE) + 1
+#define DVZ_BRICKS_EMPTY_ALPHA   1e-3 // bricks with a lower maximal alpha value are skipped
+
+
+
+/*************************************************************************************************/
+/*  Typedefs                                                                                     */
+/*************************************************************************************************/
+
+typedef struct DvzBricks DvzBricks;
+typedef struct DvzBricksLevel DvzBricksLevel;
+typedef struct DvzBricksSlot DvzBricksSlot;
+typedef struct DvzBrickRange DvzBrickRange;
+
+
+
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
+
+// Range of the voxel values of a brick, including its gutter, normalized to 16 bits.
+struct DvzBrickRange
+{
+    uint16_t min, max;
+};
+
+
+
+struct DvzBricksLevel
+{
+    uint32_t width, height, depth; // size of the level volume, in voxels
+    uint32_t cols, rows, layers;   // number of bricks along each axis
+    uint32_t brick_count;
+    uint16_t* voxels;      // level volume (NULL for level 0, which refers to the original volume)
+    DvzBrickRange* range;  // per-brick range of values
+    bool* is_empty;        // per-brick classification with the current transfer function
+    uint32_t filled_count; // number of non-empty bricks
+    int32_t* slot;         // per-brick slot in the atlas, or -1
+};
+
+
+
+struct DvzBricksSlot
+{
+    uint32_t level, brick;
+    bool is_used;
+    uint64_t frame; // last frame during which the brick was part of the page table
+};
+
+
+
+struct DvzBricks
+{
+    DvzObject obj;
+
+    // Original volume, x varying fastest, NOT owned by the pyramid.
+    uint32_t width, height, depth;
+    uint32_t item_size; // 1 (uint8) or 2 (uint16)
+    const void* voxels;
+
+    uint32_t level_count;
+    DvzBricksLevel levels[DVZ_BRICKS_MAX_LEVELS];
+
+    DvzThread thread;
+    atomic(uint32_t, levels_ready); // number of levels, from the finest, already built
+    atomic(bool, is_building);
+    atomic(bool, to_stop);
+
+    // CPU copy of the transfer function used to classify the bricks.
+    vec2 transfer_xrange;
+    // Texture and texture version the values were copied from, set by the caller.
+    const void* transfer_texture;
+    uint64_t transfer_version;
+    // transfer[k][i] is the maximum of the values i to i + 2^k - 1, for constant-time range maxima
+    float transfer[DVZ_BRICKS_TRANSFER_LOG][DVZ_BRICKS_TRANSFER_SIZE];
+    uint32_t classified; // number of levels classified with the current transfer function
+
+    // Brick cache, its slots map to cubic regions of a 3D atlas texture.
+    uint64_t frame;
+    DvzBricksSlot slots[DVZ_BRICKS_SLOT_COUNT];
+    uint16_t* slot_voxels; // CPU copy of the slot contents, to be uploaded to the atlas
+
+    // Slots filled during the last update, to be uploaded by the caller.
+    uint32_t upload_count;
+    uint32_t uploads[DVZ_BRICKS_MAX_UPLOADS];
+
+    // Page table of the current level: one RGBA texel per brick with the atlas slot coordinates.
+    // The alpha component is 255 for the resident non-empty bricks, 0 for the skipped bricks, and
+    // d > 0 for the non-empty bricks that are not resident yet and are drawn with the resident
+    // brick d levels coarser that contains them. Double-buffered as the upload of the previous
+    // page table may still be pending.
+    uint32_t level;
+    uint8_t* page[2];
+    uint32_t page_idx;
+    bool is_complete; // whether all non-empty bricks of the current level are resident
+};
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+/**
+ * Create an empty bricked volume.
+ *
+ * @returns a pointer to the bricked volume
+ */
+DVZ_EXPORT DvzBricks* dvz_bricks(void);
+
+/**
+ * Set the volume and start computing its bricks and pyramid in a background thread.
+ *
+ * The per-brick ranges of the full-resolution volume are computed first, in parallel, then each
+ * coarser level. The volume is not copied and must remain valid and unchanged until the
+ * computation is stopped or the bricked volume is destroyed.
+ *
+ * @param bricks the bricked volume
+ * @param width the volume width, in voxels
+ * @param height the volume height, in voxels
+ * @param depth the volume depth, in voxels
+ * @param item_size the number of bytes per voxel, 1 (uint8) or 2 (uint16)
+ * @param voxels the volume, x varying fastest, then y, then z
+ */
+DVZ_EXPORT void dvz_bricks_data(
+    DvzBricks* bricks, uint32_t width, uint32_t height, uint32_t depth, uint32_t item_size,
+    const void* voxels);
+
+/**
+ * Stop the background computation and wait for the background thread.
+ *
+ * @param bricks the bricked volume
+ */
+DVZ_EXPORT void dvz_bricks_stop(DvzBricks* bricks);
+
+/**
+ * Whether all pyramid levels have been built.
+ *
+ * @param bricks the bricked volume
+ * @returns a boolean
+ */
+DVZ_EXPORT bool dvz_bricks_ready(DvzBricks* bricks);
+
+/**
+ * Set the transfer function used to skip the empty bricks.
+ *
+ * A brick is empty when the transfer function maps all of its values to an alpha value below
+ * DVZ_BRICKS_EMPTY_ALPHA. The values are those of the transfer function texture of the volume
+ * visual, between the two x coordinates of the transfer function. When both x coordinates are
+ * equal, the transfer function is disabled and the alpha value is the normalized voxel value.
+ *
+ * @param bricks the bricked volume
+ * @param xrange the x coordinates of the endpoints of the transfer function
+ * @param count the number of values, 0 to keep the current values (by default, linear)
+ * @param values the transfer function values
+ */
+DVZ_EXPORT void
+dvz_bricks_transfer(DvzBricks* bricks, vec2 xrange, uint32_t count, const float* values);
+
+/**
+ * Update the level, the brick cache, and the page table.
+ *
+ * The level is the finest built level whose non-empty bricks fit in the atlas. At most
+ * DVZ_BRICKS_MAX_UPLOADS missing bricks are loaded per call, in the least recently used slots.
+ * The slots to upload are listed in `bricks->uploads`. Once the pyramid is built, the bricks of
+ * the coarsest level are loaded first and always kept resident, so that the missing bricks of
+ * the current level are drawn at a coarser resolution while they stream in.
+ *
+ * @param bricks the bricked volume
+ * @returns whether the page table changed and needs to be uploaded
+ */
+DVZ_EXPORT bool dvz_bricks_update(DvzBricks* bricks);
+
+/**
+ * Return the current page table, with one RGBA texel per brick of the current level.
+ *
+ * @param bricks the bricked volume
+ * @returns a pointer to the page table
+ */
+DVZ_EXPORT uint8_t* dvz_bricks_page(DvzBricks* bricks);
+
+/**
+ * Return the offset of a slot in the atlas texture, in voxels.
+ *
+ * @param slot the slot index
+ * @param[out] offset the offset
+ */
+DVZ_EXPORT void dvz_bricks_slot_offset(uint32_t slot, uvec3 offset);
+
+/**
+ * Return the CPU copy of a slot, with DVZ_BRICKS_SLOT_VOXELS voxels.
+ *
+ * @param bricks the bricked volume
+ * @param slot the slot index
+ * @returns a pointer to the slot voxels
+ */
+DVZ_EXPORT uint16_t* dvz_bricks_slot_voxels(DvzBricks* bricks, uint32_t slot);
+
+/**
+ * Destroy a bricked volume.
+ *
+ * @param bricks the bricked volume
+ */
+DVZ_EXPORT void dvz_bricks_destroy(DvzBricks* bricks);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
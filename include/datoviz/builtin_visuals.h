@@ -75,6 +75,10 @@ typedef enum
     DVZ_VISUAL_AXES_3D,
     DVZ_VISUAL_COLORMAP,
 
+    DVZ_VISUAL_MARKER_CMAP,
+    DVZ_VISUAL_MESH_INSTANCED,
+    DVZ_VISUAL_DENSITY,
+
     DVZ_VISUAL_COUNT,
 
     DVZ_VISUAL_CUSTOM,
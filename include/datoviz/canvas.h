@@ -8,6 +8,7 @@
 #include "context.h"
 #include "fifo.h"
 #include "keycode.h"
+#include "profiler.h"
 #include "transfers.h"
 #include "vklite.h"
 
@@ -24,6 +25,8 @@ extern "C" {
 #define DVZ_MAX_EVENT_CALLBACKS 32
 // Maximum acceptable duration for the pending events in the event queue, in seconds
 #define DVZ_MAX_EVENT_DURATION .5
+// Maximum number of pending async events of each type
+#define DVZ_EVENT_QUEUE_CAPACITY 32
 #define DVZ_DEFAULT_BACKGROUND                                                                    \
     (VkClearColorValue)                                                                           \
     {                                                                                             \
@@ -42,6 +45,19 @@ extern "C" {
 #define DVZ_DEFAULT_COMMANDS_RENDER   1
 #define DVZ_MAX_FRAMES_IN_FLIGHT      2
 
+// Batch rendering.
+#define DVZ_BATCH_MAX_SLOTS    8 // maximum number of frames being read back at the same time
+#define DVZ_BATCH_THREADS      4 // number of image encoding threads
+#define DVZ_BATCH_PATH_SIZE    1024
+#define DVZ_BATCH_JPEG_QUALITY 90
+
+// Object picking.
+#define DVZ_PICK_FORMAT   VK_FORMAT_R32G32_UINT // visual id and item index
+#define DVZ_PICK_MAX_SIZE 32                    // maximum size of a pick region, in pixels
+
+// On-demand rendering.
+#define DVZ_IDLE_MAX_WAIT .1 // maximum blocking time of an idle iteration, in seconds
+
 
 
 /*************************************************************************************************/
@@ -53,7 +69,14 @@ typedef enum
 {
     DVZ_CANVAS_FLAGS_NONE = 0x0000,
     DVZ_CANVAS_FLAGS_IMGUI = 0x0001,
-    DVZ_CANVAS_FLAGS_FPS = 0x0003, // NOTE: 1 bit for ImGUI, 1 bit for FPS
+    DVZ_CANVAS_FLAGS_FPS = 0x0003,       // NOTE: 1 bit for ImGUI, 1 bit for FPS
+    DVZ_CANVAS_FLAGS_PICK = 0x0010,      // object picking attachment
+    DVZ_CANVAS_FLAGS_ON_DEMAND = 0x0020, // render a frame only when needed
+
+    // NOTE: the highest sample count supported by the device is used if lower.
+    DVZ_CANVAS_FLAGS_MSAA_2 = 0x0100,
+    DVZ_CANVAS_FLAGS_MSAA_4 = 0x0200,
+    DVZ_CANVAS_FLAGS_MSAA_8 = 0x0300,
 
     DVZ_CANVAS_FLAGS_DPI_SCALE_050 = 0x1000,
     DVZ_CANVAS_FLAGS_DPI_SCALE_100 = 0x2000,
@@ -72,6 +95,18 @@ typedef enum
 
 
 
+// State of the frame thread of a canvas, in parallel mode.
+typedef enum
+{
+    DVZ_FRAME_STATE_NONE,
+    DVZ_FRAME_STATE_RUNNING,  // the frame thread processes frames
+    DVZ_FRAME_STATE_RECREATE, // the frame thread waits for the main thread to recreate the canvas
+    DVZ_FRAME_STATE_STOP,     // the main thread asks the frame thread to stop
+    DVZ_FRAME_STATE_DONE,     // the frame thread has processed all of its frames
+} DvzFrameState;
+
+
+
 // Viewport type.
 // NOTE: must correspond to values in common.glsl
 typedef enum
@@ -156,6 +191,17 @@ typedef enum
 
 
 
+// Image file format of the frames rendered in batch mode.
+typedef enum
+{
+    DVZ_IMAGE_FORMAT_RAW,  // flat RGB bytes, without header
+    DVZ_IMAGE_FORMAT_PPM,  //
+    DVZ_IMAGE_FORMAT_PNG,  // requires libpng
+    DVZ_IMAGE_FORMAT_JPEG, // requires libjpeg
+} DvzImageFormat;
+
+
+
 /*************************************************************************************************/
 /*  Event system                                                                                 */
 /*************************************************************************************************/
@@ -192,6 +238,8 @@ typedef enum
     DVZ_EVENT_PRE_SEND,           // called before sending the commands buffers
     DVZ_EVENT_POST_SEND,          // called after sending the commands buffers
     DVZ_EVENT_DESTROY,            // called before destruction
+    DVZ_EVENT_PICK,               // called when a pick request has been read back
+    DVZ_EVENT_COUNT,              // number of event types
 } DvzEventType;
 
 
@@ -205,6 +253,16 @@ typedef enum
 
 
 
+// Priority of the async events, the pending events with the highest priority are processed first
+typedef enum
+{
+    DVZ_EVENT_PRIORITY_LOW,
+    DVZ_EVENT_PRIORITY_NORMAL,
+    DVZ_EVENT_PRIORITY_HIGH,
+} DvzEventPriority;
+
+
+
 // Key modifiers
 // NOTE: must match GLFW values! no mapping is done for now
 typedef enum
@@ -247,6 +305,7 @@ typedef struct DvzMouseClickEvent DvzMouseClickEvent;
 typedef struct DvzMouseDragEvent DvzMouseDragEvent;
 typedef struct DvzMouseMoveEvent DvzMouseMoveEvent;
 typedef struct DvzMouseWheelEvent DvzMouseWheelEvent;
+typedef struct DvzPickEvent DvzPickEvent;
 typedef struct DvzRefillEvent DvzRefillEvent;
 typedef struct DvzResizeEvent DvzResizeEvent;
 typedef struct DvzScreencastEvent DvzScreencastEvent;
@@ -258,8 +317,13 @@ typedef union DvzEventUnion DvzEventUnion;
 
 typedef void (*DvzEventCallback)(DvzCanvas*, DvzEvent);
 typedef struct DvzEventCallbackRegister DvzEventCallbackRegister;
+typedef struct DvzEventQueue DvzEventQueue;
+typedef struct DvzPendingInput DvzPendingInput;
 
 typedef struct DvzScreencast DvzScreencast;
+typedef struct DvzBatch DvzBatch;
+typedef struct DvzBatchSlot DvzBatchSlot;
+typedef struct DvzPick DvzPick;
 typedef struct DvzPendingRefill DvzPendingRefill;
 
 // Forward declarations.
@@ -341,6 +405,9 @@ struct DvzViewport
     // Used to discard transform on one axis
     int32_t interact_axis;
 
+    // Object picking id of the visual, written in the picking attachment
+    uint32_t pick_id;
+
     // TODO: aspect ratio
 };
 
@@ -432,6 +499,16 @@ struct DvzScreencastEvent
 
 
 
+struct DvzPickEvent
+{
+    vec2 pos;        // requested position, in screen coordinates
+    uvec2 pixel;     // position of the picked pixel, in framebuffer coordinates
+    uint32_t visual; // pick id of the visual, 0 if there is no visual in the region
+    uint32_t item;   // index of the item (vertex) within the visual
+};
+
+
+
 struct DvzRefillEvent
 {
     uint32_t img_idx;
@@ -481,6 +558,7 @@ union DvzEventUnion
     DvzScreencastEvent sc; // for SCREENCAST events
     DvzSubmitEvent s;      // for SUBMIT events
     DvzGuiEvent g;         // for GUI events
+    DvzPickEvent p;        // for PICK events
 };
 
 
@@ -506,6 +584,33 @@ struct DvzEventCallbackRegister
 
 
 
+// Ring buffer of the pending async events of a given type.
+struct DvzEventQueue
+{
+    DvzEventPriority priority;
+    double deadline; // maximum age of the pending events, in seconds, 0 for no limit
+    bool coalesce;   // whether a new event is merged into the pending event of the same type
+
+    uint32_t head, count;
+    DvzEvent events[DVZ_EVENT_QUEUE_CAPACITY];
+    double times[DVZ_EVENT_QUEUE_CAPACITY]; // time at which the events were enqueued
+    uint64_t discarded;                     // number of events dropped as they were too old
+    uint64_t barrier;                       // number of mouse button events before the last event
+};
+
+
+
+// Input events received by the backend since the last frame, merged into one event per type.
+struct DvzPendingInput
+{
+    bool has_move, has_wheel;
+    vec2 pos;       // latest cursor position
+    vec2 wheel_dir; // sum of the wheel deltas
+    int modifiers;
+};
+
+
+
 /*************************************************************************************************/
 /*  Misc structs                                                                                 */
 /*************************************************************************************************/
@@ -530,6 +635,73 @@ struct DvzScreencast
 
 
 
+// Readback slot of the batch rendering mode: a staging image with its copy command buffer.
+struct DvzBatchSlot
+{
+    DvzBatch* batch;
+    DvzImages staging;
+    DvzCommands cmds;
+    DvzFences fence; // signaled when the copy to the staging image is done
+
+    // Frame being read back, protected by the batch lock.
+    bool busy;
+    uint64_t idx;
+    DvzImageFormat format;
+    char path[DVZ_BATCH_PATH_SIZE];
+};
+
+
+
+struct DvzBatch
+{
+    DvzObject obj;
+    DvzCanvas* canvas;
+
+    uint32_t slot_count, cur_slot;
+    DvzBatchSlot slots[DVZ_BATCH_MAX_SLOTS];
+    DvzSubmit submit;
+
+    // Encoding thread pool, the rendered slots are enqueued in the FIFO queue.
+    DvzFifo jobs;
+    DvzThread threads[DVZ_BATCH_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    // Statistics.
+    DvzClock clock;
+    uint64_t rendered, written, failed;
+    double elapsed; // time between the first render and the last written file
+};
+
+
+
+// Object picking: the picking attachment is copied to the host, one small region at a time.
+struct DvzPick
+{
+    DvzImages image;      // single-sampled picking attachment
+    DvzImages msaa_image; // multisampled picking attachment, resolved into the image
+    DvzBuffer staging;    // host-visible copy of the requested region
+    DvzCommands cmds;
+    DvzFences fence; // signaled when the region has been copied to the staging buffer
+    DvzSubmit submit;
+    uint32_t id_count; // last visual pick id, 0 is reserved for the background
+
+    // Latest pick request, protected by the lock.
+    pthread_mutex_t lock;
+    bool requested;
+    vec2 pos;
+    uint32_t size;
+
+    // Region being copied.
+    bool pending;
+    vec2 pending_pos;
+    ivec3 offset;
+    uvec3 shape;
+    uvec2 center;
+};
+
+
+
 struct DvzPendingRefill
 {
     bool completed[DVZ_MAX_SWAPCHAIN_IMAGES];
@@ -560,11 +732,18 @@ struct DvzCanvas
     atomic(DvzObjectStatus, cur_status);
     atomic(bool, to_close);
 
+    // On-demand rendering, the frames are only rendered when needed.
+    bool on_demand;
+    atomic(bool, redraw); // a new frame has been requested, see dvz_canvas_redraw()
+
     DvzWindow* window;
 
     // Swapchain.
     DvzSwapchain swapchain;
     DvzImages depth_image;
+    DvzImages msaa_image; // multisampled color attachment, resolved into the swapchain image
+    VkSampleCountFlagBits samples;
+    DvzPick pick;
     DvzFramebuffers framebuffers;
     DvzFramebuffers framebuffers_overlay; // used by the overlay renderpass
     DvzSubmit submit;
@@ -606,9 +785,14 @@ struct DvzCanvas
     uint32_t callbacks_count;
     DvzEventCallbackRegister callbacks[DVZ_MAX_EVENT_CALLBACKS];
 
-    // Event queue.
-    DvzFifo event_queue;
-    DvzEvent events[DVZ_MAX_FIFO_CAPACITY];
+    // Async event queues, one per event type, processed by priority in the background thread.
+    DvzEventQueue event_queues[DVZ_EVENT_COUNT];
+    pthread_mutex_t event_lock;
+    pthread_cond_t event_cond;
+    DvzClock event_clock;
+    uint64_t event_buttons; // number of mouse button events enqueued, moves are not merged across
+    bool event_stop;
+    DvzPendingInput input;
     DvzThread event_thread;
     bool enable_lock;
     atomic(DvzEventType, event_processing);
@@ -626,6 +810,19 @@ struct DvzCanvas
 
     DvzViewport viewport;
     DvzScene* scene;
+
+    // Profiler, NULL unless enabled, and GPU timestamps of the profiled command buffers.
+    DvzProfiler* profiler;
+    DvzQueries queries;
+
+    // Frame thread in parallel mode. The frame lock is held while processing a frame, and by the
+    // main thread while processing the window events and recreating the canvas.
+    DvzThread frame_thread;
+    pthread_mutex_t frame_lock;
+    pthread_cond_t frame_cond;
+    atomic(DvzFrameState, frame_state);
+    uint64_t frame_count; // number of frames to process
+    vec2 cursor_pos;      // cursor position, polled by the main thread
 };
 
 
@@ -796,6 +993,17 @@ DVZ_EXPORT void dvz_canvas_to_refill(DvzCanvas* canvas);
  */
 DVZ_EXPORT void dvz_canvas_to_close(DvzCanvas* canvas);
 
+/**
+ * Request a new frame of a canvas created with the DVZ_CANVAS_FLAGS_ON_DEMAND flag.
+ *
+ * Input events, data transfers, canvas refills, resizes, and TIMER callbacks already trigger a
+ * new frame. This function is only required after other changes, for example a camera change
+ * made by the user. It is thread-safe and wakes up the idle main loop.
+ *
+ * @param canvas the canvas
+ */
+DVZ_EXPORT void dvz_canvas_redraw(DvzCanvas* canvas);
+
 
 
 /*************************************************************************************************/
@@ -858,6 +1066,86 @@ DVZ_EXPORT void dvz_screenshot_file(DvzCanvas* canvas, const char* png_path);
 
 
 
+/*************************************************************************************************/
+/*  Batch rendering                                                                              */
+/*************************************************************************************************/
+
+/**
+ * Prepare an offscreen canvas for batch rendering of many images.
+ *
+ * Each rendered frame is copied to one of several staging images, which are read back and saved
+ * to files by a pool of encoding threads, so that the next frames are rendered while the previous
+ * ones are downloaded and encoded. The canvas must not be run with `dvz_app_run()` while the batch
+ * is active.
+ *
+ * @param canvas the offscreen canvas
+ * @param slot_count the number of frames that may be read back at the same time, at most
+ *     DVZ_BATCH_MAX_SLOTS
+ * @returns a pointer to the batch
+ */
+DVZ_EXPORT DvzBatch* dvz_batch(DvzCanvas* canvas, uint32_t slot_count);
+
+/**
+ * Render a frame and save it asynchronously to an image file.
+ *
+ * The FRAME callbacks are called before rendering, so that they can update the scene for each
+ * image. This function only blocks when all readback slots are busy.
+ *
+ * @param batch the batch
+ * @param format the image file format
+ * @param path the path to the image file to create
+ * @returns the index of the rendered frame
+ */
+DVZ_EXPORT uint64_t dvz_batch_render(DvzBatch* batch, DvzImageFormat format, const char* path);
+
+/**
+ * Wait until all rendered frames have been saved.
+ *
+ * @param batch the batch
+ * @returns the number of frames that could not be saved
+ */
+DVZ_EXPORT uint64_t dvz_batch_wait(DvzBatch* batch);
+
+/**
+ * Return the number of images saved per second since the first rendered frame.
+ *
+ * @param batch the batch
+ * @returns the number of images per second
+ */
+DVZ_EXPORT double dvz_batch_fps(DvzBatch* batch);
+
+/**
+ * Wait for the pending images, stop the encoding threads, and destroy the batch.
+ *
+ * @param batch the batch
+ */
+DVZ_EXPORT void dvz_batch_destroy(DvzBatch* batch);
+
+
+
+/*************************************************************************************************/
+/*  Object picking                                                                               */
+/*************************************************************************************************/
+
+/**
+ * Request the visual and item at a given position of a canvas.
+ *
+ * The canvas must have been created with the DVZ_CANVAS_FLAGS_PICK flag. The picking-aware
+ * graphics (points and markers) write the pick id of their visual and the index of their vertex in
+ * an integer attachment. After the next frame, a small region around the position is copied to
+ * the host without stalling the rendering, and a PICK event is raised a few frames later with the
+ * hit closest to the position. Only the latest request is kept if several requests are made
+ * before the copy.
+ *
+ * @param canvas the canvas
+ * @param pos the position, in screen coordinates (like the mouse events)
+ * @param size the size of the square region around the position, in framebuffer pixels, at most
+ *     DVZ_PICK_MAX_SIZE
+ */
+DVZ_EXPORT void dvz_canvas_pick(DvzCanvas* canvas, vec2 pos, uint32_t size);
+
+
+
 /*************************************************************************************************/
 /*  Video                                                                                        */
 /*************************************************************************************************/
@@ -1097,6 +1385,22 @@ DVZ_EXPORT void dvz_event_timer(DvzCanvas* canvas, uint64_t idx, double time, do
  */
 DVZ_EXPORT int dvz_event_pending(DvzCanvas* canvas, DvzEventType type);
 
+/**
+ * Set how the pending async events of a given type are scheduled.
+ *
+ * The background thread always processes the oldest pending event with the highest priority.
+ * Input events have a high priority, so that slow async callbacks of other event types do not
+ * delay the interaction. The pending events older than the deadline are discarded, except the
+ * most recent one.
+ *
+ * @param canvas the canvas
+ * @param type the event type
+ * @param priority the priority of the events
+ * @param deadline the maximum age of the pending events, in seconds, or 0 for no limit
+ */
+DVZ_EXPORT void dvz_event_priority(
+    DvzCanvas* canvas, DvzEventType type, DvzEventPriority priority, double deadline);
+
 /**
  * Stop the background event loop.
  *
@@ -1108,6 +1412,63 @@ DVZ_EXPORT void dvz_event_stop(DvzCanvas* canvas);
 
 
 
+/*************************************************************************************************/
+/*  Profiler                                                                                     */
+/*************************************************************************************************/
+
+/**
+ * Enable the frame profiler of a canvas.
+ *
+ * The profiler records CPU scopes for the phases of each frame, and GPU scopes for the panels,
+ * the culling passes, and the GUI overlay, when the GPU supports timestamp queries. The records of
+ * the last DVZ_PROFILER_MAX_FRAMES frames are kept, see `dvz_profiler_frame()` and
+ * `dvz_profiler_export()`. A command buffer refill is triggered to record the GPU timestamps.
+ *
+ * @param canvas the canvas
+ * @returns the profiler
+ */
+DVZ_EXPORT DvzProfiler* dvz_canvas_profiler(DvzCanvas* canvas);
+
+/**
+ * Start recording the GPU scopes of a command buffer, outside of a render pass.
+ *
+ * Does nothing when the profiler is disabled.
+ *
+ * @param canvas the canvas
+ * @param cmds the command buffers
+ * @param idx the command buffer index, which is the swapchain image index
+ * @param type the profiled command buffer
+ */
+DVZ_EXPORT void dvz_canvas_profile_reset(
+    DvzCanvas* canvas, DvzCommands* cmds, uint32_t idx, DvzProfilerCmds type);
+
+/**
+ * Open a GPU scope in a command buffer.
+ *
+ * @param canvas the canvas
+ * @param cmds the command buffers
+ * @param idx the command buffer index, which is the swapchain image index
+ * @param type the profiled command buffer
+ * @param name the scope name
+ * @returns the scope index to pass to `dvz_canvas_profile_end()`
+ */
+DVZ_EXPORT uint32_t dvz_canvas_profile_begin(
+    DvzCanvas* canvas, DvzCommands* cmds, uint32_t idx, DvzProfilerCmds type, const char* name);
+
+/**
+ * Close a GPU scope in a command buffer.
+ *
+ * @param canvas the canvas
+ * @param cmds the command buffers
+ * @param idx the command buffer index, which is the swapchain image index
+ * @param type the profiled command buffer
+ * @param scope the scope index returned by `dvz_canvas_profile_begin()`
+ */
+DVZ_EXPORT void dvz_canvas_profile_end(
+    DvzCanvas* canvas, DvzCommands* cmds, uint32_t idx, DvzProfilerCmds type, uint32_t scope);
+
+
+
 /*************************************************************************************************/
 /*  Main canvas event loop                                                                       */
 /*************************************************************************************************/
@@ -1128,10 +1489,28 @@ DVZ_EXPORT void dvz_canvas_frame(DvzCanvas* canvas);
  */
 DVZ_EXPORT void dvz_canvas_frame_submit(DvzCanvas* canvas);
 
+/**
+ * Enable or disable the parallel processing of the canvas frames.
+ *
+ * In parallel mode, each canvas processes its frames in its own thread, so that a slow canvas does
+ * not slow down the other ones. The main thread polls the window events, and recreates and
+ * destroys the canvases. The event callbacks of a canvas may then run in its frame thread.
+ *
+ * The ImGui overlay is not thread-safe: `dvz_app_run()` falls back to the serial mode if a canvas
+ * has a GUI.
+ *
+ * @param app the app
+ * @param parallel whether to process the canvas frames in parallel
+ */
+DVZ_EXPORT void dvz_app_parallel(DvzApp* app, bool parallel);
+
 /**
  * Start the main event loop.
  *
- * Every loop iteration processes one frame of all open canvases.
+ * Every loop iteration processes one frame of all open canvases. The iterations during which all
+ * canvases are idle, with the DVZ_CANVAS_FLAGS_ON_DEMAND flag, wait for a new frame request and
+ * do not count in the number of frames. Neither do the iterations that only recreate the
+ * canvases, for example after a resize.
  *
  * @param app the app
  * @param frame_count number of frames to process (0 for infinite loop)
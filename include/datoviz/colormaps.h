@@ -85,6 +85,10 @@ extern "C" {
 
 #define TO_BYTE(x) (uint8_t) round(CLIP((x), 0, 1) * 255)
 
+// Batch colormap functions.
+#define DVZ_COLORMAP_THREADS    8      // maximum number of worker threads
+#define DVZ_COLORMAP_THREAD_MIN 262144 // minimum number of values per worker thread
+
 
 #pragma GCC visibility push(default)
 static unsigned char* DVZ_COLORMAP_ARRAY;
@@ -456,6 +460,44 @@ dvz_colormap_scale(DvzColormap cmap, double value, double vmin, double vmax, cve
 
 
 
+/**
+ * Fetch colors from a colormap and an array of float32 values.
+ *
+ * This is the batch version of `dvz_colormap_scale()`, returning the same colors. The values are
+ * mapped through a lookup table of the colormap colors, in several threads for large arrays.
+ *
+ * @param cmap the colormap
+ * @param count the number of values
+ * @param values pointer to the array of float numbers
+ * @param vmin the minimum value
+ * @param vmax the maximum value
+ * @param stride the number of bytes between two consecutive colors in the output, 0 for a packed
+ *     array of cvec4 colors
+ * @param[out] out pointer to the first output color, for example the color field of the first
+ *     item of a vertex array
+ */
+DVZ_EXPORT void dvz_colormap_array_float(
+    DvzColormap cmap, uint32_t count, const float* values, double vmin, double vmax,
+    uint32_t stride, void* out);
+
+/**
+ * Fetch colors from a colormap and an array of float64 values.
+ *
+ * See `dvz_colormap_array_float()`.
+ *
+ * @param cmap the colormap
+ * @param count the number of values
+ * @param values pointer to the array of double numbers
+ * @param vmin the minimum value
+ * @param vmax the maximum value
+ * @param stride the number of bytes between two consecutive colors in the output, 0 for a packed
+ *     array of cvec4 colors
+ * @param[out] out pointer to the first output color
+ */
+DVZ_EXPORT void dvz_colormap_array_double(
+    DvzColormap cmap, uint32_t count, const double* values, double vmin, double vmax,
+    uint32_t stride, void* out);
+
 /**
  * Fetch colors from a colormap and an array of values.
  *
@@ -469,10 +511,7 @@ dvz_colormap_scale(DvzColormap cmap, double value, double vmin, double vmax, cve
 static void dvz_colormap_array(
     DvzColormap cmap, uint32_t count, double* values, double vmin, double vmax, cvec4* out)
 {
-    ASSERT(values != NULL);
-    ASSERT(out != NULL);
-    for (uint32_t i = 0; i < count; i++)
-        dvz_colormap_scale(cmap, values[i], vmin, vmax, out[i]);
+    dvz_colormap_array_double(cmap, count, values, vmin, vmax, 0, out);
 }
 
 
@@ -101,6 +101,7 @@ END_INCL_NO_WARN
 
 #define DVZ_MAX_FRAMES_IN_FLIGHT    2
 #define DVZ_CONTAINER_DEFAULT_COUNT 64
+#define DVZ_PARALLEL_MAX_THREADS    16
 
 
 /*************************************************************************************************/
@@ -208,6 +209,7 @@ typedef enum
     DVZ_OBJECT_TYPE_AXES_2D,
     DVZ_OBJECT_TYPE_AXES_3D,
     DVZ_OBJECT_TYPE_GUI,
+    DVZ_OBJECT_TYPE_BATCH,
     DVZ_OBJECT_TYPE_CUSTOM,
 } DvzObjectType;
 
@@ -243,6 +245,10 @@ typedef struct DvzThread DvzThread;
 
 typedef void* (*DvzThreadCallback)(void*);
 
+// Process the items [first, first + count) of a parallel range, see dvz_parallel().
+typedef void (*DvzParallelCallback)(
+    uint64_t first, uint64_t count, uint32_t thread_idx, void* user_data);
+
 
 
 /*************************************************************************************************/
@@ -612,6 +618,18 @@ static void dvz_container_destroy(DvzContainer* container)
 DVZ_EXPORT int
 dvz_write_png(const char* filename, uint32_t width, uint32_t height, const uint8_t* image);
 
+/**
+ * Save an image to a JPEG file.
+ *
+ * @param filename path to the JPEG file to create
+ * @param width width of the image
+ * @param height height of the image
+ * @param image pointer to an array of 24-bit RGB values
+ * @param quality the compression quality, between 1 and 100
+ */
+DVZ_EXPORT int dvz_write_jpeg(
+    const char* filename, uint32_t width, uint32_t height, const uint8_t* image, int quality);
+
 /**
  * Save an image to a PPM file (short ASCII header and flat binary RGBA values).
  *
@@ -633,10 +651,26 @@ dvz_write_ppm(const char* filename, uint32_t width, uint32_t height, const uint8
 DVZ_EXPORT uint32_t* dvz_read_file(const char* filename, size_t* size);
 
 /**
- * Read a NumPy NPY file.
+ * Return the path of a file in the per-user cache directory, and create the directory if needed.
+ *
+ * The cache directory is `$DVZ_CACHE_DIR` if set, otherwise `%LOCALAPPDATA%/datoviz` on Windows,
+ * and `$XDG_CACHE_HOME/datoviz` or `~/.cache/datoviz` on the other platforms.
+ *
+ * @param name the name of the file in the cache directory
+ * @param[out] path the path of the file
+ * @param size the size of the path buffer
+ * @returns 0 if the cache directory exists or was created, 1 otherwise
+ */
+DVZ_EXPORT int dvz_cache_path(const char* name, char* path, size_t size);
+
+/**
+ * Read a NumPy NPY file into memory.
+ *
+ * The header is checked but the dtype and shape are not returned, use `dvz_npy()` to get them
+ * and to map large files instead of copying them.
  *
  * @param filename path of the file to open
- * @param[out] size of the file
+ * @param[out] size of the array data, in bytes
  * @returns pointer to a buffer containing the array elements
  */
 DVZ_EXPORT char* dvz_read_npy(const char* filename, size_t* size);
@@ -695,6 +729,24 @@ DVZ_EXPORT void dvz_thread_unlock(DvzThread* thread);
  */
 DVZ_EXPORT void dvz_thread_join(DvzThread* thread);
 
+/**
+ * Split a range of items between several threads, and wait until all items are processed.
+ *
+ * The callback is called once per thread with a non-empty, contiguous range of items, and with
+ * the thread index, between 0 and the returned number of threads. The ranges are in increasing
+ * order of the thread index. The calling thread processes the last range.
+ *
+ * @param count the total number of items
+ * @param min_per_thread the minimum number of items processed by a thread
+ * @param max_threads the maximum number of threads, up to `DVZ_PARALLEL_MAX_THREADS`
+ * @param callback the function processing a range of items
+ * @param user_data a pointer to arbitrary user data, shared by all threads
+ * @returns the number of threads that have been used
+ */
+DVZ_EXPORT uint32_t dvz_parallel(
+    uint64_t count, uint64_t min_per_thread, uint32_t max_threads, //
+    DvzParallelCallback callback, void* user_data);
+
 
 
 /*************************************************************************************************/
@@ -81,6 +81,7 @@ struct DvzFontAtlas
     uint8_t* font_texture;
     float glyph_width, glyph_height;
     const char* font_str;
+    uint8_t glyph_map[256]; // glyph index of every character
     DvzTexture* texture;
 };
 
@@ -99,6 +100,10 @@ struct DvzContext
     DvzObject obj;
     DvzGpu* gpu;
 
+    // Recursive lock protecting the containers, the staging buffer, and the transfer command
+    // buffer, which are shared by the canvases of the GPU.
+    pthread_mutex_t lock;
+
     DvzCommands transfer_cmd;
 
     DvzContainer buffers;
@@ -111,6 +116,7 @@ struct DvzContext
     DvzFontAtlas font_atlas;
     DvzColorTexture color_texture;
     DvzTexture* transfer_texture; // Default linear 1D texture
+    DvzTexture* volume_texture;   // Default empty 3D texture
 };
 
 
@@ -535,6 +541,18 @@ static DvzTexture* _default_transfer_texture(DvzContext* context)
 
 
 
+static DvzTexture* _default_volume_texture(DvzContext* context)
+{
+    uvec3 shape = {1, 1, 1};
+    DvzTexture* texture = dvz_ctx_texture(context, 3, shape, VK_FORMAT_R8G8B8A8_UNORM);
+    uint8_t tex_data[4] = {0};
+    uvec3 offset = {0, 0, 0};
+    dvz_texture_upload(texture, offset, offset, sizeof(tex_data), tex_data);
+    return texture;
+}
+
+
+
 #ifdef __cplusplus
 }
 #endif
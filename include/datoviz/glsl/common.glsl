@@ -85,6 +85,7 @@ layout (std140, binding = 1) uniform Viewport {
     // Options
     int clip;               // viewport clipping
     int interact_axis;
+    uint pick_id;           // object picking id of the visual
 } viewport;
 
 
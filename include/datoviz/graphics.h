@@ -106,6 +106,8 @@ typedef struct DvzGraphicsPointParams DvzGraphicsPointParams;
 
 typedef struct DvzGraphicsMarkerVertex DvzGraphicsMarkerVertex;
 typedef struct DvzGraphicsMarkerParams DvzGraphicsMarkerParams;
+typedef struct DvzGraphicsMarkerCmapVertex DvzGraphicsMarkerCmapVertex;
+typedef struct DvzGraphicsMarkerCmapParams DvzGraphicsMarkerCmapParams;
 
 typedef struct DvzGraphicsSegmentVertex DvzGraphicsSegmentVertex;
 
@@ -128,6 +130,14 @@ typedef struct DvzGraphicsVolumeParams DvzGraphicsVolumeParams;
 
 typedef struct DvzGraphicsMeshVertex DvzGraphicsMeshVertex;
 typedef struct DvzGraphicsMeshParams DvzGraphicsMeshParams;
+typedef struct DvzGraphicsMeshInstance DvzGraphicsMeshInstance;
+
+typedef struct DvzGraphicsHistogramItem DvzGraphicsHistogramItem;
+typedef struct DvzGraphicsHistogramVertex DvzGraphicsHistogramVertex;
+
+typedef struct DvzGraphicsDensityPoint DvzGraphicsDensityPoint;
+typedef struct DvzGraphicsDensityVertex DvzGraphicsDensityVertex;
+typedef struct DvzGraphicsDensityParams DvzGraphicsDensityParams;
 
 typedef struct DvzGraphicsTextParams DvzGraphicsTextParams;
 typedef struct DvzGraphicsTextVertex DvzGraphicsTextVertex;
@@ -194,6 +204,26 @@ struct DvzGraphicsMarkerParams
     float edge_width; /* line width, in pixels */
 };
 
+// Marker whose color is computed in the vertex shader from a scalar value and a colormap.
+struct DvzGraphicsMarkerCmapVertex
+{
+    vec3 pos;          /* position */
+    float value;       /* scalar value */
+    float size;        /* marker size, in pixels */
+    uint8_t marker;    /* marker type enum */
+    uint8_t angle;     /* angle, between 0 (0) included and 256 (M_2PI) excluded */
+    uint8_t transform; /* transform enum */
+};
+
+// NOTE: the first two fields must match DvzGraphicsMarkerParams, the fragment shader is shared.
+struct DvzGraphicsMarkerCmapParams
+{
+    vec4 edge_color;  /* edge color RGBA */
+    float edge_width; /* line width, in pixels */
+    int cmap;         /* colormap number */
+    vec2 vrange;      /* values mapped to the first and last colors of the colormap */
+};
+
 
 
 /*************************************************************************************************/
@@ -364,6 +394,8 @@ struct DvzGraphicsVolumeParams
     vec4 uvw0;            /* texture coordinates of the 2 corner points */
     vec4 uvw1;            /* texture coordinates of the 2 corner points */
     vec4 clip;            /* plane normal vector for volume slicing */
+    vec4 shape;           /* shape of the bricked volume level, in voxels */
+    vec4 bricks;          /* number of bricks along each axis, w > 0 if the volume is bricked */
     vec2 transfer_xrange; /* x coords of the endpoints of the transfer function */
     int32_t cmap;         /* colormap */
 };
@@ -390,6 +422,14 @@ struct DvzGraphicsMeshParams
     vec4 clip_coefs;      /* clip coefficients */
 };
 
+struct DvzGraphicsMeshInstance
+{
+    vec3 pos;      /* position of the instance */
+    vec4 rotation; /* rotation quaternion */
+    vec3 scale;    /* scaling factors of the base mesh */
+    cvec4 color;   /* color overriding the mesh color, unless the alpha value is zero */
+};
+
 static DvzGraphicsMeshParams default_graphics_mesh_params(vec3 eye)
 {
     DvzGraphicsMeshParams params = {0};
@@ -406,6 +446,49 @@ static DvzGraphicsMeshParams default_graphics_mesh_params(vec3 eye)
 
 
 
+/*************************************************************************************************/
+/*  Graphics histogram                                                                           */
+/*************************************************************************************************/
+
+struct DvzGraphicsHistogramItem
+{
+    uint32_t bin;       /* bin index */
+    uint32_t bin_count; /* number of bins */
+    cvec4 color;        /* bar color */
+};
+
+struct DvzGraphicsHistogramVertex
+{
+    vec2 pos;     /* normalized bin edge, and 0 (bottom) or 1 (top) of the bar */
+    uint32_t bin; /* bin index, the bar height is read from the bin counts */
+    cvec4 color;  /* bar color */
+};
+
+
+
+/*************************************************************************************************/
+/*  Graphics density                                                                             */
+/*************************************************************************************************/
+
+// NOTE: read as raw floats by the accumulation compute shader.
+struct DvzGraphicsDensityPoint
+{
+    vec3 pos;     /* position */
+    float weight; /* weight of the point in the density */
+};
+
+struct DvzGraphicsDensityVertex
+{
+    vec2 pos; /* corner of the quad covering the viewport, in normalized device coordinates */
+};
+
+struct DvzGraphicsDensityParams
+{
+    int cmap; /* colormap number */
+};
+
+
+
 /*************************************************************************************************/
 /*  Functions                                                                                    */
 /*************************************************************************************************/
@@ -0,0 +1,172 @@
+/*************************************************************************************************/
+/*  Multi-resolution min/max decimation of large 1D signals                                      */
+/*************************************************************************************************/
+
+#ifndef DVZ_LOD_HEADER
+#define DVZ_LOD_HEADER
+
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_LOD_MAX_LEVELS     16
+#define DVZ_LOD_FACTOR         8       // number of samples per bucket at level 1, x8 per level
+#define DVZ_LOD_THREADS        4       // number of worker threads for the first level
+#define DVZ_LOD_MIN_CHUNK      1048576 // minimum number of samples per worker thread
+#define DVZ_LOD_WINDOW_PADDING .5      // fraction of the visible range fetched on each side
+
+
+
+/*************************************************************************************************/
+/*  Typedefs                                                                                     */
+/*************************************************************************************************/
+
+typedef struct DvzLod DvzLod;
+typedef struct DvzLodLevel DvzLodLevel;
+typedef struct DvzLodWindow DvzLodWindow;
+
+
+
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
+
+struct DvzLodLevel
+{
+    uint64_t bucket; // number of original samples per bucket
+    uint32_t count;  // number of points kept in this level
+    dvec3* pos;      // kept points (NULL for level 0, which refers to the original data)
+    uint32_t* idx;   // index of each kept point in the original data
+};
+
+
+
+struct DvzLodWindow
+{
+    uint32_t level;    // pyramid level
+    uint32_t first;    // index of the first point within the level
+    uint32_t count;    // number of points in the window
+    uint32_t stride;   // > 1 only for the preview shown while the pyramid is being built
+    double xmin, xmax; // range, in normalized coordinates, covered by the window
+};
+
+
+
+struct DvzLod
+{
+    DvzObject obj;
+
+    // Original data, sorted by increasing x, NOT owned by the pyramid.
+    uint32_t sample_count;
+    const dvec3* pos;
+
+    uint32_t level_count;
+    DvzLodLevel levels[DVZ_LOD_MAX_LEVELS];
+
+    DvzThread thread;
+    atomic(bool, is_building);
+    atomic(bool, is_ready);
+    atomic(bool, to_stop);
+
+    DvzLodWindow window; // last window returned by dvz_lod_window()
+};
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+/**
+ * Create an empty decimation pyramid.
+ *
+ * @returns a pointer to the pyramid
+ */
+DVZ_EXPORT DvzLod* dvz_lod(void);
+
+/**
+ * Start building the decimation pyramid of a signal in a background thread.
+ *
+ * The points must be sorted by increasing x coordinate. The array is not copied and must remain
+ * valid and unchanged until the pyramid is stopped or destroyed.
+ *
+ * @param lod the pyramid
+ * @param count the number of points
+ * @param pos the points
+ */
+DVZ_EXPORT void dvz_lod_data(DvzLod* lod, uint32_t count, const dvec3* pos);
+
+/**
+ * Stop building the pyramid and wait for the background thread.
+ *
+ * @param lod the pyramid
+ */
+DVZ_EXPORT void dvz_lod_stop(DvzLod* lod);
+
+/**
+ * Whether all pyramid levels have been built.
+ *
+ * @param lod the pyramid
+ * @returns a boolean
+ */
+DVZ_EXPORT bool dvz_lod_ready(DvzLod* lod);
+
+/**
+ * Choose the level and window to upload for a given visible x range.
+ *
+ * The level is the coarsest one with at least one bucket per pixel, and the window extends on
+ * each side of the visible range so that small pans do not require a new upload.
+ *
+ * @param lod the pyramid
+ * @param xmin the left edge of the visible range, in normalized coordinates
+ * @param xmax the right edge of the visible range, in normalized coordinates
+ * @param width the viewport width, in pixels
+ * @returns the window
+ */
+DVZ_EXPORT DvzLodWindow dvz_lod_window(DvzLod* lod, double xmin, double xmax, uint32_t width);
+
+/**
+ * Whether a visible x range is covered by a window at the appropriate level.
+ *
+ * @param lod the pyramid
+ * @param window the window
+ * @param xmin the left edge of the visible range, in normalized coordinates
+ * @param xmax the right edge of the visible range, in normalized coordinates
+ * @param width the viewport width, in pixels
+ * @returns a boolean
+ */
+DVZ_EXPORT bool
+dvz_lod_covers(DvzLod* lod, DvzLodWindow window, double xmin, double xmax, uint32_t width);
+
+/**
+ * Copy the points of a window.
+ *
+ * @param lod the pyramid
+ * @param window the window
+ * @param[out] pos the output points, must hold `window.count` items
+ * @param[out] idx the index of each point in the original data, may be NULL
+ */
+DVZ_EXPORT void dvz_lod_copy(DvzLod* lod, DvzLodWindow window, dvec3* pos, uint32_t* idx);
+
+/**
+ * Destroy a pyramid.
+ *
+ * @param lod the pyramid
+ */
+DVZ_EXPORT void dvz_lod_destroy(DvzLod* lod);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
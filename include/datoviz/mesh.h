@@ -7,6 +7,7 @@
 
 #include "array.h"
 #include "graphics.h"
+#include "npy.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,6 +15,15 @@ extern "C" {
 
 
 
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_MESH_THREADS    8     // maximum number of threads used by the mesh transformations
+#define DVZ_MESH_THREAD_MIN 65536 // minimum number of vertices or faces per thread
+
+
+
 /*************************************************************************************************/
 /*  Enums                                                                                     */
 /*************************************************************************************************/
@@ -51,6 +61,9 @@ struct DvzMesh
     DvzArray vertices;
     DvzArray indices;
     mat4 transform;
+
+    // File mapping the arrays point to, for a mesh loaded with dvz_mesh_load().
+    DvzNpy* file;
 };
 
 
@@ -102,6 +115,9 @@ DVZ_EXPORT void dvz_mesh_rotate(DvzMesh* mesh, float angle, vec3 axis);
 /**
  * Apply the transformation matrix to a mesh.
  *
+ * The positions are transformed by the matrix, and the normals by its inverse transpose. Large
+ * meshes are processed in parallel.
+ *
  * @param mesh the mesh
  */
 DVZ_EXPORT void dvz_mesh_transform(DvzMesh* mesh);
@@ -109,7 +125,11 @@ DVZ_EXPORT void dvz_mesh_transform(DvzMesh* mesh);
 /**
  * Compute the normals of a mesh from the vertices and faces, with cross-products.
  *
- * Useful when a mesh has no normal data, just vertex positions and face indices.
+ * Useful when a mesh has no normal data, just vertex positions and face indices. The face normals
+ * are added to the existing vertex normals before normalization. Large meshes are processed in
+ * parallel: the face normals are computed by range of faces, then each thread sums the normals of
+ * the faces touching its own range of vertices, in the face order, so that the result does not
+ * depend on the number of threads.
  *
  * @param mesh the mesh
  */
@@ -221,12 +241,55 @@ DVZ_EXPORT void dvz_mesh_destroy(DvzMesh* mesh);
 /**
  * Load an OBJ mesh.
  *
+ * Polygonal faces are triangulated, and vertices with the same position, normal and texture
+ * coordinates are shared between faces. The normals are computed from the faces when the file
+ * has none.
+ *
  * @param file_path the path to the .obj file
  * @returns the mesh
  */
 DVZ_EXPORT DvzMesh dvz_mesh_obj(const char* file_path);
 
 
+
+/*************************************************************************************************/
+/*  Binary mesh cache                                                                            */
+/*************************************************************************************************/
+
+/**
+ * Save a mesh to a binary file, with its vertices and indices as they are in memory.
+ *
+ * @param mesh the mesh
+ * @param path the path to the file to create
+ * @returns 0 on success, a nonzero value otherwise
+ */
+DVZ_EXPORT int dvz_mesh_save(DvzMesh* mesh, const char* path);
+
+/**
+ * Load a mesh saved with `dvz_mesh_save()`.
+ *
+ * The file is memory-mapped and the mesh arrays point directly to the mapping, without any copy.
+ * The mapping is copy-on-write: the mesh can be modified in place, for example transformed,
+ * without modifying the file, but its arrays must not be resized.
+ *
+ * @param path the path to the file
+ * @returns the mesh, empty if the file could not be read or was saved by an incompatible version
+ */
+DVZ_EXPORT DvzMesh dvz_mesh_load(const char* path);
+
+/**
+ * Load an OBJ mesh, using a binary cache next to the OBJ file.
+ *
+ * The first time, the OBJ file is parsed and the mesh is saved to `<file_path>.dvzmesh`, along
+ * with the size and modification time of the OBJ file. The next times, the mesh is loaded from
+ * this file as long as the OBJ file has the same size and modification time.
+ *
+ * @param file_path the path to the .obj file
+ * @returns the mesh
+ */
+DVZ_EXPORT DvzMesh dvz_mesh_obj_cached(const char* file_path);
+
+
 #ifdef __cplusplus
 }
 #endif
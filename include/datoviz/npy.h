@@ -0,0 +1,138 @@
+/*************************************************************************************************/
+/*  Memory-mapped NPY and raw binary files                                                       */
+/*************************************************************************************************/
+
+#ifndef DVZ_NPY_HEADER
+#define DVZ_NPY_HEADER
+
+#include "array.h"
+#include "common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_NPY_MAX_DIMS   8
+#define DVZ_NPY_DESCR_SIZE 256      // maximum size of the dtype description, including the NUL
+#define DVZ_NPY_MAX_HEADER 65536    // maximum size of the header, as written by NumPy
+#define DVZ_NPY_CHUNK_SIZE 16777216 // default size of the streamed chunks, in bytes (16 MB)
+
+
+
+/*************************************************************************************************/
+/*  Typedefs                                                                                     */
+/*************************************************************************************************/
+
+typedef struct DvzNpy DvzNpy;
+
+
+
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
+
+struct DvzNpy
+{
+    DvzObject obj;
+
+    // Array description, parsed from the NPY header.
+    uint32_t version;                 // major version of the NPY format, 0 for raw binary files
+    char descr[DVZ_NPY_DESCR_SIZE];   // NumPy dtype description, for example "<f4"
+    DvzDataType dtype;                // DVZ_DTYPE_CUSTOM for unsupported or structured dtypes
+    VkDeviceSize item_size;           // size of one array element, in bytes
+    bool fortran_order;               // whether the array is stored in column-major order
+    uint32_t ndims;                   // number of dimensions
+    uint64_t shape[DVZ_NPY_MAX_DIMS]; // size of each dimension
+    uint64_t item_count;              // total number of array elements
+
+    // Payload.
+    VkDeviceSize offset; // offset of the payload in the file, in bytes
+    VkDeviceSize size;   // size of the payload, in bytes
+    const void* data;    // pointer to the payload
+
+    // File mapping, or heap copy of the payload on platforms without mmap().
+    bool is_mapped;
+    void* map;
+    VkDeviceSize map_size;
+};
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+/**
+ * Open a NumPy NPY file and map its payload in memory.
+ *
+ * The header is parsed (magic string, version, dtype, shape, memory order) and the payload is
+ * mapped read-only, so that its pages are only read from disk when they are first accessed. Only
+ * little-endian and byte-sized dtypes are supported.
+ *
+ * @param path the path to the NPY file
+ * @returns a pointer to the opened file, or NULL if the file could not be opened or parsed
+ */
+DVZ_EXPORT DvzNpy* dvz_npy(const char* path);
+
+/**
+ * Open a raw binary file and map its contents in memory.
+ *
+ * The file is a flat 1D array of a given dtype, the number of elements is determined from the
+ * file size.
+ *
+ * @param path the path to the binary file
+ * @param dtype the dtype of the array elements
+ * @param offset the number of header bytes to skip at the beginning of the file
+ * @returns a pointer to the opened file, or NULL if the file could not be opened
+ */
+DVZ_EXPORT DvzNpy* dvz_npy_raw(const char* path, DvzDataType dtype, VkDeviceSize offset);
+
+/**
+ * Return a pointer to an element of the payload, in the storage order.
+ *
+ * @param npy the opened file
+ * @param idx the element index
+ * @returns a pointer to the element
+ */
+DVZ_EXPORT const void* dvz_npy_item(DvzNpy* npy, uint64_t idx);
+
+/**
+ * Tell the system that a part of the payload will be accessed soon, so that it is read ahead.
+ *
+ * @param npy the opened file
+ * @param offset the offset within the payload, in bytes
+ * @param size the size of the region, in bytes
+ */
+DVZ_EXPORT void dvz_npy_prefetch(DvzNpy* npy, VkDeviceSize offset, VkDeviceSize size);
+
+/**
+ * Release the memory pages of a part of the payload that is no longer needed.
+ *
+ * The pages are read again from disk if they are accessed later.
+ *
+ * @param npy the opened file
+ * @param offset the offset within the payload, in bytes
+ * @param size the size of the region, in bytes
+ */
+DVZ_EXPORT void dvz_npy_release(DvzNpy* npy, VkDeviceSize offset, VkDeviceSize size);
+
+/**
+ * Close a file and unmap its payload.
+ *
+ * @param npy the opened file
+ */
+DVZ_EXPORT void dvz_npy_destroy(DvzNpy* npy);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,310 @@
+/*************************************************************************************************/
+/*  Frame profiler with CPU scopes, GPU timestamps, and Chrome trace export                      */
+/*************************************************************************************************/
+
+#ifndef DVZ_PROFILER_HEADER
+#define DVZ_PROFILER_HEADER
+
+#include "app.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_PROFILER_MAX_FRAMES 256 // number of frame records kept in the ring buffer
+#define DVZ_PROFILER_MAX_SCOPES 64  // maximum number of CPU and GPU scopes per frame
+#define DVZ_PROFILER_MAX_DEPTH  16  // maximum nesting of the CPU scopes
+#define DVZ_PROFILER_NAME_SIZE  32
+
+// GPU scopes are recorded in the command buffers of each swapchain image.
+// NOTE: must be at least DVZ_MAX_SWAPCHAIN_IMAGES.
+#define DVZ_PROFILER_MAX_IMAGES    8
+#define DVZ_PROFILER_GPU_SCOPES    32 // maximum number of GPU scopes per command buffer
+#define DVZ_PROFILER_IMAGE_QUERIES (2 * DVZ_PROFILER_GPU_SCOPES * DVZ_PROFILER_CMDS_COUNT)
+#define DVZ_PROFILER_QUERY_COUNT   (DVZ_PROFILER_MAX_IMAGES * DVZ_PROFILER_IMAGE_QUERIES)
+
+
+
+/*************************************************************************************************/
+/*  Enums                                                                                        */
+/*************************************************************************************************/
+
+// Profiler scope domain.
+typedef enum
+{
+    DVZ_PROFILER_DOMAIN_CPU,
+    DVZ_PROFILER_DOMAIN_GPU,
+} DvzProfilerDomain;
+
+
+
+// Profiled command buffers of a swapchain image.
+typedef enum
+{
+    DVZ_PROFILER_CMDS_RENDER,
+    DVZ_PROFILER_CMDS_OVERLAY,
+    DVZ_PROFILER_CMDS_COUNT,
+} DvzProfilerCmds;
+
+
+
+/*************************************************************************************************/
+/*  Typedefs                                                                                     */
+/*************************************************************************************************/
+
+typedef struct DvzProfiler DvzProfiler;
+typedef struct DvzProfilerFrame DvzProfilerFrame;
+typedef struct DvzProfilerScope DvzProfilerScope;
+typedef struct DvzProfilerGpuScopes DvzProfilerGpuScopes;
+
+
+
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
+
+struct DvzProfilerScope
+{
+    char name[DVZ_PROFILER_NAME_SIZE];
+    DvzProfilerDomain domain;
+    uint32_t depth;    // nesting level of CPU scopes
+    double start, end; // in seconds, since the creation of the profiler
+};
+
+
+
+struct DvzProfilerFrame
+{
+    uint64_t frame_idx;
+    double start, end;
+    uint32_t scope_count;
+    DvzProfilerScope scopes[DVZ_PROFILER_MAX_SCOPES];
+};
+
+
+
+// GPU scopes recorded in a command buffer.
+struct DvzProfilerGpuScopes
+{
+    uint32_t count;
+    char names[DVZ_PROFILER_GPU_SCOPES][DVZ_PROFILER_NAME_SIZE];
+};
+
+
+
+struct DvzProfiler
+{
+    DvzObject obj;
+    DvzClock clock;
+
+    // Ring buffer of frame records, the current frame is recorded in
+    // frames[frame_count % DVZ_PROFILER_MAX_FRAMES].
+    uint64_t frame_count; // number of completed frames
+    bool in_frame;
+    DvzProfilerFrame* frames;
+
+    // Stack of the open CPU scopes.
+    uint32_t depth;
+    uint32_t stack[DVZ_PROFILER_MAX_DEPTH];
+
+    // GPU scopes recorded in the command buffers of each swapchain image, and frame and CPU time
+    // of the last submission of these command buffers, whose timestamps are yet to be resolved.
+    DvzProfilerGpuScopes gpu_scopes[DVZ_PROFILER_MAX_IMAGES][DVZ_PROFILER_CMDS_COUNT];
+    bool gpu_pending[DVZ_PROFILER_MAX_IMAGES];
+    uint64_t gpu_frame[DVZ_PROFILER_MAX_IMAGES];
+    double gpu_submit[DVZ_PROFILER_MAX_IMAGES];
+};
+
+
+
+/*************************************************************************************************/
+/*  Profiler                                                                                     */
+/*************************************************************************************************/
+
+/**
+ * Create a profiler.
+ *
+ * @returns a pointer to the profiler
+ */
+DVZ_EXPORT DvzProfiler* dvz_profiler(void);
+
+/**
+ * Return the time elapsed since the creation of the profiler.
+ *
+ * @param profiler the profiler
+ * @returns the time, in seconds
+ */
+DVZ_EXPORT double dvz_profiler_time(DvzProfiler* profiler);
+
+/**
+ * Start recording a new frame, ending the current frame if needed.
+ *
+ * This function and the CPU scope functions do nothing when the profiler is NULL, so that they
+ * can be called unconditionally with the profiler of a canvas. They must be called from the thread
+ * processing the frames of the canvas.
+ *
+ * @param profiler the profiler, may be NULL
+ * @param frame_idx the frame index
+ */
+DVZ_EXPORT void dvz_profiler_frame_begin(DvzProfiler* profiler, uint64_t frame_idx);
+
+/**
+ * End the current frame and close its open CPU scopes.
+ *
+ * @param profiler the profiler, may be NULL
+ */
+DVZ_EXPORT void dvz_profiler_frame_end(DvzProfiler* profiler);
+
+/**
+ * Open a CPU scope in the current frame.
+ *
+ * @param profiler the profiler, may be NULL
+ * @param name the scope name
+ */
+DVZ_EXPORT void dvz_profiler_begin(DvzProfiler* profiler, const char* name);
+
+/**
+ * Close the last open CPU scope.
+ *
+ * @param profiler the profiler, may be NULL
+ */
+DVZ_EXPORT void dvz_profiler_end(DvzProfiler* profiler);
+
+/**
+ * Add a scope with given times to a frame, for example GPU timings resolved after the frame.
+ *
+ * @param profiler the profiler
+ * @param frame_idx the frame index, the scope is discarded if the frame is no longer recorded
+ * @param domain the scope domain
+ * @param name the scope name
+ * @param start the start time, in seconds since the creation of the profiler
+ * @param end the end time, in seconds since the creation of the profiler
+ */
+DVZ_EXPORT void dvz_profiler_scope(
+    DvzProfiler* profiler, uint64_t frame_idx, DvzProfilerDomain domain, const char* name,
+    double start, double end);
+
+/**
+ * Return the number of completed frames in the ring buffer.
+ *
+ * @param profiler the profiler
+ * @returns the number of frames, at most DVZ_PROFILER_MAX_FRAMES
+ */
+DVZ_EXPORT uint32_t dvz_profiler_frame_count(DvzProfiler* profiler);
+
+/**
+ * Return a completed frame record.
+ *
+ * @param profiler the profiler
+ * @param idx the frame index within the ring buffer, from 0 (oldest) to the frame count minus 1
+ * @returns the frame record
+ */
+DVZ_EXPORT DvzProfilerFrame* dvz_profiler_frame(DvzProfiler* profiler, uint32_t idx);
+
+/**
+ * Return the mean and maximum duration of a scope across the completed frames.
+ *
+ * @param profiler the profiler
+ * @param domain the scope domain
+ * @param name the scope name
+ * @param[out] max the maximum duration, in seconds (may be NULL)
+ * @returns the mean duration, in seconds, or 0 if the scope was not recorded
+ */
+DVZ_EXPORT double dvz_profiler_stats(
+    DvzProfiler* profiler, DvzProfilerDomain domain, const char* name, double* max);
+
+/**
+ * Export the completed frames in the Chrome trace event JSON format.
+ *
+ * The file can be opened in chrome://tracing or in Perfetto. CPU and GPU scopes are shown on
+ * two separate tracks.
+ *
+ * @param profiler the profiler
+ * @param path the path to the JSON file
+ * @returns 0 on success, a nonzero value otherwise
+ */
+DVZ_EXPORT int dvz_profiler_export(DvzProfiler* profiler, const char* path);
+
+/**
+ * Destroy a profiler.
+ *
+ * @param profiler the profiler
+ */
+DVZ_EXPORT void dvz_profiler_destroy(DvzProfiler* profiler);
+
+
+
+/*************************************************************************************************/
+/*  GPU scopes                                                                                   */
+/*************************************************************************************************/
+
+/**
+ * Return the index of a timestamp query in the query pool of the profiled command buffers.
+ *
+ * @param img_idx the swapchain image index
+ * @param cmds the profiled command buffer
+ * @param scope the scope index within the command buffer
+ * @param end false for the beginning of the scope, true for its end
+ * @returns the query index
+ */
+DVZ_EXPORT uint32_t
+dvz_profiler_gpu_query(uint32_t img_idx, DvzProfilerCmds cmds, uint32_t scope, bool end);
+
+/**
+ * Forget the GPU scopes of a command buffer, before recording it again.
+ *
+ * @param profiler the profiler
+ * @param img_idx the swapchain image index
+ * @param cmds the profiled command buffer
+ */
+DVZ_EXPORT void
+dvz_profiler_gpu_reset(DvzProfiler* profiler, uint32_t img_idx, DvzProfilerCmds cmds);
+
+/**
+ * Register a GPU scope recorded in a command buffer.
+ *
+ * @param profiler the profiler
+ * @param img_idx the swapchain image index
+ * @param cmds the profiled command buffer
+ * @param name the scope name
+ * @returns the scope index, or UINT32_MAX if the command buffer has too many scopes
+ */
+DVZ_EXPORT uint32_t dvz_profiler_gpu_begin(
+    DvzProfiler* profiler, uint32_t img_idx, DvzProfilerCmds cmds, const char* name);
+
+/**
+ * Mark the command buffers of a swapchain image as submitted during the current frame.
+ *
+ * @param profiler the profiler
+ * @param img_idx the swapchain image index
+ */
+DVZ_EXPORT void dvz_profiler_gpu_submit(DvzProfiler* profiler, uint32_t img_idx);
+
+/**
+ * Add the GPU scopes of the last submission of a swapchain image to its frame record.
+ *
+ * The GPU clock is aligned on the CPU clock by assuming that the first GPU scope started when the
+ * command buffers were submitted.
+ *
+ * @param profiler the profiler
+ * @param img_idx the swapchain image index
+ * @param timestamps the DVZ_PROFILER_IMAGE_QUERIES timestamps of the image, indexed by
+ *     `dvz_profiler_gpu_query(0, cmds, scope, end)`, or NULL to discard the submission
+ * @param period the number of nanoseconds per timestamp increment
+ */
+DVZ_EXPORT void dvz_profiler_gpu_resolve(
+    DvzProfiler* profiler, uint32_t img_idx, const uint64_t* timestamps, double period);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -19,6 +19,7 @@
 /*************************************************************************************************/
 
 #define DVZ_MAX_VISUALS_PER_CONTROLLER 64
+#define DVZ_SCENE_BAKE_THREADS         2 // number of worker threads baking the visuals
 
 
 
@@ -52,6 +53,15 @@ typedef enum
     DVZ_VISUAL_FLAGS_TRANSFORM_NONE = 0x0010,
     DVZ_VISUAL_FLAGS_TRANSFORM_BOX_INIT = 0x0020, // do not recompute the panel box whenever
                                                   // the POS prop changes
+    DVZ_VISUAL_FLAGS_LOD = 0x0040, // min/max decimation of LINE_STRIP and PATH visuals, the
+                                   // POS prop must be sorted by increasing x coordinate
+    DVZ_VISUAL_FLAGS_CULLING = 0x0080, // GPU viewport culling of MARKER and POINT visuals
+    DVZ_VISUAL_FLAGS_TILED = 0x0200,   // tiled mip pyramid of IMAGE and IMAGE_CMAP visuals, the
+                                       // image is set with dvz_tiles_data() or dvz_tiles_npy()
+    DVZ_VISUAL_FLAGS_BRICKED = 0x2000, // bricked storage of VOLUME visuals with empty-space
+                                       // skipping, the volume is set with dvz_bricks_data()
+    DVZ_VISUAL_FLAGS_BAKE_ASYNC = 0x4000, // normalize and bake the data in a worker thread, the
+                                          // previous data remains visible until then
 } DvzVisualFlags;
 
 
@@ -111,8 +121,22 @@ struct DvzAxes2D
 {
     DvzAxesContext ctx[2]; // one per dimension
     DvzAxesTicks ticks[2];
+    // Memoized tick computations, one per dimension.
+    DvzAxesTicksCache cache[2];
     DvzBox box; // box, in data coordinates, corresponding to the box showed with initial panzoom
     float font_size;
+
+    // Buffers reused across uploads of the tick positions and labels.
+    uint32_t buffer_size;
+    double* buffer;
+    char** text;
+
+    // Ring layout of the ticks in the axes visuals: the tick i is stored in the slot
+    // (i + ring) % N and the minor ticks following it in the slot (i + ring) % (N - 1), so that
+    // panning only updates the slots of the new ticks.
+    int32_t ring[2];
+    uint32_t ring_count[2];
+    char* labels[2]; // labels in slot order, referenced by the TEXT prop
 };
 
 
@@ -161,6 +185,11 @@ struct DvzScene
 
     // FIFO queue with the pending scene updates.
     DvzFifo update_fifo;
+
+    // Worker threads baking the visuals with the DVZ_VISUAL_FLAGS_BAKE_ASYNC flag, started when
+    // needed, and FIFO queue with the pending bake jobs.
+    DvzThread bake_threads[DVZ_SCENE_BAKE_THREADS];
+    DvzFifo bake_fifo;
 };
 
 
@@ -9,6 +9,15 @@
 
 
 
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_TICKS_CACHE_SIZE 16 // number of memoized tick computations per axis
+#define DVZ_TICKS_CACHE_KEY  6  // number of integers in a cache key
+
+
+
 /*************************************************************************************************/
 /*  Enums                                                                                        */
 /*************************************************************************************************/
@@ -29,6 +38,8 @@ typedef enum
 
 typedef struct DvzAxesContext DvzAxesContext;
 typedef struct DvzAxesTicks DvzAxesTicks;
+typedef struct DvzAxesTicksCacheItem DvzAxesTicksCacheItem;
+typedef struct DvzAxesTicksCache DvzAxesTicksCache;
 typedef struct Q Q;
 
 
@@ -63,4 +74,24 @@ struct DvzAxesTicks
 
 
 
+struct DvzAxesTicksCacheItem
+{
+    int64_t key[DVZ_TICKS_CACHE_KEY]; // quantized range and axes context
+    DvzAxesTicks ticks;               // owns its values and labels
+    uint64_t last_used;
+};
+
+
+
+// Memoized tick computations, keyed by the quantized requested range and the axes context.
+struct DvzAxesTicksCache
+{
+    uint32_t count;
+    uint64_t clock;
+    uint32_t hits, misses;
+    DvzAxesTicksCacheItem items[DVZ_TICKS_CACHE_SIZE];
+};
+
+
+
 #endif
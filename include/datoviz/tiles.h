@@ -0,0 +1,257 @@
+/*************************************************************************************************/
+/*  Tiled mip pyramid and tile cache for very large images                                       */
+/*************************************************************************************************/
+
+#ifndef DVZ_TILES_HEADER
+#define DVZ_TILES_HEADER
+
+#include "common.h"
+#include "npy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_TILES_SIZE        254 // number of image texels per tile side
+#define DVZ_TILES_GUTTER      1   // texels copied from the neighbor tiles on each side
+#define DVZ_TILES_SLOT_SIZE   (DVZ_TILES_SIZE + 2 * DVZ_TILES_GUTTER)
+#define DVZ_TILES_ATLAS_SLOTS 16  // number of tile slots per side of the atlas texture
+#define DVZ_TILES_SLOT_COUNT  (DVZ_TILES_ATLAS_SLOTS * DVZ_TILES_ATLAS_SLOTS)
+#define DVZ_TILES_MAX_VISIBLE (DVZ_TILES_SLOT_COUNT / 2) // keep room for the fallback tiles
+#define DVZ_TILES_MAX_UPLOADS 8   // maximum number of tiles uploaded per frame
+#define DVZ_TILES_MAX_LEVELS  24
+#define DVZ_TILES_THREADS     4   // number of worker threads per pyramid level
+#define DVZ_TILES_BAND        256 // number of level rows built between two page releases
+
+
+
+/*************************************************************************************************/
+/*  Typedefs                                                                                     */
+/*************************************************************************************************/
+
+typedef struct DvzTiles DvzTiles;
+typedef struct DvzTilesLevel DvzTilesLevel;
+typedef struct DvzTile DvzTile;
+typedef struct DvzTilesSlot DvzTilesSlot;
+typedef struct DvzTilesQuad DvzTilesQuad;
+
+
+
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
+
+struct DvzTilesLevel
+{
+    uint32_t width, height; // size of the level image, in texels
+    uint32_t cols, rows;    // number of tiles
+    uint8_t* pixels;        // level image (NULL for level 0, which refers to the original image)
+    uint64_t size;          // size of the level image, in bytes
+    bool is_mapped;         // whether the level image is mapped from a scratch file
+};
+
+
+
+struct DvzTile
+{
+    uint32_t level, col, row;
+};
+
+
+
+struct DvzTilesSlot
+{
+    DvzTile tile;
+    bool is_used;
+    uint64_t frame; // last frame during which the tile was drawn
+};
+
+
+
+// Part of a tile drawn as an image quad.
+struct DvzTilesQuad
+{
+    dvec4 box; // u0, v0, u1, v1 in normalized image coordinates, v from top to bottom
+    vec4 uv;   // u0, v0, u1, v1 in the atlas texture
+};
+
+
+
+struct DvzTiles
+{
+    DvzObject obj;
+
+    // Original image, row-major, NOT owned by the pyramid.
+    uint32_t width, height, channels;
+    const uint8_t* pixels;
+    DvzNpy* npy; // mapped file the original image is read from, if any
+
+    uint32_t level_count;
+    DvzTilesLevel levels[DVZ_TILES_MAX_LEVELS];
+
+    DvzThread thread;
+    atomic(uint32_t, levels_ready); // number of levels, from the finest, already built
+    atomic(bool, is_building);
+    atomic(bool, to_stop);
+
+    // Tile cache, its slots map to square regions of an atlas texture.
+    uint64_t frame;
+    DvzTilesSlot slots[DVZ_TILES_SLOT_COUNT];
+    uint8_t* slot_pixels; // CPU copy of the slot contents, to be uploaded to the atlas
+
+    // Slots filled during the last update, to be uploaded by the caller.
+    uint32_t upload_count;
+    uint32_t uploads[DVZ_TILES_MAX_UPLOADS];
+
+    // Quads to draw after the last update.
+    uint32_t quad_count;
+    DvzTilesQuad quads[DVZ_TILES_MAX_VISIBLE];
+
+    // Parameters of the last update.
+    dvec4 box;
+    dvec2 scale;
+    uint32_t last_levels_ready;
+    bool is_complete; // whether all tiles were resident at the chosen level
+};
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+/**
+ * Create an empty tiled image.
+ *
+ * @returns a pointer to the tiled image
+ */
+DVZ_EXPORT DvzTiles* dvz_tiles(void);
+
+/**
+ * Set the image and start building its mip pyramid in a background thread.
+ *
+ * The image is not copied and must remain valid and unchanged until the pyramid is stopped or
+ * destroyed. The coarser levels are written to a scratch file mapped in memory, so that only the
+ * pages being built or copied to the tile cache are resident in host memory.
+ *
+ * @param tiles the tiled image
+ * @param width the image width, in texels
+ * @param height the image height, in texels
+ * @param channels the number of uint8 channels per texel (1 or 4)
+ * @param pixels the image, row-major
+ */
+DVZ_EXPORT void dvz_tiles_data(
+    DvzTiles* tiles, uint32_t width, uint32_t height, uint32_t channels, const uint8_t* pixels);
+
+/**
+ * Set the image from a mapped NPY file and start building its mip pyramid in a background thread.
+ *
+ * The array must have the uint8 dtype, the C order, and the shape (height, width) or
+ * (height, width, channels) with 1 or 4 channels. The image is read from the file on demand and
+ * its pages are released once copied, so that images much larger than the host memory can be
+ * used. The file must remain open until the pyramid is stopped or destroyed.
+ *
+ * @param tiles the tiled image
+ * @param npy the opened file
+ * @returns 0 if the array is a supported image, 1 otherwise
+ */
+DVZ_EXPORT int dvz_tiles_npy(DvzTiles* tiles, DvzNpy* npy);
+
+/**
+ * Stop building the pyramid and wait for the background thread.
+ *
+ * @param tiles the tiled image
+ */
+DVZ_EXPORT void dvz_tiles_stop(DvzTiles* tiles);
+
+/**
+ * Whether all pyramid levels have been built.
+ *
+ * @param tiles the tiled image
+ * @returns a boolean
+ */
+DVZ_EXPORT bool dvz_tiles_ready(DvzTiles* tiles);
+
+/**
+ * Choose the pyramid level for a given on-screen scale.
+ *
+ * @param tiles the tiled image
+ * @param scale the number of screen pixels spanned by the full image width and height
+ * @returns the coarsest built level with at least one texel per screen pixel
+ */
+DVZ_EXPORT uint32_t dvz_tiles_level(DvzTiles* tiles, dvec2 scale);
+
+/**
+ * List the tiles of a level that intersect a region of the image.
+ *
+ * @param tiles the tiled image
+ * @param level the pyramid level
+ * @param box the region u0, v0, u1, v1, in normalized image coordinates
+ * @param max_count the maximum number of tiles to return
+ * @param[out] out the tiles
+ * @returns the number of tiles intersecting the region, may be larger than max_count
+ */
+DVZ_EXPORT uint32_t
+dvz_tiles_visible(DvzTiles* tiles, uint32_t level, dvec4 box, uint32_t max_count, DvzTile* out);
+
+/**
+ * Whether a new update is needed for a given visible region and scale.
+ *
+ * @param tiles the tiled image
+ * @param box the visible region, in normalized image coordinates
+ * @param scale the number of screen pixels spanned by the full image width and height
+ * @returns a boolean
+ */
+DVZ_EXPORT bool dvz_tiles_changed(DvzTiles* tiles, dvec4 box, dvec2 scale);
+
+/**
+ * Update the tile cache and the quads to draw for a visible region.
+ *
+ * At most DVZ_TILES_MAX_UPLOADS missing tiles are loaded in the least recently used slots, the
+ * other missing tiles are replaced by their closest resident ancestor. The slots to upload are
+ * listed in `tiles->uploads` and the quads to draw in `tiles->quads`.
+ *
+ * @param tiles the tiled image
+ * @param box the visible region, in normalized image coordinates
+ * @param scale the number of screen pixels spanned by the full image width and height
+ * @returns the number of quads to draw
+ */
+DVZ_EXPORT uint32_t dvz_tiles_update(DvzTiles* tiles, dvec4 box, dvec2 scale);
+
+/**
+ * Return the offset of a slot in the atlas texture, in texels.
+ *
+ * @param slot the slot index
+ * @param[out] offset the offset
+ */
+DVZ_EXPORT void dvz_tiles_slot_offset(uint32_t slot, uvec3 offset);
+
+/**
+ * Return the CPU copy of a slot, with DVZ_TILES_SLOT_SIZE^2 texels.
+ *
+ * @param tiles the tiled image
+ * @param slot the slot index
+ * @returns a pointer to the slot texels
+ */
+DVZ_EXPORT uint8_t* dvz_tiles_slot_pixels(DvzTiles* tiles, uint32_t slot);
+
+/**
+ * Destroy a tiled image.
+ *
+ * @param tiles the tiled image
+ */
+DVZ_EXPORT void dvz_tiles_destroy(DvzTiles* tiles);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
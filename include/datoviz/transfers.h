@@ -115,6 +115,42 @@ struct DvzTransfer
 DVZ_EXPORT void dvz_upload_buffers(
     DvzCanvas* canvas, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data);
 
+/**
+ * Write uniform data directly in a persistently-mapped uniform buffer.
+ *
+ * The buffer regions must come from the `DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE` buffer, with one region
+ * per swapchain image. While the event loop is running, only the region of the swapchain image
+ * being recorded is written, without going through the transfer queue. This function should be
+ * called in a FRAME callback, after the swapchain image acquisition, and the data is meant to be
+ * updated at every frame (for example, the MVP). Otherwise, all regions are written.
+ *
+ * @param canvas the canvas
+ * @param br the buffer regions to update
+ * @param offset the offset within the buffer regions, in bytes
+ * @param size the size of the data to write, in bytes
+ * @param data pointer to the data to write, it can be freed after the call
+ */
+DVZ_EXPORT void dvz_update_uniforms(
+    DvzCanvas* canvas, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size,
+    const void* data);
+
+/**
+ * Write uniform data in all the regions of a persistently-mapped uniform buffer.
+ *
+ * Unlike `dvz_update_uniforms()`, this function is meant for data that does not change at every
+ * frame (for example, the visual parameters), so that all swapchain images use the new data.
+ * While the event loop is running, it first waits until the frames in flight are rendered.
+ *
+ * @param canvas the canvas
+ * @param br the buffer regions to update
+ * @param offset the offset within the buffer regions, in bytes
+ * @param size the size of the data to write, in bytes
+ * @param data pointer to the data to write, it can be freed after the call
+ */
+DVZ_EXPORT void dvz_upload_uniforms(
+    DvzCanvas* canvas, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size,
+    const void* data);
+
 /**
  * Download data from a buffer region to the CPU while the app event loop is running.
  *
@@ -6,8 +6,12 @@
 #define DVZ_VISUALS_HEADER
 
 #include "array.h"
+#include "bricks.h"
 #include "context.h"
 #include "graphics.h"
+#include "lod.h"
+#include "npy.h"
+#include "tiles.h"
 #include "transforms.h"
 #include "vklite.h"
 
@@ -21,6 +25,7 @@
 #define DVZ_MAX_VISUAL_GROUPS       1024
 #define DVZ_MAX_VISUAL_PRIORITY     4
 #define DVZ_MAX_UNIFORM_SIZE        65536
+#define DVZ_CULLING_MARGIN          16 // default margin around the viewport, in pixels
 
 
 /*************************************************************************************************/
@@ -75,6 +80,10 @@ typedef enum
     DVZ_PROP_INDEX,
     DVZ_PROP_SCALE,
     DVZ_PROP_TRANSFORM,
+    DVZ_PROP_VALUE,
+    DVZ_PROP_ROTATION,
+    DVZ_PROP_BIN_COUNT,
+    DVZ_PROP_NORMALIZATION,
 } DvzPropType;
 
 
@@ -110,6 +119,9 @@ typedef enum
     DVZ_SOURCE_TYPE_COLOR_TEXTURE, //
     DVZ_SOURCE_TYPE_FONT_ATLAS,    //
     DVZ_SOURCE_TYPE_OTHER,         //
+    DVZ_SOURCE_TYPE_INSTANCE,      //
+    DVZ_SOURCE_TYPE_SAMPLES,       //
+    DVZ_SOURCE_TYPE_COUNTS,        //
 
     DVZ_SOURCE_TYPE_COUNT,
 } DvzSourceType;
@@ -150,11 +162,35 @@ typedef enum
 
 
 
+// Normalization of the density image before the colormap lookup.
+typedef enum
+{
+    DVZ_DENSITY_NORM_LINEAR,  // proportional to the density
+    DVZ_DENSITY_NORM_LOG,     // proportional to the logarithm of the density
+    DVZ_DENSITY_NORM_EQ_HIST, // histogram equalization of the non-empty pixels
+} DvzDensityNorm;
+
+
+
+// Background baking state of a visual.
+typedef enum
+{
+    DVZ_VISUAL_BAKE_NONE,    // the source arrays match the GPU data
+    DVZ_VISUAL_BAKE_PENDING, // the back arrays of the sources are being baked in a worker thread
+    DVZ_VISUAL_BAKE_DONE,    // the back arrays are ready to be swapped and uploaded
+} DvzVisualBakeState;
+
+
+
 /*************************************************************************************************/
 /*  Typedefs                                                                                     */
 /*************************************************************************************************/
 
 typedef struct DvzVisual DvzVisual;
+typedef struct DvzVisualCulling DvzVisualCulling;
+typedef struct DvzVisualBinning DvzVisualBinning;
+typedef struct DvzVisualDensity DvzVisualDensity;
+typedef struct DvzVisualBake DvzVisualBake;
 typedef struct DvzProp DvzProp;
 
 typedef union DvzSourceUnion DvzSourceUnion;
@@ -223,6 +259,25 @@ struct DvzSource
     int flags;
     DvzArray arr; // array to be uploaded to that source
 
+    // Double buffering for the background baking: while the visual is baked, `arr` is filled by
+    // the worker thread and `arr_back` holds the array matching the GPU data.
+    DvzArray arr_back;
+    bool is_baking;
+
+    // Data streamed in chunks from an external memory region, for example a mapped NPY file. The
+    // region is NOT owned by the source and is uploaded without any intermediate copy, the array
+    // has no data and its item count is the number of items already uploaded.
+    const void* stream;
+    uint32_t stream_count;    // total number of items
+    uint32_t stream_chunk;    // maximum number of items uploaded per call to dvz_visual_stream()
+    DvzNpy* stream_npy;       // mapped file the items are streamed from, if any
+    uint32_t stream_released; // number of items whose file pages have been released
+
+    // Range of items to upload, set by the baking callbacks that only change part of the array.
+    // The whole array is uploaded when the count is 0.
+    uint32_t upload_first;
+    uint32_t upload_count;
+
     DvzSourceOrigin origin; // whether the underlying GPU object is handled by the user or datoviz
     DvzSourceUnion u;
 };
@@ -250,6 +305,11 @@ struct DvzProp
     DvzArray arr_staging; // optional modification made to the prop by the baking function
     // DvzArray arr_triang; // triangulated data array
 
+    // Range of items changed since the last bake, for the baking callbacks that only update the
+    // affected part of the source arrays. All items are marked when the item count changes.
+    uint32_t changed_first;
+    uint32_t changed_count;
+
     DvzDataType target_dtype; // used for casting during the copy to the vertex array
     DvzArrayCopyType copy_type;
     uint32_t reps; // number of repeats when copying
@@ -262,6 +322,89 @@ struct DvzProp
 /*  Visual struct                                                                                */
 /*************************************************************************************************/
 
+// GPU viewport culling of point-like visuals: a compute pass compacts the indices of the visible
+// vertices and the visual is drawn with an indexed indirect draw.
+struct DvzVisualCulling
+{
+    DvzCompute* compute;
+    DvzBindings bindings;
+
+    DvzBufferRegions br_vertex;   // vertex buffer regions bound to the compute shader
+    DvzBufferRegions br_index;    // compacted indices of the visible vertices, one per image
+    DvzBufferRegions br_indirect; // VkDrawIndexedIndirectCommand, one per image
+    uint32_t capacity;            // maximum number of indices in br_index
+
+    float margin;         // extra margin around the viewport, in pixels
+    uint32_t size_offset; // offset of the float size attribute in the vertex, in bytes (0: none)
+    uint32_t mode_offset; // offset of the uint8 transform attribute, in bytes (0: none)
+};
+
+
+// GPU binning of the samples of a histogram: a compute pass counts the samples of the SAMPLES
+// source into per-workgroup histograms merged into the bins, a second one reduces the bin counts
+// to the largest count, and the graphics pipeline reads the bin counts directly.
+struct DvzVisualBinning
+{
+    DvzCompute* compute;
+    DvzBindings bindings;
+
+    DvzCommands cmds; // one-shot binning command buffer, submitted to the render queue
+    DvzFences fence;
+    DvzSubmit submit;
+
+    DvzBufferRegions br_samples; // samples region bound to the compute shader
+    DvzBufferRegions br_counts;  // maximum count, followed by the bin counts
+    uint32_t capacity;           // maximum number of bins in br_counts
+
+    uint32_t bin_count;  // number of bins
+    vec2 range;          // range of the sample values covered by the bins
+    atomic(bool, dirty); // whether the samples need to be binned again
+};
+
+
+// Screen-space density of a point cloud: compute passes, submitted before the frame when the
+// points, the MVP, or the viewport have changed, accumulate the points of the SAMPLES source into
+// a per-pixel image of the panel viewport, and the graphics pipeline maps the image to the
+// colormap.
+struct DvzVisualDensity
+{
+    DvzCompute* compute;
+    DvzBindings bindings;
+
+    DvzCommands cmds; // one-shot density command buffers, one per swapchain image
+    DvzFences fence;
+    DvzSubmit submit;
+
+    DvzBufferRegions br_density; // header followed by the density image
+    uint32_t capacity;           // maximum number of pixels in br_density
+    uint32_t count;              // number of points accumulated by the last pass
+
+    DvzDensityNorm norm;
+    DvzViewport viewport;      // viewport of the panel the visual is drawn in
+    DvzMVP mvp;                // MVP of the last accumulation
+    uint64_t accumulate_count; // number of submitted accumulations
+    atomic(bool, dirty);       // whether the points need to be accumulated again
+};
+
+
+// Background baking of a visual, see DVZ_VISUAL_FLAGS_BAKE_ASYNC.
+struct DvzVisualBake
+{
+    atomic(DvzVisualBakeState, state);
+    pthread_mutex_t lock; // protects the end of the bake, signalled with the condition
+    pthread_cond_t cond;
+
+    // Copy of the panel state when the bake started.
+    DvzViewport viewport;
+    DvzDataCoords coords;
+
+    uint32_t to_normalize; // POS props to renormalize at the next bake, one bit per prop index
+    uint32_t normalize;    // POS props renormalized by the current bake
+    DvzBox box;            // bounding box of the renormalized POS props
+};
+
+
+
 struct DvzVisual
 {
     DvzObject obj;
@@ -274,11 +417,12 @@ struct DvzVisual
     uint32_t graphics_count;
     DvzGraphics* graphics[DVZ_MAX_GRAPHICS_PER_VISUAL];
 
-    // Keep track of the previous number of vertices/indices in each graphics pipeline, so that
-    // we can automatically detect changes in vetex_count/index_count and trigger a full REFILL
-    // in this case.
+    // Keep track of the previous number of vertices/indices/instances in each graphics pipeline,
+    // so that we can automatically detect changes in vetex_count/index_count/instance_count and
+    // trigger a full REFILL in this case.
     uint32_t prev_vertex_count[DVZ_MAX_GRAPHICS_PER_VISUAL];
     uint32_t prev_index_count[DVZ_MAX_GRAPHICS_PER_VISUAL];
+    uint32_t prev_instance_count[DVZ_MAX_GRAPHICS_PER_VISUAL];
 
     // Computes.
     uint32_t compute_count;
@@ -305,6 +449,28 @@ struct DvzVisual
     DvzInteractAxis interact_axis[DVZ_MAX_GRAPHICS_PER_VISUAL];
     DvzViewportClip clip[DVZ_MAX_GRAPHICS_PER_VISUAL];
     DvzViewport viewport; // usually the visual's panel viewport, but may be customized
+    uint32_t pick_id;     // id written by the picking-aware graphics, unique within the canvas
+
+    // Optional decimation pyramid of the POS prop, only the visible window is uploaded.
+    DvzLod* lod;
+
+    // Optional GPU culling of the vertices outside of the viewport.
+    DvzVisualCulling* culling;
+
+    // Optional GPU binning of the samples, used by the histogram visual.
+    DvzVisualBinning* binning;
+
+    // Optional screen-space density of the points, used by the density visual.
+    DvzVisualDensity* density;
+
+    // Optional tiled mip pyramid of a large image, only the visible tiles are uploaded.
+    DvzTiles* tiles;
+
+    // Optional bricked storage of a large volume, only the non-empty bricks are uploaded.
+    DvzBricks* bricks;
+
+    // Optional background baking.
+    DvzVisualBake bake;
 
     // GPU data
     DvzContainer bindings;
@@ -540,6 +706,53 @@ DVZ_EXPORT void dvz_visual_data_source(
     DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx, //
     uint32_t first_item, uint32_t item_count, uint32_t data_item_count, const void* data);
 
+/**
+ * Stream data to a buffer source, in chunks, from an external memory region.
+ *
+ * The GPU buffer is allocated for all items, but the data is only uploaded by the successive
+ * calls to `dvz_visual_stream()`, directly from the passed region, without any intermediate copy.
+ * The visual only draws the items already uploaded. The region must remain valid until the visual
+ * is destroyed or its source is set again.
+ *
+ * @param visual the visual
+ * @param source_type the source type
+ * @param source_idx the source index
+ * @param item_count the total number of items
+ * @param chunk_count the maximum number of items to upload per call to `dvz_visual_stream()`
+ * @param data the data, that should be in the dtype of the source
+ */
+DVZ_EXPORT void dvz_visual_data_stream(
+    DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx, //
+    uint32_t item_count, uint32_t chunk_count, const void* data);
+
+/**
+ * Stream the payload of a mapped NPY or raw binary file to a buffer source.
+ *
+ * The payload must be an array of items in the dtype of the source, for example a structured
+ * array matching the vertex struct of the visual, in C order. It is uploaded in chunks of about
+ * DVZ_NPY_CHUNK_SIZE bytes, so that the file pages are only read when they are uploaded, and
+ * released once they have been transferred. The file must remain open until the visual is
+ * destroyed or its source is set again.
+ *
+ * @param visual the visual
+ * @param source_type the source type
+ * @param source_idx the source index
+ * @param npy the opened file
+ */
+DVZ_EXPORT void dvz_visual_npy(
+    DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx, DvzNpy* npy);
+
+/**
+ * Upload the next chunk of the streamed sources of a visual.
+ *
+ * This function is called at every frame by the scene. Otherwise, the canvas must be refilled
+ * when the function returns true, as the number of items to draw has changed.
+ *
+ * @param visual the visual
+ * @returns whether some data was uploaded
+ */
+DVZ_EXPORT bool dvz_visual_stream(DvzVisual* visual);
+
 /**
  * Set an existing GPU buffer for a visual source.
  *
@@ -618,6 +831,85 @@ DVZ_EXPORT void dvz_visual_fill_begin(DvzCanvas* canvas, DvzCommands* cmds, uint
  */
 DVZ_EXPORT void dvz_visual_fill_end(DvzCanvas* canvas, DvzCommands* cmds, uint32_t idx);
 
+/**
+ * Enable GPU viewport culling for a visual with a single point-like graphics pipeline.
+ *
+ * A compute pass, recorded before the render pass, writes the indices of the vertices that fall
+ * within the viewport and the visual is then drawn with an indexed indirect draw. The draw order
+ * of the vertices is not preserved.
+ *
+ * @param visual the visual
+ * @param margin extra margin around the viewport, in pixels
+ */
+DVZ_EXPORT void dvz_visual_culling(DvzVisual* visual, float margin);
+
+/**
+ * Record the culling compute pass of a visual, must be called outside of the render pass.
+ *
+ * @param visual the visual
+ * @param cmds the command buffers
+ * @param idx the command buffer index
+ */
+DVZ_EXPORT void dvz_visual_cull(DvzVisual* visual, DvzCommands* cmds, uint32_t idx);
+
+/**
+ * Enable GPU binning of the samples of a visual, or change the bins.
+ *
+ * The samples (float) are read from the SAMPLES source #0 by a compute pass that counts them into
+ * a shared histogram per workgroup, merged once into the bins. The bin counts, preceded by the
+ * maximum count, are bound to the COUNTS source #0 of the graphics pipeline. Changing the bins
+ * only dispatches the compute pass again, the samples are not uploaded again.
+ *
+ * @param visual the visual
+ * @param bin_count the number of bins
+ * @param range the range of the sample values covered by the bins
+ */
+DVZ_EXPORT void dvz_visual_binning(DvzVisual* visual, uint32_t bin_count, vec2 range);
+
+/**
+ * Submit the binning compute pass of a visual if the samples or the bins have changed.
+ *
+ * The pass is submitted to the render queue, it must be called before the submission of the frame
+ * that uses the bin counts.
+ *
+ * @param visual the visual
+ */
+DVZ_EXPORT void dvz_visual_bin(DvzVisual* visual);
+
+/**
+ * Enable the screen-space density of the points of a visual, or change its normalization.
+ *
+ * The points (DvzGraphicsDensityPoint) are read from the SAMPLES source #0 by a compute pass that
+ * sums their weights into a per-pixel image of the panel viewport, saturating at UINT32_MAX. The
+ * largest value is computed by a reduction pass over the pixels. The image, preceded by a header,
+ * is bound to the COUNTS source #0 of the graphics pipeline. The passes only run again when the
+ * points, the MVP matrices, or the viewport change, panning and zooming do not upload the points
+ * again.
+ *
+ * @param visual the visual
+ * @param norm the normalization of the density before the colormap lookup
+ */
+DVZ_EXPORT void dvz_visual_density(DvzVisual* visual, DvzDensityNorm norm);
+
+/**
+ * Set the viewport of the density image of a visual, when the command buffers are recorded.
+ *
+ * @param visual the visual
+ * @param viewport the viewport of the panel the visual is drawn in
+ */
+DVZ_EXPORT void dvz_visual_density_viewport(DvzVisual* visual, DvzViewport viewport);
+
+/**
+ * Submit the density compute passes of a visual if the points, the MVP, or the viewport have
+ * changed.
+ *
+ * The passes are submitted to the render queue, it must be called before the submission of the
+ * frame that uses the density image, after the MVP of the frame has been written.
+ *
+ * @param visual the visual
+ */
+DVZ_EXPORT void dvz_visual_accumulate(DvzVisual* visual);
+
 /**
  * Set the visual bake callback function.
  *
@@ -715,6 +1007,34 @@ DVZ_EXPORT void* dvz_prop_item(DvzProp* prop, uint32_t prop_idx);
 DVZ_EXPORT void dvz_visual_update(
     DvzVisual* visual, DvzViewport viewport, DvzDataCoords coords, const void* user_data);
 
+/**
+ * Fill the source arrays from the visual props, without uploading them.
+ *
+ * This function calls the bake callback, and may run in a worker thread as long as the bake
+ * callback only fills the source arrays.
+ *
+ * @param visual the visual
+ * @param viewport the viewport
+ * @param coords the data coordinates and transformation
+ * @param user_data arbitrary user data pointer
+ */
+DVZ_EXPORT void dvz_visual_bake(
+    DvzVisual* visual, DvzViewport viewport, DvzDataCoords coords, const void* user_data);
+
+/**
+ * Upload the changed source arrays to the GPU buffers and textures.
+ *
+ * @param visual the visual
+ */
+DVZ_EXPORT void dvz_visual_upload(DvzVisual* visual);
+
+/**
+ * Wait until the pending background baking of a visual, if any, has completed.
+ *
+ * @param visual the visual
+ */
+DVZ_EXPORT void dvz_visual_bake_wait(DvzVisual* visual);
+
 
 
 #endif
@@ -90,6 +90,7 @@ typedef struct DvzBarrierImage DvzBarrierImage;
 typedef struct DvzBarrier DvzBarrier;
 typedef struct DvzSemaphores DvzSemaphores;
 typedef struct DvzFences DvzFences;
+typedef struct DvzQueries DvzQueries;
 typedef struct DvzRenderpass DvzRenderpass;
 typedef struct DvzRenderpassAttachment DvzRenderpassAttachment;
 typedef struct DvzRenderpassSubpass DvzRenderpassSubpass;
@@ -179,6 +180,11 @@ typedef enum
     DVZ_GRAPHICS_FAKE_SPHERE,
     DVZ_GRAPHICS_VOLUME,
 
+    DVZ_GRAPHICS_MARKER_CMAP,
+    DVZ_GRAPHICS_MESH_INSTANCED,
+    DVZ_GRAPHICS_HISTOGRAM,
+    DVZ_GRAPHICS_DENSITY,
+
     DVZ_GRAPHICS_COUNT,
     DVZ_GRAPHICS_CUSTOM,
 } DvzGraphicsType;
@@ -218,6 +224,7 @@ typedef enum
 {
     DVZ_RENDERPASS_ATTACHMENT_COLOR,
     DVZ_RENDERPASS_ATTACHMENT_DEPTH,
+    DVZ_RENDERPASS_ATTACHMENT_RESOLVE,
 } DvzRenderpassAttachmentType;
 
 
@@ -340,6 +347,9 @@ struct DvzGpu
     VkPhysicalDeviceFeatures requested_features;
     VkDevice device;
 
+    // Serializes the host access to the queues, which may be used from several threads.
+    pthread_mutex_t queue_lock;
+
     DvzContext* context;
 };
 
@@ -446,6 +456,7 @@ struct DvzImages
     VkImageViewType view_type;
     uint32_t width, height, depth;
     VkFormat format;
+    VkSampleCountFlagBits samples;
     VkImageLayout layout;
     VkImageTiling tiling;
     VkImageUsageFlags usage;
@@ -531,6 +542,7 @@ struct DvzVertexBinding
 {
     uint32_t binding;
     VkDeviceSize stride;
+    VkVertexInputRate input_rate;
 };
 
 
@@ -562,6 +574,7 @@ struct DvzGraphics
     VkPolygonMode polygon_mode;
     VkCullModeFlags cull_mode;
     VkFrontFace front_face;
+    bool pick; // whether the fragment shader writes to the object picking attachment
 
     VkPipeline pipeline;
     DvzSlots slots;
@@ -641,6 +654,18 @@ struct DvzFences
 
 
 
+struct DvzQueries
+{
+    DvzObject obj;
+    DvzGpu* gpu;
+
+    VkQueryType type;
+    uint32_t count;
+    VkQueryPool pool;
+};
+
+
+
 struct DvzSemaphores
 {
     DvzObject obj;
@@ -657,6 +682,7 @@ struct DvzRenderpassAttachment
     VkImageLayout ref_layout;
     DvzRenderpassAttachmentType type;
     VkFormat format;
+    VkSampleCountFlagBits samples;
 
     VkImageLayout src_layout;
     VkImageLayout dst_layout;
@@ -754,6 +780,7 @@ struct DvzTexture
 
     DvzImages* image;
     DvzSampler* sampler;
+    uint64_t version; // incremented whenever the texture contents change
 };
 
 
@@ -1276,6 +1303,14 @@ DVZ_EXPORT void dvz_images_layout(DvzImages* images, VkImageLayout layout);
 DVZ_EXPORT void
 dvz_images_size(DvzImages* images, uint32_t width, uint32_t height, uint32_t depth);
 
+/**
+ * Set the number of samples per pixel, for multisampled attachments.
+ *
+ * @param images the images
+ * @param samples the sample count
+ */
+DVZ_EXPORT void dvz_images_samples(DvzImages* images, VkSampleCountFlagBits samples);
+
 /**
  * Set the images tiling.
  *
@@ -1547,6 +1582,15 @@ DVZ_EXPORT void dvz_compute_create(DvzCompute* compute);
  */
 DVZ_EXPORT void dvz_compute_code(DvzCompute* compute, const char* code);
 
+/**
+ * Set the SPIRV code directly, for example a shader embedded in the library resources.
+ *
+ * @param compute the compute pipeline
+ * @param size the size of the SPIRV buffer, in bytes
+ * @param buffer the binary buffer with the SPIRV code
+ */
+DVZ_EXPORT void dvz_compute_spirv(DvzCompute* compute, VkDeviceSize size, const uint32_t* buffer);
+
 /**
  * Declare a slot for the compute pipeline.
  *
@@ -1655,6 +1699,16 @@ dvz_graphics_shader(DvzGraphics* graphics, VkShaderStageFlagBits stage, const ch
 DVZ_EXPORT void
 dvz_graphics_vertex_binding(DvzGraphics* graphics, uint32_t binding, VkDeviceSize stride);
 
+/**
+ * Set a vertex binding whose attributes advance once per instance instead of once per vertex.
+ *
+ * @param graphics the graphics pipeline
+ * @param binding the binding index
+ * @param stride the stride in the instance buffer, in bytes
+ */
+DVZ_EXPORT void
+dvz_graphics_instance_binding(DvzGraphics* graphics, uint32_t binding, VkDeviceSize stride);
+
 /**
  * Add a vertex attribute.
  *
@@ -1676,6 +1730,19 @@ DVZ_EXPORT void dvz_graphics_vertex_attr(
  */
 DVZ_EXPORT void dvz_graphics_blend(DvzGraphics* graphics, DvzBlendType blend_type);
 
+/**
+ * Set whether the graphics writes the object picking ids.
+ *
+ * When the subpass has more than one color attachment, the fragment shader of a picking-aware
+ * graphics writes a `uvec2` (visual id, item index) at location 1. Opaque graphics that are not
+ * pickable write 0 there, so that they hide the items behind them. The other graphics leave the
+ * picking attachment untouched.
+ *
+ * @param graphics the graphics pipeline
+ * @param pick whether the graphics writes to the picking attachment
+ */
+DVZ_EXPORT void dvz_graphics_pick(DvzGraphics* graphics, bool pick);
+
 /**
  * Set the graphics depth test.
  *
@@ -1914,6 +1981,41 @@ DVZ_EXPORT void dvz_fences_destroy(DvzFences* fences);
 
 
 
+/*************************************************************************************************/
+/*  Queries                                                                                      */
+/*************************************************************************************************/
+
+/**
+ * Create a pool of GPU queries.
+ *
+ * @param gpu the GPU
+ * @param type the query type, for example VK_QUERY_TYPE_TIMESTAMP
+ * @param count the number of queries
+ * @returns the queries
+ */
+DVZ_EXPORT DvzQueries dvz_queries(DvzGpu* gpu, VkQueryType type, uint32_t count);
+
+/**
+ * Get the 64-bit results of a range of queries, without waiting.
+ *
+ * @param queries the queries
+ * @param first the first query
+ * @param count the number of queries
+ * @param[out] results the results
+ * @returns whether all results were available
+ */
+DVZ_EXPORT bool
+dvz_queries_results(DvzQueries* queries, uint32_t first, uint32_t count, uint64_t* results);
+
+/**
+ * Destroy queries.
+ *
+ * @param queries the queries
+ */
+DVZ_EXPORT void dvz_queries_destroy(DvzQueries* queries);
+
+
+
 /*************************************************************************************************/
 /*  Renderpass                                                                                   */
 /*************************************************************************************************/
@@ -1970,6 +2072,20 @@ DVZ_EXPORT void dvz_renderpass_attachment_ops(
     DvzRenderpass* renderpass, uint32_t idx, //
     VkAttachmentLoadOp load_op, VkAttachmentStoreOp store_op);
 
+/**
+ * Set the number of samples per pixel of an attachment.
+ *
+ * The color and depth attachments of a subpass must have the same sample count. A multisampled
+ * color attachment is resolved into the `DVZ_RENDERPASS_ATTACHMENT_RESOLVE` attachment of the
+ * subpass, if any. The graphics pipelines use the sample count of their subpass.
+ *
+ * @param renderpass the render pass
+ * @param idx the attachment index
+ * @param samples the sample count
+ */
+DVZ_EXPORT void dvz_renderpass_attachment_samples(
+    DvzRenderpass* renderpass, uint32_t idx, VkSampleCountFlagBits samples);
+
 /**
  * Set a subpass attachment.
  *
@@ -2197,6 +2313,21 @@ DVZ_EXPORT void dvz_cmd_copy_buffer_to_image(
 DVZ_EXPORT void dvz_cmd_copy_image_to_buffer(
     DvzCommands* cmds, uint32_t idx, DvzImages* images, DvzBuffer* buffer);
 
+/**
+ * Copy a region of a GPU image to a GPU buffer.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param images the image
+ * @param offset the offset of the region within the image
+ * @param shape the shape of the region
+ * @param buffer the buffer
+ * @param buf_offset the offset within the buffer, the texels are tightly packed
+ */
+DVZ_EXPORT void dvz_cmd_copy_image_region_to_buffer(
+    DvzCommands* cmds, uint32_t idx, DvzImages* images, ivec3 offset, uvec3 shape,
+    DvzBuffer* buffer, VkDeviceSize buf_offset);
+
 /**
  * Copy a GPU image to another.
  *
@@ -2241,6 +2372,18 @@ DVZ_EXPORT void dvz_cmd_bind_graphics(
 DVZ_EXPORT void dvz_cmd_bind_vertex_buffer(
     DvzCommands* cmds, uint32_t idx, DvzBufferRegions br, VkDeviceSize offset);
 
+/**
+ * Bind a per-instance vertex buffer.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param binding the vertex binding index of the instance attributes
+ * @param br the buffer regions
+ * @param offset the offset within the buffer regions, in bytes
+ */
+DVZ_EXPORT void dvz_cmd_bind_instance_buffer(
+    DvzCommands* cmds, uint32_t idx, uint32_t binding, DvzBufferRegions br, VkDeviceSize offset);
+
 /**
  * Bind an index buffer.
  *
@@ -2276,6 +2419,35 @@ DVZ_EXPORT void dvz_cmd_draw_indexed(
     DvzCommands* cmds, uint32_t idx, uint32_t first_index, uint32_t vertex_offset,
     uint32_t index_count);
 
+/**
+ * Direct instanced draw.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param first_vertex index of the first vertex
+ * @param vertex_count number of vertices to draw
+ * @param first_instance index of the first instance
+ * @param instance_count number of instances to draw
+ */
+DVZ_EXPORT void dvz_cmd_draw_instanced(
+    DvzCommands* cmds, uint32_t idx, uint32_t first_vertex, uint32_t vertex_count,
+    uint32_t first_instance, uint32_t instance_count);
+
+/**
+ * Direct indexed instanced draw.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param first_index index of the first index
+ * @param vertex_offset offset of the vertex
+ * @param index_count number of indices to draw
+ * @param first_instance index of the first instance
+ * @param instance_count number of instances to draw
+ */
+DVZ_EXPORT void dvz_cmd_draw_indexed_instanced(
+    DvzCommands* cmds, uint32_t idx, uint32_t first_index, uint32_t vertex_offset,
+    uint32_t index_count, uint32_t first_instance, uint32_t instance_count);
+
 /**
  * Indirect draw.
  *
@@ -2295,6 +2467,20 @@ DVZ_EXPORT void dvz_cmd_draw_indirect(DvzCommands* cmds, uint32_t idx, DvzBuffer
 DVZ_EXPORT void
 dvz_cmd_draw_indexed_indirect(DvzCommands* cmds, uint32_t idx, DvzBufferRegions indirect);
 
+/**
+ * Fill a GPU buffer region with a repeated 32-bit value.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param br the buffer regions
+ * @param offset the offset within the buffer region, in bytes, must be a multiple of 4
+ * @param size the size to fill, in bytes, must be a multiple of 4
+ * @param value the 32-bit value
+ */
+DVZ_EXPORT void dvz_cmd_fill_buffer(
+    DvzCommands* cmds, uint32_t idx, DvzBufferRegions br, //
+    VkDeviceSize offset, VkDeviceSize size, uint32_t value);
+
 /**
  * Copy a GPU buffer to another.
  *
@@ -2327,6 +2513,31 @@ DVZ_EXPORT void dvz_cmd_push(
     DvzCommands* cmds, uint32_t idx, DvzSlots* slots, VkShaderStageFlagBits shaders, //
     VkDeviceSize offset, VkDeviceSize size, const void* data);
 
+/**
+ * Reset a range of queries, outside of a render pass.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param queries the queries
+ * @param first the first query
+ * @param count the number of queries
+ */
+DVZ_EXPORT void dvz_cmd_reset_queries(
+    DvzCommands* cmds, uint32_t idx, DvzQueries* queries, uint32_t first, uint32_t count);
+
+/**
+ * Write a GPU timestamp once the previous commands have reached a pipeline stage.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param stage the pipeline stage
+ * @param queries the timestamp queries
+ * @param query the query index
+ */
+DVZ_EXPORT void dvz_cmd_timestamp(
+    DvzCommands* cmds, uint32_t idx, VkPipelineStageFlagBits stage, DvzQueries* queries,
+    uint32_t query);
+
 
 
 /*************************************************************************************************/
@@ -65,6 +65,11 @@ then
          ${@:2}
 fi
 
+if [ $1 == "bench" ]
+then
+    ./build/datoviz_bench --output build/bench.json $2
+fi
+
 if [ $1 == "test" ]
 then
     dump=""
@@ -65,7 +65,8 @@ static DvzAxesContext _axes_context(DvzController* controller, DvzAxisCoord coor
 
 
 // Recompute the tick locations as a function of the current axis range in data coordinates.
-static void _axes_ticks(DvzController* controller, DvzAxisCoord coord, dvec2 range)
+// Return whether the ticks changed.
+static bool _axes_ticks(DvzController* controller, DvzAxisCoord coord, dvec2 range)
 {
     ASSERT(controller != NULL);
     ASSERT(controller->type == DVZ_CONTROLLER_AXES_2D);
@@ -84,21 +85,25 @@ static void _axes_ticks(DvzController* controller, DvzAxisCoord coord, dvec2 ran
     double vlen = vmax - vmin;
     ASSERT(vlen > 0);
 
-    // Free the existing ticks.
-    if (axes->ticks[coord].values != NULL)
-        dvz_ticks_destroy(&axes->ticks[coord]);
-
-    // Determine the tick number and positions.
-    axes->ticks[coord] = dvz_ticks(vmin, vmax, ctx);
+    // Determine the tick number and positions, reusing the computation made on a nearby range
+    // with the same context if there is one.
+    DvzAxesTicks* ticks = dvz_ticks_cached(&axes->cache[coord], vmin, vmax, ctx);
+    ASSERT(ticks != NULL);
 
     // We keep track of the context.
     axes->ctx[coord] = ctx;
+
+    if (dvz_ticks_equal(ticks, &axes->ticks[coord]))
+        return false;
+    dvz_ticks_copy(ticks, &axes->ticks[coord]);
+    return true;
 }
 
 
 
-// Update the axes visual's data as a function of the computed ticks.
-static void _axes_upload(DvzController* controller, DvzAxisCoord coord)
+// Update the axes visual's data as a function of the computed ticks. When the ticks were shifted
+// by a number of steps, only the slots of the new ticks are updated.
+static void _axes_upload(DvzController* controller, DvzAxisCoord coord, int32_t shift)
 {
     ASSERT(controller != NULL);
     ASSERT(controller->type == DVZ_CONTROLLER_AXES_2D);
@@ -117,46 +122,97 @@ static void _axes_upload(DvzController* controller, DvzAxisCoord coord)
 
     DvzAxesTicks* axticks = &axes->ticks[coord];
     uint32_t N = axticks->value_count;
+    ASSERT(N >= 2);
+
+    // Slot of the first tick, kept modulo N (N - 1) to get the slots of both the ticks and the
+    // minor ticks.
+    uint32_t s = (uint32_t)abs(shift);
+    bool is_ring = s > 0 && s < N - 1 && N == axes->ring_count[coord];
+    int32_t m = (int32_t)(N * (N - 1));
+    int32_t ring = is_ring ? ((axes->ring[coord] + shift) % m + m) % m : 0;
+    axes->ring[coord] = ring;
+    axes->ring_count[coord] = N;
 
     // Range used for normalization of the ticks (corresponds to init panzoom).
     double vmin = axes->box.p0[coord];
     double vmax = axes->box.p1[coord];
 
-    // Normalize the tick values to fit in NDC range.
-    double* ticks = (double*)calloc(N, sizeof(double));
-    for (uint32_t i = 0; i < N; i++)
+    // Grow the reusable buffers if needed, the minor ticks follow the major ticks.
+    uint32_t size = N + 4 * (N - 1);
+    if (axes->buffer_size < size)
     {
-        ticks[i] = -1 + 2 * (axticks->values[i] - vmin) / (vmax - vmin);
-        // log_info("%d %f vmin=%f vmax=%f", i, ticks[i], vmin, vmax);
+        axes->buffer = (double*)realloc(axes->buffer, size * sizeof(double));
+        axes->text = (char**)realloc(axes->text, size * sizeof(char*));
+        ASSERT(axes->buffer != NULL);
+        ASSERT(axes->text != NULL);
+        axes->buffer_size = size;
     }
 
-    // Minor ticks.
-    double* minor_ticks = (double*)calloc((N - 1) * 4, sizeof(double));
-    uint32_t k = 0;
-    for (uint32_t i = 0; i < N - 1; i++)
-        for (uint32_t j = 1; j <= 4; j++)
-            minor_ticks[k++] = ticks[i] + j * (ticks[i + 1] - ticks[i]) / 5.;
-    ASSERT(k == (N - 1) * 4);
+    // The labels are copied in slot order, the TEXT prop refers to them.
+    dvz_visual_bake_wait(visual);
+    if (!is_ring)
+    {
+        axes->labels[coord] =
+            (char*)realloc(axes->labels[coord], N * MAX_GLYPHS_PER_TICK * sizeof(char));
+        ASSERT(axes->labels[coord] != NULL);
+    }
 
-    // Prepare text values.
-    char** text = (char**)calloc(N, sizeof(char*));
+    // Normalize the tick values to fit in NDC range, in slot order, along with the minor ticks
+    // following each tick and the labels.
+    double* ticks = axes->buffer;
+    double* minor_ticks = &axes->buffer[N];
+    char** text = axes->text;
+    double x0 = 0, x1 = 0;
+    uint32_t slot = 0;
     for (uint32_t i = 0; i < N; i++)
     {
-        text[i] = &axticks->labels[i * MAX_GLYPHS_PER_TICK];
-        // log_info("%f %s", ticks[i], text[i]);
+        slot = (i + (uint32_t)ring) % N;
+        x0 = -1 + 2 * (axticks->values[i] - vmin) / (vmax - vmin);
+        ticks[slot] = x0;
+        text[slot] = &axes->labels[coord][slot * MAX_GLYPHS_PER_TICK];
+        memcpy(
+            text[slot], &axticks->labels[i * MAX_GLYPHS_PER_TICK],
+            MAX_GLYPHS_PER_TICK * sizeof(char));
+        if (i == N - 1)
+            break;
+        x1 = -1 + 2 * (axticks->values[i + 1] - vmin) / (vmax - vmin);
+        slot = (i + (uint32_t)ring) % (N - 1);
+        for (uint32_t j = 1; j <= 4; j++)
+            minor_ticks[4 * slot + j - 1] = x0 + j * (x1 - x0) / 5.;
     }
 
     // Set visual data.
-    double lim[] = {-1};
-    dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MINOR, 4 * (N - 1), minor_ticks);
-    dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MAJOR, N, ticks);
-    dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_GRID, N, ticks);
-    dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_LIM, 1, lim);
-    dvz_visual_data(visual, DVZ_PROP_TEXT, 0, N, text);
-
-    FREE(minor_ticks);
-    FREE(ticks);
-    FREE(text);
+    if (!is_ring)
+    {
+        double lim[] = {-1};
+        dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MINOR, 4 * (N - 1), minor_ticks);
+        dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MAJOR, N, ticks);
+        dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_GRID, N, ticks);
+        dvz_visual_data(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_LIM, 1, lim);
+        dvz_visual_data(visual, DVZ_PROP_TEXT, 0, N, text);
+        return;
+    }
+
+    // Only update the slots of the new ticks: the last ones when shifting to the right, the first
+    // ones otherwise. The unchanged labels are still referenced by the TEXT prop.
+    uint32_t i0 = shift > 0 ? N - s : 0;
+    for (uint32_t i = i0; i < i0 + s; i++)
+    {
+        slot = (i + (uint32_t)ring) % N;
+        dvz_visual_data_partial(
+            visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MAJOR, slot, 1, 1, &ticks[slot]);
+        dvz_visual_data_partial(
+            visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_GRID, slot, 1, 1, &ticks[slot]);
+        dvz_visual_data_partial(visual, DVZ_PROP_TEXT, 0, slot, 1, 1, &text[slot]);
+    }
+    // New minor ticks, between the new ticks and the kept ones.
+    i0 = shift > 0 ? N - 1 - s : 0;
+    for (uint32_t i = i0; i < i0 + s; i++)
+    {
+        slot = (i + (uint32_t)ring) % (N - 1);
+        dvz_visual_data_partial(
+            visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MINOR, 4 * slot, 4, 4, &minor_ticks[4 * slot]);
+    }
 }
 
 
@@ -186,7 +242,7 @@ static void _axes_set(DvzController* controller, DvzBox box)
         _axes_ticks(controller, coord, (dvec2){box.p0[coord], box.p1[coord]});
 
         // Upload the data.
-        _axes_upload(controller, coord);
+        _axes_upload(controller, coord, 0);
     }
 }
 
@@ -246,11 +302,6 @@ static bool _axes_collision(DvzController* controller, DvzAxisCoord coord, dvec2
     // Check whether there are overlapping labels (dezooming).
     double min_distance = min_distance_labels(ticks, &ctx);
 
-    // Check whether the current view is outside the computed ticks (panning);
-    bool outside = range[0] <= ticks->lmin_in || range[1] >= ticks->lmax_in;
-    // if (coord == 0)
-    //     log_info("%f %f %d", ticks->lmin_ex, ticks->lmax_ex, outside);
-
     double rel_space = min_distance / (ctx.size_viewport / scale);
 
     // if (i == 0)
@@ -260,7 +311,41 @@ static bool _axes_collision(DvzController* controller, DvzAxisCoord coord, dvec2
     // Recompute the ticks on the current axis?
     // }
 
-    return min_distance <= 0 || rel_space >= .5 || outside;
+    return min_distance <= 0 || rel_space >= .5;
+}
+
+
+
+// Whether the current view is outside the computed ticks (panning).
+static bool _axes_outside(DvzController* controller, DvzAxisCoord coord, dvec2 range)
+{
+    ASSERT(controller != NULL);
+    DvzAxesTicks* ticks = &controller->u.axes_2D.ticks[coord];
+    return range[0] <= ticks->lmin_in || range[1] >= ticks->lmax_in;
+}
+
+
+
+// Shift the ticks by a whole number of steps to center them on the current view when panning.
+// Return false if the ticks still do not cover the view and must be recomputed.
+static bool _axes_pan(DvzController* controller, DvzAxisCoord coord, dvec2 range, int32_t* shift)
+{
+    ASSERT(controller != NULL);
+    ASSERT(controller->type == DVZ_CONTROLLER_AXES_2D);
+    DvzAxesTicks* ticks = &controller->u.axes_2D.ticks[coord];
+    ASSERT(ticks->lstep > 0);
+
+    ASSERT(shift != NULL);
+
+    double offset = .5 * (range[0] + range[1] - ticks->lmin_in - ticks->lmax_in);
+    double steps = round(offset / ticks->lstep);
+    // Jumps larger than the tick range are handled as a full recomputation.
+    if (steps == 0 || fabs(steps) > ticks->value_count)
+        return false;
+
+    *shift = (int32_t)steps;
+    dvz_ticks_shift(ticks, *shift);
+    return !_axes_outside(controller, coord, range);
 }
 
 
@@ -310,7 +395,9 @@ static void _axes_refresh(DvzController* controller, bool force)
     // Check label collision
     // DEBUG
     // bool update[2] = {true, true}; // whether X and Y axes must be updated or not
-    bool update[2] = {false, false}; // whether X and Y axes must be updated or not
+    bool update[2] = {false, false}; // whether the X and Y ticks must be recomputed or not
+    bool upload[2] = {false, false}; // whether the X and Y axes visuals must be updated or not
+    int32_t shift[2] = {0, 0};       // number of steps the X and Y ticks were shifted by
 
     dvec2 range[2];
     // Compute current visible range in data coordinates in range[coord]
@@ -329,6 +416,13 @@ static void _axes_refresh(DvzController* controller, bool force)
         range[i][1] = out_tr[i];
 
         update[i] = _axes_collision(controller, (DvzAxisCoord)i, range[i]);
+
+        // When panning, shift the current ticks rather than recomputing them.
+        if (!update[i] && _axes_outside(controller, (DvzAxisCoord)i, range[i]))
+        {
+            upload[i] = _axes_pan(controller, (DvzAxisCoord)i, range[i], &shift[i]);
+            update[i] = !upload[i];
+        }
     }
 
     // Force axes ticks refresh when resizing.
@@ -340,10 +434,19 @@ static void _axes_refresh(DvzController* controller, bool force)
 
     for (uint32_t coord = 0; coord < 2; coord++)
     {
-        if (!update[coord])
+        // NOTE: the visual data is only uploaded when the ticks change. The shifted ticks only
+        // update the segments and the glyphs of the new ticks, the recomputed ticks update all
+        // of them.
+        if (update[coord])
+        {
+            // The ticks may have been shifted before being recomputed.
+            if (_axes_ticks(controller, (DvzAxisCoord)coord, range[coord]) || shift[coord] != 0)
+                upload[coord] = true;
+            shift[coord] = 0;
+        }
+        if (!upload[coord])
             continue;
-        _axes_ticks(controller, (DvzAxisCoord)coord, range[coord]);
-        _axes_upload(controller, (DvzAxisCoord)coord);
+        _axes_upload(controller, (DvzAxisCoord)coord, shift[coord]);
 
         // TODO: what else to do here? update a request??
         // canvas->obj.status = DVZ_OBJECT_STATUS_NEED_UPDATE;
@@ -467,7 +570,13 @@ static void _axes_destroy(DvzController* controller)
     for (uint32_t i = 0; i < 2; i++)
     {
         dvz_ticks_destroy(&axes->ticks[i]);
+        dvz_ticks_cache_destroy(&axes->cache[i]);
     }
+    FREE(axes->buffer);
+    FREE(axes->text);
+    FREE(axes->labels[0]);
+    FREE(axes->labels[1]);
+    axes->buffer_size = 0;
 }
 
 
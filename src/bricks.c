@@ -0,0 +1,675 @@
+#include "../include/datoviz/bricks.h"
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+typedef struct DvzBricksChunk DvzBricksChunk;
+
+struct DvzBricksChunk
+{
+    DvzBricks* bricks;
+    uint32_t level;
+};
+
+
+
+// Voxel of a level, normalized to 16 bits.
+static inline uint16_t _voxel(DvzBricks* bricks, uint32_t level, uint64_t idx)
+{
+    if (level > 0)
+        return bricks->levels[level].voxels[idx];
+    if (bricks->item_size == 1)
+        return (uint16_t)(((const uint8_t*)bricks->voxels)[idx] * 257);
+    return ((const uint16_t*)bricks->voxels)[idx];
+}
+
+
+
+static inline uint64_t _voxel_idx(DvzBricksLevel* level, uint32_t x, uint32_t y, uint32_t z)
+{
+    return ((uint64_t)z * level->height + y) * level->width + x;
+}
+
+
+
+// Range of voxels covered by a brick along one axis, including the gutter, clamped.
+static inline void _brick_extent(uint32_t idx, uint32_t size, uint32_t* first, uint32_t* last)
+{
+    int64_t a = (int64_t)idx * DVZ_BRICKS_SIZE - DVZ_BRICKS_GUTTER;
+    int64_t b = (int64_t)(idx + 1) * DVZ_BRICKS_SIZE + DVZ_BRICKS_GUTTER - 1;
+    *first = (uint32_t)CLIP(a, 0, (int64_t)size - 1);
+    *last = (uint32_t)CLIP(b, 0, (int64_t)size - 1);
+}
+
+
+
+// Downsample a range of z slices of a level, each voxel is the mean of 2x2x2 voxels of the
+// previous level (clamped at the edges).
+static void _bricks_downsample_chunk(
+    uint64_t first, uint64_t count, uint32_t thread_idx, void* user_data)
+{
+    DvzBricksChunk* chunk = (DvzBricksChunk*)user_data;
+    ASSERT(chunk != NULL);
+    DvzBricks* bricks = chunk->bricks;
+    ASSERT(bricks != NULL);
+    ASSERT(chunk->level >= 1);
+
+    uint32_t k = chunk->level;
+    DvzBricksLevel* prev = &bricks->levels[k - 1];
+    DvzBricksLevel* level = &bricks->levels[k];
+
+    uint32_t x0 = 0, x1 = 0, y0 = 0, y1 = 0, z0 = 0, z1 = 0, sum = 0;
+    for (uint32_t z = (uint32_t)first; z < first + count; z++)
+    {
+        if (atomic_load(&bricks->to_stop))
+            break;
+        z0 = 2 * z;
+        z1 = MIN(z0 + 1, prev->depth - 1);
+        for (uint32_t y = 0; y < level->height; y++)
+        {
+            y0 = 2 * y;
+            y1 = MIN(y0 + 1, prev->height - 1);
+            for (uint32_t x = 0; x < level->width; x++)
+            {
+                x0 = 2 * x;
+                x1 = MIN(x0 + 1, prev->width - 1);
+                sum = (uint32_t)_voxel(bricks, k - 1, _voxel_idx(prev, x0, y0, z0)) +
+                      (uint32_t)_voxel(bricks, k - 1, _voxel_idx(prev, x1, y0, z0)) +
+                      (uint32_t)_voxel(bricks, k - 1, _voxel_idx(prev, x0, y1, z0)) +
+                      (uint32_t)_voxel(bricks, k - 1, _voxel_idx(prev, x1, y1, z0)) +
+                      (uint32_t)_voxel(bricks, k - 1, _voxel_idx(prev, x0, y0, z1)) +
+                      (uint32_t)_voxel(bricks, k - 1, _voxel_idx(prev, x1, y0, z1)) +
+                      (uint32_t)_voxel(bricks, k - 1, _voxel_idx(prev, x0, y1, z1)) +
+                      (uint32_t)_voxel(bricks, k - 1, _voxel_idx(prev, x1, y1, z1));
+                level->voxels[_voxel_idx(level, x, y, z)] = (uint16_t)((sum + 4) / 8);
+            }
+        }
+    }
+}
+
+
+
+// Compute the range of values of a range of brick layers of a level.
+static void _bricks_range_chunk(
+    uint64_t first, uint64_t count, uint32_t thread_idx, void* user_data)
+{
+    DvzBricksChunk* chunk = (DvzBricksChunk*)user_data;
+    ASSERT(chunk != NULL);
+    DvzBricks* bricks = chunk->bricks;
+    ASSERT(bricks != NULL);
+
+    uint32_t k = chunk->level;
+    DvzBricksLevel* level = &bricks->levels[k];
+
+    uint32_t x0 = 0, x1 = 0, y0 = 0, y1 = 0, z0 = 0, z1 = 0;
+    uint16_t vmin = 0, vmax = 0, v = 0;
+    uint64_t idx = 0;
+    uint32_t brick = 0;
+    for (uint32_t l = (uint32_t)first; l < first + count; l++)
+    {
+        if (atomic_load(&bricks->to_stop))
+            break;
+        _brick_extent(l, level->depth, &z0, &z1);
+        for (uint32_t r = 0; r < level->rows; r++)
+        {
+            _brick_extent(r, level->height, &y0, &y1);
+            for (uint32_t c = 0; c < level->cols; c++)
+            {
+                _brick_extent(c, level->width, &x0, &x1);
+                vmin = UINT16_MAX;
+                vmax = 0;
+                for (uint32_t z = z0; z <= z1; z++)
+                {
+                    for (uint32_t y = y0; y <= y1; y++)
+                    {
+                        idx = _voxel_idx(level, x0, y, z);
+                        for (uint32_t x = x0; x <= x1; x++, idx++)
+                        {
+                            v = _voxel(bricks, k, idx);
+                            vmin = MIN(vmin, v);
+                            vmax = MAX(vmax, v);
+                        }
+                    }
+                }
+                brick = (l * level->rows + r) * level->cols + c;
+                level->range[brick] = (DvzBrickRange){vmin, vmax};
+            }
+        }
+    }
+}
+
+
+
+static void* _bricks_build(void* user_data)
+{
+    DvzBricks* bricks = (DvzBricks*)user_data;
+    ASSERT(bricks != NULL);
+
+    // From the finest to the coarsest level, each level is usable as soon as its brick ranges
+    // are known.
+    DvzBricksLevel* level = NULL;
+    DvzBricksChunk chunk = {bricks, 0};
+    for (uint32_t k = 0; k < bricks->level_count; k++)
+    {
+        level = &bricks->levels[k];
+        chunk.level = k;
+        if (k > 0)
+        {
+            level->voxels = (uint16_t*)calloc(
+                (uint64_t)level->width * level->height * level->depth, sizeof(uint16_t));
+            dvz_parallel(level->depth, 8, DVZ_BRICKS_THREADS, _bricks_downsample_chunk, &chunk);
+        }
+        dvz_parallel(level->layers, 1, DVZ_BRICKS_THREADS, _bricks_range_chunk, &chunk);
+        if (atomic_load(&bricks->to_stop))
+            return NULL;
+        atomic_store(&bricks->levels_ready, k + 1);
+    }
+
+    log_debug(
+        "built %d-level bricked pyramid of %dx%dx%d volume", bricks->level_count, bricks->width,
+        bricks->height, bricks->depth);
+    return NULL;
+}
+
+
+
+static void _bricks_free_levels(DvzBricks* bricks)
+{
+    ASSERT(bricks != NULL);
+    DvzBricksLevel* level = NULL;
+    for (uint32_t k = 0; k < DVZ_BRICKS_MAX_LEVELS; k++)
+    {
+        level = &bricks->levels[k];
+        FREE(level->voxels);
+        FREE(level->range);
+        FREE(level->is_empty);
+        FREE(level->slot);
+    }
+    memset(bricks->levels, 0, sizeof(bricks->levels));
+    bricks->level_count = 0;
+    FREE(bricks->page[0]);
+    FREE(bricks->page[1]);
+}
+
+
+
+// Maximum of the transfer function values i0 to i1 included.
+static inline float _transfer_max(DvzBricks* bricks, uint32_t i0, uint32_t i1)
+{
+    ASSERT(i0 <= i1);
+    ASSERT(i1 < DVZ_BRICKS_TRANSFER_SIZE);
+    uint32_t k = 0;
+    while ((2u << k) <= i1 - i0 + 1)
+        k++;
+    return MAX(bricks->transfer[k][i0], bricks->transfer[k][i1 + 1 - (1u << k)]);
+}
+
+
+
+// Maximum alpha value of a brick with the current transfer function.
+static float _brick_alpha(DvzBricks* bricks, DvzBrickRange range)
+{
+    ASSERT(bricks != NULL);
+    double a = range.min / 65535.0, b = range.max / 65535.0;
+    double x0 = bricks->transfer_xrange[0], x1 = bricks->transfer_xrange[1];
+
+    // Transfer function disabled: the alpha value is the voxel value.
+    if (x0 >= x1)
+        return (float)b;
+
+    // Transfer function texels that may be sampled, with linear interpolation.
+    const double n = DVZ_BRICKS_TRANSFER_SIZE;
+    double t0 = CLIP((a - x0) / (x1 - x0), 0, 1), t1 = CLIP((b - x0) / (x1 - x0), 0, 1);
+    uint32_t i0 = (uint32_t)CLIP(floor(t0 * n - .5), 0, n - 1);
+    uint32_t i1 = (uint32_t)CLIP(ceil(t1 * n - .5), 0, n - 1);
+    return _transfer_max(bricks, i0, i1);
+}
+
+
+
+// Classify the bricks of a level as empty or not.
+static void _bricks_classify(DvzBricks* bricks, uint32_t k)
+{
+    ASSERT(bricks != NULL);
+    DvzBricksLevel* level = &bricks->levels[k];
+    level->filled_count = 0;
+    for (uint32_t i = 0; i < level->brick_count; i++)
+    {
+        level->is_empty[i] = _brick_alpha(bricks, level->range[i]) < DVZ_BRICKS_EMPTY_ALPHA;
+        level->filled_count += level->is_empty[i] ? 0 : 1;
+    }
+    log_trace("%d/%d non-empty bricks at level %d", level->filled_count, level->brick_count, k);
+}
+
+
+
+static inline bool _slot_is_needed(DvzBricks* bricks, DvzBricksSlot* slot)
+{
+    if (!slot->is_used)
+        return false;
+    // The bricks of the coarsest level are always resident, as a fallback for the other levels.
+    if (slot->level + 1 == bricks->level_count)
+        return true;
+    return slot->level == bricks->level && !bricks->levels[slot->level].is_empty[slot->brick];
+}
+
+
+
+// Free slot, or least recently used slot that is not needed by the current level, or -1.
+static int32_t _slot_evict(DvzBricks* bricks)
+{
+    ASSERT(bricks != NULL);
+    int32_t lru = -1;
+    DvzBricksSlot* slot = NULL;
+    for (uint32_t i = 0; i < DVZ_BRICKS_SLOT_COUNT; i++)
+    {
+        slot = &bricks->slots[i];
+        if (!slot->is_used)
+            return (int32_t)i;
+        if (!_slot_is_needed(bricks, slot) &&
+            (lru < 0 || slot->frame < bricks->slots[lru].frame))
+            lru = (int32_t)i;
+    }
+    return lru;
+}
+
+
+
+// Copy the voxels of a brick, with its gutter, into the CPU copy of a slot.
+static void _slot_fill(DvzBricks* bricks, uint32_t slot, uint32_t k, uint32_t brick)
+{
+    ASSERT(bricks != NULL);
+    ASSERT(slot < DVZ_BRICKS_SLOT_COUNT);
+    ASSERT(k < atomic_load(&bricks->levels_ready));
+
+    // Release the slot from its previous brick.
+    DvzBricksSlot* s = &bricks->slots[slot];
+    if (s->is_used)
+        bricks->levels[s->level].slot[s->brick] = -1;
+
+    DvzBricksLevel* level = &bricks->levels[k];
+    ASSERT(brick < level->brick_count);
+    uint16_t* dst = dvz_bricks_slot_voxels(bricks, slot);
+    uint32_t c = brick % level->cols;
+    uint32_t r = (brick / level->cols) % level->rows;
+    uint32_t l = brick / (level->cols * level->rows);
+
+    int64_t x0 = (int64_t)c * DVZ_BRICKS_SIZE - DVZ_BRICKS_GUTTER;
+    int64_t y0 = (int64_t)r * DVZ_BRICKS_SIZE - DVZ_BRICKS_GUTTER;
+    int64_t z0 = (int64_t)l * DVZ_BRICKS_SIZE - DVZ_BRICKS_GUTTER;
+    // 16-bit voxels are copied row by row away from the x edges.
+    const uint16_t* src = level->voxels;
+    if (k == 0)
+        src = bricks->item_size == 2 ? (const uint16_t*)bricks->voxels : NULL;
+    bool inner_x = src != NULL && x0 >= 0 && x0 + DVZ_BRICKS_SLOT_SIZE <= (int64_t)level->width;
+    uint32_t x = 0, y = 0, z = 0;
+    for (uint32_t kz = 0; kz < DVZ_BRICKS_SLOT_SIZE; kz++)
+    {
+        z = (uint32_t)CLIP(z0 + kz, 0, (int64_t)level->depth - 1);
+        for (uint32_t ky = 0; ky < DVZ_BRICKS_SLOT_SIZE; ky++)
+        {
+            y = (uint32_t)CLIP(y0 + ky, 0, (int64_t)level->height - 1);
+            if (inner_x)
+            {
+                memcpy(
+                    dst, &src[_voxel_idx(level, (uint32_t)x0, y, z)],
+                    DVZ_BRICKS_SLOT_SIZE * sizeof(uint16_t));
+                dst += DVZ_BRICKS_SLOT_SIZE;
+                continue;
+            }
+            for (uint32_t kx = 0; kx < DVZ_BRICKS_SLOT_SIZE; kx++)
+            {
+                x = (uint32_t)CLIP(x0 + kx, 0, (int64_t)level->width - 1);
+                *dst++ = _voxel(bricks, k, _voxel_idx(level, x, y, z));
+            }
+        }
+    }
+
+    s->level = k;
+    s->brick = brick;
+    s->is_used = true;
+    level->slot[brick] = (int32_t)slot;
+}
+
+
+
+// Slot of the resident brick of a coarser level that contains a brick of the current level, or
+// -1. The number of levels between both bricks is returned in `d`.
+static int32_t _brick_fallback(DvzBricks* bricks, uint32_t brick, uint32_t* d)
+{
+    ASSERT(bricks != NULL);
+    ASSERT(d != NULL);
+    DvzBricksLevel* level = &bricks->levels[bricks->level];
+    uint32_t c = brick % level->cols;
+    uint32_t r = (brick / level->cols) % level->rows;
+    uint32_t l = brick / (level->cols * level->rows);
+
+    // Each level halves the voxel coordinates, so that the brick coordinates are halved too.
+    uint32_t ready = atomic_load(&bricks->levels_ready);
+    DvzBricksLevel* coarse = NULL;
+    int32_t slot = -1;
+    for (uint32_t k = bricks->level + 1; k < ready; k++)
+    {
+        c /= 2;
+        r /= 2;
+        l /= 2;
+        coarse = &bricks->levels[k];
+        ASSERT(c < coarse->cols && r < coarse->rows && l < coarse->layers);
+        slot = coarse->slot[(l * coarse->rows + r) * coarse->cols + c];
+        if (slot >= 0)
+        {
+            *d = k - bricks->level;
+            return slot;
+        }
+    }
+    return -1;
+}
+
+
+
+// Fill the page table of the current level.
+static void _bricks_page(DvzBricks* bricks)
+{
+    ASSERT(bricks != NULL);
+    DvzBricksLevel* level = &bricks->levels[bricks->level];
+    bricks->page_idx = 1 - bricks->page_idx;
+    uint8_t* page = bricks->page[bricks->page_idx];
+    ASSERT(page != NULL);
+
+    uvec3 offset = {0};
+    int32_t slot = 0;
+    uint32_t d = 0;
+    for (uint32_t i = 0; i < level->brick_count; i++)
+    {
+        slot = level->slot[i];
+        d = 0;
+        // Missing brick: draw the coarser resident brick that contains it, if any.
+        if (!level->is_empty[i] && slot < 0)
+            slot = _brick_fallback(bricks, i, &d);
+        if (level->is_empty[i] || slot < 0)
+        {
+            memset(&page[4 * i], 0, 4);
+            continue;
+        }
+        ASSERT(d < 255);
+        bricks->slots[slot].frame = bricks->frame;
+        dvz_bricks_slot_offset((uint32_t)slot, offset);
+        page[4 * i + 0] = (uint8_t)(offset[0] / DVZ_BRICKS_SLOT_SIZE);
+        page[4 * i + 1] = (uint8_t)(offset[1] / DVZ_BRICKS_SLOT_SIZE);
+        page[4 * i + 2] = (uint8_t)(offset[2] / DVZ_BRICKS_SLOT_SIZE);
+        page[4 * i + 3] = d == 0 ? 255 : (uint8_t)d;
+    }
+}
+
+
+
+// Load a missing brick in the least recently used slot, within the per-frame upload budget.
+// Return false if the brick could not be loaded.
+static bool _brick_load(DvzBricks* bricks, uint32_t k, uint32_t brick)
+{
+    ASSERT(bricks != NULL);
+    if (bricks->levels[k].slot[brick] >= 0)
+        return true;
+    if (bricks->upload_count >= DVZ_BRICKS_MAX_UPLOADS)
+        return false;
+    int32_t slot = _slot_evict(bricks);
+    // Only while the coarse levels are being built.
+    if (slot < 0)
+        return false;
+    _slot_fill(bricks, (uint32_t)slot, k, brick);
+    bricks->uploads[bricks->upload_count++] = (uint32_t)slot;
+    return true;
+}
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+DvzBricks* dvz_bricks(void)
+{
+    DvzBricks* bricks = calloc(1, sizeof(DvzBricks));
+    atomic_init(&bricks->levels_ready, 0);
+    atomic_init(&bricks->is_building, false);
+    atomic_init(&bricks->to_stop, false);
+
+    // Linear transfer function by default.
+    float values[DVZ_BRICKS_TRANSFER_SIZE] = {0};
+    for (uint32_t i = 0; i < DVZ_BRICKS_TRANSFER_SIZE; i++)
+        values[i] = i / (DVZ_BRICKS_TRANSFER_SIZE - 1.0);
+    dvz_bricks_transfer(bricks, (vec2){0, 0}, DVZ_BRICKS_TRANSFER_SIZE, values);
+
+    dvz_obj_init(&bricks->obj);
+    dvz_obj_created(&bricks->obj);
+    return bricks;
+}
+
+
+
+void dvz_bricks_data(
+    DvzBricks* bricks, uint32_t width, uint32_t height, uint32_t depth, uint32_t item_size,
+    const void* voxels)
+{
+    ASSERT(bricks != NULL);
+    ASSERT(item_size == 1 || item_size == 2);
+    dvz_bricks_stop(bricks);
+    _bricks_free_levels(bricks);
+
+    // The cache content refers to the previous volume.
+    memset(bricks->slots, 0, sizeof(bricks->slots));
+    bricks->frame = 0;
+    bricks->level = 0;
+    bricks->upload_count = 0;
+    bricks->classified = 0;
+    bricks->is_complete = false;
+
+    bricks->width = width;
+    bricks->height = height;
+    bricks->depth = depth;
+    bricks->item_size = item_size;
+    bricks->voxels = voxels;
+    atomic_store(&bricks->levels_ready, 0);
+    if (width == 0 || height == 0 || depth == 0 || voxels == NULL)
+        return;
+
+    if (bricks->slot_voxels == NULL)
+        bricks->slot_voxels = (uint16_t*)calloc(
+            (uint64_t)DVZ_BRICKS_SLOT_COUNT * DVZ_BRICKS_SLOT_VOXELS, sizeof(uint16_t));
+
+    // Level sizes, down to a single brick.
+    uint32_t k = 0;
+    uint32_t w = width, h = height, d = depth;
+    DvzBricksLevel* level = NULL;
+    while (true)
+    {
+        level = &bricks->levels[k];
+        level->width = w;
+        level->height = h;
+        level->depth = d;
+        level->cols = (w + DVZ_BRICKS_SIZE - 1) / DVZ_BRICKS_SIZE;
+        level->rows = (h + DVZ_BRICKS_SIZE - 1) / DVZ_BRICKS_SIZE;
+        level->layers = (d + DVZ_BRICKS_SIZE - 1) / DVZ_BRICKS_SIZE;
+        level->brick_count = level->cols * level->rows * level->layers;
+        level->range = (DvzBrickRange*)calloc(level->brick_count, sizeof(DvzBrickRange));
+        level->is_empty = (bool*)calloc(level->brick_count, sizeof(bool));
+        level->slot = (int32_t*)malloc(level->brick_count * sizeof(int32_t));
+        for (uint32_t i = 0; i < level->brick_count; i++)
+            level->slot[i] = -1;
+        k++;
+        if ((w <= DVZ_BRICKS_SIZE && h <= DVZ_BRICKS_SIZE && d <= DVZ_BRICKS_SIZE) ||
+            k == DVZ_BRICKS_MAX_LEVELS)
+            break;
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+        d = (d + 1) / 2;
+    }
+    bricks->level_count = k;
+
+    // The page table of the finest level is the largest one.
+    bricks->page[0] = (uint8_t*)calloc(bricks->levels[0].brick_count, 4);
+    bricks->page[1] = (uint8_t*)calloc(bricks->levels[0].brick_count, 4);
+
+    log_trace("start building the bricked pyramid of a %dx%dx%d volume", width, height, depth);
+    atomic_store(&bricks->to_stop, false);
+    atomic_store(&bricks->is_building, true);
+    bricks->thread = dvz_thread(_bricks_build, bricks);
+}
+
+
+
+void dvz_bricks_stop(DvzBricks* bricks)
+{
+    ASSERT(bricks != NULL);
+    if (!atomic_load(&bricks->is_building))
+        return;
+    atomic_store(&bricks->to_stop, true);
+    dvz_thread_join(&bricks->thread);
+    atomic_store(&bricks->is_building, false);
+    atomic_store(&bricks->to_stop, false);
+}
+
+
+
+bool dvz_bricks_ready(DvzBricks* bricks)
+{
+    ASSERT(bricks != NULL);
+    return bricks->level_count > 0 && atomic_load(&bricks->levels_ready) == bricks->level_count;
+}
+
+
+
+void dvz_bricks_transfer(DvzBricks* bricks, vec2 xrange, uint32_t count, const float* values)
+{
+    ASSERT(bricks != NULL);
+    bool changed = memcmp(xrange, bricks->transfer_xrange, sizeof(vec2)) != 0;
+    memcpy(bricks->transfer_xrange, xrange, sizeof(vec2));
+
+    if (count > 0)
+    {
+        ASSERT(values != NULL);
+        // Resample the values to the table resolution.
+        float v = 0;
+        uint32_t j = 0;
+        for (uint32_t i = 0; i < DVZ_BRICKS_TRANSFER_SIZE; i++)
+        {
+            j = (uint32_t)((uint64_t)i * count / DVZ_BRICKS_TRANSFER_SIZE);
+            v = values[MIN(j, count - 1)];
+            changed |= v != bricks->transfer[0][i];
+            bricks->transfer[0][i] = v;
+        }
+        for (uint32_t k = 1; k < DVZ_BRICKS_TRANSFER_LOG; k++)
+        {
+            for (uint32_t i = 0; i + (1u << k) <= DVZ_BRICKS_TRANSFER_SIZE; i++)
+                bricks->transfer[k][i] = MAX(
+                    bricks->transfer[k - 1][i], bricks->transfer[k - 1][i + (1u << (k - 1))]);
+        }
+    }
+
+    // All levels need to be classified again.
+    if (changed)
+        bricks->classified = 0;
+}
+
+
+
+bool dvz_bricks_update(DvzBricks* bricks)
+{
+    ASSERT(bricks != NULL);
+    bricks->frame++;
+    bricks->upload_count = 0;
+    uint32_t ready = atomic_load(&bricks->levels_ready);
+    if (ready == 0)
+        return false;
+
+    // Classify the bricks of the newly built levels, or of all levels after a transfer change.
+    bool changed = bricks->classified < ready;
+    for (uint32_t k = bricks->classified; k < ready; k++)
+        _bricks_classify(bricks, k);
+    bricks->classified = ready;
+
+    // The bricks of the coarsest level are kept resident once the pyramid is built.
+    uint32_t last = bricks->level_count - 1;
+    uint32_t pinned = ready == bricks->level_count ? bricks->levels[last].brick_count : 0;
+
+    // Finest level whose non-empty bricks fit in the atlas.
+    uint32_t level = ready - 1;
+    for (uint32_t k = 0; k < ready; k++)
+    {
+        if (bricks->levels[k].filled_count + (k == last ? 0 : pinned) <= DVZ_BRICKS_SLOT_COUNT)
+        {
+            level = k;
+            break;
+        }
+    }
+    if (level != bricks->level)
+    {
+        log_debug("switch to level %d of the bricked volume", level);
+        bricks->level = level;
+        changed = true;
+    }
+    if (!changed && bricks->is_complete)
+        return false;
+
+    // Load the coarsest bricks first, then the missing non-empty bricks of the current level,
+    // within the per-frame upload budget.
+    bool is_complete = true;
+    for (uint32_t i = 0; i < pinned && is_complete; i++)
+        is_complete = _brick_load(bricks, last, i);
+    DvzBricksLevel* lvl = &bricks->levels[level];
+    for (uint32_t i = 0; i < lvl->brick_count && is_complete; i++)
+    {
+        if (!lvl->is_empty[i])
+            is_complete = _brick_load(bricks, level, i);
+    }
+    bricks->is_complete = is_complete;
+    if (!changed && bricks->upload_count == 0)
+        return false;
+
+    _bricks_page(bricks);
+    return true;
+}
+
+
+
+uint8_t* dvz_bricks_page(DvzBricks* bricks)
+{
+    ASSERT(bricks != NULL);
+    return bricks->page[bricks->page_idx];
+}
+
+
+
+void dvz_bricks_slot_offset(uint32_t slot, uvec3 offset)
+{
+    ASSERT(slot < DVZ_BRICKS_SLOT_COUNT);
+    offset[0] = (slot % DVZ_BRICKS_ATLAS_X) * DVZ_BRICKS_SLOT_SIZE;
+    offset[1] = ((slot / DVZ_BRICKS_ATLAS_X) % DVZ_BRICKS_ATLAS_Y) * DVZ_BRICKS_SLOT_SIZE;
+    offset[2] = (slot / (DVZ_BRICKS_ATLAS_X * DVZ_BRICKS_ATLAS_Y)) * DVZ_BRICKS_SLOT_SIZE;
+}
+
+
+
+uint16_t* dvz_bricks_slot_voxels(DvzBricks* bricks, uint32_t slot)
+{
+    ASSERT(bricks != NULL);
+    ASSERT(bricks->slot_voxels != NULL);
+    ASSERT(slot < DVZ_BRICKS_SLOT_COUNT);
+    return &bricks->slot_voxels[(uint64_t)slot * DVZ_BRICKS_SLOT_VOXELS];
+}
+
+
+
+void dvz_bricks_destroy(DvzBricks* bricks)
+{
+    if (bricks == NULL)
+        return;
+    dvz_bricks_stop(bricks);
+    _bricks_free_levels(bricks);
+    FREE(bricks->slot_voxels);
+    dvz_obj_destroyed(&bricks->obj);
+    FREE(bricks);
+}
@@ -446,6 +446,110 @@ static void _visual_marker(DvzVisual* visual)
 
 
 
+static void _visual_marker_cmap(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzProp* prop = NULL;
+
+    // Graphics.
+    dvz_visual_graphics(
+        visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_MARKER_CMAP, visual->flags));
+    dvz_graphics_depth_test(visual->graphics[0], DVZ_DEPTH_TEST_DISABLE);
+
+    // Sources
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, 0,
+        sizeof(DvzGraphicsMarkerCmapVertex), 0);
+    _common_sources(visual);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_PARAM, 0, DVZ_PIPELINE_GRAPHICS, 0, DVZ_USER_BINDING,
+        sizeof(DvzGraphicsMarkerCmapParams), 0);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_COLOR_TEXTURE, 0, DVZ_PIPELINE_GRAPHICS, 0,
+        DVZ_USER_BINDING + 1, sizeof(uint8_t), 0);
+
+    // Props:
+
+    // Marker pos.
+    prop = dvz_visual_prop(visual, DVZ_PROP_POS, 0, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_cast(
+        prop, 0, offsetof(DvzGraphicsMarkerCmapVertex, pos), DVZ_DTYPE_VEC3,
+        DVZ_ARRAY_COPY_SINGLE, 1);
+
+    // Marker scalar value, mapped to a color on the GPU.
+    prop = dvz_visual_prop(visual, DVZ_PROP_VALUE, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 1, offsetof(DvzGraphicsMarkerCmapVertex, value), DVZ_ARRAY_COPY_SINGLE, 1);
+    float value = 0;
+    dvz_visual_prop_default(prop, &value);
+
+    // Marker size.
+    prop = dvz_visual_prop(
+        visual, DVZ_PROP_MARKER_SIZE, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 1, offsetof(DvzGraphicsMarkerCmapVertex, size), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_dpi(prop, canvas->dpi_scaling);
+    float size = 20;
+    dvz_visual_prop_default(prop, &size);
+
+    // Marker type.
+    prop = dvz_visual_prop(
+        visual, DVZ_PROP_MARKER_TYPE, 0, DVZ_DTYPE_CHAR, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 1, offsetof(DvzGraphicsMarkerCmapVertex, marker), DVZ_ARRAY_COPY_SINGLE, 1);
+    DvzMarkerType marker = DVZ_MARKER_DISC;
+    dvz_visual_prop_default(prop, &marker);
+
+    // Marker angle.
+    prop = dvz_visual_prop(visual, DVZ_PROP_ANGLE, 0, DVZ_DTYPE_CHAR, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 1, offsetof(DvzGraphicsMarkerCmapVertex, angle), DVZ_ARRAY_COPY_SINGLE, 1);
+    float angle = 0;
+    dvz_visual_prop_default(prop, &angle);
+
+    // Marker transform.
+    prop =
+        dvz_visual_prop(visual, DVZ_PROP_TRANSFORM, 0, DVZ_DTYPE_CHAR, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 1, offsetof(DvzGraphicsMarkerCmapVertex, transform), DVZ_ARRAY_COPY_SINGLE, 1);
+
+    // Common props.
+    _common_props(visual);
+
+    // Param: edge color.
+    prop = dvz_visual_prop(visual, DVZ_PROP_COLOR, 1, DVZ_DTYPE_VEC4, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 0, offsetof(DvzGraphicsMarkerCmapParams, edge_color), DVZ_ARRAY_COPY_SINGLE, 1);
+    vec4 edge_color = {0, 0, 0, 1};
+    dvz_visual_prop_default(prop, &edge_color);
+
+    // Param: edge width.
+    prop =
+        dvz_visual_prop(visual, DVZ_PROP_LINE_WIDTH, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 1, offsetof(DvzGraphicsMarkerCmapParams, edge_width), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_dpi(prop, canvas->dpi_scaling);
+    float edge_width = 1;
+    dvz_visual_prop_default(prop, &edge_width);
+
+    // Param: colormap.
+    prop = dvz_visual_prop(visual, DVZ_PROP_COLORMAP, 0, DVZ_DTYPE_INT, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 2, offsetof(DvzGraphicsMarkerCmapParams, cmap), DVZ_ARRAY_COPY_SINGLE, 1);
+    DvzColormap cmap = DVZ_CMAP_VIRIDIS;
+    dvz_visual_prop_default(prop, &cmap);
+
+    // Param: color limits.
+    prop = dvz_visual_prop(visual, DVZ_PROP_RANGE, 0, DVZ_DTYPE_VEC2, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 3, offsetof(DvzGraphicsMarkerCmapParams, vrange), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_default(prop, (vec2){0, 1});
+}
+
+
+
 /*************************************************************************************************/
 /*  Polygon                                                                                      */
 /*************************************************************************************************/
@@ -1169,6 +1273,22 @@ static void _add_ticks(
     }
 }
 
+// Whether a prop changed since the last bake.
+static bool _axes_prop_changed(DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx)
+{
+    DvzProp* prop = dvz_prop_get(visual, prop_type, prop_idx);
+    return prop != NULL && prop->changed_count > 0;
+}
+
+// Extend a range of items to upload.
+static void _axes_range(uvec2 range, uint32_t first, uint32_t count)
+{
+    if (count == 0)
+        return;
+    range[0] = MIN(range[0], first);
+    range[1] = MAX(range[1], first + count);
+}
+
 static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 {
     ASSERT(visual != NULL);
@@ -1179,13 +1299,24 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
     DvzSource* seg_index_src = dvz_source_get(visual, DVZ_SOURCE_TYPE_INDEX, 0);
     DvzSource* text_vert_src = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 1);
 
-    // HACK: mark the index buffer to be updated.
-    seg_index_src->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
-
     // Count the total number of segments.
     // NOTE: the number of segments is determined by the POS prop.
     uint32_t count = _count_prop_items(visual, 1, (DvzPropType[]){DVZ_PROP_POS}, 4);
 
+    // When only the tick positions change and the number of segments is unchanged, for example
+    // when panning, only the segments of the changed ticks are uploaded and the indices are kept.
+    bool partial = 4 * count == visual->prev_vertex_count[0];
+    for (uint32_t level = 0; level < DVZ_AXES_LEVEL_COUNT; level++)
+        partial &= !_axes_prop_changed(visual, DVZ_PROP_COLOR, level) &&
+                   !_axes_prop_changed(visual, DVZ_PROP_LINE_WIDTH, level);
+    partial &= !_axes_prop_changed(visual, DVZ_PROP_LENGTH, DVZ_AXES_LEVEL_MINOR) &&
+               !_axes_prop_changed(visual, DVZ_PROP_LENGTH, DVZ_AXES_LEVEL_MAJOR);
+    uvec2 seg_range = {UINT32_MAX, 0}; // changed segments
+
+    // HACK: mark the index buffer to be updated.
+    if (!partial)
+        seg_index_src->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+
 
     // Segment graphics.
     // -----------------
@@ -1212,6 +1343,7 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 
     DvzProp* prop = NULL;
     uint32_t tick_count = 0;
+    uint32_t seg_first = 0;
     int flags = ((visual->flags >> 2) & 0x0003);
     bool hide_minor = flags & 0x1;
     bool hide_grid = flags & 0x2;
@@ -1236,6 +1368,13 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
             color[3] = 0;
 
         _add_ticks(prop, &seg_data, (DvzAxisLevel)level, coord, color, lw, tick_length);
+        _axes_range(seg_range, seg_first + prop->changed_first, prop->changed_count);
+        seg_first += tick_count;
+    }
+    if (partial && seg_range[1] > seg_range[0])
+    {
+        seg_vert_src->upload_first = 4 * seg_range[0];
+        seg_vert_src->upload_count = 4 * (seg_range[1] - seg_range[0]);
     }
 
     // Labels: one for each major tick.
@@ -1243,8 +1382,9 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
         dvz_graphics_data(visual->graphics[1], &text_vert_src->arr, NULL, visual);
 
     // Text prop.
-    DvzArray* arr_text = _prop_array(dvz_prop_get(visual, DVZ_PROP_TEXT, 0));
-    ASSERT(prop != NULL);
+    DvzProp* prop_text = dvz_prop_get(visual, DVZ_PROP_TEXT, 0);
+    ASSERT(prop_text != NULL);
+    DvzArray* arr_text = _prop_array(prop_text);
 
     // Major tick prop.
     DvzProp* prop_major = dvz_prop_get(visual, DVZ_PROP_POS, DVZ_AXES_LEVEL_MAJOR);
@@ -1294,6 +1434,16 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
     // Text color.
     PARAM(cvec4, str_item.vertex.color, COLOR, 4)
 
+    // Same for the glyphs: the glyphs are uploaded from the first changed label, as the length of
+    // the changed labels may differ.
+    partial = 4 * count_chars == visual->prev_vertex_count[1] &&
+              !_axes_prop_changed(visual, DVZ_PROP_TEXT_SIZE, 0) &&
+              !_axes_prop_changed(visual, DVZ_PROP_COLOR, 4);
+    uvec2 text_range = {UINT32_MAX, 0}; // changed labels
+    _axes_range(text_range, prop_major->changed_first, prop_major->changed_count);
+    _axes_range(text_range, prop_text->changed_first, prop_text->changed_count);
+    uint32_t glyph_first = 0;
+
     for (uint32_t i = 0; i < n_text; i++)
     {
         // Add text.
@@ -1308,8 +1458,15 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
         ASSERT(x != NULL);
         _tick_pos(*x, DVZ_AXES_LEVEL_MAJOR, coord, str_item.vertex.pos, P);
 
+        if (i < text_range[0])
+            glyph_first += strlen(text);
         dvz_graphics_append(&text_data, &str_item);
     }
+    if (partial && text_range[1] > text_range[0])
+    {
+        text_vert_src->upload_first = 4 * glyph_first;
+        text_vert_src->upload_count = 4 * (count_chars - glyph_first);
+    }
 }
 
 static void _visual_axes_2D(DvzVisual* visual)
@@ -1439,6 +1596,81 @@ static void _visual_axes_2D(DvzVisual* visual)
 /*  Mesh                                                                                         */
 /*************************************************************************************************/
 
+// Compute the vertex normals from the faces if they have not been specified.
+static void _mesh_bake_normals(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+
+    // Check the normal data.
+    DvzArray* arr_vertex = dvz_source_array(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    DvzArray* arr_index = dvz_source_array(visual, DVZ_SOURCE_TYPE_INDEX, 0);
+    if (arr_vertex == NULL || arr_index == NULL || arr_vertex->item_count == 0)
+        return;
+
+    // Check if the first normal is 00
+    vec3* normal = &((DvzGraphicsMeshVertex*)dvz_array_item(arr_vertex, 0))->normal;
+    if (normal[0][0] == 0 && normal[0][1] == 0 && normal[0][2] == 0)
+    {
+        // Compute the normal from the faces.
+        DvzMesh mesh = {0};
+        mesh.vertices = *arr_vertex; // (DvzGraphicsMeshVertex*)arr_vertex->data;
+        mesh.indices = *arr_index;   // (DvzIndex*)arr_index->data;
+        dvz_mesh_normals(&mesh);
+    }
+    // The first normal should no longer be empty.
+    ASSERT(!(normal[0][0] == 0 && normal[0][1] == 0 && normal[0][2] == 0));
+}
+
+// Mesh params and texture sources, shared by the mesh visuals.
+static void _mesh_sources(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+
+    dvz_visual_source(                                              // params
+        visual, DVZ_SOURCE_TYPE_PARAM, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        DVZ_USER_BINDING, sizeof(DvzGraphicsMeshParams), 0);        //
+
+    for (uint32_t i = 0; i < 4; i++)                                    // texture sources
+        dvz_visual_source(                                              //
+            visual, DVZ_SOURCE_TYPE_IMAGE, i, DVZ_PIPELINE_GRAPHICS, 0, //
+            DVZ_USER_BINDING + i + 1, sizeof(cvec4), 0);                //
+}
+
+// Mesh params props, shared by the mesh visuals.
+static void _mesh_params_props(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzProp* prop = NULL;
+
+    // Default values.
+    DvzGraphicsMeshParams params = default_graphics_mesh_params(DVZ_CAMERA_EYE);
+
+    // Light positions.
+    prop =
+        dvz_visual_prop(visual, DVZ_PROP_LIGHT_POS, 0, DVZ_DTYPE_MAT4, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 0, offsetof(DvzGraphicsMeshParams, lights_pos_0), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_default(prop, &params.lights_pos_0);
+
+    // Light params.
+    prop = dvz_visual_prop(
+        visual, DVZ_PROP_LIGHT_PARAMS, 0, DVZ_DTYPE_MAT4, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 1, offsetof(DvzGraphicsMeshParams, lights_params_0), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_default(prop, &params.lights_params_0);
+
+    // Texture coefficients.
+    prop = dvz_visual_prop(visual, DVZ_PROP_TEXCOEFS, 0, DVZ_DTYPE_VEC4, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 3, offsetof(DvzGraphicsMeshParams, tex_coefs), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_default(prop, &params.tex_coefs);
+
+    // Clipping coefficients.
+    prop = dvz_visual_prop(visual, DVZ_PROP_CLIP, 0, DVZ_DTYPE_VEC4, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 4, offsetof(DvzGraphicsMeshParams, clip_coefs), DVZ_ARRAY_COPY_SINGLE, 1);
+}
+
 static void _mesh_bake(DvzVisual* visual, DvzVisualDataEvent ev)
 {
     // Take the color prop and override the tex coords and alpha if needed.
@@ -1484,22 +1716,7 @@ static void _mesh_bake(DvzVisual* visual, DvzVisualDataEvent ev)
     // etc.
     _default_visual_bake(visual, ev);
 
-    // Check the normal data.
-    DvzArray* arr_vertex = dvz_source_array(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
-    DvzArray* arr_index = dvz_source_array(visual, DVZ_SOURCE_TYPE_INDEX, 0);
-
-    // Check if the first normal is 00
-    vec3* normal = &((DvzGraphicsMeshVertex*)dvz_array_item(arr_vertex, 0))->normal;
-    if (normal[0][0] == 0 && normal[0][1] == 0 && normal[0][2] == 0)
-    {
-        // Compute the normal from the faces.
-        DvzMesh mesh = {0};
-        mesh.vertices = *arr_vertex; // (DvzGraphicsMeshVertex*)arr_vertex->data;
-        mesh.indices = *arr_index;   // (DvzIndex*)arr_index->data;
-        dvz_mesh_normals(&mesh);
-    }
-    // The first normal should no longer be empty.
-    ASSERT(!(normal[0][0] == 0 && normal[0][1] == 0 && normal[0][2] == 0));
+    _mesh_bake_normals(visual);
 }
 
 static void _visual_mesh(DvzVisual* visual)
@@ -1522,15 +1739,7 @@ static void _visual_mesh(DvzVisual* visual)
         0, sizeof(DvzIndex), 0);                                    //
 
     _common_sources(visual); // common sources
-
-    dvz_visual_source(                                              // params
-        visual, DVZ_SOURCE_TYPE_PARAM, 0, DVZ_PIPELINE_GRAPHICS, 0, //
-        DVZ_USER_BINDING, sizeof(DvzGraphicsMeshParams), 0);        //
-
-    for (uint32_t i = 0; i < 4; i++)                                    // texture sources
-        dvz_visual_source(                                              //
-            visual, DVZ_SOURCE_TYPE_IMAGE, i, DVZ_PIPELINE_GRAPHICS, 0, //
-            DVZ_USER_BINDING + i + 1, sizeof(cvec4), 0);                //
+    _mesh_sources(visual);   // params and texture sources
 
     // Props:
 
@@ -1567,39 +1776,308 @@ static void _visual_mesh(DvzVisual* visual)
     _common_props(visual);
 
     // Params.
-    // Default values.
-    DvzGraphicsMeshParams params = default_graphics_mesh_params(DVZ_CAMERA_EYE);
+    _mesh_params_props(visual);
 
-    // Light positions.
+    // // Texture props.
+    // for (uint32_t i = 0; i < 4; i++)
+    //     dvz_visual_prop(visual, DVZ_PROP_IMAGE, i, DVZ_DTYPE_UINT, DVZ_SOURCE_TYPE_IMAGE, i);
+
+    dvz_visual_callback_bake(visual, _mesh_bake);
+}
+
+
+
+/*************************************************************************************************/
+/*  Instanced mesh                                                                               */
+/*************************************************************************************************/
+
+static void _mesh_instanced_bake(DvzVisual* visual, DvzVisualDataEvent ev)
+{
+    // The default baking takes care of the INSTANCE source, which is the only one that depends
+    // on the props. The base mesh is only baked once, when the VERTEX source is set.
+    _default_visual_bake(visual, ev);
+
+    _mesh_bake_normals(visual);
+}
+
+static void _visual_mesh_instanced(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzProp* prop = NULL;
+
+    // Graphics.
+    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_MESH_INSTANCED, 0));
+
+    // Sources
+    dvz_visual_source(                                               // vertex buffer
+        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        0, sizeof(DvzGraphicsMeshVertex), 0);                        //
+
+    dvz_visual_source(                                              // index buffer
+        visual, DVZ_SOURCE_TYPE_INDEX, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        0, sizeof(DvzIndex), 0);                                    //
+
+    dvz_visual_source(                                                 // instance buffer
+        visual, DVZ_SOURCE_TYPE_INSTANCE, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        1, sizeof(DvzGraphicsMeshInstance), 0);                        //
+
+    _common_sources(visual); // common sources
+    _mesh_sources(visual);   // params and texture sources
+
+    // Props:
+
+    // NOTE: the base mesh (DvzGraphicsMeshVertex) is set directly with dvz_visual_data_source()
+    // on the VERTEX and INDEX sources, in normalized coordinates relative to each instance.
+    // Only the instance positions are normalized by the scene.
+
+    // Index.
+    prop = dvz_visual_prop(visual, DVZ_PROP_INDEX, 0, DVZ_DTYPE_UINT, DVZ_SOURCE_TYPE_INDEX, 0);
+    dvz_visual_prop_copy(prop, 0, 0, DVZ_ARRAY_COPY_SINGLE, 1);
+
+    // Instance pos.
+    prop = dvz_visual_prop(visual, DVZ_PROP_POS, 0, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_INSTANCE, 0);
+    dvz_visual_prop_cast(
+        prop, 0, offsetof(DvzGraphicsMeshInstance, pos), DVZ_DTYPE_VEC3, DVZ_ARRAY_COPY_SINGLE,
+        1);
+
+    // Instance rotation, as a unit quaternion (x, y, z, w).
     prop =
-        dvz_visual_prop(visual, DVZ_PROP_LIGHT_POS, 0, DVZ_DTYPE_MAT4, DVZ_SOURCE_TYPE_PARAM, 0);
+        dvz_visual_prop(visual, DVZ_PROP_ROTATION, 0, DVZ_DTYPE_VEC4, DVZ_SOURCE_TYPE_INSTANCE, 0);
     dvz_visual_prop_copy(
-        prop, 0, offsetof(DvzGraphicsMeshParams, lights_pos_0), DVZ_ARRAY_COPY_SINGLE, 1);
-    dvz_visual_prop_default(prop, &params.lights_pos_0);
+        prop, 0, offsetof(DvzGraphicsMeshInstance, rotation), DVZ_ARRAY_COPY_SINGLE, 1);
+    vec4 rotation = {0, 0, 0, 1};
+    dvz_visual_prop_default(prop, &rotation);
 
-    // Light params.
-    prop = dvz_visual_prop(
-        visual, DVZ_PROP_LIGHT_PARAMS, 0, DVZ_DTYPE_MAT4, DVZ_SOURCE_TYPE_PARAM, 0);
+    // Instance scale.
+    prop = dvz_visual_prop(visual, DVZ_PROP_SCALE, 0, DVZ_DTYPE_VEC3, DVZ_SOURCE_TYPE_INSTANCE, 0);
     dvz_visual_prop_copy(
-        prop, 1, offsetof(DvzGraphicsMeshParams, lights_params_0), DVZ_ARRAY_COPY_SINGLE, 1);
-    dvz_visual_prop_default(prop, &params.lights_params_0);
+        prop, 0, offsetof(DvzGraphicsMeshInstance, scale), DVZ_ARRAY_COPY_SINGLE, 1);
+    vec3 scale = {1, 1, 1};
+    dvz_visual_prop_default(prop, &scale);
 
-    // Texture coefficients.
-    prop = dvz_visual_prop(visual, DVZ_PROP_TEXCOEFS, 0, DVZ_DTYPE_VEC4, DVZ_SOURCE_TYPE_PARAM, 0);
+    // Instance color: a zero alpha keeps the mesh color.
+    prop =
+        dvz_visual_prop(visual, DVZ_PROP_COLOR, 0, DVZ_DTYPE_CVEC4, DVZ_SOURCE_TYPE_INSTANCE, 0);
     dvz_visual_prop_copy(
-        prop, 3, offsetof(DvzGraphicsMeshParams, tex_coefs), DVZ_ARRAY_COPY_SINGLE, 1);
-    dvz_visual_prop_default(prop, &params.tex_coefs);
+        prop, 0, offsetof(DvzGraphicsMeshInstance, color), DVZ_ARRAY_COPY_SINGLE, 1);
+    cvec4 color = {0, 0, 0, 0};
+    dvz_visual_prop_default(prop, &color);
 
-    // Clipping coefficients.
-    prop = dvz_visual_prop(visual, DVZ_PROP_CLIP, 0, DVZ_DTYPE_VEC4, DVZ_SOURCE_TYPE_PARAM, 0);
+    // Common props.
+    _common_props(visual);
+
+    // Params.
+    _mesh_params_props(visual);
+
+    dvz_visual_callback_bake(visual, _mesh_instanced_bake);
+}
+
+
+
+/*************************************************************************************************/
+/*  Histogram                                                                                    */
+/*************************************************************************************************/
+
+static void _visual_histogram_bake(DvzVisual* visual, DvzVisualDataEvent ev)
+{
+    ASSERT(visual != NULL);
+
+    // The samples are copied as they are in the SAMPLES source, they are binned on the GPU.
+    _bake_source(visual, dvz_source_get(visual, DVZ_SOURCE_TYPE_SAMPLES, 0));
+
+    // Get props.
+    DvzProp* range = dvz_prop_get(visual, DVZ_PROP_RANGE, 0);
+    DvzProp* bin_count = dvz_prop_get(visual, DVZ_PROP_BIN_COUNT, 0);
+    DvzProp* color = dvz_prop_get(visual, DVZ_PROP_COLOR, 0);
+
+    ASSERT(range != NULL);
+    ASSERT(bin_count != NULL);
+    ASSERT(color != NULL);
+
+    // Changing the bins only dispatches the binning compute pass again.
+    uint32_t n = *(const uint32_t*)dvz_prop_item(bin_count, 0);
+    ASSERT(n > 0);
+    vec2 r = {0};
+    memcpy(r, dvz_prop_item(range, 0), sizeof(vec2));
+    dvz_visual_binning(visual, n, r);
+
+    // Vertex buffer source, one bar per bin. The bar heights are read from the bin counts.
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    ASSERT(source->arr.item_size == sizeof(DvzGraphicsHistogramVertex));
+    // NOTE: the VERTEX source does not depend on the samples, but it must be baked even if only
+    // the VALUE prop has been set.
+    source->origin = DVZ_SOURCE_ORIGIN_LIB;
+    _source_set_changed(source, true);
+
+    // Graphics data.
+    DvzGraphicsData data = dvz_graphics_data(visual->graphics[0], &source->arr, NULL, NULL);
+    dvz_graphics_alloc(&data, n);
+
+    // A single color is used for all bars.
+    uint32_t color_count = dvz_prop_size(color);
+
+    DvzGraphicsHistogramItem item = {0};
+    item.bin_count = n;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        item.bin = i;
+        memcpy(&item.color, dvz_prop_item(color, color_count == 1 ? 0 : i), sizeof(cvec4));
+        dvz_graphics_append(&data, &item);
+    }
+}
+
+static void _visual_histogram(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzProp* prop = NULL;
+
+    // Graphics.
+    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_HISTOGRAM, 0));
+
+    // Sources
+    dvz_visual_source(                                               // vertex buffer
+        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        0, sizeof(DvzGraphicsHistogramVertex), 0);                   //
+
+    _common_sources(visual); // common sources
+
+    dvz_visual_source(                                               // bin counts
+        visual, DVZ_SOURCE_TYPE_COUNTS, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        DVZ_USER_BINDING, sizeof(uint32_t), 0);                      //
+
+    dvz_visual_source(                                                // samples
+        visual, DVZ_SOURCE_TYPE_SAMPLES, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        0, sizeof(float), 0);                                         //
+
+    // Props:
+
+    // Samples.
+    prop = dvz_visual_prop(visual, DVZ_PROP_VALUE, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_SAMPLES, 0);
+    dvz_visual_prop_copy(prop, 0, 0, DVZ_ARRAY_COPY_SINGLE, 1);
+
+    // Range of the sample values covered by the bins.
+    prop = dvz_visual_prop(visual, DVZ_PROP_RANGE, 0, DVZ_DTYPE_VEC2, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_default(prop, (vec2[]){{0, 1}});
+
+    // Number of bins.
+    prop =
+        dvz_visual_prop(visual, DVZ_PROP_BIN_COUNT, 0, DVZ_DTYPE_UINT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_default(prop, (uint32_t[]){64});
+
+    // Bar color, one per bin, or a single one for all bins.
+    prop = dvz_visual_prop(visual, DVZ_PROP_COLOR, 0, DVZ_DTYPE_CVEC4, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_default(prop, (cvec4[]){{128, 128, 128, 255}});
+
+    // Common props.
+    _common_props(visual);
+
+    dvz_visual_callback_bake(visual, _visual_histogram_bake);
+}
+
+
+
+/*************************************************************************************************/
+/*  Density                                                                                      */
+/*************************************************************************************************/
+
+static void _visual_density_bake(DvzVisual* visual, DvzVisualDataEvent ev)
+{
+    ASSERT(visual != NULL);
+
+    // The points are copied in the SAMPLES source, they are accumulated on the GPU when they, the
+    // MVP, or the viewport change.
+    DvzSource* samples = dvz_source_get(visual, DVZ_SOURCE_TYPE_SAMPLES, 0);
+    ASSERT(samples->arr.item_size == sizeof(DvzGraphicsDensityPoint));
+    _bake_source(visual, samples);
+
+    DvzProp* norm = dvz_prop_get(visual, DVZ_PROP_NORMALIZATION, 0);
+    ASSERT(norm != NULL);
+    dvz_visual_density(visual, *(const DvzDensityNorm*)dvz_prop_item(norm, 0));
+
+    // Vertex buffer source: a single quad covering the viewport, that does not depend on the
+    // props. It must be set even if only the point props have been set.
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    ASSERT(source->arr.item_size == sizeof(DvzGraphicsDensityVertex));
+    if (source->arr.item_count == 0)
+    {
+        DvzGraphicsDensityVertex vertices[6] = {
+            {{-1, -1}}, {{+1, -1}}, {{+1, +1}}, {{+1, +1}}, {{-1, +1}}, {{-1, -1}}};
+        dvz_array_resize(&source->arr, 6);
+        dvz_array_data(&source->arr, 0, 6, 6, vertices);
+        source->origin = DVZ_SOURCE_ORIGIN_LIB;
+        _source_set_changed(source, true);
+    }
+}
+
+static void _visual_density(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzProp* prop = NULL;
+
+    // Graphics.
+    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_DENSITY, 0));
+
+    // Sources
+    dvz_visual_source(                                               // vertex buffer
+        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        0, sizeof(DvzGraphicsDensityVertex), 0);                     //
+
+    _common_sources(visual); // common sources
+
+    dvz_visual_source(                                              // params
+        visual, DVZ_SOURCE_TYPE_PARAM, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        DVZ_USER_BINDING, sizeof(DvzGraphicsDensityParams), 0);     //
+
+    dvz_visual_source(                                                      // colormap texture
+        visual, DVZ_SOURCE_TYPE_COLOR_TEXTURE, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        DVZ_USER_BINDING + 1, sizeof(uint8_t), 0);                          //
+
+    dvz_visual_source(                                               // density image
+        visual, DVZ_SOURCE_TYPE_COUNTS, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        DVZ_USER_BINDING + 2, sizeof(uint32_t), 0);                  //
+
+    dvz_visual_source(                                                // points
+        visual, DVZ_SOURCE_TYPE_SAMPLES, 0, DVZ_PIPELINE_GRAPHICS, 0, //
+        0, sizeof(DvzGraphicsDensityPoint), 0);                       //
+
+    // Props:
+
+    // Point pos.
+    prop = dvz_visual_prop(visual, DVZ_PROP_POS, 0, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_SAMPLES, 0);
+    dvz_visual_prop_cast(
+        prop, 0, offsetof(DvzGraphicsDensityPoint, pos), DVZ_DTYPE_VEC3, DVZ_ARRAY_COPY_SINGLE,
+        1);
+
+    // Point weight.
+    prop = dvz_visual_prop(visual, DVZ_PROP_VALUE, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_SAMPLES, 0);
     dvz_visual_prop_copy(
-        prop, 4, offsetof(DvzGraphicsMeshParams, clip_coefs), DVZ_ARRAY_COPY_SINGLE, 1);
+        prop, 1, offsetof(DvzGraphicsDensityPoint, weight), DVZ_ARRAY_COPY_SINGLE, 1);
+    float weight = 1;
+    dvz_visual_prop_default(prop, &weight);
 
-    // // Texture props.
-    // for (uint32_t i = 0; i < 4; i++)
-    //     dvz_visual_prop(visual, DVZ_PROP_IMAGE, i, DVZ_DTYPE_UINT, DVZ_SOURCE_TYPE_IMAGE, i);
+    // Normalization of the density.
+    prop = dvz_visual_prop(
+        visual, DVZ_PROP_NORMALIZATION, 0, DVZ_DTYPE_INT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    DvzDensityNorm norm = DVZ_DENSITY_NORM_LOG;
+    dvz_visual_prop_default(prop, &norm);
 
-    dvz_visual_callback_bake(visual, _mesh_bake);
+    // Common props.
+    _common_props(visual);
+
+    // Param: colormap.
+    prop = dvz_visual_prop(visual, DVZ_PROP_COLORMAP, 0, DVZ_DTYPE_INT, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 0, offsetof(DvzGraphicsDensityParams, cmap), DVZ_ARRAY_COPY_SINGLE, 1);
+    DvzColormap cmap = DVZ_CMAP_VIRIDIS;
+    dvz_visual_prop_default(prop, &cmap);
+
+    dvz_visual_callback_bake(visual, _visual_density_bake);
 }
 
 
@@ -1674,6 +2152,10 @@ static void _visual_volume(DvzVisual* visual)
         visual, DVZ_SOURCE_TYPE_VOLUME, 0, DVZ_PIPELINE_GRAPHICS, 0, //
         DVZ_USER_BINDING + 3, sizeof(uint16_t), 0);                  //
 
+    dvz_visual_source(                                               // brick page table
+        visual, DVZ_SOURCE_TYPE_VOLUME, 1, DVZ_PIPELINE_GRAPHICS, 0, //
+        DVZ_USER_BINDING + 4, sizeof(uint8_t), 0);                   //
+
     // Props:
 
     // Point positions.
@@ -1714,18 +2196,30 @@ static void _visual_volume(DvzVisual* visual)
     // If both values are equal, disable the transfer function on the GPU.
     dvz_visual_prop_default(prop, (vec4){0, 0, 0, 0});
 
+    // Shape of the bricked volume level, in voxels (set by the scene).
+    prop = dvz_visual_prop(visual, DVZ_PROP_LENGTH, 1, DVZ_DTYPE_VEC4, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 4, offsetof(DvzGraphicsVolumeParams, shape), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_default(prop, (vec4){0, 0, 0, 0});
+
+    // Number of bricks along each axis, the volume is not bricked by default.
+    prop = dvz_visual_prop(visual, DVZ_PROP_LENGTH, 2, DVZ_DTYPE_VEC4, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 5, offsetof(DvzGraphicsVolumeParams, bricks), DVZ_ARRAY_COPY_SINGLE, 1);
+    dvz_visual_prop_default(prop, (vec4){0, 0, 0, 0});
+
     // Transfer xrange.
     prop =
         dvz_visual_prop(visual, DVZ_PROP_TRANSFER_X, 0, DVZ_DTYPE_VEC2, DVZ_SOURCE_TYPE_PARAM, 0);
     dvz_visual_prop_copy(
-        prop, 4, offsetof(DvzGraphicsVolumeParams, transfer_xrange), DVZ_ARRAY_COPY_SINGLE, 1);
+        prop, 6, offsetof(DvzGraphicsVolumeParams, transfer_xrange), DVZ_ARRAY_COPY_SINGLE, 1);
     // If both values are equal, disable the transfer function on the GPU.
     dvz_visual_prop_default(prop, (vec2){0, 0});
 
     // Colormap value.
     prop = dvz_visual_prop(visual, DVZ_PROP_COLORMAP, 0, DVZ_DTYPE_INT, DVZ_SOURCE_TYPE_PARAM, 0);
     dvz_visual_prop_copy(
-        prop, 5, offsetof(DvzGraphicsVolumeParams, cmap), DVZ_ARRAY_COPY_SINGLE, 1);
+        prop, 7, offsetof(DvzGraphicsVolumeParams, cmap), DVZ_ARRAY_COPY_SINGLE, 1);
     dvz_visual_prop_default(prop, (DvzColormap[]){DVZ_CMAP_BONE});
 
 
@@ -1943,6 +2437,10 @@ void dvz_visual_builtin(DvzVisual* visual, DvzVisualType type, int flags)
         _visual_marker(visual);
         break;
 
+    case DVZ_VISUAL_MARKER_CMAP:
+        _visual_marker_cmap(visual);
+        break;
+
     case DVZ_VISUAL_POLYGON:
         _visual_polygon(visual);
         break;
@@ -1969,6 +2467,18 @@ void dvz_visual_builtin(DvzVisual* visual, DvzVisualType type, int flags)
         _visual_mesh(visual);
         break;
 
+    case DVZ_VISUAL_MESH_INSTANCED:
+        _visual_mesh_instanced(visual);
+        break;
+
+    case DVZ_VISUAL_HISTOGRAM:
+        _visual_histogram(visual);
+        break;
+
+    case DVZ_VISUAL_DENSITY:
+        _visual_density(visual);
+        break;
+
     case DVZ_VISUAL_VOLUME:
         _visual_volume(visual);
         break;
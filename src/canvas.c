@@ -27,7 +27,8 @@
 /*  Utils                                                                                        */
 /*************************************************************************************************/
 
-static DvzRenderpass renderpass_overlay(DvzGpu* gpu, VkFormat format, VkImageLayout layout)
+static DvzRenderpass
+renderpass_overlay(DvzGpu* gpu, VkFormat format, VkImageLayout layout, bool depth)
 {
     DvzRenderpass renderpass = dvz_renderpass(gpu);
 
@@ -41,19 +42,25 @@ static DvzRenderpass renderpass_overlay(DvzGpu* gpu, VkFormat format, VkImageLay
         &renderpass, 0, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE);
 
     // Depth attachment.
-    dvz_renderpass_attachment(
-        &renderpass, 1, //
-        DVZ_RENDERPASS_ATTACHMENT_DEPTH, VK_FORMAT_D32_SFLOAT,
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
-    dvz_renderpass_attachment_layout(
-        &renderpass, 1, VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
-    dvz_renderpass_attachment_ops(
-        &renderpass, 1, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+    // NOTE: the overlay is rendered directly in the single-sampled swapchain image, so it cannot
+    // share the multisampled depth image of the default renderpass.
+    if (depth)
+    {
+        dvz_renderpass_attachment(
+            &renderpass, 1, //
+            DVZ_RENDERPASS_ATTACHMENT_DEPTH, VK_FORMAT_D32_SFLOAT,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        dvz_renderpass_attachment_layout(
+            &renderpass, 1, VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        dvz_renderpass_attachment_ops(
+            &renderpass, 1, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+    }
 
     // Subpass.
     dvz_renderpass_subpass_attachment(&renderpass, 0, 0);
-    dvz_renderpass_subpass_attachment(&renderpass, 0, 1);
+    if (depth)
+        dvz_renderpass_subpass_attachment(&renderpass, 0, 1);
     dvz_renderpass_subpass_dependency(&renderpass, 0, VK_SUBPASS_EXTERNAL, 0);
     dvz_renderpass_subpass_dependency_stage(
         &renderpass, 0, //
@@ -73,6 +80,7 @@ depth_image(DvzImages* depth_images, DvzRenderpass* renderpass, uint32_t width,
     // Depth attachment
     dvz_images_format(depth_images, renderpass->attachments[1].format);
     dvz_images_size(depth_images, width, height, 1);
+    dvz_images_samples(depth_images, renderpass->attachments[1].samples);
     dvz_images_tiling(depth_images, VK_IMAGE_TILING_OPTIMAL);
     dvz_images_usage(depth_images, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
     dvz_images_memory(depth_images, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -84,6 +92,51 @@ depth_image(DvzImages* depth_images, DvzRenderpass* renderpass, uint32_t width,
 
 
 
+static void
+msaa_image(DvzImages* msaa_images, DvzRenderpass* renderpass, uint32_t width, uint32_t height)
+{
+    // Multisampled color attachment, only used within the renderpass.
+    dvz_images_format(msaa_images, renderpass->attachments[2].format);
+    dvz_images_size(msaa_images, width, height, 1);
+    dvz_images_samples(msaa_images, renderpass->attachments[2].samples);
+    dvz_images_tiling(msaa_images, VK_IMAGE_TILING_OPTIMAL);
+    dvz_images_usage(
+        msaa_images,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT);
+    dvz_images_memory(msaa_images, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    dvz_images_layout(msaa_images, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    dvz_images_aspect(msaa_images, VK_IMAGE_ASPECT_COLOR_BIT);
+    dvz_images_queue_access(msaa_images, 0);
+    dvz_images_create(msaa_images);
+}
+
+
+
+static void pick_image(
+    DvzImages* pick_images, DvzRenderpass* renderpass, uint32_t idx, //
+    uint32_t width, uint32_t height)
+{
+    // Integer object picking attachment, the single-sampled one is copied to the host.
+    DvzRenderpassAttachment* attachment = &renderpass->attachments[idx];
+    bool msaa = attachment->samples > VK_SAMPLE_COUNT_1_BIT;
+    dvz_images_format(pick_images, attachment->format);
+    dvz_images_size(pick_images, width, height, 1);
+    dvz_images_samples(pick_images, attachment->samples);
+    dvz_images_tiling(pick_images, VK_IMAGE_TILING_OPTIMAL);
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    usage |= msaa ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    dvz_images_usage(pick_images, usage);
+    dvz_images_memory(pick_images, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    dvz_images_layout(
+        pick_images,
+        msaa ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    dvz_images_aspect(pick_images, VK_IMAGE_ASPECT_COLOR_BIT);
+    dvz_images_queue_access(pick_images, DVZ_DEFAULT_QUEUE_RENDER);
+    dvz_images_create(pick_images);
+}
+
+
+
 static void blank_commands(DvzCanvas* canvas, DvzCommands* cmds, uint32_t cmd_idx)
 {
     dvz_cmd_begin(cmds, cmd_idx);
@@ -110,6 +163,244 @@ static inline bool _all_true(uint32_t n, bool* arr)
 
 
 
+// Whether the canvas processes its frames in its own thread, see dvz_app_parallel().
+// NOTE: the frame state is set before the frame thread starts, unlike the thread object, so that
+// the frame thread sees itself as threaded from its first frame.
+static inline bool _is_threaded(DvzCanvas* canvas)
+{
+    return atomic_load(&canvas->frame_state) != DVZ_FRAME_STATE_NONE;
+}
+
+static inline void _frame_lock(DvzCanvas* canvas)
+{
+    if (_is_threaded(canvas))
+        pthread_mutex_lock(&canvas->frame_lock);
+}
+
+static inline void _frame_unlock(DvzCanvas* canvas)
+{
+    if (_is_threaded(canvas))
+        pthread_mutex_unlock(&canvas->frame_lock);
+}
+
+
+
+/*************************************************************************************************/
+/*  Object picking utils                                                                         */
+/*************************************************************************************************/
+
+static void _pick_create(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzGpu* gpu = canvas->gpu;
+    DvzPick* pick = &canvas->pick;
+    uint32_t width = canvas->swapchain.images->width;
+    uint32_t height = canvas->swapchain.images->height;
+
+    // Picking attachments, see default_renderpass().
+    bool msaa = canvas->samples > VK_SAMPLE_COUNT_1_BIT;
+    pick->image = dvz_images(gpu, VK_IMAGE_TYPE_2D, 1);
+    pick_image(&pick->image, &canvas->renderpass, msaa ? 3 : 2, width, height);
+    if (msaa)
+    {
+        pick->msaa_image = dvz_images(gpu, VK_IMAGE_TYPE_2D, 1);
+        pick_image(&pick->msaa_image, &canvas->renderpass, 4, width, height);
+    }
+
+    // Permanently mapped staging buffer, large enough for the biggest pick region.
+    pick->staging = dvz_buffer(gpu);
+    dvz_buffer_size(&pick->staging, DVZ_PICK_MAX_SIZE * DVZ_PICK_MAX_SIZE * sizeof(uvec2));
+    dvz_buffer_usage(&pick->staging, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    dvz_buffer_memory(
+        &pick->staging,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    dvz_buffer_queue_access(&pick->staging, DVZ_DEFAULT_QUEUE_RENDER);
+    dvz_buffer_create(&pick->staging);
+    pick->staging.mmap = dvz_buffer_map(&pick->staging, 0, VK_WHOLE_SIZE);
+
+    // The copy command buffer is submitted to the render queue just after a frame, so that the
+    // barrier waits for the rendering of that frame without semaphore.
+    pick->cmds = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_RENDER, 1);
+    pick->fence = dvz_fences(gpu, 1, true);
+    pick->submit = dvz_submit(gpu);
+    pthread_mutex_init(&pick->lock, NULL);
+}
+
+
+
+static void _pick_destroy(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPick* pick = &canvas->pick;
+    dvz_images_destroy(&pick->image);
+    dvz_images_destroy(&pick->msaa_image);
+    dvz_buffer_destroy(&pick->staging);
+    dvz_commands_destroy(&pick->cmds);
+    dvz_fences_destroy(&pick->fence);
+    pthread_mutex_destroy(&pick->lock);
+}
+
+
+
+// Record and submit the copy of the pick region to the staging buffer.
+static void _pick_copy(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPick* pick = &canvas->pick;
+    DvzImages* images = &pick->image;
+    DvzCommands* cmds = &pick->cmds;
+    DvzBufferRegions br = dvz_buffer_regions(&pick->staging, 1, 0, pick->staging.size, 0);
+
+    dvz_cmd_reset(cmds, 0);
+    dvz_cmd_begin(cmds, 0);
+
+    // The renderpass leaves the picking image in the SRC layout, wait for the frame rendering.
+    DvzBarrier barrier = dvz_barrier(canvas->gpu);
+    dvz_barrier_images(&barrier, images);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    dvz_cmd_barrier(cmds, 0, &barrier);
+
+    dvz_cmd_copy_image_region_to_buffer(
+        cmds, 0, images, pick->offset, pick->shape, &pick->staging, 0);
+
+    // The next frame must not clear the picking image before the end of the copy, and the copied
+    // region must be visible to the host.
+    barrier = dvz_barrier(canvas->gpu);
+    dvz_barrier_images(&barrier, images);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+    dvz_barrier_buffer(&barrier, br);
+    dvz_barrier_buffer_access(&barrier, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT);
+    dvz_cmd_barrier(cmds, 0, &barrier);
+
+    dvz_cmd_end(cmds, 0);
+
+    dvz_submit_reset(&pick->submit);
+    dvz_submit_commands(&pick->submit, cmds);
+    dvz_submit_send(&pick->submit, 0, &pick->fence, 0);
+    pick->pending = true;
+}
+
+
+
+// Find the hit closest to the requested position in the copied region, and raise a PICK event.
+static void _pick_event(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPick* pick = &canvas->pick;
+    uint32_t* texels = (uint32_t*)pick->staging.mmap;
+    ASSERT(texels != NULL);
+
+    DvzEvent ev = {0};
+    ev.type = DVZ_EVENT_PICK;
+    ev.u.p.pos[0] = pick->pending_pos[0];
+    ev.u.p.pos[1] = pick->pending_pos[1];
+
+    int64_t best = -1;
+    int64_t dx = 0, dy = 0, d = 0;
+    uint32_t k = 0;
+    for (uint32_t j = 0; j < pick->shape[1]; j++)
+    {
+        for (uint32_t i = 0; i < pick->shape[0]; i++)
+        {
+            k = 2 * (j * pick->shape[0] + i);
+            if (texels[k] == 0)
+                continue;
+            dx = (int64_t)pick->offset[0] + i - pick->center[0];
+            dy = (int64_t)pick->offset[1] + j - pick->center[1];
+            d = dx * dx + dy * dy;
+            if (best >= 0 && d >= best)
+                continue;
+            best = d;
+            ev.u.p.pixel[0] = (uint32_t)pick->offset[0] + i;
+            ev.u.p.pixel[1] = (uint32_t)pick->offset[1] + j;
+            ev.u.p.visual = texels[k];
+            ev.u.p.item = texels[k + 1];
+        }
+    }
+    _event_produce(canvas, ev);
+}
+
+
+
+// Called after each frame submission: raise the PICK event once the pending copy is done, and
+// start the copy of the latest request.
+static void _pick_process(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPick* pick = &canvas->pick;
+
+    // Never wait for the copy, the fence is checked again after the next frame.
+    if (pick->pending)
+    {
+        if (!dvz_fences_ready(&pick->fence, 0))
+            return;
+        pick->pending = false;
+        _pick_event(canvas);
+    }
+
+    pthread_mutex_lock(&pick->lock);
+    bool requested = pick->requested;
+    vec2 pos = {pick->pos[0], pick->pos[1]};
+    uint32_t size = pick->size;
+    pick->requested = false;
+    pthread_mutex_unlock(&pick->lock);
+    if (!requested)
+        return;
+
+    // Convert the position from screen coordinates to framebuffer pixels.
+    uvec2 size_screen = {0}, size_framebuffer = {0};
+    dvz_canvas_size(canvas, DVZ_CANVAS_SIZE_SCREEN, size_screen);
+    dvz_canvas_size(canvas, DVZ_CANVAS_SIZE_FRAMEBUFFER, size_framebuffer);
+    ASSERT(size_screen[0] > 0 && size_screen[1] > 0);
+    int32_t x = (int32_t)floor(pos[0] * size_framebuffer[0] / size_screen[0]);
+    int32_t y = (int32_t)floor(pos[1] * size_framebuffer[1] / size_screen[1]);
+    int32_t w = (int32_t)pick->image.width;
+    int32_t h = (int32_t)pick->image.height;
+    if (x < 0 || y < 0 || x >= w || y >= h)
+    {
+        // Nothing to copy outside of the canvas.
+        DvzEvent ev = {0};
+        ev.type = DVZ_EVENT_PICK;
+        ev.u.p.pos[0] = pos[0];
+        ev.u.p.pos[1] = pos[1];
+        _event_produce(canvas, ev);
+        return;
+    }
+
+    // Square region around the position, clipped to the canvas.
+    int32_t x0 = MAX(x - (int32_t)size / 2, 0);
+    int32_t y0 = MAX(y - (int32_t)size / 2, 0);
+    int32_t x1 = MIN(x - (int32_t)size / 2 + (int32_t)size, w);
+    int32_t y1 = MIN(y - (int32_t)size / 2 + (int32_t)size, h);
+    ASSERT(x0 <= x && x < x1);
+    ASSERT(y0 <= y && y < y1);
+
+    pick->pending_pos[0] = pos[0];
+    pick->pending_pos[1] = pos[1];
+    pick->offset[0] = x0;
+    pick->offset[1] = y0;
+    pick->offset[2] = 0;
+    pick->shape[0] = (uint32_t)(x1 - x0);
+    pick->shape[1] = (uint32_t)(y1 - y0);
+    pick->shape[2] = 1;
+    pick->center[0] = (uint32_t)x;
+    pick->center[1] = (uint32_t)y;
+    _pick_copy(canvas);
+}
+
+
+
 /*************************************************************************************************/
 /*  Backend-specific event callbacks                                                             */
 /*************************************************************************************************/
@@ -128,6 +419,18 @@ static int _key_modifiers(int key_code)
     return mods;
 }
 
+// Raise the input events received by the backend since the last frame, at most one per type.
+static void _flush_input(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzPendingInput* input = &canvas->input;
+    if (input->has_move)
+        dvz_event_mouse_move(canvas, input->pos, input->modifiers);
+    if (input->has_wheel)
+        dvz_event_mouse_wheel(canvas, canvas->mouse.cur_pos, input->wheel_dir, input->modifiers);
+    memset(input, 0, sizeof(DvzPendingInput));
+}
+
 static void _glfw_key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     DvzCanvas* canvas = (DvzCanvas*)glfwGetWindowUserPointer(window);
@@ -148,10 +451,12 @@ static void _glfw_key_callback(GLFWwindow* window, int key, int scancode, int ac
     key_code = key;
 
     // Find the key event type.
+    _frame_lock(canvas);
     if (action == GLFW_PRESS || action == GLFW_REPEAT)
         dvz_event_key_press(canvas, key_code, mods);
     else
         dvz_event_key_release(canvas, key_code, mods);
+    _frame_unlock(canvas);
 }
 
 static void _glfw_wheel_callback(GLFWwindow* window, double dx, double dy)
@@ -165,8 +470,16 @@ static void _glfw_wheel_callback(GLFWwindow* window, double dx, double dy)
     // Limitation: a single modifier is allowed here.
     // TODO: allow for multiple simultlaneous modifiers, will require updating the keyboard struct
     // so that it supports multiple simultaneous keys
-    dvz_event_mouse_wheel(
-        canvas, canvas->mouse.cur_pos, (vec2){dx, dy}, _key_modifiers(canvas->keyboard.key_code));
+    // NOTE: the wheel events received during a frame are merged into a single event, raised at the
+    // next frame.
+    _frame_lock(canvas);
+    DvzPendingInput* input = &canvas->input;
+    input->wheel_dir[0] += dx;
+    input->wheel_dir[1] += dy;
+    input->modifiers = _key_modifiers(canvas->keyboard.key_code);
+    input->has_wheel = true;
+    _frame_unlock(canvas);
+    dvz_canvas_redraw(canvas);
 }
 
 static void _glfw_button_callback(GLFWwindow* window, int button, int action, int mods)
@@ -186,10 +499,15 @@ static void _glfw_button_callback(GLFWwindow* window, int button, int action, in
 
     // Find mouse button action type
     // NOTE: Datoviz modifiers code must match GLFW
+    _frame_lock(canvas);
+    // The pending move is raised before the button event, so that it is not merged with the
+    // moves received after it.
+    _flush_input(canvas);
     if (action == GLFW_PRESS)
         dvz_event_mouse_press(canvas, b, mods);
     else
         dvz_event_mouse_release(canvas, b, mods);
+    _frame_unlock(canvas);
 }
 
 static void _glfw_move_callback(GLFWwindow* window, double xpos, double ypos)
@@ -198,7 +516,33 @@ static void _glfw_move_callback(GLFWwindow* window, double xpos, double ypos)
     ASSERT(canvas != NULL);
     ASSERT(canvas->window != NULL);
 
-    dvz_event_mouse_move(canvas, (vec2){xpos, ypos}, canvas->mouse.modifiers);
+    // NOTE: only the latest position is kept, a single move event is raised at the next frame.
+    _frame_lock(canvas);
+    DvzPendingInput* input = &canvas->input;
+    input->pos[0] = xpos;
+    input->pos[1] = ypos;
+    input->modifiers = canvas->mouse.modifiers;
+    input->has_move = true;
+    _frame_unlock(canvas);
+}
+
+// With on-demand rendering, a new frame is needed when the window has been damaged or resized,
+// or when the cursor has moved, as the cursor position is only polled at every frame.
+static void _glfw_refresh_callback(GLFWwindow* window)
+{
+    DvzCanvas* canvas = (DvzCanvas*)glfwGetWindowUserPointer(window);
+    ASSERT(canvas != NULL);
+    dvz_canvas_redraw(canvas);
+}
+
+static void _glfw_size_callback(GLFWwindow* window, int width, int height)
+{
+    _glfw_refresh_callback(window);
+}
+
+static void _glfw_cursor_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    _glfw_refresh_callback(window);
 }
 
 static void _glfw_frame_callback(DvzCanvas* canvas, DvzEvent ev)
@@ -213,9 +557,20 @@ static void _glfw_frame_callback(DvzCanvas* canvas, DvzEvent ev)
     canvas->mouse.prev_state = canvas->mouse.cur_state;
 
     // Mouse move event.
-    double xpos, ypos;
-    glfwGetCursorPos(w, &xpos, &ypos);
-    vec2 pos = {xpos, ypos};
+    // NOTE: in parallel mode, this callback runs in the frame thread and the cursor position is
+    // polled by the main thread, as GLFW functions must be called from the main thread.
+    vec2 pos = {0};
+    if (_is_threaded(canvas))
+    {
+        glm_vec2_copy(canvas->cursor_pos, pos);
+    }
+    else
+    {
+        double xpos, ypos;
+        glfwGetCursorPos(w, &xpos, &ypos);
+        pos[0] = xpos;
+        pos[1] = ypos;
+    }
     if (canvas->mouse.cur_pos[0] != pos[0] || canvas->mouse.cur_pos[1] != pos[1])
         dvz_event_mouse_move(canvas, pos, canvas->mouse.modifiers);
 
@@ -241,6 +596,22 @@ static void _backend_next_frame(DvzCanvas* canvas)
     }
 }
 
+static void _backend_poll_cursor(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->app != NULL);
+    if (canvas->app->backend != DVZ_BACKEND_GLFW || canvas->window == NULL)
+        return;
+
+    double xpos, ypos;
+    glfwGetCursorPos(canvas->window->backend_window, &xpos, &ypos);
+
+    _frame_lock(canvas);
+    canvas->cursor_pos[0] = xpos;
+    canvas->cursor_pos[1] = ypos;
+    _frame_unlock(canvas);
+}
+
 static void backend_event_callbacks(DvzCanvas* canvas)
 {
     ASSERT(canvas != NULL);
@@ -266,6 +637,14 @@ static void backend_event_callbacks(DvzCanvas* canvas)
         // Register the mouse move callback.
         // glfwSetCursorPosCallback(w, _glfw_move_callback);
 
+        // Wake up the idle canvas with on-demand rendering.
+        if (canvas->on_demand)
+        {
+            glfwSetWindowRefreshCallback(w, _glfw_refresh_callback);
+            glfwSetFramebufferSizeCallback(w, _glfw_size_callback);
+            glfwSetCursorPosCallback(w, _glfw_cursor_callback);
+        }
+
         // Register a function called at every frame, after event polling and state update
         dvz_event_callback(
             canvas, DVZ_EVENT_INTERACT, 0, DVZ_EVENT_MODE_SYNC, _glfw_frame_callback, NULL);
@@ -304,14 +683,14 @@ static int _event_frame(DvzCanvas* canvas)
 
 
 
-static void _event_timer(DvzCanvas* canvas)
+static uint32_t _event_timer(DvzCanvas* canvas, double cur_time)
 {
     ASSERT(canvas != NULL);
     // Go through all TIMER callbacks
     double last_time = 0;
     double expected_time = 0;
-    double cur_time = canvas->clock.elapsed;
     double interval = 0;
+    uint32_t count = 0; // number of TIMER callbacks called
     DvzEvent ev = {0};
     DvzEventCallbackRegister* r = NULL;
     ev.type = DVZ_EVENT_TIMER;
@@ -343,9 +722,11 @@ static void _event_timer(DvzCanvas* canvas)
 
                 // Call this TIMER callback.
                 r->callback(canvas, ev);
+                count++;
             }
         }
     }
+    return count;
 }
 
 
@@ -547,6 +928,111 @@ static void _fps_callback(DvzCanvas* canvas, DvzEvent ev)
 
 
 
+/*************************************************************************************************/
+/*  On-demand rendering utils                                                                    */
+/*************************************************************************************************/
+
+static void _idle_wakeup(DvzApp* app)
+{
+    ASSERT(app != NULL);
+    pthread_mutex_lock(&app->idle_lock);
+    app->idle_seq++;
+    pthread_cond_broadcast(&app->idle_cond);
+    pthread_mutex_unlock(&app->idle_lock);
+
+    // Also wake up the main thread waiting for the window events.
+    backend_post_empty_event(app->backend);
+}
+
+
+
+static uint64_t _idle_seq(DvzApp* app)
+{
+    ASSERT(app != NULL);
+    pthread_mutex_lock(&app->idle_lock);
+    uint64_t seq = app->idle_seq;
+    pthread_mutex_unlock(&app->idle_lock);
+    return seq;
+}
+
+
+
+// Block until a wake-up happens after the sequence number was read, or until the timeout (in
+// seconds) expires. With backend events, the main thread waits for the window events instead.
+static void _idle_wait(DvzApp* app, uint64_t seq, double timeout, bool backend_events)
+{
+    ASSERT(app != NULL);
+    ASSERT(timeout >= 0);
+
+    pthread_mutex_lock(&app->idle_lock);
+    bool woken = app->idle_seq != seq;
+    if (!woken && !backend_events)
+    {
+        struct timespec ts = {0};
+        clock_gettime(CLOCK_REALTIME, &ts);
+        double deadline = ts.tv_sec + ts.tv_nsec * 1e-9 + timeout;
+        ts.tv_sec = (time_t)deadline;
+        ts.tv_nsec = (long)((deadline - ts.tv_sec) * 1e9);
+        pthread_cond_timedwait(&app->idle_cond, &app->idle_lock, &ts);
+    }
+    pthread_mutex_unlock(&app->idle_lock);
+
+    // NOTE: a wake-up after the sequence number check posts an empty event, so that this call
+    // returns immediately.
+    if (!woken && backend_events && timeout > 0)
+        backend_wait_events(app->backend, timeout);
+}
+
+
+
+// The idle wait must not delay the next TIMER callback.
+static double _idle_timeout(DvzCanvas* canvas, double timeout)
+{
+    ASSERT(canvas != NULL);
+    double cur_time = _clock_get(&canvas->clock);
+    DvzEventCallbackRegister* r = NULL;
+    for (uint32_t i = 0; i < canvas->callbacks_count; i++)
+    {
+        r = &canvas->callbacks[i];
+        if (r->type == DVZ_EVENT_TIMER)
+            timeout = fmin(timeout, (r->idx + 1) * r->param - cur_time);
+    }
+    return fmax(timeout, 0);
+}
+
+
+
+// Whether an on-demand canvas can skip the current frame. This check has no side effect: a due
+// TIMER callback triggers a new frame, which calls it, see dvz_canvas_frame().
+static bool _canvas_idle(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    if (!canvas->on_demand)
+        return false;
+
+    // Explicit request, input event, resize, or data change, see dvz_canvas_redraw().
+    bool redraw = atomic_exchange(&canvas->redraw, false);
+    if (redraw || canvas->frame_idx == 0)
+        return false;
+
+    // Pending refill, data transfers, or input events to flush.
+    if (atomic_load(&canvas->refills.status) != DVZ_REFILL_NONE)
+        return false;
+    if (dvz_fifo_size(&canvas->transfers) > 0)
+        return false;
+    if (canvas->input.has_move || canvas->input.has_wheel)
+        return false;
+
+    // Screencasts and pick readbacks are processed after every frame.
+    if (canvas->screencast != NULL || canvas->pick.pending)
+        return false;
+
+    // Next TIMER callback due.
+    return _idle_timeout(canvas, DVZ_IDLE_MAX_WAIT) > 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  Canvas creation                                                                              */
 /*************************************************************************************************/
@@ -580,6 +1066,15 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
     canvas->flags = flags;
     bool show_fps = ((canvas->flags >> 1) & DVZ_CANVAS_FLAGS_FPS) != 0;
 
+    // Multisampling, the flag encodes the base-2 logarithm of the requested sample count.
+    int flag_msaa = (flags >> 8) & 0x000F;
+    VkSampleCountFlagBits samples = (VkSampleCountFlagBits)(1 << flag_msaa);
+    canvas->samples = max_sample_count(&gpu->device_properties, samples);
+    if (canvas->samples != samples)
+        log_warn(
+            "%dx MSAA is not supported by the device, falling back to %dx", //
+            samples, canvas->samples);
+
     // Initialize the canvas local clock.
     _clock_init(&canvas->clock);
 
@@ -588,6 +1083,10 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
     atomic_init(&canvas->to_close, false);
     atomic_init(&canvas->refills.status, DVZ_REFILL_NONE);
 
+    // On-demand rendering.
+    canvas->on_demand = (flags & DVZ_CANVAS_FLAGS_ON_DEMAND) != 0;
+    atomic_init(&canvas->redraw, false);
+
     // Allocate memory for canvas objects.
     canvas->commands =
         dvz_container(DVZ_CONTAINER_DEFAULT_COUNT, sizeof(DvzCommands), DVZ_OBJECT_TYPE_COMMANDS);
@@ -615,11 +1114,13 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
     }
 
     // Create default renderpass.
-    canvas->renderpass =
-        default_renderpass(gpu, DVZ_DEFAULT_BACKGROUND, DVZ_DEFAULT_IMAGE_FORMAT, overlay);
+    bool msaa = canvas->samples > VK_SAMPLE_COUNT_1_BIT;
+    bool pick = (flags & DVZ_CANVAS_FLAGS_PICK) != 0;
+    canvas->renderpass = default_renderpass(
+        gpu, DVZ_DEFAULT_BACKGROUND, DVZ_DEFAULT_IMAGE_FORMAT, overlay, canvas->samples, pick);
     if (overlay)
-        canvas->renderpass_overlay =
-            renderpass_overlay(gpu, DVZ_DEFAULT_IMAGE_FORMAT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        canvas->renderpass_overlay = renderpass_overlay(
+            gpu, DVZ_DEFAULT_IMAGE_FORMAT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, !msaa);
 
     // Create swapchain
     {
@@ -661,6 +1162,19 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
         depth_image(
             &canvas->depth_image, &canvas->renderpass, //
             canvas->swapchain.images->width, canvas->swapchain.images->height);
+
+        // Multisampled color attachment.
+        if (msaa)
+        {
+            canvas->msaa_image = dvz_images(gpu, VK_IMAGE_TYPE_2D, 1);
+            msaa_image(
+                &canvas->msaa_image, &canvas->renderpass, //
+                canvas->swapchain.images->width, canvas->swapchain.images->height);
+        }
+
+        // Object picking attachments.
+        if (pick)
+            _pick_create(canvas);
     }
 
     // Create renderpass.
@@ -673,6 +1187,12 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
         canvas->framebuffers = dvz_framebuffers(gpu);
         dvz_framebuffers_attachment(&canvas->framebuffers, 0, canvas->swapchain.images);
         dvz_framebuffers_attachment(&canvas->framebuffers, 1, &canvas->depth_image);
+        if (msaa)
+            dvz_framebuffers_attachment(&canvas->framebuffers, 2, &canvas->msaa_image);
+        if (pick)
+            dvz_framebuffers_attachment(&canvas->framebuffers, msaa ? 3 : 2, &canvas->pick.image);
+        if (pick && msaa)
+            dvz_framebuffers_attachment(&canvas->framebuffers, 4, &canvas->pick.msaa_image);
         dvz_framebuffers_create(&canvas->framebuffers, &canvas->renderpass);
 
         if (overlay)
@@ -680,7 +1200,9 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
             canvas->framebuffers_overlay = dvz_framebuffers(gpu);
             dvz_framebuffers_attachment(
                 &canvas->framebuffers_overlay, 0, canvas->swapchain.images);
-            dvz_framebuffers_attachment(&canvas->framebuffers_overlay, 1, &canvas->depth_image);
+            if (!msaa)
+                dvz_framebuffers_attachment(
+                    &canvas->framebuffers_overlay, 1, &canvas->depth_image);
             dvz_framebuffers_create(&canvas->framebuffers_overlay, &canvas->renderpass_overlay);
         }
     }
@@ -716,7 +1238,10 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
 
     // Event system.
     {
-        canvas->event_queue = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+        pthread_mutex_init(&canvas->event_lock, NULL);
+        pthread_cond_init(&canvas->event_cond, NULL);
+        _clock_init(&canvas->event_clock);
+        _event_queues_init(canvas);
         canvas->event_thread = dvz_thread(_event_thread, canvas);
 
         canvas->mouse = dvz_mouse();
@@ -750,8 +1275,11 @@ _canvas(DvzGpu* gpu, uint32_t width, uint32_t height, bool offscreen, bool overl
         canvas->fps = 100;
         canvas->efps = 100;
         // Compute FPS every 100 ms, even if FPS is not shown (so that the value remains accessible
-        // in callbacks if needed).
-        dvz_event_callback(canvas, DVZ_EVENT_TIMER, .1, DVZ_EVENT_MODE_SYNC, _fps_callback, NULL);
+        // in callbacks if needed). This TIMER would wake up an idle on-demand canvas 10 times per
+        // second, so it is only used if the FPS is shown.
+        if (!canvas->on_demand || show_fps)
+            dvz_event_callback(
+                canvas, DVZ_EVENT_TIMER, .1, DVZ_EVENT_MODE_SYNC, _fps_callback, NULL);
 
         if (show_fps)
             dvz_event_callback(
@@ -813,6 +1341,9 @@ void dvz_canvas_recreate(DvzCanvas* canvas)
     if (canvas->overlay)
         dvz_framebuffers_destroy(&canvas->framebuffers_overlay);
     dvz_images_destroy(&canvas->depth_image);
+    dvz_images_destroy(&canvas->msaa_image);
+    dvz_images_destroy(&canvas->pick.image);
+    dvz_images_destroy(&canvas->pick.msaa_image);
     dvz_images_destroy(canvas->swapchain.images);
 
     // Recreate the swapchain. This will automatically set the swapchain->images new size.
@@ -828,6 +1359,21 @@ void dvz_canvas_recreate(DvzCanvas* canvas)
     // Need to recreate the depth image with the new size.
     dvz_images_size(&canvas->depth_image, width, height, 1);
     dvz_images_create(&canvas->depth_image);
+    if (canvas->samples > VK_SAMPLE_COUNT_1_BIT)
+    {
+        dvz_images_size(&canvas->msaa_image, width, height, 1);
+        dvz_images_create(&canvas->msaa_image);
+    }
+    if ((canvas->flags & DVZ_CANVAS_FLAGS_PICK) != 0)
+    {
+        dvz_images_size(&canvas->pick.image, width, height, 1);
+        dvz_images_create(&canvas->pick.image);
+        if (canvas->samples > VK_SAMPLE_COUNT_1_BIT)
+        {
+            dvz_images_size(&canvas->pick.msaa_image, width, height, 1);
+            dvz_images_create(&canvas->pick.msaa_image);
+        }
+    }
 
     // Recreate the framebuffers with the new size.
     ASSERT(framebuffers->attachments[0]->width == width);
@@ -857,8 +1403,10 @@ DvzCommands* dvz_canvas_commands(DvzCanvas* canvas, uint32_t queue_idx, uint32_t
 
 DvzCanvas* dvz_canvas_offscreen(DvzGpu* gpu, uint32_t width, uint32_t height, int flags)
 {
-    // NOTE: no overlay for now in offscreen canvas
-    return _canvas(gpu, width, height, true, false, 0);
+    // NOTE: no overlay for now in offscreen canvas, only the MSAA, picking, and on-demand
+    // rendering flags are used.
+    int mask = 0x0F00 | DVZ_CANVAS_FLAGS_PICK | DVZ_CANVAS_FLAGS_ON_DEMAND;
+    return _canvas(gpu, width, height, true, false, flags & mask);
 }
 
 
@@ -871,6 +1419,9 @@ void dvz_canvas_clear_color(DvzCanvas* canvas, float red, float green, float blu
 {
     ASSERT(canvas != NULL);
     canvas->renderpass.clear_values->color = (VkClearColorValue){{red, green, blue, 1}};
+    // With MSAA, the multisampled color attachment is the one that is cleared.
+    if (canvas->samples > VK_SAMPLE_COUNT_1_BIT)
+        canvas->renderpass.clear_values[2].color = canvas->renderpass.clear_values->color;
     dvz_canvas_to_refill(canvas);
 }
 
@@ -1037,6 +1588,8 @@ void dvz_canvas_to_refill(DvzCanvas* canvas)
     ASSERT(canvas != NULL);
     DvzRefillStatus status = DVZ_REFILL_REQUESTED;
     atomic_store(&canvas->refills.status, status);
+    if (canvas->on_demand)
+        _idle_wakeup(canvas->app);
 }
 
 
@@ -1050,6 +1603,18 @@ void dvz_canvas_to_close(DvzCanvas* canvas)
 
 
 
+void dvz_canvas_redraw(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    if (!canvas->on_demand)
+        return;
+    bool value = true;
+    atomic_store(&canvas->redraw, value);
+    _idle_wakeup(canvas->app);
+}
+
+
+
 /*************************************************************************************************/
 /*  Utils                                                                                        */
 /*************************************************************************************************/
@@ -1310,6 +1875,14 @@ void dvz_keyboard_event(DvzKeyboard* keyboard, DvzCanvas* canvas, DvzEvent ev)
 /*  Event system                                                                                 */
 /*************************************************************************************************/
 
+// Input events trigger a new frame with on-demand rendering.
+static inline void _event_input(DvzCanvas* canvas, DvzEvent event)
+{
+    dvz_canvas_redraw(canvas);
+    _event_produce(canvas, event);
+}
+
+
 void dvz_event_mouse_press(DvzCanvas* canvas, DvzMouseButton button, int modifiers)
 {
     ASSERT(canvas != NULL);
@@ -1324,7 +1897,7 @@ void dvz_event_mouse_press(DvzCanvas* canvas, DvzMouseButton button, int modifie
     // Update the mouse state.
     dvz_mouse_event(&canvas->mouse, canvas, event);
 
-    _event_produce(canvas, event);
+    _event_input(canvas, event);
 }
 
 
@@ -1343,7 +1916,7 @@ void dvz_event_mouse_release(DvzCanvas* canvas, DvzMouseButton button, int modif
     // Update the mouse state.
     dvz_mouse_event(&canvas->mouse, canvas, event);
 
-    _event_produce(canvas, event);
+    _event_input(canvas, event);
 }
 
 
@@ -1363,7 +1936,7 @@ void dvz_event_mouse_move(DvzCanvas* canvas, vec2 pos, int modifiers)
     // Update the mouse state.
     dvz_mouse_event(&canvas->mouse, canvas, event);
 
-    _event_produce(canvas, event);
+    _event_input(canvas, event);
 }
 
 
@@ -1385,7 +1958,7 @@ void dvz_event_mouse_wheel(DvzCanvas* canvas, vec2 pos, vec2 dir, int modifiers)
     // Update the mouse state.
     dvz_mouse_event(&canvas->mouse, canvas, event);
 
-    _event_produce(canvas, event);
+    _event_input(canvas, event);
 }
 
 
@@ -1403,7 +1976,7 @@ void dvz_event_mouse_click(DvzCanvas* canvas, vec2 pos, DvzMouseButton button, i
     event.u.c.button = button;
     event.u.c.modifiers = modifiers;
     event.u.c.double_click = false;
-    _event_produce(canvas, event);
+    _event_input(canvas, event);
 }
 
 
@@ -1422,7 +1995,7 @@ void dvz_event_mouse_double_click(
     event.u.c.button = button;
     event.u.c.modifiers = modifiers;
     event.u.c.double_click = true;
-    _event_produce(canvas, event);
+    _event_input(canvas, event);
 }
 
 
@@ -1439,7 +2012,7 @@ void dvz_event_mouse_drag(DvzCanvas* canvas, vec2 pos, DvzMouseButton button, in
     event.u.d.pos[1] = pos[1];
     event.u.d.modifiers = modifiers;
     event.u.d.button = button;
-    _event_produce(canvas, event);
+    _event_input(canvas, event);
 }
 
 
@@ -1453,7 +2026,7 @@ void dvz_event_mouse_drag_end(DvzCanvas* canvas, vec2 pos, DvzMouseButton button
     event.u.d.pos[1] = pos[1];
     event.u.d.modifiers = modifiers;
     event.u.d.button = button;
-    _event_produce(canvas, event);
+    _event_input(canvas, event);
 }
 
 
@@ -1472,7 +2045,7 @@ void dvz_event_key_press(DvzCanvas* canvas, DvzKeyCode key_code, int modifiers)
     // Update the keyboard state.
     dvz_keyboard_event(&canvas->keyboard, canvas, event);
 
-    _event_produce(canvas, event);
+    _event_input(canvas, event);
 }
 
 
@@ -1489,7 +2062,7 @@ void dvz_event_key_release(DvzCanvas* canvas, DvzKeyCode key_code, int modifiers
     // Update the keyboard state.
     dvz_keyboard_event(&canvas->keyboard, canvas, event);
 
-    _event_produce(canvas, event);
+    _event_input(canvas, event);
 }
 
 
@@ -1512,46 +2085,47 @@ void dvz_event_frame(DvzCanvas* canvas, uint64_t idx, double time, double interv
 int dvz_event_pending(DvzCanvas* canvas, DvzEventType type)
 {
     ASSERT(canvas != NULL);
-    DvzFifo* fifo = &canvas->event_queue;
-    pthread_mutex_lock(&fifo->lock);
-    int i, j;
-    if (fifo->tail <= fifo->head)
-    {
-        i = fifo->tail;
-        j = fifo->head;
-    }
-    else
-    {
-        i = fifo->head;
-        j = fifo->tail;
-    }
-    ASSERT(i <= j);
+    ASSERT(type < DVZ_EVENT_COUNT);
+    pthread_mutex_lock(&canvas->event_lock);
+
     // Count the pending events with the given type.
-    int count = 0;
-    for (int k = i; k <= j; k++)
-    {
-        if (((DvzEvent*)fifo->items[k])->type == type)
-            count++;
-    }
+    int count = (int)canvas->event_queues[type].count;
 
     // Add 1 if the event being processed in the event thread has the requested type.
     if (canvas->event_processing == type)
         count++;
 
-    pthread_mutex_unlock(&fifo->lock);
+    pthread_mutex_unlock(&canvas->event_lock);
     ASSERT(count >= 0);
     return count;
 }
 
 
 
+void dvz_event_priority(
+    DvzCanvas* canvas, DvzEventType type, DvzEventPriority priority, double deadline)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(type < DVZ_EVENT_COUNT);
+    ASSERT(deadline >= 0);
+    pthread_mutex_lock(&canvas->event_lock);
+    canvas->event_queues[type].priority = priority;
+    canvas->event_queues[type].deadline = deadline;
+    pthread_mutex_unlock(&canvas->event_lock);
+}
+
+
+
 void dvz_event_stop(DvzCanvas* canvas)
 {
     ASSERT(canvas != NULL);
-    DvzFifo* fifo = &canvas->event_queue;
-    dvz_fifo_reset(fifo);
-    // Send a null event to the queue which causes the dequeue awaiting thread to end.
-    _event_enqueue(canvas, (DvzEvent){0});
+    // Discard the pending events and wake up the event thread, which then ends.
+    pthread_mutex_lock(&canvas->event_lock);
+    for (uint32_t i = 0; i < DVZ_EVENT_COUNT; i++)
+        canvas->event_queues[i].count = 0;
+    canvas->event_stop = true;
+    pthread_cond_broadcast(&canvas->event_cond);
+    pthread_mutex_unlock(&canvas->event_lock);
 }
 
 
@@ -1896,51 +2470,368 @@ uint8_t* dvz_screenshot(DvzCanvas* canvas, bool has_alpha)
 
 
 /*************************************************************************************************/
-/*  Video screencast                                                                             */
+/*  Batch rendering                                                                              */
 /*************************************************************************************************/
 
-static void _video_callback(DvzCanvas* canvas, DvzEvent ev)
+static void _batch_slot(DvzBatch* batch, DvzBatchSlot* slot)
 {
+    ASSERT(batch != NULL);
+    ASSERT(slot != NULL);
+    DvzCanvas* canvas = batch->canvas;
     ASSERT(canvas != NULL);
-    log_debug("video frame #%d", ev.u.sc.idx);
+    DvzGpu* gpu = canvas->gpu;
+    DvzImages* images = canvas->swapchain.images;
 
-    Video* video = (Video*)canvas->screencast->user_data;
-    if (video == NULL)
-        return;
-    ASSERT(video != NULL);
+    slot->batch = batch;
 
-    // Create the video if needed.
-    if (video->ost == NULL)
-    {
-        create_video(video);
-    }
-    ASSERT(video->ost != NULL);
+    // Staging image.
+    slot->staging = dvz_images(gpu, VK_IMAGE_TYPE_2D, 1);
+    dvz_images_format(&slot->staging, images->format);
+    dvz_images_size(&slot->staging, images->width, images->height, images->depth);
+    dvz_images_tiling(&slot->staging, VK_IMAGE_TILING_LINEAR);
+    dvz_images_usage(&slot->staging, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    dvz_images_layout(&slot->staging, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    dvz_images_memory(
+        &slot->staging,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    dvz_images_create(&slot->staging);
+    dvz_images_transition(&slot->staging);
+
+    slot->fence = dvz_fences(gpu, 1, true);
+
+    // The copy command buffer is recorded once. It is submitted to the render queue just after
+    // the frame, so that the barrier waits for the rendering of that frame without semaphore.
+    slot->cmds = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_RENDER, 1);
+    DvzCommands* cmds = &slot->cmds;
+    DvzBarrier barrier = dvz_barrier(gpu);
+    dvz_barrier_images(&barrier, images);
+    dvz_cmd_begin(cmds, 0);
 
-    add_frame(video, ev.u.sc.rgba);
-    FREE(ev.u.sc.rgba);
-}
+    // Transition to SRC layout once the frame has been rendered.
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    dvz_cmd_barrier(cmds, 0, &barrier);
 
-static void _video_destroy(DvzCanvas* canvas, DvzEvent ev)
-{
-    ASSERT(canvas != NULL);
-    if (canvas->screencast != NULL && canvas->screencast->user_data != NULL)
-        end_video((Video*)canvas->screencast->user_data);
+    // Copy the canvas image to the staging image.
+    dvz_cmd_copy_image(cmds, 0, images, &slot->staging);
+
+    // Transition back to the layout expected by the next frame.
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+    dvz_cmd_barrier(cmds, 0, &barrier);
+
+    dvz_cmd_end(cmds, 0);
 }
 
 
 
-void dvz_canvas_video(DvzCanvas* canvas, int framerate, int bitrate, const char* path, bool record)
+static int _batch_write(DvzImageFormat format, const char* path, DvzImages* img, uint8_t* rgb)
 {
-    ASSERT(canvas != NULL);
-    uvec2 size;
-    dvz_canvas_size(canvas, DVZ_CANVAS_SIZE_FRAMEBUFFER, size);
-    Video* video = init_video(path, (int)size[0], (int)size[1], framerate, bitrate);
-    if (video == NULL)
-        return;
+    ASSERT(path != NULL);
+    ASSERT(img != NULL);
+    ASSERT(rgb != NULL);
+    uint32_t w = img->width;
+    uint32_t h = img->height;
+
+    switch (format)
+    {
+    case DVZ_IMAGE_FORMAT_RAW:;
+        FILE* fp = fopen(path, "wb");
+        if (fp == NULL)
+            return 1;
+        size_t n = fwrite(rgb, 3, (size_t)w * h, fp);
+        fclose(fp);
+        return n == (size_t)w * h ? 0 : 1;
+
+    case DVZ_IMAGE_FORMAT_PPM:
+        return dvz_write_ppm(path, w, h, rgb);
+
+    case DVZ_IMAGE_FORMAT_PNG:
+        return dvz_write_png(path, w, h, rgb);
+
+    case DVZ_IMAGE_FORMAT_JPEG:
+        return dvz_write_jpeg(path, w, h, rgb, DVZ_BATCH_JPEG_QUALITY);
+
+    default:
+        log_error("unknown image format %d", format);
+        break;
+    }
+    return 1;
+}
+
+
+
+static void* _batch_thread(void* user_data)
+{
+    DvzBatch* batch = (DvzBatch*)user_data;
+    ASSERT(batch != NULL);
+    DvzBatchSlot* slot = NULL;
+    DvzImageFormat format = DVZ_IMAGE_FORMAT_RAW;
+    char path[DVZ_BATCH_PATH_SIZE] = {0};
+    uint8_t* rgb = NULL;
+    int res = 0;
+    while (true)
+    {
+        // A NULL item stops the thread.
+        slot = (DvzBatchSlot*)dvz_fifo_dequeue(&batch->jobs, true);
+        if (slot == NULL)
+            break;
+
+        // Download the frame, and release the slot before encoding it so that the slot can be
+        // used for the next frames.
+        dvz_fences_wait(&slot->fence, 0);
+        rgb = calloc((uint64_t)slot->staging.width * slot->staging.height, 3 * sizeof(uint8_t));
+        dvz_images_download(&slot->staging, 0, true, false, rgb);
+        format = slot->format;
+        strncpy(path, slot->path, DVZ_BATCH_PATH_SIZE - 1);
+
+        pthread_mutex_lock(&batch->lock);
+        slot->busy = false;
+        pthread_cond_broadcast(&batch->cond);
+        pthread_mutex_unlock(&batch->lock);
+
+        res = _batch_write(format, path, &slot->staging, rgb);
+        if (res != 0)
+            log_error("could not save frame to %s", path);
+        FREE(rgb);
+
+        pthread_mutex_lock(&batch->lock);
+        if (res == 0)
+            batch->written++;
+        else
+            batch->failed++;
+        batch->elapsed = _clock_get(&batch->clock);
+        pthread_cond_broadcast(&batch->cond);
+        pthread_mutex_unlock(&batch->lock);
+    }
+    return NULL;
+}
+
+
+
+DvzBatch* dvz_batch(DvzCanvas* canvas, uint32_t slot_count)
+{
+    ASSERT(canvas != NULL);
+    if (!canvas->offscreen)
+    {
+        log_error("batch rendering requires an offscreen canvas");
+        return NULL;
+    }
+    ASSERT(canvas->swapchain.images->count == 1);
+    slot_count = CLIP(slot_count, 1, DVZ_BATCH_MAX_SLOTS);
+
+    DvzBatch* batch = calloc(1, sizeof(DvzBatch));
+    batch->canvas = canvas;
+    batch->slot_count = slot_count;
+    for (uint32_t i = 0; i < slot_count; i++)
+        _batch_slot(batch, &batch->slots[i]);
+    batch->submit = dvz_submit(canvas->gpu);
+
+    batch->jobs = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->cond, NULL);
+    log_debug(
+        "starting batch rendering with %d slots and %d encoding threads", slot_count,
+        DVZ_BATCH_THREADS);
+    for (uint32_t i = 0; i < DVZ_BATCH_THREADS; i++)
+        batch->threads[i] = dvz_thread(_batch_thread, batch);
+
+    batch->obj.type = DVZ_OBJECT_TYPE_BATCH;
+    dvz_obj_created(&batch->obj);
+    return batch;
+}
+
+
+
+uint64_t dvz_batch_render(DvzBatch* batch, DvzImageFormat format, const char* path)
+{
+    ASSERT(batch != NULL);
+    ASSERT(path != NULL);
+    DvzCanvas* canvas = batch->canvas;
+    ASSERT(canvas != NULL);
+    DvzBatchSlot* slot = &batch->slots[batch->cur_slot];
+
+    // Wait until the slot has been downloaded by an encoding thread.
+    pthread_mutex_lock(&batch->lock);
+    while (slot->busy)
+        pthread_cond_wait(&batch->cond, &batch->lock);
+    if (batch->rendered == 0)
+        _clock_init(&batch->clock);
+    slot->busy = true;
+    slot->idx = batch->rendered;
+    slot->format = format;
+    strncpy(slot->path, path, DVZ_BATCH_PATH_SIZE - 1);
+    slot->path[DVZ_BATCH_PATH_SIZE - 1] = 0;
+    pthread_mutex_unlock(&batch->lock);
+
+    // Render the frame, like in the main loop.
+    if (canvas->frame_idx == 0)
+    {
+        _event_resize(canvas);
+        DvzEvent ev = {0};
+        ev.type = DVZ_EVENT_INIT;
+        _event_produce(canvas, ev);
+    }
+    dvz_fences_wait(&canvas->fences_render_finished, canvas->cur_frame);
+    dvz_canvas_frame(canvas);
+    dvz_canvas_frame_submit(canvas);
+    canvas->frame_idx++;
+
+    // Copy the frame to the staging image of the slot, the copy waits for the frame rendering
+    // on the GPU, not on the CPU.
+    DvzSubmit* submit = &batch->submit;
+    dvz_submit_reset(submit);
+    dvz_submit_commands(submit, &slot->cmds);
+    dvz_submit_send(submit, 0, &slot->fence, 0);
+
+    // Hand the slot to the encoding threads.
+    pthread_mutex_lock(&batch->lock);
+    batch->rendered++;
+    pthread_mutex_unlock(&batch->lock);
+    dvz_fifo_enqueue(&batch->jobs, slot);
+    batch->cur_slot = (batch->cur_slot + 1) % batch->slot_count;
+
+    return slot->idx;
+}
+
+
+
+uint64_t dvz_batch_wait(DvzBatch* batch)
+{
+    ASSERT(batch != NULL);
+    pthread_mutex_lock(&batch->lock);
+    while (batch->written + batch->failed < batch->rendered)
+        pthread_cond_wait(&batch->cond, &batch->lock);
+    uint64_t failed = batch->failed;
+    pthread_mutex_unlock(&batch->lock);
+    return failed;
+}
+
 
-    dvz_event_callback(
-        canvas, DVZ_EVENT_SCREENCAST, 0, DVZ_EVENT_MODE_SYNC, _video_callback, NULL);
-    dvz_event_callback(canvas, DVZ_EVENT_DESTROY, 0, DVZ_EVENT_MODE_SYNC, _video_destroy, NULL);
+
+double dvz_batch_fps(DvzBatch* batch)
+{
+    ASSERT(batch != NULL);
+    pthread_mutex_lock(&batch->lock);
+    double fps = batch->elapsed > 0 ? batch->written / batch->elapsed : 0;
+    pthread_mutex_unlock(&batch->lock);
+    return fps;
+}
+
+
+
+void dvz_batch_destroy(DvzBatch* batch)
+{
+    if (batch == NULL || !dvz_obj_is_created(&batch->obj))
+        return;
+
+    dvz_batch_wait(batch);
+    log_debug(
+        "batch rendering: %d images saved at %.1f FPS, %d failed", batch->written,
+        dvz_batch_fps(batch), batch->failed);
+
+    for (uint32_t i = 0; i < DVZ_BATCH_THREADS; i++)
+        dvz_fifo_enqueue(&batch->jobs, NULL);
+    for (uint32_t i = 0; i < DVZ_BATCH_THREADS; i++)
+        dvz_thread_join(&batch->threads[i]);
+    dvz_fifo_destroy(&batch->jobs);
+
+    dvz_gpu_wait(batch->canvas->gpu);
+    for (uint32_t i = 0; i < batch->slot_count; i++)
+    {
+        dvz_commands_destroy(&batch->slots[i].cmds);
+        dvz_fences_destroy(&batch->slots[i].fence);
+        dvz_images_destroy(&batch->slots[i].staging);
+    }
+    pthread_mutex_destroy(&batch->lock);
+    pthread_cond_destroy(&batch->cond);
+
+    dvz_obj_destroyed(&batch->obj);
+    FREE(batch);
+}
+
+
+
+/*************************************************************************************************/
+/*  Object picking                                                                               */
+/*************************************************************************************************/
+
+void dvz_canvas_pick(DvzCanvas* canvas, vec2 pos, uint32_t size)
+{
+    ASSERT(canvas != NULL);
+    if ((canvas->flags & DVZ_CANVAS_FLAGS_PICK) == 0)
+    {
+        log_error("object picking requires a canvas created with the DVZ_CANVAS_FLAGS_PICK flag");
+        return;
+    }
+
+    // Only the latest request is kept, it is processed after the next frame.
+    DvzPick* pick = &canvas->pick;
+    pthread_mutex_lock(&pick->lock);
+    pick->requested = true;
+    pick->pos[0] = pos[0];
+    pick->pos[1] = pos[1];
+    pick->size = CLIP(size, 1, DVZ_PICK_MAX_SIZE);
+    pthread_mutex_unlock(&pick->lock);
+    dvz_canvas_redraw(canvas);
+}
+
+
+
+/*************************************************************************************************/
+/*  Video screencast                                                                             */
+/*************************************************************************************************/
+
+static void _video_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    log_debug("video frame #%d", ev.u.sc.idx);
+
+    Video* video = (Video*)canvas->screencast->user_data;
+    if (video == NULL)
+        return;
+    ASSERT(video != NULL);
+
+    // Create the video if needed.
+    if (video->ost == NULL)
+    {
+        create_video(video);
+    }
+    ASSERT(video->ost != NULL);
+
+    add_frame(video, ev.u.sc.rgba);
+    FREE(ev.u.sc.rgba);
+}
+
+static void _video_destroy(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    if (canvas->screencast != NULL && canvas->screencast->user_data != NULL)
+        end_video((Video*)canvas->screencast->user_data);
+}
+
+
+
+void dvz_canvas_video(DvzCanvas* canvas, int framerate, int bitrate, const char* path, bool record)
+{
+    ASSERT(canvas != NULL);
+    uvec2 size;
+    dvz_canvas_size(canvas, DVZ_CANVAS_SIZE_FRAMEBUFFER, size);
+    Video* video = init_video(path, (int)size[0], (int)size[1], framerate, bitrate);
+    if (video == NULL)
+        return;
+
+    dvz_event_callback(
+        canvas, DVZ_EVENT_SCREENCAST, 0, DVZ_EVENT_MODE_SYNC, _video_callback, NULL);
+    dvz_event_callback(canvas, DVZ_EVENT_DESTROY, 0, DVZ_EVENT_MODE_SYNC, _video_destroy, NULL);
 
     dvz_screencast(canvas, 1. / framerate, true);
     ASSERT(canvas->screencast != NULL);
@@ -1985,6 +2876,139 @@ void dvz_canvas_stop(DvzCanvas* canvas)
 
 
 
+/*************************************************************************************************/
+/*  Profiler                                                                                     */
+/*************************************************************************************************/
+
+static bool _has_timestamps(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    if (gpu->device_properties.limits.timestampComputeAndGraphics)
+        return true;
+
+    // Otherwise, check the render queue family.
+    uint32_t family = gpu->queues.queue_families[DVZ_DEFAULT_QUEUE_RENDER];
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu->physical_device, &count, NULL);
+    if (family >= count)
+        return false;
+    VkQueueFamilyProperties* props = calloc(count, sizeof(VkQueueFamilyProperties));
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu->physical_device, &count, props);
+    bool res = props[family].timestampValidBits > 0;
+    FREE(props);
+    return res;
+}
+
+
+
+static bool _is_profiled(DvzCanvas* canvas, uint32_t idx)
+{
+    ASSERT(canvas != NULL);
+    return canvas->profiler != NULL && dvz_obj_is_created(&canvas->queries.obj) &&
+           idx < DVZ_PROFILER_MAX_IMAGES;
+}
+
+
+
+// Read the timestamps of the last submission of a swapchain image, once its fence has been
+// waited upon, and add the GPU scopes to the profiler.
+static void _profile_collect(DvzCanvas* canvas, uint32_t img_idx)
+{
+    ASSERT(canvas != NULL);
+    DvzProfiler* profiler = canvas->profiler;
+    if (!_is_profiled(canvas, img_idx) || !profiler->gpu_pending[img_idx])
+        return;
+
+    uint64_t timestamps[DVZ_PROFILER_IMAGE_QUERIES] = {0};
+    bool ok = true;
+    for (uint32_t c = 0; c < DVZ_PROFILER_CMDS_COUNT; c++)
+    {
+        uint32_t count = profiler->gpu_scopes[img_idx][c].count;
+        if (count == 0)
+            continue;
+        uint32_t offset = dvz_profiler_gpu_query(0, (DvzProfilerCmds)c, 0, false);
+        ok &= dvz_queries_results(
+            &canvas->queries, dvz_profiler_gpu_query(img_idx, (DvzProfilerCmds)c, 0, false),
+            2 * count, &timestamps[offset]);
+    }
+    dvz_profiler_gpu_resolve(
+        profiler, img_idx, ok ? timestamps : NULL,
+        canvas->gpu->device_properties.limits.timestampPeriod);
+}
+
+
+
+DvzProfiler* dvz_canvas_profiler(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->gpu != NULL);
+    if (canvas->profiler != NULL)
+        return canvas->profiler;
+
+    canvas->profiler = dvz_profiler();
+    if (canvas->swapchain.img_count > DVZ_PROFILER_MAX_IMAGES)
+        log_warn("too many swapchain images, GPU profiling disabled");
+    else if (!_has_timestamps(canvas->gpu))
+        log_warn("timestamp queries not supported, GPU profiling disabled");
+    else
+        canvas->queries =
+            dvz_queries(canvas->gpu, VK_QUERY_TYPE_TIMESTAMP, DVZ_PROFILER_QUERY_COUNT);
+
+    // Record the timestamps in the command buffers.
+    dvz_canvas_to_refill(canvas);
+    return canvas->profiler;
+}
+
+
+
+void dvz_canvas_profile_reset(
+    DvzCanvas* canvas, DvzCommands* cmds, uint32_t idx, DvzProfilerCmds type)
+{
+    ASSERT(canvas != NULL);
+    if (!_is_profiled(canvas, idx))
+        return;
+
+    // The previous timestamps of this command buffer are about to be overwritten.
+    _profile_collect(canvas, idx);
+    dvz_profiler_gpu_reset(canvas->profiler, idx, type);
+    dvz_cmd_reset_queries(
+        cmds, idx, &canvas->queries, dvz_profiler_gpu_query(idx, type, 0, false),
+        2 * DVZ_PROFILER_GPU_SCOPES);
+}
+
+
+
+uint32_t dvz_canvas_profile_begin(
+    DvzCanvas* canvas, DvzCommands* cmds, uint32_t idx, DvzProfilerCmds type, const char* name)
+{
+    ASSERT(canvas != NULL);
+    if (!_is_profiled(canvas, idx))
+        return UINT32_MAX;
+
+    uint32_t scope = dvz_profiler_gpu_begin(canvas->profiler, idx, type, name);
+    if (scope != UINT32_MAX)
+        dvz_cmd_timestamp(
+            cmds, idx, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &canvas->queries,
+            dvz_profiler_gpu_query(idx, type, scope, false));
+    return scope;
+}
+
+
+
+void dvz_canvas_profile_end(
+    DvzCanvas* canvas, DvzCommands* cmds, uint32_t idx, DvzProfilerCmds type, uint32_t scope)
+{
+    ASSERT(canvas != NULL);
+    if (!_is_profiled(canvas, idx) || scope == UINT32_MAX)
+        return;
+
+    dvz_cmd_timestamp(
+        cmds, idx, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &canvas->queries,
+        dvz_profiler_gpu_query(idx, type, scope, true));
+}
+
+
+
 /*************************************************************************************************/
 /*  Event loop                                                                                   */
 /*************************************************************************************************/
@@ -1998,32 +3022,49 @@ void dvz_canvas_frame(DvzCanvas* canvas)
     // Update the global and local clocks.
     // These calls update canvas->clock.elapsed and canvas->clock.interval, the latter is
     // the delay since the last frame.
-    _clock_set(&canvas->app->clock); // global clock
-    _clock_set(&canvas->clock);      // canvas-local clock
+    // NOTE: in parallel mode, the global clock is updated by the main thread.
+    if (!_is_threaded(canvas))
+        _clock_set(&canvas->app->clock); // global clock
+    _clock_set(&canvas->clock);          // canvas-local clock
     // Compute the maximum delay between two successive frames.
     canvas->max_delay = fmax(canvas->max_delay, canvas->clock.interval);
 
+    // Start recording the frame in the profiler, if enabled.
+    DvzProfiler* profiler = canvas->profiler;
+    dvz_profiler_frame_begin(profiler, canvas->frame_idx);
+
     // Call INTERACT callbacks (for backends only), which may enqueue some events.
+    dvz_profiler_begin(profiler, "interact");
+    _flush_input(canvas);
     _event_interact(canvas);
+    dvz_profiler_end(profiler);
 
     // Call FRAME callbacks.
+    dvz_profiler_begin(profiler, "frame callbacks");
     _event_frame(canvas);
+    dvz_profiler_end(profiler);
 
     // Give a chance to update event structures in the main loop, for example reset wheel.
     _backend_next_frame(canvas);
 
     // Call TIMER callbacks, in the main thread.
-    _event_timer(canvas);
+    dvz_profiler_begin(profiler, "timer callbacks");
+    _event_timer(canvas, canvas->clock.elapsed);
+    dvz_profiler_end(profiler);
 
     // Refill all command buffers at the first iteration.
     if (canvas->frame_idx == 0)
         dvz_canvas_to_refill(canvas);
 
     // Pending transfers.
+    dvz_profiler_begin(profiler, "transfers");
     dvz_process_transfers(canvas);
+    dvz_profiler_end(profiler);
 
     // Refill if needed, only 1 swapchain command buffer per frame to avoid waiting on the device.
+    dvz_profiler_begin(profiler, "refill");
     _refill_frame(canvas);
+    dvz_profiler_end(profiler);
 }
 
 
@@ -2037,6 +3078,8 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
     DvzSubmit* s = &canvas->submit;
     uint32_t f = canvas->cur_frame;
     uint32_t img_idx = canvas->swapchain.img_idx;
+    DvzProfiler* profiler = canvas->profiler;
+    dvz_profiler_begin(profiler, "submit");
 
     // Keep track of the fence associated to the current swapchain image.
     dvz_fences_copy(
@@ -2066,6 +3109,7 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
     if (s->commands_count == 0)
     {
         log_error("no recorded command buffers");
+        dvz_profiler_end(profiler);
         return;
     }
 
@@ -2081,11 +3125,19 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
 
     // SEND callbacks and send the Submit instance.
     {
+        // The previous submission of this swapchain image has completed, collect its GPU
+        // timestamps before the PRE_SEND callbacks record the overlay command buffer again.
+        _profile_collect(canvas, img_idx);
+
         // Call PRE_SEND callbacks
+        dvz_profiler_begin(profiler, "pre send");
         _event_presend(canvas);
+        dvz_profiler_end(profiler);
 
         // Send the Submit instance.
         dvz_submit_send(s, img_idx, &canvas->fences_render_finished, f);
+        if (_is_profiled(canvas, img_idx))
+            dvz_profiler_gpu_submit(profiler, img_idx);
 
         // Call POST_SEND callbacks
         _event_postsend(canvas);
@@ -2094,12 +3146,299 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
     // Once the image is rendered, we present the swapchain image.
     // The semaphore used for waiting during presentation may be changed by the canvas
     // callbacks.
+    dvz_profiler_end(profiler);
+    dvz_profiler_begin(profiler, "present");
     if (!canvas->offscreen)
         dvz_swapchain_present(
             &canvas->swapchain, 1, //
             canvas->present_semaphores, CLIP(f, 0, canvas->present_semaphores->count - 1));
+    dvz_profiler_end(profiler);
+
+    // Copy the pending pick region once the frame is rendered, or raise the PICK event.
+    if ((canvas->flags & DVZ_CANVAS_FLAGS_PICK) != 0)
+        _pick_process(canvas);
 
     canvas->cur_frame = (f + 1) % canvas->fences_render_finished.count;
+    dvz_profiler_frame_end(profiler);
+}
+
+
+
+static bool _present_queue_differs(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    return gpu->queues.queues[DVZ_DEFAULT_QUEUE_PRESENT] != VK_NULL_HANDLE &&
+           gpu->queues.queues[DVZ_DEFAULT_QUEUE_PRESENT] !=
+               gpu->queues.queues[DVZ_DEFAULT_QUEUE_RENDER];
+}
+
+
+
+static void* _frame_thread(void* user_data)
+{
+    DvzCanvas* canvas = (DvzCanvas*)user_data;
+    ASSERT(canvas != NULL);
+    DvzGpu* gpu = canvas->gpu;
+    ASSERT(gpu != NULL);
+
+    // NOTE: the idle iterations of an on-demand canvas, and the iterations waiting for the canvas
+    // recreation, do not count as frames.
+    uint64_t iter = 0;
+    while (iter < canvas->frame_count)
+    {
+        // Wait while the main thread recreates the canvas.
+        pthread_mutex_lock(&canvas->frame_lock);
+        while (atomic_load(&canvas->frame_state) == DVZ_FRAME_STATE_RECREATE)
+            pthread_cond_wait(&canvas->frame_cond, &canvas->frame_lock);
+        pthread_mutex_unlock(&canvas->frame_lock);
+        if (atomic_load(&canvas->frame_state) == DVZ_FRAME_STATE_STOP)
+            break;
+
+        // On-demand rendering: wait for a reason to render a new frame.
+        if (canvas->on_demand)
+        {
+            uint64_t idle_seq = _idle_seq(canvas->app);
+            double timeout = -1;
+            pthread_mutex_lock(&canvas->frame_lock);
+            if (_canvas_idle(canvas))
+                timeout = _idle_timeout(canvas, DVZ_IDLE_MAX_WAIT);
+            pthread_mutex_unlock(&canvas->frame_lock);
+            if (timeout >= 0)
+            {
+                _idle_wait(canvas->app, idle_seq, timeout, false);
+                continue;
+            }
+        }
+
+        // Wait for fence.
+        dvz_fences_wait(&canvas->fences_render_finished, canvas->cur_frame);
+
+        // We acquire the next swapchain image.
+        if (!canvas->offscreen)
+            dvz_swapchain_acquire(
+                &canvas->swapchain, &canvas->sem_img_available, canvas->cur_frame, NULL, 0);
+
+        // If there is a problem with swapchain image acquisition, wait and try again later.
+        if (canvas->swapchain.obj.status == DVZ_OBJECT_STATUS_INVALID)
+        {
+            log_trace("swapchain image acquisition failed, waiting and skipping this frame");
+            dvz_gpu_wait(gpu);
+            iter++;
+            continue;
+        }
+
+        // The swapchain is recreated by the main thread, which owns the window.
+        if (canvas->swapchain.obj.status == DVZ_OBJECT_STATUS_NEED_RECREATE)
+        {
+            log_trace("swapchain image acquisition failed, waiting for the canvas recreation");
+            atomic_store(&canvas->frame_state, DVZ_FRAME_STATE_RECREATE);
+            continue;
+        }
+
+        // Frame logic, mutually exclusive with the event callbacks called by the main thread.
+        pthread_mutex_lock(&canvas->frame_lock);
+        dvz_canvas_frame(canvas);
+        canvas->resized = false;
+        pthread_mutex_unlock(&canvas->frame_lock);
+
+        // Submit the command buffers and swapchain logic.
+        uint32_t f = canvas->cur_frame;
+        dvz_canvas_frame_submit(canvas);
+        canvas->frame_idx++;
+        iter++;
+
+        // See the note about the present queue in dvz_app_run(). Rather than waiting for the
+        // present queue shared by all canvases to be idle, with the queue lock, only wait for the
+        // fence of the submitted frame. The present waits for the render semaphore of that frame.
+        if (_present_queue_differs(gpu))
+            dvz_fences_wait(&canvas->fences_render_finished, f);
+    }
+
+    // A recreation requested at the last frame is done by the main thread before the frames are
+    // marked as done, otherwise the DONE state would discard it.
+    pthread_mutex_lock(&canvas->frame_lock);
+    while (atomic_load(&canvas->frame_state) == DVZ_FRAME_STATE_RECREATE)
+        pthread_cond_wait(&canvas->frame_cond, &canvas->frame_lock);
+    if (atomic_load(&canvas->frame_state) != DVZ_FRAME_STATE_STOP)
+        atomic_store(&canvas->frame_state, DVZ_FRAME_STATE_DONE);
+    pthread_mutex_unlock(&canvas->frame_lock);
+    return NULL;
+}
+
+
+
+static void _frame_thread_start(DvzCanvas* canvas, uint64_t frame_count)
+{
+    ASSERT(canvas != NULL);
+
+    // INIT event at the first frame, before the frame thread starts.
+    if (canvas->frame_idx == 0)
+    {
+        _event_resize(canvas);
+
+        DvzEvent ev = {0};
+        ev.type = DVZ_EVENT_INIT;
+        _event_produce(canvas, ev);
+    }
+
+    pthread_mutex_init(&canvas->frame_lock, NULL);
+    pthread_cond_init(&canvas->frame_cond, NULL);
+    atomic_store(&canvas->frame_state, DVZ_FRAME_STATE_RUNNING);
+    canvas->frame_count = frame_count;
+    canvas->frame_thread = dvz_thread(_frame_thread, canvas);
+}
+
+
+
+static void _frame_thread_stop(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    if (!_is_threaded(canvas))
+        return;
+
+    pthread_mutex_lock(&canvas->frame_lock);
+    if (atomic_load(&canvas->frame_state) != DVZ_FRAME_STATE_DONE)
+        atomic_store(&canvas->frame_state, DVZ_FRAME_STATE_STOP);
+    pthread_cond_signal(&canvas->frame_cond);
+    pthread_mutex_unlock(&canvas->frame_lock);
+    if (canvas->on_demand)
+        _idle_wakeup(canvas->app);
+
+    dvz_thread_join(&canvas->frame_thread);
+    atomic_store(&canvas->frame_state, DVZ_FRAME_STATE_NONE);
+    pthread_cond_destroy(&canvas->frame_cond);
+    pthread_mutex_destroy(&canvas->frame_lock);
+}
+
+
+
+static bool _can_run_parallel(DvzApp* app)
+{
+    ASSERT(app != NULL);
+    DvzContainerIterator iterator = dvz_container_iterator(&app->canvases);
+    DvzCanvas* canvas = NULL;
+    while (iterator.item != NULL)
+    {
+        canvas = (DvzCanvas*)iterator.item;
+        if (canvas->obj.status >= DVZ_OBJECT_STATUS_CREATED && canvas->overlay)
+        {
+            log_warn("the GUI overlay is not thread-safe, falling back to serial frames");
+            return false;
+        }
+        dvz_container_iter(&iterator);
+    }
+    return true;
+}
+
+
+
+static void _app_run_parallel(DvzApp* app, uint64_t frame_count)
+{
+    ASSERT(app != NULL);
+
+    DvzContainerIterator iterator;
+    DvzCanvas* canvas = NULL;
+
+    // Start one frame thread per canvas.
+    iterator = dvz_container_iterator(&app->canvases);
+    while (iterator.item != NULL)
+    {
+        canvas = (DvzCanvas*)iterator.item;
+        if (canvas->obj.status >= DVZ_OBJECT_STATUS_CREATED)
+            _frame_thread_start(canvas, frame_count);
+        dvz_container_iter(&iterator);
+    }
+
+    // The main thread polls the events, and recreates and destroys the canvases.
+    uint32_t n_canvas_active = 0;
+    do
+    {
+        n_canvas_active = 0;
+        iterator = dvz_container_iterator(&app->canvases);
+        canvas = NULL;
+        while (iterator.item != NULL)
+        {
+            canvas = (DvzCanvas*)iterator.item;
+            ASSERT(canvas != NULL);
+            if (canvas->obj.status < DVZ_OBJECT_STATUS_CREATED || !_is_threaded(canvas))
+            {
+                dvz_container_iter(&iterator);
+                continue;
+            }
+
+            // Poll events, the event callbacks take the frame lock.
+            if (canvas->window != NULL)
+                dvz_window_poll_events(canvas->window);
+            _backend_poll_cursor(canvas);
+
+            // Recreate the canvas if the frame thread asked for it.
+            if (atomic_load(&canvas->frame_state) == DVZ_FRAME_STATE_RECREATE)
+            {
+                log_trace("recreating the canvas");
+                pthread_mutex_lock(&canvas->frame_lock);
+
+                dvz_canvas_recreate(canvas);
+                _event_resize(canvas);
+                canvas->resized = true;
+                if (canvas->screencast != NULL)
+                    log_error("resizing is not supported during a screencast");
+                dvz_canvas_to_refill(canvas);
+
+                atomic_store(&canvas->frame_state, DVZ_FRAME_STATE_RUNNING);
+                pthread_cond_signal(&canvas->frame_cond);
+                pthread_mutex_unlock(&canvas->frame_lock);
+            }
+
+            // Destroy the canvas if needed.
+            if (canvas->window != NULL)
+            {
+                if (backend_window_should_close(app->backend, canvas->window->backend_window))
+                    canvas->window->obj.status = DVZ_OBJECT_STATUS_NEED_DESTROY;
+                if (canvas->window->obj.status == DVZ_OBJECT_STATUS_NEED_DESTROY)
+                    canvas->obj.status = DVZ_OBJECT_STATUS_NEED_DESTROY;
+            }
+            if (canvas->obj.status == DVZ_OBJECT_STATUS_NEED_DESTROY)
+            {
+                log_trace("destroying canvas");
+                _frame_thread_stop(canvas);
+                dvz_event_stop(canvas);
+                dvz_app_wait(app);
+                dvz_canvas_destroy(canvas);
+                dvz_container_iter(&iterator);
+                continue;
+            }
+
+            // Stop the frame thread once all of its frames have been processed.
+            if (atomic_load(&canvas->frame_state) == DVZ_FRAME_STATE_DONE)
+            {
+                _frame_thread_stop(canvas);
+                dvz_container_iter(&iterator);
+                continue;
+            }
+
+            n_canvas_active++;
+            dvz_container_iter(&iterator);
+        }
+
+        _clock_set(&app->clock); // global clock
+        if (n_canvas_active > 0)
+            dvz_sleep(1);
+    } while (n_canvas_active > 0);
+
+    log_trace("no more active canvas, closing the app");
+}
+
+
+
+void dvz_app_parallel(DvzApp* app, bool parallel)
+{
+    ASSERT(app != NULL);
+    if (app->is_running)
+    {
+        log_error("the parallel mode cannot be changed while the app is running");
+        return;
+    }
+    app->is_parallel = parallel;
 }
 
 
@@ -2114,14 +3453,32 @@ void dvz_app_run(DvzApp* app, uint64_t frame_count)
         frame_count = UINT64_MAX;
     ASSERT(frame_count > 0);
 
+    // Parallel mode, with one frame thread per canvas.
+    if (app->is_parallel && _can_run_parallel(app))
+    {
+        _app_run_parallel(app, frame_count);
+        dvz_app_wait(app);
+        app->is_running = false;
+        return;
+    }
+
     DvzContainerIterator iterator;
     DvzCanvas* canvas = NULL;
 
     // Main loop.
     uint32_t n_canvas_active = 0;
-    for (uint64_t iter = 0; iter < frame_count; iter++)
+    uint32_t n_canvas_idle = 0;
+    uint32_t n_canvas_recreated = 0;
+    uint64_t idle_seq = 0;
+    double timeout = 0;
+    uint64_t iter = 0;
+    while (iter < frame_count)
     {
         n_canvas_active = 0;
+        n_canvas_idle = 0;
+        n_canvas_recreated = 0;
+        idle_seq = _idle_seq(app);
+        timeout = DVZ_IDLE_MAX_WAIT;
 
         // Loop over the canvases.
         iterator = dvz_container_iterator(&app->canvases);
@@ -2152,6 +3509,40 @@ void dvz_app_run(DvzApp* app, uint64_t frame_count)
             if (canvas->window != NULL)
                 dvz_window_poll_events(canvas->window);
 
+            // Destroy the canvas if needed.
+            if (canvas->window != NULL)
+            {
+                if (backend_window_should_close(app->backend, canvas->window->backend_window))
+                    canvas->window->obj.status = DVZ_OBJECT_STATUS_NEED_DESTROY;
+                if (canvas->window->obj.status == DVZ_OBJECT_STATUS_NEED_DESTROY)
+                    canvas->obj.status = DVZ_OBJECT_STATUS_NEED_DESTROY;
+            }
+            if (canvas->obj.status == DVZ_OBJECT_STATUS_NEED_DESTROY)
+            {
+                log_trace("destroying canvas");
+
+                // Stop the transfer queue.
+                dvz_event_stop(canvas);
+
+                // Wait for all GPUs to be idle.
+                dvz_app_wait(app);
+
+                // Destroy the canvas.
+                dvz_canvas_destroy(canvas);
+                dvz_container_iter(&iterator);
+                continue;
+            }
+
+            // On-demand rendering: no GPU work if there is no reason to render a new frame.
+            if (_canvas_idle(canvas))
+            {
+                timeout = _idle_timeout(canvas, timeout);
+                n_canvas_idle++;
+                n_canvas_active++;
+                dvz_container_iter(&iterator);
+                continue;
+            }
+
             // NOTE: swapchain image acquisition happens here
 
             // Wait for fence.
@@ -2192,30 +3583,7 @@ void dvz_app_run(DvzApp* app, uint64_t frame_count)
                 dvz_canvas_to_refill(canvas);
 
                 n_canvas_active++;
-                dvz_container_iter(&iterator);
-                continue;
-            }
-
-            // Destroy the canvas if needed.
-            if (canvas->window != NULL)
-            {
-                if (backend_window_should_close(app->backend, canvas->window->backend_window))
-                    canvas->window->obj.status = DVZ_OBJECT_STATUS_NEED_DESTROY;
-                if (canvas->window->obj.status == DVZ_OBJECT_STATUS_NEED_DESTROY)
-                    canvas->obj.status = DVZ_OBJECT_STATUS_NEED_DESTROY;
-            }
-            if (canvas->obj.status == DVZ_OBJECT_STATUS_NEED_DESTROY)
-            {
-                log_trace("destroying canvas");
-
-                // Stop the transfer queue.
-                dvz_event_stop(canvas);
-
-                // Wait for all GPUs to be idle.
-                dvz_app_wait(app);
-
-                // Destroy the canvas.
-                dvz_canvas_destroy(canvas);
+                n_canvas_recreated++;
                 dvz_container_iter(&iterator);
                 continue;
             }
@@ -2247,9 +3615,7 @@ void dvz_app_run(DvzApp* app, uint64_t frame_count)
             gpu = iterator.item;
             if (!dvz_obj_is_created(&gpu->obj))
                 break;
-            if (gpu->queues.queues[DVZ_DEFAULT_QUEUE_PRESENT] != VK_NULL_HANDLE &&
-                gpu->queues.queues[DVZ_DEFAULT_QUEUE_PRESENT] !=
-                    gpu->queues.queues[DVZ_DEFAULT_QUEUE_RENDER])
+            if (_present_queue_differs(gpu))
             // && iter % DVZ_MAX_SWAPCHAIN_IMAGES == 0)
             {
                 dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_PRESENT);
@@ -2264,6 +3630,14 @@ void dvz_app_run(DvzApp* app, uint64_t frame_count)
             log_trace("no more active canvas, closing the app");
             break;
         }
+
+        // If all canvases are idle, block until a new frame is requested or a window event
+        // happens, instead of spinning. The idle iterations do not count as frames, nor do the
+        // iterations that only recreated canvases.
+        if (n_canvas_idle == n_canvas_active)
+            _idle_wait(app, idle_seq, timeout, app->backend == DVZ_BACKEND_GLFW);
+        else if (n_canvas_idle + n_canvas_recreated < n_canvas_active)
+            iter++;
     }
     log_trace("end main loop");
 
@@ -2299,7 +3673,8 @@ void dvz_canvas_destroy(DvzCanvas* canvas)
     dvz_gpu_wait(canvas->gpu);
     dvz_event_stop(canvas);
     dvz_thread_join(&canvas->event_thread);
-    dvz_fifo_destroy(&canvas->event_queue);
+    pthread_cond_destroy(&canvas->event_cond);
+    pthread_mutex_destroy(&canvas->event_lock);
 
     // Destroy the transfers queue.
     dvz_fifo_destroy(&canvas->transfers);
@@ -2312,8 +3687,13 @@ void dvz_canvas_destroy(DvzCanvas* canvas)
     CONTAINER_DESTROY_ITEMS(DvzGraphics, canvas->graphics, dvz_graphics_destroy)
     dvz_container_destroy(&canvas->graphics);
 
-    // Destroy the depth image.
+    // Destroy the depth image and the multisampled color image.
     dvz_images_destroy(&canvas->depth_image);
+    dvz_images_destroy(&canvas->msaa_image);
+
+    // Destroy the object picking resources.
+    if ((canvas->flags & DVZ_CANVAS_FLAGS_PICK) != 0)
+        _pick_destroy(canvas);
 
     // Destroy the renderpasses.
     log_trace("canvas destroy renderpass");
@@ -2352,6 +3732,14 @@ void dvz_canvas_destroy(DvzCanvas* canvas)
     log_trace("canvas destroy fences");
     dvz_fences_destroy(&canvas->fences_render_finished);
 
+    // Destroy the profiler.
+    if (canvas->profiler != NULL)
+    {
+        dvz_queries_destroy(&canvas->queries);
+        dvz_profiler_destroy(canvas->profiler);
+        canvas->profiler = NULL;
+    }
+
     if (canvas->overlay)
         dvz_imgui_destroy(canvas);
     CONTAINER_DESTROY_ITEMS(DvzGui, canvas->guis, dvz_gui_destroy)
@@ -13,33 +13,179 @@ extern "C" {
 /*  Event system                                                                                 */
 /*************************************************************************************************/
 
+// Default scheduling of the async events of each type.
+static void _event_queues_init(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzEventQueue* queue = NULL;
+    for (uint32_t i = 0; i < DVZ_EVENT_COUNT; i++)
+    {
+        queue = &canvas->event_queues[i];
+        memset(queue, 0, sizeof(DvzEventQueue));
+        switch ((DvzEventType)i)
+        {
+        // Discrete input events are never merged nor discarded.
+        case DVZ_EVENT_MOUSE_PRESS:
+        case DVZ_EVENT_MOUSE_RELEASE:
+        case DVZ_EVENT_MOUSE_DRAG_BEGIN:
+        case DVZ_EVENT_MOUSE_DRAG_END:
+        case DVZ_EVENT_MOUSE_CLICK:
+        case DVZ_EVENT_MOUSE_DOUBLE_CLICK:
+        case DVZ_EVENT_KEY_PRESS:
+        case DVZ_EVENT_KEY_RELEASE:
+            queue->priority = DVZ_EVENT_PRIORITY_HIGH;
+            break;
+
+        // Only the latest state matters for the continuous input events.
+        case DVZ_EVENT_MOUSE_MOVE:
+        case DVZ_EVENT_MOUSE_WHEEL:
+        case DVZ_EVENT_RESIZE:
+            queue->priority = DVZ_EVENT_PRIORITY_HIGH;
+            queue->coalesce = true;
+            queue->deadline = DVZ_MAX_EVENT_DURATION;
+            break;
+
+        // Per-frame events.
+        case DVZ_EVENT_INTERACT:
+        case DVZ_EVENT_FRAME:
+        case DVZ_EVENT_IMGUI:
+        case DVZ_EVENT_PRE_SEND:
+        case DVZ_EVENT_POST_SEND:
+            queue->priority = DVZ_EVENT_PRIORITY_LOW;
+            queue->coalesce = true;
+            queue->deadline = DVZ_MAX_EVENT_DURATION;
+            break;
+
+        default:
+            queue->priority = DVZ_EVENT_PRIORITY_NORMAL;
+            break;
+        }
+    }
+}
+
+
+
+// Merge a new event into a pending event of the same type.
+static void _event_merge(DvzEvent* pending, DvzEvent event)
+{
+    ASSERT(pending != NULL);
+    ASSERT(pending->type == event.type);
+
+    // The wheel deltas are summed, the other fields come from the latest event.
+    if (event.type == DVZ_EVENT_MOUSE_WHEEL)
+    {
+        event.u.w.dir[0] += pending->u.w.dir[0];
+        event.u.w.dir[1] += pending->u.w.dir[1];
+    }
+    *pending = event;
+}
+
+
+
 // Enqueue an event.
 static void _event_enqueue(DvzCanvas* canvas, DvzEvent event)
 {
     ASSERT(canvas != NULL);
-    DvzFifo* fifo = &canvas->event_queue;
-    ASSERT(fifo != NULL);
-    DvzEvent* ev = (DvzEvent*)calloc(1, sizeof(DvzEvent));
-    *ev = event;
-    dvz_fifo_enqueue(fifo, ev);
+    ASSERT(event.type < DVZ_EVENT_COUNT);
+    DvzEventQueue* queue = &canvas->event_queues[event.type];
+
+    pthread_mutex_lock(&canvas->event_lock);
+    double now = _clock_get(&canvas->event_clock);
+    if (event.type == DVZ_EVENT_MOUSE_PRESS || event.type == DVZ_EVENT_MOUSE_RELEASE)
+        canvas->event_buttons++;
+
+    // NOTE: an event is never merged with an event enqueued before a mouse button event, so that
+    // the moves before and after a press or a release are processed in order.
+    if (queue->coalesce && queue->count > 0 && queue->barrier == canvas->event_buttons)
+    {
+        // NOTE: the merged event takes the time of the latest event.
+        uint32_t last = (queue->head + queue->count - 1) % DVZ_EVENT_QUEUE_CAPACITY;
+        _event_merge(&queue->events[last], event);
+        queue->times[last] = now;
+    }
+    else
+    {
+        if (queue->count == DVZ_EVENT_QUEUE_CAPACITY)
+        {
+            log_debug("event queue %d is full, discarding the oldest event", event.type);
+            queue->head = (queue->head + 1) % DVZ_EVENT_QUEUE_CAPACITY;
+            queue->count--;
+            queue->discarded++;
+        }
+        uint32_t idx = (queue->head + queue->count) % DVZ_EVENT_QUEUE_CAPACITY;
+        queue->events[idx] = event;
+        queue->times[idx] = now;
+        queue->count++;
+    }
+    queue->barrier = canvas->event_buttons;
+    pthread_cond_signal(&canvas->event_cond);
+    pthread_mutex_unlock(&canvas->event_lock);
+}
+
+
+
+// Return the type of the next event to process, or DVZ_EVENT_NONE if there is no pending event.
+// NOTE: must be called with the event lock.
+static DvzEventType _event_next(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    double now = _clock_get(&canvas->event_clock);
+    DvzEventType next = DVZ_EVENT_NONE;
+    DvzEventQueue* best = NULL;
+    DvzEventQueue* queue = NULL;
+    for (uint32_t i = 0; i < DVZ_EVENT_COUNT; i++)
+    {
+        queue = &canvas->event_queues[i];
+
+        // Discard the events that are too old, except the most recent one.
+        while (queue->deadline > 0 && queue->count > 1 &&
+               now - queue->times[queue->head] > queue->deadline)
+        {
+            queue->head = (queue->head + 1) % DVZ_EVENT_QUEUE_CAPACITY;
+            queue->count--;
+            queue->discarded++;
+        }
+        if (queue->count == 0)
+            continue;
+
+        // Oldest pending event with the highest priority.
+        if (best == NULL || queue->priority > best->priority ||
+            (queue->priority == best->priority &&
+             queue->times[queue->head] < best->times[best->head]))
+        {
+            best = queue;
+            next = (DvzEventType)i;
+        }
+    }
+    return next;
 }
 
 
 
-// Dequeue an event, immediately, or waiting until an event is available.
+// Dequeue the next event, immediately, or waiting until an event is available.
 static DvzEvent _event_dequeue(DvzCanvas* canvas, bool wait)
 {
     ASSERT(canvas != NULL);
-    DvzFifo* fifo = &canvas->event_queue;
-    ASSERT(fifo != NULL);
-    DvzEvent* item = (DvzEvent*)dvz_fifo_dequeue(fifo, wait);
-    DvzEvent out;
+    DvzEvent out = {0};
     out.type = DVZ_EVENT_NONE;
-    if (item == NULL)
-        return out;
-    ASSERT(item != NULL);
-    out = *item;
-    FREE(item);
+
+    pthread_mutex_lock(&canvas->event_lock);
+    DvzEventType type = _event_next(canvas);
+    while (wait && type == DVZ_EVENT_NONE && !canvas->event_stop)
+    {
+        pthread_cond_wait(&canvas->event_cond, &canvas->event_lock);
+        type = _event_next(canvas);
+    }
+    if (type != DVZ_EVENT_NONE && !canvas->event_stop)
+    {
+        DvzEventQueue* queue = &canvas->event_queues[type];
+        out = queue->events[queue->head];
+        queue->head = (queue->head + 1) % DVZ_EVENT_QUEUE_CAPACITY;
+        queue->count--;
+        // NOTE: set while holding the lock, so that the event is always counted as pending.
+        canvas->event_processing = type;
+    }
+    pthread_mutex_unlock(&canvas->event_lock);
     return out;
 }
 
@@ -140,57 +286,20 @@ static void* _event_thread(void* p_canvas)
     log_debug("starting event thread");
 
     DvzEvent ev;
-    double avg_event_time = 0; // average event callback time across all event types
-    double elapsed = 0;        // average time of the event callbacks in the current iteration
-    int n_callbacks = 0;       // number of event callbacks in the current event loop iteration
-    int counter = 0;           // number of iterations in the event loop
-    int events_to_keep = 0;    // maximum number of pending events to keep in the queue
-
     while (true)
     {
-        // log_trace("event thread awaits for events...");
-        // Wait until an event is available
+        // Wait until an event is available. The pending events are processed by priority, the
+        // continuous input events are merged and the old events are discarded, so that slow
+        // callbacks do not delay the processing of the most recent input.
         ev = _event_dequeue(canvas, true);
-        canvas->event_processing = ev.type; // type of the event being processed
         if (ev.type == DVZ_EVENT_NONE)
         {
-            log_trace("received empty event, stopping the event thread");
+            log_trace("the event loop was stopped, stopping the event thread");
             break;
         }
 
-        // Logic to discard some events if the queue is getting overloaded because of long-running
-        // callbacks.
-
-        // TODO: there are ways to improve the mechanism dropping events from the queue when the
-        // queue is getting overloaded. Doing it on a per-type basis, better estimating the avg
-        // time taken by each callback, etc.
-
-        // log_trace("event dequeued type %d, processing it...", ev.type);
-        // process the dequeued task
-        elapsed = _clock_get(&canvas->clock);
-        n_callbacks = _event_consume(canvas, ev, DVZ_EVENT_MODE_ASYNC);
-        elapsed = _clock_get(&canvas->clock) - elapsed;
-        // NOTE: avoid division by zero.
-        if (n_callbacks > 0)
-            elapsed /= n_callbacks; // average duration of the events
-
-        // Update the average event time.
-        avg_event_time = ((avg_event_time * counter) + elapsed) / (counter + 1);
-        if (avg_event_time > 0)
-        {
-            events_to_keep =
-                CLIP(DVZ_MAX_EVENT_DURATION / avg_event_time, 1, DVZ_MAX_FIFO_CAPACITY);
-            if (events_to_keep == DVZ_MAX_FIFO_CAPACITY)
-                events_to_keep = 0;
-        }
-
-        // Handle event queue overloading: if events are enqueued faster than
-        // they are consumed, we should discard the older events so that the
-        // queue doesn't keep filling up.
-        dvz_fifo_discard(&canvas->event_queue, events_to_keep);
-
+        _event_consume(canvas, ev, DVZ_EVENT_MODE_ASYNC);
         canvas->event_processing = DVZ_EVENT_NONE;
-        counter++;
     }
     log_debug("end event thread");
 
@@ -203,8 +312,9 @@ static void* _event_thread(void* p_canvas)
 /*  Utils                                                                                        */
 /*************************************************************************************************/
 
-static DvzRenderpass
-default_renderpass(DvzGpu* gpu, VkClearColorValue clear_color_value, VkFormat format, bool overlay)
+static DvzRenderpass default_renderpass(
+    DvzGpu* gpu, VkClearColorValue clear_color_value, VkFormat format, bool overlay,
+    VkSampleCountFlagBits samples, bool pick)
 {
     DvzRenderpass renderpass = dvz_renderpass(gpu);
 
@@ -220,13 +330,19 @@ default_renderpass(DvzGpu* gpu, VkClearColorValue clear_color_value, VkFormat fo
     VkImageLayout layout =
         overlay ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
+    // Multisampling: the scene is rendered in a multisampled color attachment, which is resolved
+    // into the first attachment (swapchain image) at the end of the subpass.
+    bool msaa = samples > VK_SAMPLE_COUNT_1_BIT;
+
     // Color attachment.
     dvz_renderpass_attachment(
         &renderpass, 0, //
-        DVZ_RENDERPASS_ATTACHMENT_COLOR, format, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        msaa ? DVZ_RENDERPASS_ATTACHMENT_RESOLVE : DVZ_RENDERPASS_ATTACHMENT_COLOR, format,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
     dvz_renderpass_attachment_layout(&renderpass, 0, VK_IMAGE_LAYOUT_UNDEFINED, layout);
     dvz_renderpass_attachment_ops(
-        &renderpass, 0, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+        &renderpass, 0, msaa ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_CLEAR,
+        VK_ATTACHMENT_STORE_OP_STORE);
 
     // Depth attachment.
     dvz_renderpass_attachment(
@@ -238,10 +354,60 @@ default_renderpass(DvzGpu* gpu, VkClearColorValue clear_color_value, VkFormat fo
         VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
     dvz_renderpass_attachment_ops(
         &renderpass, 1, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+    dvz_renderpass_attachment_samples(&renderpass, 1, samples);
+
+    // Multisampled color attachment.
+    if (msaa)
+    {
+        dvz_renderpass_clear(&renderpass, clear_color);
+        dvz_renderpass_attachment(
+            &renderpass, 2, //
+            DVZ_RENDERPASS_ATTACHMENT_COLOR, format, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        dvz_renderpass_attachment_layout(
+            &renderpass, 2, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        dvz_renderpass_attachment_ops(
+            &renderpass, 2, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+        dvz_renderpass_attachment_samples(&renderpass, 2, samples);
+    }
+
+    // Object picking attachment, cleared to zero (no visual), and copied to the host on demand.
+    // With MSAA, the multisampled picking attachment is resolved into a single-sampled one.
+    if (pick)
+    {
+        VkClearValue clear_pick = {0};
+        uint32_t idx = msaa ? 3 : 2;
+        dvz_renderpass_clear(&renderpass, clear_pick);
+        dvz_renderpass_attachment(
+            &renderpass, idx, //
+            msaa ? DVZ_RENDERPASS_ATTACHMENT_RESOLVE : DVZ_RENDERPASS_ATTACHMENT_COLOR,
+            DVZ_PICK_FORMAT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        dvz_renderpass_attachment_layout(
+            &renderpass, idx, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        dvz_renderpass_attachment_ops(
+            &renderpass, idx, msaa ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_CLEAR,
+            VK_ATTACHMENT_STORE_OP_STORE);
+
+        if (msaa)
+        {
+            dvz_renderpass_clear(&renderpass, clear_pick);
+            dvz_renderpass_attachment(
+                &renderpass, 4, //
+                DVZ_RENDERPASS_ATTACHMENT_COLOR, DVZ_PICK_FORMAT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+            dvz_renderpass_attachment_layout(
+                &renderpass, 4, VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+            dvz_renderpass_attachment_ops(
+                &renderpass, 4, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+            dvz_renderpass_attachment_samples(&renderpass, 4, samples);
+        }
+    }
 
     // Subpass.
-    dvz_renderpass_subpass_attachment(&renderpass, 0, 0);
-    dvz_renderpass_subpass_attachment(&renderpass, 0, 1);
+    // NOTE: the color attachments and the resolve attachments are matched in the order of their
+    // indices, the picking attachment comes after the color attachment (fragment location 1).
+    for (uint32_t i = 0; i < renderpass.attachment_count; i++)
+        dvz_renderpass_subpass_attachment(&renderpass, 0, i);
     dvz_renderpass_subpass_dependency(&renderpass, 0, VK_SUBPASS_EXTERNAL, 0);
     dvz_renderpass_subpass_dependency_stage(
         &renderpass, 0, //
@@ -0,0 +1,165 @@
+#include "../include/datoviz/colormaps.h"
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+#define DVZ_COLORMAP_BLOCK 1024 // number of values whose indices are computed at once
+
+typedef struct DvzColormapChunk DvzColormapChunk;
+
+struct DvzColormapChunk
+{
+    const uint32_t* lut; // 256 RGBA colors packed in 32-bit words
+    bool is_double;
+    const void* values;
+    double vmin, range;
+    uint32_t stride;
+    uint8_t* out;
+};
+
+
+
+// Fill a lookup table with the 256 colors of a colormap, so that the batch functions return the
+// same colors as dvz_colormap_scale().
+static void _colormap_lut(DvzColormap cmap, uint32_t* lut)
+{
+    ASSERT(lut != NULL);
+    cvec4 color = {0};
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        dvz_colormap(cmap, (uint8_t)i, color);
+        memcpy(&lut[i], color, sizeof(cvec4));
+    }
+}
+
+
+
+// Compute the colormap indices of a block of values, in double precision and with the same
+// operations as _scale_uint8(), so that the values on the bin edges fall in the same bins.
+// NOTE: these loops have no branch and no lookup so that the compiler can vectorize them. NaN
+// values fail both comparisons and are mapped to the first color.
+static void _colormap_indices_float(
+    const float* values, uint32_t count, double vmin, double range, uint8_t* indices)
+{
+    double x = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        x = ((double)values[i] - vmin) / range * 256;
+        x = x >= 0 ? x : 0;
+        x = x < 255 ? x : 255;
+        indices[i] = (uint8_t)x;
+    }
+}
+
+static void _colormap_indices_double(
+    const double* values, uint32_t count, double vmin, double range, uint8_t* indices)
+{
+    double x = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        x = (values[i] - vmin) / range * 256;
+        x = x >= 0 ? x : 0;
+        x = x < 255 ? x : 255;
+        indices[i] = (uint8_t)x;
+    }
+}
+
+
+
+static void _colormap_chunk(uint64_t first, uint64_t count, uint32_t thread_idx, void* user_data)
+{
+    DvzColormapChunk* chunk = (DvzColormapChunk*)user_data;
+    ASSERT(chunk != NULL);
+    ASSERT(chunk->lut != NULL);
+
+    uint8_t indices[DVZ_COLORMAP_BLOCK] = {0};
+    uint32_t n = 0;
+    uint32_t end = (uint32_t)(first + count);
+    uint8_t* out = NULL;
+    for (uint32_t i = (uint32_t)first; i < end; i += DVZ_COLORMAP_BLOCK)
+    {
+        n = MIN(DVZ_COLORMAP_BLOCK, end - i);
+        if (chunk->is_double)
+            _colormap_indices_double(
+                (const double*)chunk->values + i, n, chunk->vmin, chunk->range, indices);
+        else
+            _colormap_indices_float(
+                (const float*)chunk->values + i, n, chunk->vmin, chunk->range, indices);
+
+        // Table lookup, the colors are written with a single 32-bit store each.
+        out = chunk->out + (uint64_t)i * chunk->stride;
+        if (chunk->stride == sizeof(uint32_t))
+        {
+            uint32_t* out32 = (uint32_t*)(void*)out;
+            for (uint32_t j = 0; j < n; j++)
+                out32[j] = chunk->lut[indices[j]];
+        }
+        else
+        {
+            for (uint32_t j = 0; j < n; j++)
+                memcpy(out + j * chunk->stride, &chunk->lut[indices[j]], sizeof(uint32_t));
+        }
+    }
+}
+
+
+
+static void _colormap_batch(
+    DvzColormap cmap, uint32_t count, bool is_double, const void* values, double vmin,
+    double vmax, uint32_t stride, void* out)
+{
+    if (count == 0)
+        return;
+    ASSERT(values != NULL);
+    ASSERT(out != NULL);
+    if (stride == 0)
+        stride = sizeof(cvec4);
+    ASSERT(stride >= sizeof(cvec4));
+
+    uint32_t lut[256] = {0};
+    _colormap_lut(cmap, lut);
+
+    // Like _scale_uint8(), all values are mapped to the first color when vmin=vmax: with an
+    // infinite range, the scaled values are 0 or NaN.
+    double range = vmax - vmin;
+    if (vmin == vmax)
+    {
+        log_warn("error in colormap_value(): vmin=vmax");
+        range = INFINITY;
+    }
+
+    DvzColormapChunk chunk = {0};
+    chunk.lut = lut;
+    chunk.is_double = is_double;
+    chunk.values = values;
+    chunk.vmin = vmin;
+    chunk.range = range;
+    chunk.stride = stride;
+    chunk.out = (uint8_t*)out;
+    dvz_parallel(count, DVZ_COLORMAP_THREAD_MIN, DVZ_COLORMAP_THREADS, _colormap_chunk, &chunk);
+}
+
+
+
+/*************************************************************************************************/
+/*  Batch colormap functions                                                                     */
+/*************************************************************************************************/
+
+void dvz_colormap_array_float(
+    DvzColormap cmap, uint32_t count, const float* values, double vmin, double vmax,
+    uint32_t stride, void* out)
+{
+    _colormap_batch(cmap, count, false, values, vmin, vmax, stride, out);
+}
+
+
+
+void dvz_colormap_array_double(
+    DvzColormap cmap, uint32_t count, const double* values, double vmin, double vmax,
+    uint32_t stride, void* out)
+{
+    _colormap_batch(cmap, count, true, values, vmin, vmax, stride, out);
+}
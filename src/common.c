@@ -1,6 +1,8 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 // Optional PNG support
 #if HAS_PNG
@@ -8,8 +10,17 @@
 #include <zlib.h>
 #endif
 
+// Optional JPEG support
+#if HAS_JPEG
+#include <jpeglib.h>
+#endif
+
 #include "../include/datoviz/common.h"
 
+#if OS_WIN32
+#include <direct.h>
+#endif
+
 BEGIN_INCL_NO_WARN
 #include <cglm/struct.h>
 END_INCL_NO_WARN
@@ -86,6 +97,48 @@ int dvz_write_png(const char* filename, uint32_t width, uint32_t height, const u
 #endif
 }
 
+int dvz_write_jpeg(
+    const char* filename, uint32_t width, uint32_t height, const uint8_t* image, int quality)
+{
+#if HAS_JPEG
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL)
+    {
+        log_error("could not open file %s", filename);
+        return 1;
+    }
+
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, fp);
+
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, CLIP(quality, 1, 100), TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+
+    JSAMPROW row = NULL;
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        row = (JSAMPROW)&image[(uint64_t)cinfo.next_scanline * width * 3];
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    fclose(fp);
+    return 0;
+#else
+    log_error("datoviz was not build with JPEG support, please install libjpeg-dev");
+    return 1;
+#endif
+}
+
 int dvz_write_ppm(const char* filename, uint32_t width, uint32_t height, const uint8_t* image)
 {
     // from https://github.com/SaschaWillems/Vulkan/blob/master/examples/screenshot/screenshot.cpp
@@ -191,71 +244,66 @@ uint32_t* dvz_read_file(const char* filename, size_t* size)
     return buffer;
 }
 
-char* dvz_read_npy(const char* filename, size_t* size)
-{
-    /* Tiny NPY reader that requires the user to know in advance the data type of the file. */
 
-    /* The returned pointer must be freed by the caller. */
-    char* buffer = NULL;
-    size_t length = 0;
-    int nread = 0, err = 0;
-
-    FILE* f = fopen(filename, "rb");
-    if (!f)
-    {
-        log_error("the file %s does not exist", filename);
-        return NULL;
-    }
 
-    // Determine the total file size.
-    fseek(f, 0, SEEK_END);
-    length = (size_t)ftell(f);
-    fseek(f, 0, SEEK_SET);
+// Create a directory, which may already exist.
+static bool _make_dir(const char* path)
+{
+    ASSERT(path != NULL);
+#if OS_WIN32
+    int res = _mkdir(path);
+#else
+    int res = mkdir(path, 0755);
+#endif
+    return res == 0 || errno == EEXIST;
+}
 
-    // const uint32_t MAGIC_SIZE = 6;
-    // char magic[MAGIC_SIZE];
-
-    // // Read NPY header.
-    // nread = fread(magic, sizeof(char), MAGIC_SIZE, f);
-    // if (!nread)
-    //     goto error;
-
-    // TODO: check the magic
-    // TODO: check the version numbers
-
-    // Determine the header size.
-    uint16_t header_len = 0;
-    err = fseek(f, 8, SEEK_SET);
-    if (err)
-        goto error;
-    nread = fread(&header_len, sizeof(uint16_t), 1, f);
-    if (!nread)
-        goto error;
-    log_trace("npy file header size is %d bytes", header_len);
-    ASSERT(header_len > 0);
-    header_len += 10; // NOTE: the header len does NOT include the 10 bytes with the magic string,
-                      // the version, the header length
-
-    // Jump to the beginning of the data buffer.
-    fseek(f, 0, header_len);
-    length -= header_len;
-    if (size != NULL)
-        *size = length;
-    err = fseek(f, header_len, SEEK_SET);
-    if (err)
-        goto error;
 
-    // Read the data buffer.
-    buffer = calloc((uint32_t)length, 1);
-    ASSERT(buffer != NULL);
-    fread(buffer, 1, (size_t)length, f);
-    fclose(f);
 
-    return buffer;
+int dvz_cache_path(const char* name, char* path, size_t size)
+{
+    ASSERT(name != NULL);
+    ASSERT(path != NULL);
 
-error:
-    log_error("unable to read the NPY file %s", filename);
-    return NULL;
+    char dir[1024] = {0};
+    const char* env = getenv("DVZ_CACHE_DIR");
+    if (env != NULL && env[0] != 0)
+    {
+        snprintf(dir, sizeof(dir), "%s", env);
+    }
+    else
+    {
+#if OS_WIN32
+        const char* base = getenv("LOCALAPPDATA");
+        if (base == NULL || base[0] == 0)
+            return 1;
+        snprintf(dir, sizeof(dir), "%s/datoviz", base);
+#else
+        // The base directory may not exist yet on a new account.
+        const char* base = getenv("XDG_CACHE_HOME");
+        if (base != NULL && base[0] != 0)
+        {
+            snprintf(dir, sizeof(dir), "%s", base);
+        }
+        else
+        {
+            const char* home = getenv("HOME");
+            if (home == NULL || home[0] == 0)
+                return 1;
+            snprintf(dir, sizeof(dir), "%s/.cache", home);
+        }
+        if (!_make_dir(dir))
+            return 1;
+        strncat(dir, "/datoviz", sizeof(dir) - strlen(dir) - 1);
+#endif
+    }
+    if (!_make_dir(dir))
+    {
+        log_debug("unable to create the cache directory %s", dir);
+        return 1;
+    }
+    snprintf(path, size, "%s/%s", dir, name);
+    return 0;
 }
 
 
@@ -327,6 +375,65 @@ void dvz_thread_unlock(DvzThread* thread)
 
 
 
+typedef struct DvzParallelChunk DvzParallelChunk;
+
+struct DvzParallelChunk
+{
+    DvzParallelCallback callback;
+    void* user_data;
+    uint64_t first, count;
+    uint32_t thread_idx;
+};
+
+
+
+static void* _parallel_chunk(void* user_data)
+{
+    DvzParallelChunk* chunk = (DvzParallelChunk*)user_data;
+    ASSERT(chunk != NULL);
+    ASSERT(chunk->callback != NULL);
+    chunk->callback(chunk->first, chunk->count, chunk->thread_idx, chunk->user_data);
+    return NULL;
+}
+
+
+
+uint32_t dvz_parallel(
+    uint64_t count, uint64_t min_per_thread, uint32_t max_threads, //
+    DvzParallelCallback callback, void* user_data)
+{
+    ASSERT(callback != NULL);
+    if (count == 0)
+        return 0;
+
+    max_threads = CLIP(max_threads, 1, DVZ_PARALLEL_MAX_THREADS);
+    uint64_t n = CLIP(count / MAX(min_per_thread, 1), 1, (uint64_t)max_threads);
+    uint64_t per_thread = (count + n - 1) / n;
+    // No thread gets an empty range.
+    uint32_t n_threads = (uint32_t)((count + per_thread - 1) / per_thread);
+    ASSERT(1 <= n_threads && n_threads <= max_threads);
+
+    DvzParallelChunk chunks[DVZ_PARALLEL_MAX_THREADS] = {0};
+    DvzThread threads[DVZ_PARALLEL_MAX_THREADS] = {0};
+    for (uint32_t t = 0; t < n_threads; t++)
+    {
+        chunks[t].callback = callback;
+        chunks[t].user_data = user_data;
+        chunks[t].first = t * per_thread;
+        chunks[t].count = MIN(per_thread, count - chunks[t].first);
+        chunks[t].thread_idx = t;
+    }
+
+    for (uint32_t t = 0; t + 1 < n_threads; t++)
+        threads[t] = dvz_thread(_parallel_chunk, &chunks[t]);
+    _parallel_chunk(&chunks[n_threads - 1]);
+    for (uint32_t t = 0; t + 1 < n_threads; t++)
+        dvz_thread_join(&threads[t]);
+    return n_threads;
+}
+
+
+
 /*************************************************************************************************/
 /*  Random                                                                                       */
 /*************************************************************************************************/
@@ -89,7 +89,10 @@ static void _context_default_buffers(DvzContext* context)
         ASSERT(buffer != NULL);
         dvz_buffer_type(buffer, DVZ_BUFFER_TYPE_STORAGE);
         dvz_buffer_size(buffer, DVZ_BUFFER_TYPE_STORAGE_SIZE);
-        dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        // NOTE: storage regions may also be written by compute shaders for indirect draws.
+        dvz_buffer_usage(
+            buffer, transferable | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
         dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
         dvz_buffer_create(buffer);
         ASSERT(dvz_obj_is_created(&buffer->obj));
@@ -157,6 +160,13 @@ DvzContext* dvz_context(DvzGpu* gpu, DvzWindow* window)
     DvzContext* context = calloc(1, sizeof(DvzContext));
     context->gpu = gpu;
 
+    // The context functions may call each other, hence the recursive lock.
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&context->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
     // Allocate memory for buffers, textures, and computes.
     context->buffers =
         dvz_container(DVZ_CONTAINER_DEFAULT_COUNT, sizeof(DvzBuffer), DVZ_OBJECT_TYPE_BUFFER);
@@ -207,6 +217,9 @@ DvzContext* dvz_context(DvzGpu* gpu, DvzWindow* window)
     // Default 1D texture, for transfer functions.
     context->transfer_texture = _default_transfer_texture(context);
 
+    // Default 3D texture, for unset volumes and brick page tables.
+    context->volume_texture = _default_volume_texture(context);
+
     return context;
 }
 
@@ -218,6 +231,7 @@ void dvz_context_colormap(DvzContext* context)
     ASSERT(context->color_texture.texture != NULL);
     ASSERT(context->color_texture.arr != NULL);
 
+    // NOTE: dvz_texture_upload() takes the context lock.
     dvz_texture_upload(
         context->color_texture.texture, DVZ_ZERO_OFFSET, DVZ_ZERO_OFFSET, 256 * 256 * 4,
         context->color_texture.arr);
@@ -258,6 +272,8 @@ void dvz_context_destroy(DvzContext* context)
     dvz_container_destroy(&context->samplers);
     dvz_container_destroy(&context->textures);
     dvz_container_destroy(&context->computes);
+
+    pthread_mutex_destroy(&context->lock);
 }
 
 
@@ -266,7 +282,7 @@ void dvz_context_destroy(DvzContext* context)
 /*  Buffer allocation                                                                            */
 /*************************************************************************************************/
 
-DvzBufferRegions dvz_ctx_buffers(
+static DvzBufferRegions _ctx_buffers(
     DvzContext* context, DvzBufferType buffer_type, uint32_t buffer_count, VkDeviceSize size)
 {
     ASSERT(context != NULL);
@@ -303,6 +319,12 @@ DvzBufferRegions dvz_ctx_buffers(
         alignment = context->gpu->device_properties.limits.minUniformBufferOffsetAlignment;
         ASSERT(offset % alignment == 0); // offset should be already aligned
     }
+    // Storage regions may be bound as storage buffers in compute shaders.
+    else if (buffer_type == DVZ_BUFFER_TYPE_STORAGE)
+    {
+        alignment = context->gpu->device_properties.limits.minStorageBufferOffsetAlignment;
+        offset = aligned_size(offset, alignment);
+    }
 
     DvzBufferRegions regions = dvz_buffer_regions(buffer, buffer_count, offset, size, alignment);
     VkDeviceSize alsize = regions.aligned_size;
@@ -337,7 +359,7 @@ DvzBufferRegions dvz_ctx_buffers(
         "allocating %d buffers (type %d) with size %s (aligned size %s)", //
         buffer_count, buffer_type, pretty_size(size), pretty_size(alsize));
     ASSERT(offset + alsize * buffer_count <= regions.buffer->size);
-    buffer->allocated_size += alsize * buffer_count;
+    buffer->allocated_size = offset + alsize * buffer_count;
 
     ASSERT(regions.offsets[buffer_count - 1] + alsize == buffer->allocated_size);
     return regions;
@@ -345,6 +367,18 @@ DvzBufferRegions dvz_ctx_buffers(
 
 
 
+DvzBufferRegions dvz_ctx_buffers(
+    DvzContext* context, DvzBufferType buffer_type, uint32_t buffer_count, VkDeviceSize size)
+{
+    ASSERT(context != NULL);
+    pthread_mutex_lock(&context->lock);
+    DvzBufferRegions regions = _ctx_buffers(context, buffer_type, buffer_count, size);
+    pthread_mutex_unlock(&context->lock);
+    return regions;
+}
+
+
+
 void dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceSize new_size)
 {
     // NOTE: this function tries to resize a buffer region in-place, which only works if
@@ -359,6 +393,8 @@ void dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceS
     }
     ASSERT(br->count == 1);
 
+    pthread_mutex_lock(&context->lock);
+
     // The region is the last allocated in the buffer, we can safely resize it.
     VkDeviceSize old_size = br->aligned_size > 0 ? br->aligned_size : br->size;
     ASSERT(old_size > 0);
@@ -383,8 +419,10 @@ void dvz_ctx_buffers_resize(DvzContext* context, DvzBufferRegions* br, VkDeviceS
     else
     {
         log_debug("failed to resize the buffer region in-place, allocating a new region");
-        *br = dvz_ctx_buffers(context, br->buffer->type, 1, new_size);
+        *br = _ctx_buffers(context, br->buffer->type, 1, new_size);
     }
+
+    pthread_mutex_unlock(&context->lock);
 }
 
 
@@ -398,7 +436,10 @@ DvzCompute* dvz_ctx_compute(DvzContext* context, const char* shader_path)
     ASSERT(context != NULL);
     ASSERT(shader_path != NULL);
 
+    pthread_mutex_lock(&context->lock);
     DvzCompute* compute = dvz_container_alloc(&context->computes);
+    pthread_mutex_unlock(&context->lock);
+
     *compute = dvz_compute(context->gpu, shader_path);
     return compute;
 }
@@ -439,6 +480,8 @@ DvzTexture* dvz_ctx_texture(DvzContext* context, uint32_t dims, uvec3 size, VkFo
         "creating %dD texture with shape %dx%dx%d and format %d", //
         dims, size[0], size[1], size[2], format);
 
+    pthread_mutex_lock(&context->lock);
+
     DvzTexture* texture = dvz_container_alloc(&context->textures);
     DvzImages* image = dvz_container_alloc(&context->images);
     DvzSampler* sampler = dvz_container_alloc(&context->samplers);
@@ -495,6 +538,7 @@ DvzTexture* dvz_ctx_texture(DvzContext* context, uint32_t dims, uvec3 size, VkFo
         dvz_cmd_submit_sync(cmds, 0);
     }
 
+    pthread_mutex_unlock(&context->lock);
     return texture;
 }
 
@@ -504,8 +548,12 @@ void dvz_texture_resize(DvzTexture* texture, uvec3 size)
 {
     ASSERT(texture != NULL);
     ASSERT(texture->image != NULL);
+    ASSERT(texture->context != NULL);
 
+    pthread_mutex_lock(&texture->context->lock);
     dvz_images_resize(texture->image, size[0], size[1], size[2]);
+    texture->version++;
+    pthread_mutex_unlock(&texture->context->lock);
 }
 
 
@@ -556,6 +604,8 @@ void dvz_texture_upload(
     ASSERT(size > 0);
     ASSERT(data != NULL);
 
+    pthread_mutex_lock(&context->lock);
+
     // Take the staging buffer.
     DvzBuffer* staging = staging_buffer(context, size);
 
@@ -564,6 +614,9 @@ void dvz_texture_upload(
 
     // Copy from the staging buffer to the texture.
     _copy_texture_from_staging(context, texture, offset, shape, size);
+    texture->version++;
+
+    pthread_mutex_unlock(&context->lock);
 }
 
 
@@ -577,6 +630,8 @@ void dvz_texture_download(
     ASSERT(size > 0);
     ASSERT(data != NULL);
 
+    pthread_mutex_lock(&context->lock);
+
     // Take the staging buffer.
     DvzBuffer* staging = staging_buffer(context, size);
 
@@ -585,6 +640,8 @@ void dvz_texture_download(
 
     // Memcpy into the staging buffer.
     dvz_buffer_download(staging, 0, size, data);
+
+    pthread_mutex_unlock(&context->lock);
 }
 
 
@@ -595,8 +652,10 @@ void dvz_texture_copy(
     ASSERT(src != NULL);
     ASSERT(dst != NULL);
     DvzContext* context = src->context;
-    DvzGpu* gpu = context->gpu;
     ASSERT(context != NULL);
+    DvzGpu* gpu = context->gpu;
+
+    pthread_mutex_lock(&context->lock);
 
     // Take transfer cmd buf.
     DvzCommands* cmds = &context->transfer_cmd;
@@ -680,6 +739,9 @@ void dvz_texture_copy(
 
     // Wait for the transfer queue to be idle.
     dvz_queue_wait(gpu, DVZ_DEFAULT_QUEUE_TRANSFER);
+    dst->version++;
+
+    pthread_mutex_unlock(&context->lock);
 }
 
 
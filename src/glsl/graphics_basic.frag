@@ -3,6 +3,7 @@
 
 layout (location = 0) in vec4 in_color;
 layout (location = 0) out vec4 out_color;
+layout (location = 1) out uvec2 out_pick; // object picking
 
 void main()
 {
@@ -11,4 +12,6 @@ void main()
     out_color = in_color;
     if (out_color.a < .01)
         discard;
+    // Not pickable, but hides the pickable items behind.
+    out_pick = uvec2(0);
 }
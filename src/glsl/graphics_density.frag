@@ -0,0 +1,60 @@
+#version 450
+#include "common.glsl"
+
+#define DVZ_DENSITY_NORM_LINEAR  0
+#define DVZ_DENSITY_NORM_LOG     1
+#define DVZ_DENSITY_NORM_EQ_HIST 2
+
+#define HIST_SIZE 256u
+
+layout (std140, binding = USER_BINDING) uniform Params {
+    int cmap;
+} params;
+
+layout (binding = (USER_BINDING + 1)) uniform sampler2D tex_cmap; // colormap texture
+
+// Written by the density compute shader.
+layout (std430, binding = (USER_BINDING + 2)) readonly buffer Density {
+    uint max_value;
+    uint norm;
+    uint width;
+    uint height;
+    uint cdf[HIST_SIZE];
+    uint data[];
+} density;
+
+layout (location = 0) out vec4 out_color;
+layout (location = 1) out uvec2 out_pick; // object picking
+
+void main()
+{
+    CLIP
+
+    uvec2 size = uvec2(density.width, density.height);
+    uvec2 pixel = uvec2(gl_FragCoord.xy - vec2(viewport.viewport.x, viewport.viewport.y));
+    if (pixel.x >= size.x || pixel.y >= size.y)
+        discard;
+
+    // Empty pixels are transparent.
+    uint value = density.data[pixel.y * size.x + pixel.x];
+    if (value == 0 || density.max_value == 0)
+        discard;
+
+    float t = float(value) / float(density.max_value);
+    float tlog = log(1.0 + float(value)) / log(1.0 + float(density.max_value));
+    if (density.norm == DVZ_DENSITY_NORM_LOG) {
+        t = tlog;
+    }
+    else if (density.norm == DVZ_DENSITY_NORM_EQ_HIST) {
+        // Same logarithmic bins as the histogram computed by the density compute shader.
+        uint bin = min(uint(tlog * (HIST_SIZE - 1)), HIST_SIZE - 1);
+        t = float(density.cdf[bin]) / float(max(density.cdf[HIST_SIZE - 1], 1u));
+    }
+
+    // Fetch the color from the center of the texel in the colormap row.
+    vec2 uv = vec2((clamp(t, 0.0, 1.0) * 255 + .5) / 256.0, (params.cmap + .5) / 256.0);
+    out_color = textureLod(tex_cmap, uv, 0);
+    out_color.a = 1;
+    // Not pickable, but hides the pickable items behind.
+    out_pick = uvec2(0);
+}
@@ -0,0 +1,9 @@
+#version 450
+#include "common.glsl"
+
+layout (location = 0) in vec2 pos;
+
+void main() {
+    // The quad covers the whole viewport, the density image is already in screen space.
+    gl_Position = vec4(pos, 0, 1);
+}
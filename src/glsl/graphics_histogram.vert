@@ -0,0 +1,20 @@
+#version 450
+#include "common.glsl"
+
+// Bin counts, written by the binning compute shader.
+layout (std430, binding = USER_BINDING) readonly buffer Counts {
+    uint max_count;
+    uint data[];
+} counts;
+
+layout (location = 0) in vec2 pos; // normalized bin edge, and 0 (bottom) or 1 (top) of the bar
+layout (location = 1) in uint bin;
+layout (location = 2) in vec4 color;
+
+layout (location = 0) out vec4 out_color;
+
+void main() {
+    float h = counts.max_count > 0 ? float(counts.data[bin]) / float(counts.max_count) : 0;
+    gl_Position = transform(vec3(pos.x, -1 + 2 * pos.y * h, 0));
+    out_color = color;
+}
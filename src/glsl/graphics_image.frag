@@ -13,6 +13,7 @@ layout(binding = (USER_BINDING + 4)) uniform sampler2D tex_3;
 layout (location = 0) in vec2 in_uv;
 
 layout (location = 0) out vec4 out_color;
+layout (location = 1) out uvec2 out_pick; // object picking
 
 void main() {
     CLIP
@@ -26,4 +27,6 @@ void main() {
         out_color += params.tex_coefs.z * texture(tex_2, in_uv);
     if (params.tex_coefs.w > 0)
         out_color += params.tex_coefs.w * texture(tex_3, in_uv);
+    // Not pickable, but hides the pickable items behind.
+    out_pick = uvec2(0);
 }
@@ -14,6 +14,7 @@ layout(binding = (USER_BINDING + 2)) uniform sampler2D tex;      // image
 layout(location = 0) in vec2 in_uv;
 
 layout(location = 0) out vec4 out_color;
+layout(location = 1) out uvec2 out_pick; // object picking
 
 void main()
 {
@@ -34,4 +35,6 @@ void main()
     // out_color = colormap(params.cmap, value);
 
     out_color.a = 1;
+    // Not pickable, but hides the pickable items behind.
+    out_pick = uvec2(0);
 }
@@ -13,6 +13,7 @@ layout (location = 0) out vec4 out_color;
 layout (location = 1) out float out_size;
 layout (location = 2) out float out_marker;
 layout (location = 3) out float out_angle;
+layout (location = 4) flat out uint out_item; // object picking
 
 void main() {
     gl_Position = transform(pos, transform_mode);
@@ -22,4 +23,5 @@ void main() {
     out_size = size;
     out_marker = marker;
     out_angle = angle * M_2PI;
+    out_item = uint(gl_VertexIndex);
 }
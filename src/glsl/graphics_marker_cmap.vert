@@ -0,0 +1,51 @@
+#version 450
+#include "constants.glsl"
+#include "common.glsl"
+
+// NOTE: the first two fields must match the params struct of graphics_marker.frag.
+layout (std140, binding = USER_BINDING) uniform MarkersCmapParams {
+    vec4 edge_color;
+    float edge_width;
+    int cmap;
+    vec2 vrange;
+} params;
+
+layout (binding = (USER_BINDING + 1)) uniform sampler2D tex_cmap; // colormap texture
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in float value;
+layout (location = 2) in float size;
+layout (location = 3) in uint marker;
+layout (location = 4) in float angle;
+layout (location = 5) in uint transform_mode;
+
+layout (location = 0) out vec4 out_color;
+layout (location = 1) out float out_size;
+layout (location = 2) out float out_marker;
+layout (location = 3) out float out_angle;
+layout (location = 4) flat out uint out_item; // object picking
+
+void main() {
+    gl_Position = transform(pos, transform_mode);
+    gl_PointSize = size;
+
+    // Normalize the value with the color limits, which are a uniform so that changing them does
+    // not require recomputing and uploading the vertices.
+    float v0 = params.vrange.x;
+    float v1 = params.vrange.y;
+    float x = v1 != v0 ? clamp((value - v0) / (v1 - v0), 0, 1) : 0;
+
+    // Fetch the color from the center of the texel in the colormap row.
+    // NOTE: this won't work on color palettes
+    vec2 uv = vec2((x * 255 + .5) / 256.0, (params.cmap + .5) / 256.0);
+    out_color = textureLod(tex_cmap, uv, 0);
+
+    // Hide the markers with NaN values.
+    if (isnan(value))
+        out_color.a = 0;
+
+    out_size = size;
+    out_marker = marker;
+    out_angle = angle * M_2PI;
+    out_item = uint(gl_VertexIndex);
+}
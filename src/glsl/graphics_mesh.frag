@@ -21,6 +21,7 @@ layout (location = 4) in float in_clip;
 layout (location = 5) in float in_alpha;
 
 layout (location = 0) out vec4 out_color;
+layout (location = 1) out uvec2 out_pick; // object picking
 
 const float eps = .00001;
 
@@ -81,4 +82,6 @@ void main() {
     }
 
     out_color.a = in_alpha;
+    // Not pickable, but hides the pickable items behind.
+    out_pick = uvec2(0);
 }
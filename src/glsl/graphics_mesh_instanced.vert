@@ -0,0 +1,61 @@
+#version 450
+#include "common.glsl"
+
+layout (std140, binding = USER_BINDING) uniform Params {
+    mat4 lights_pos_0; // lights 0-3
+    mat4 lights_params_0; // for each light, coefs for ambient, diffuse, specular, specular expon
+    vec4 tex_coefs; // blending coefficients for the textures
+    vec4 clip_coefs;
+} params;
+
+// Base mesh, per vertex.
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 uv;
+layout (location = 3) in float alpha;
+
+// Per instance.
+layout (location = 4) in vec3 instance_pos;
+layout (location = 5) in vec4 instance_rotation; // quaternion
+layout (location = 6) in vec3 instance_scale;
+layout (location = 7) in vec4 instance_color; // overrides the mesh color if alpha is not zero
+
+layout (location = 0) out vec3 out_pos;
+layout (location = 1) out vec3 out_normal;
+layout (location = 2) out vec2 out_uv;
+layout (location = 3) out vec3 out_color;
+layout (location = 4) out float out_clip;
+layout (location = 5) out float out_alpha;
+
+vec3 rotate(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    // Scale, rotate, and translate the base mesh vertex.
+    vec3 ipos = instance_pos + rotate(instance_rotation, instance_scale * pos);
+    // The normal is transformed by the inverse transpose of the rotation-scaling matrix.
+    vec3 inormal = rotate(instance_rotation, normal / instance_scale);
+
+    gl_Position = transform(ipos);
+
+    out_pos = ((mvp.model * vec4(ipos, 1.0))).xyz;
+    out_normal = ((transpose(inverse(mvp.model)) * vec4(inormal, 1.0))).xyz;
+
+    out_uv = uv;
+    out_clip = dot(vec4(ipos, 1.0), params.clip_coefs);
+    out_alpha = alpha;
+    out_color = vec3(0);
+
+    // NOTE: if uv.y is negative, we take uv.x and unpack the 3 first bytes and interpret them as
+    // custom colors
+    if (uv.y < 0)
+        out_color = unpack_color(uv).xyz;
+
+    // The instance color replaces the textures and the mesh colors.
+    if (instance_color.a > 0) {
+        out_uv = vec2(0, -1);
+        out_color = instance_color.rgb;
+        out_alpha = alpha * instance_color.a;
+    }
+}
@@ -9,9 +9,11 @@ layout (location = 0) in vec3 pos;
 layout (location = 1) in vec4 color;
 
 layout (location = 0) out vec4 out_color;
+layout (location = 1) flat out uint out_item; // object picking
 
 void main() {
     gl_Position = transform(pos);
     out_color = color;
     gl_PointSize = params.point_size;
+    out_item = uint(gl_VertexIndex);
 }
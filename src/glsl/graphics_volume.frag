@@ -5,12 +5,20 @@
 #define STEP_SIZE 0.005
 #define MAX_ITER 10 / STEP_SIZE
 
+// Bricked volumes, must match bricks.h.
+#define BRICK_SIZE 30
+#define BRICK_GUTTER 1
+#define BRICK_SLOT (BRICK_SIZE + 2 * BRICK_GUTTER)
+#define ATLAS_SIZE (vec3(16, 16, 4) * BRICK_SLOT)
+
 layout(std140, binding = USER_BINDING) uniform Params
 {
     vec4 box_size;
     vec4 uvw0;
     vec4 uvw1;
     vec4 clip;
+    vec4 shape;
+    vec4 bricks;
     vec2 transfer_xrange;
     int cmap;
 }
@@ -18,7 +26,8 @@ params;
 
 layout(binding = (USER_BINDING + 1)) uniform sampler2D tex_cmap;        // colormap texture
 layout(binding = (USER_BINDING + 2)) uniform sampler1D tex_transfer;    // transfer function
-layout(binding = (USER_BINDING + 3)) uniform sampler3D tex;             // 3D volume
+layout(binding = (USER_BINDING + 3)) uniform sampler3D tex;             // 3D volume or brick atlas
+layout(binding = (USER_BINDING + 4)) uniform sampler3D tex_page;        // brick page table
 
 layout(location = 0) in vec3 in_pos;
 layout(location = 1) in vec3 in_ray;
@@ -102,6 +111,12 @@ void main()
     vec4 s = vec4(0);
     vec4 acc = vec4(0);
     float alpha = 0;
+    vec3 voxel = vec3(0);
+    vec3 dv = vec3(0);
+    ivec3 brick = ivec3(0);
+    vec4 page = vec4(0);
+    int level = 0;
+    int skip = 0;
     for (int i = 0; i < MAX_ITER && travel > 0.0; ++i, pos += dl, travel -= STEP_SIZE) {
         // Normalize 3D pos within cube in [0,1]^3
         uvw = (pos - b0) / (b1 - b0);
@@ -111,6 +126,40 @@ void main()
         // Now, normalize between uvw0 and uvw1.
         uvw = params.uvw0.xyz + uvw * (params.uvw1 - params.uvw0).xyz;
 
+        // Bricked volume: find the brick in the page table.
+        if (params.bricks.w > 0) {
+            voxel = clamp(uvw, 0, 1) * params.shape.xyz;
+            brick = min(ivec3(voxel / BRICK_SIZE), ivec3(params.bricks.xyz) - 1);
+            page = texelFetch(tex_page, brick, 0);
+            level = int(round(page.a * 255));
+
+            // Empty brick: skip all of its samples.
+            if (level == 0) {
+                // Number of samples until the ray exits the brick.
+                dv = dl / (b1 - b0) * (params.uvw1 - params.uvw0).xyz * params.shape.xyz;
+                vec3 lo = vec3(brick * BRICK_SIZE);
+                vec3 hi = lo + BRICK_SIZE;
+                vec3 t = mix((lo - voxel) / dv, (hi - voxel) / dv, greaterThan(dv, vec3(0)));
+                t = mix(t, vec3(1e9), lessThan(abs(dv), vec3(1e-9)));
+                skip = max(int(floor(min(min(t.x, t.y), t.z))), 0);
+                i += skip;
+                pos += dl * skip;
+                travel -= STEP_SIZE * skip;
+                continue;
+            }
+
+            // Brick not resident yet: the slot holds the brick of a coarser level that contains
+            // it, each level halving the voxel coordinates.
+            if (level < 255) {
+                voxel /= exp2(level);
+                brick = ivec3(voxel / BRICK_SIZE);
+            }
+
+            // Position within the brick slot of the atlas.
+            uvw = (round(page.xyz * 255) * BRICK_SLOT + BRICK_GUTTER +
+                   (voxel - vec3(brick * BRICK_SIZE))) / ATLAS_SIZE;
+        }
+
         // Fetch the color from the 3D texture.
         s = fetch_color(uvw);
         alpha = s.a;
@@ -19,6 +19,7 @@ layout(binding = (USER_BINDING + 2)) uniform sampler3D tex;      // 3D volume
 layout(location = 0) in vec3 in_uvw;
 
 layout(location = 0) out vec4 out_color;
+layout(location = 1) out uvec2 out_pick; // object picking
 
 void main()
 {
@@ -58,4 +59,6 @@ void main()
 
     out_color.a = alpha;
     if (alpha < .01) discard;
+    // Not pickable, but hides the pickable items behind.
+    out_pick = uvec2(0);
 }
@@ -54,6 +54,12 @@ static inline void _load_shader(
 
 #define ATTR_COL(t, f) ATTR(t, VK_FORMAT_R8G8B8A8_UNORM, f)
 
+// Per-instance attributes, in the second vertex binding, after the per-vertex attributes.
+#define INSTANCE_BEGIN(t) dvz_graphics_instance_binding(graphics, 1, sizeof(t));
+
+#define INSTANCE_ATTR(t, fmt, f)                                                                  \
+    dvz_graphics_vertex_attr(graphics, 1, attr_idx++, fmt, offsetof(t, f));
+
 
 
 /*************************************************************************************************/
@@ -90,6 +96,9 @@ static void _graphics_point(DvzCanvas* canvas, DvzGraphics* graphics)
     _common_slots(graphics);
     dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 
+    // Object picking.
+    dvz_graphics_pick(graphics, true);
+
     CREATE
 }
 
@@ -112,6 +121,9 @@ static void _graphics_basic(DvzCanvas* canvas, DvzGraphics* graphics, VkPrimitiv
 
     _common_slots(graphics);
 
+    // Object picking: not pickable, but hides the pickable items behind.
+    dvz_graphics_pick(graphics, true);
+
     CREATE
 }
 
@@ -142,6 +154,41 @@ static void _graphics_marker(DvzCanvas* canvas, DvzGraphics* graphics)
     _common_slots(graphics);
     dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 
+    // Object picking.
+    dvz_graphics_pick(graphics, true);
+
+    CREATE
+}
+
+static void _graphics_marker_cmap(DvzCanvas* canvas, DvzGraphics* graphics)
+{
+    SHADER(VERTEX, "graphics_marker_cmap_vert")
+    SHADER(FRAGMENT, "graphics_marker_frag")
+    PRIMITIVE(POINT_LIST)
+
+    // Depth test flag.
+    if ((graphics->flags & DVZ_GRAPHICS_FLAGS_DEPTH_TEST_ENABLE) != 0)
+        dvz_graphics_depth_test(graphics, DVZ_DEPTH_TEST_ENABLE);
+
+    ATTR_BEGIN(DvzGraphicsMarkerCmapVertex)
+    ATTR_POS(DvzGraphicsMarkerCmapVertex, pos)
+    ATTR(DvzGraphicsMarkerCmapVertex, VK_FORMAT_R32_SFLOAT, value)
+    ATTR(DvzGraphicsMarkerCmapVertex, VK_FORMAT_R32_SFLOAT, size)
+    ATTR(DvzGraphicsMarkerCmapVertex, VK_FORMAT_R8_UINT, marker)
+    ATTR(DvzGraphicsMarkerCmapVertex, VK_FORMAT_R8_UNORM, angle)
+    ATTR(DvzGraphicsMarkerCmapVertex, VK_FORMAT_R8_UINT, transform)
+
+    _common_slots(graphics);
+
+    // Params buffer.
+    dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+
+    // Colormap texture, sampled in the vertex shader.
+    dvz_graphics_slot(graphics, DVZ_USER_BINDING + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+
+    // Object picking.
+    dvz_graphics_pick(graphics, true);
+
     CREATE
 }
 
@@ -281,32 +328,37 @@ static void _graphics_text_callback(DvzGraphicsData* data, uint32_t item_count,
 
     // const char* str = item;
     const DvzGraphicsTextItem* str_item = item;
-    uint32_t n = strlen(str_item->string);
-    DvzGraphicsTextVertex vertex = {0};
-    vertex = str_item->vertex;
+    const char* str = str_item->string;
+    uint32_t n = strlen(str);
     ASSERT(n > 0);
     ASSERT(data->current_idx + n <= item_count);
-    for (uint32_t i = 0; i < n; i++)
-    {
-        size_t g = _font_atlas_glyph(atlas, str_item->string, i);
 
-        // Glyph size.
-        _font_atlas_glyph_size(atlas, str_item->font_size, vertex.glyph_size);
+    // The glyph size, string length and string index are the same for all glyphs.
+    DvzGraphicsTextVertex vertex = {0};
+    vertex = str_item->vertex;
+    _font_atlas_glyph_size(atlas, str_item->font_size, vertex.glyph_size);
+    vertex.glyph[2] = n;                   // str len
+    vertex.glyph[3] = data->current_group; // str idx
 
+    // Write the vertices directly in the vertex array, repeating each glyph vertex 4 times.
+    DvzGraphicsTextVertex* vertices =
+        (DvzGraphicsTextVertex*)dvz_array_item(data->vertices, 4 * data->current_idx);
+    for (uint32_t i = 0; i < n; i++)
+    {
         // Glyph.
-        vertex.glyph[0] = g;                   // char
-        vertex.glyph[1] = i;                   // char idx
-        vertex.glyph[2] = n;                   // str len
-        vertex.glyph[3] = data->current_group; // str idx
+        vertex.glyph[0] = _font_atlas_glyph(atlas, str, i); // char
+        vertex.glyph[1] = i;                                // char idx
 
         // Glyph colors.
         if (str_item->glyph_colors != NULL)
             memcpy(vertex.color, str_item->glyph_colors[i], sizeof(cvec4));
 
-        // Fill the vertices array by simply repeating them 4 times.
-        dvz_array_data(data->vertices, 4 * data->current_idx, 4, 1, &vertex);
-        data->current_idx++; // glyph index
+        vertices[4 * i + 0] = vertex;
+        vertices[4 * i + 1] = vertex;
+        vertices[4 * i + 2] = vertex;
+        vertices[4 * i + 3] = vertex;
     }
+    data->current_idx += n; // glyph index
     data->current_group++; // glyph index
 }
 
@@ -393,6 +445,9 @@ static void _graphics_image(DvzCanvas* canvas, DvzGraphics* graphics)
         dvz_graphics_slot(
             graphics, DVZ_USER_BINDING + i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
+    // Object picking: not pickable, but hides the pickable items behind.
+    dvz_graphics_pick(graphics, true);
+
     CREATE
 
     dvz_graphics_callback(graphics, _graphics_image_callback);
@@ -421,6 +476,9 @@ static void _graphics_image_cmap(DvzCanvas* canvas, DvzGraphics* graphics)
     // Scalar image.
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
+    // Object picking: not pickable, but hides the pickable items behind.
+    dvz_graphics_pick(graphics, true);
+
     CREATE
 
     dvz_graphics_callback(graphics, _graphics_image_callback);
@@ -485,6 +543,9 @@ static void _graphics_volume_slice(DvzCanvas* canvas, DvzGraphics* graphics)
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
+    // Object picking: not pickable, but hides the pickable items behind.
+    dvz_graphics_pick(graphics, true);
+
     CREATE
 
     dvz_graphics_callback(graphics, _graphics_volume_slice_callback);
@@ -583,6 +644,7 @@ static void _graphics_volume(DvzCanvas* canvas, DvzGraphics* graphics)
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    dvz_graphics_slot(graphics, DVZ_USER_BINDING + 4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
     CREATE
 
@@ -616,6 +678,135 @@ static void _graphics_mesh(DvzCanvas* canvas, DvzGraphics* graphics)
         dvz_graphics_slot(
             graphics, DVZ_USER_BINDING + i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
+    // Object picking: not pickable, but hides the pickable items behind.
+    dvz_graphics_pick(graphics, true);
+
+    CREATE
+}
+
+
+
+static void _graphics_mesh_instanced(DvzCanvas* canvas, DvzGraphics* graphics)
+{
+    SHADER(VERTEX, "graphics_mesh_instanced_vert")
+    SHADER(FRAGMENT, "graphics_mesh_frag")
+    PRIMITIVE(TRIANGLE_LIST)
+    dvz_graphics_depth_test(graphics, DVZ_DEPTH_TEST_ENABLE);
+
+    ATTR_BEGIN(DvzGraphicsMeshVertex)
+    ATTR_POS(DvzGraphicsMeshVertex, pos)
+    ATTR(DvzGraphicsMeshVertex, VK_FORMAT_R32G32B32_SFLOAT, normal)
+    ATTR(DvzGraphicsMeshVertex, VK_FORMAT_R32G32_SFLOAT, uv)
+    ATTR(DvzGraphicsMeshVertex, VK_FORMAT_R8_UNORM, alpha)
+
+    INSTANCE_BEGIN(DvzGraphicsMeshInstance)
+    INSTANCE_ATTR(DvzGraphicsMeshInstance, VK_FORMAT_R32G32B32_SFLOAT, pos)
+    INSTANCE_ATTR(DvzGraphicsMeshInstance, VK_FORMAT_R32G32B32A32_SFLOAT, rotation)
+    INSTANCE_ATTR(DvzGraphicsMeshInstance, VK_FORMAT_R32G32B32_SFLOAT, scale)
+    INSTANCE_ATTR(DvzGraphicsMeshInstance, VK_FORMAT_R8G8B8A8_UNORM, color)
+
+    _common_slots(graphics);
+    dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    for (uint32_t i = 1; i <= 4; i++)
+        dvz_graphics_slot(
+            graphics, DVZ_USER_BINDING + i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+
+    // Object picking: not pickable, but hides the pickable items behind.
+    dvz_graphics_pick(graphics, true);
+
+    CREATE
+}
+
+
+
+/*************************************************************************************************/
+/*  Histogram                                                                                    */
+/*************************************************************************************************/
+
+static void
+_graphics_histogram_callback(DvzGraphicsData* data, uint32_t item_count, const void* item)
+{
+    ASSERT(data != NULL);
+    ASSERT(data->vertices != NULL);
+
+    ASSERT(item_count > 0);
+    dvz_array_resize(data->vertices, 6 * item_count);
+
+    if (item == NULL)
+        return;
+    ASSERT(item != NULL);
+    ASSERT(data->current_idx < item_count);
+
+    const DvzGraphicsHistogramItem* item_vert = (const DvzGraphicsHistogramItem*)item;
+    uint32_t bin = item_vert->bin;
+    float n = (float)MAX(item_vert->bin_count, 1);
+
+    // Bin edges in normalized coordinates, the bar height is only known by the vertex shader.
+    float x0 = -1 + 2 * bin / n;
+    float x1 = -1 + 2 * (bin + 1) / n;
+
+    DvzGraphicsHistogramVertex vertices[6] = {
+        {{x0, 0}, bin, {0}}, //
+        {{x1, 0}, bin, {0}}, //
+        {{x1, 1}, bin, {0}}, //
+        {{x1, 1}, bin, {0}}, //
+        {{x0, 1}, bin, {0}}, //
+        {{x0, 0}, bin, {0}}, //
+    };
+    for (uint32_t i = 0; i < 6; i++)
+        memcpy(vertices[i].color, item_vert->color, sizeof(cvec4));
+
+    dvz_array_data(data->vertices, 6 * data->current_idx, 6, 6, vertices);
+    data->current_idx++;
+}
+
+static void _graphics_histogram(DvzCanvas* canvas, DvzGraphics* graphics)
+{
+    SHADER(VERTEX, "graphics_histogram_vert")
+    SHADER(FRAGMENT, "graphics_basic_frag")
+    PRIMITIVE(TRIANGLE_LIST)
+
+    ATTR_BEGIN(DvzGraphicsHistogramVertex)
+    ATTR(DvzGraphicsHistogramVertex, VK_FORMAT_R32G32_SFLOAT, pos)
+    ATTR(DvzGraphicsHistogramVertex, VK_FORMAT_R32_UINT, bin)
+    ATTR_COL(DvzGraphicsHistogramVertex, color)
+
+    _common_slots(graphics);
+    // Bin counts, written by the binning compute shader.
+    dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    // Object picking: not pickable, but hides the pickable items behind.
+    dvz_graphics_pick(graphics, true);
+
+    CREATE
+
+    dvz_graphics_callback(graphics, _graphics_histogram_callback);
+}
+
+
+
+/*************************************************************************************************/
+/*  Density                                                                                      */
+/*************************************************************************************************/
+
+static void _graphics_density(DvzCanvas* canvas, DvzGraphics* graphics)
+{
+    SHADER(VERTEX, "graphics_density_vert")
+    SHADER(FRAGMENT, "graphics_density_frag")
+    PRIMITIVE(TRIANGLE_LIST)
+
+    ATTR_BEGIN(DvzGraphicsDensityVertex)
+    ATTR(DvzGraphicsDensityVertex, VK_FORMAT_R32G32_SFLOAT, pos)
+
+    _common_slots(graphics);
+    dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    dvz_graphics_slot(graphics, DVZ_USER_BINDING + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    // Density image, written by the density compute shader.
+    dvz_graphics_slot(graphics, DVZ_USER_BINDING + 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    // Object picking: not pickable, but hides the pickable items behind.
+    dvz_graphics_pick(graphics, true);
+
     CREATE
 }
 
@@ -781,6 +972,10 @@ DvzGraphics* dvz_graphics_builtin(DvzCanvas* canvas, DvzGraphicsType type, int f
         _graphics_marker(canvas, graphics);
         break;
 
+    case DVZ_GRAPHICS_MARKER_CMAP:
+        _graphics_marker_cmap(canvas, graphics);
+        break;
+
     case DVZ_GRAPHICS_SEGMENT:
         _graphics_segment(canvas, graphics);
         break;
@@ -820,6 +1015,20 @@ DvzGraphics* dvz_graphics_builtin(DvzCanvas* canvas, DvzGraphicsType type, int f
         _graphics_mesh(canvas, graphics);
         break;
 
+    case DVZ_GRAPHICS_MESH_INSTANCED:
+        _graphics_mesh_instanced(canvas, graphics);
+        break;
+
+        // Histogram
+    case DVZ_GRAPHICS_HISTOGRAM:
+        _graphics_histogram(canvas, graphics);
+        break;
+
+        // Density
+    case DVZ_GRAPHICS_DENSITY:
+        _graphics_density(canvas, graphics);
+        break;
+
     case DVZ_GRAPHICS_CUSTOM:
         break;
 
@@ -85,6 +85,8 @@ static void _presend(DvzCanvas* canvas, DvzEvent ev)
     uint32_t idx = canvas->swapchain.img_idx;
 
     dvz_cmd_begin(cmds, idx);
+    dvz_canvas_profile_reset(canvas, cmds, idx, DVZ_PROFILER_CMDS_OVERLAY);
+    uint32_t scope = dvz_canvas_profile_begin(canvas, cmds, idx, DVZ_PROFILER_CMDS_OVERLAY, "gui");
     dvz_cmd_begin_renderpass(
         cmds, idx, &canvas->renderpass_overlay, &canvas->framebuffers_overlay);
 
@@ -112,6 +114,7 @@ static void _presend(DvzCanvas* canvas, DvzEvent ev)
     }
 
     dvz_cmd_end_renderpass(cmds, idx);
+    dvz_canvas_profile_end(canvas, cmds, idx, DVZ_PROFILER_CMDS_OVERLAY, scope);
     dvz_cmd_end(cmds, idx);
 
     ASSERT(canvas != NULL);
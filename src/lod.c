@@ -0,0 +1,426 @@
+#include "../include/datoviz/lod.h"
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+typedef struct DvzLodChunk DvzLodChunk;
+
+struct DvzLodChunk
+{
+    DvzLod* lod;
+    uint32_t count;
+    dvec3* pos;
+    uint32_t* idx;
+};
+
+
+
+static inline double _level_x(DvzLod* lod, uint32_t level, uint32_t j)
+{
+    ASSERT(lod != NULL);
+    ASSERT(level < lod->level_count);
+    return level == 0 ? lod->pos[j][0] : lod->levels[level].pos[j][0];
+}
+
+
+
+// Index of the first point of a level with x >= value.
+static uint32_t _lower_bound(DvzLod* lod, uint32_t level, double value)
+{
+    uint32_t lo = 0;
+    uint32_t hi = lod->levels[level].count;
+    uint32_t mid = 0;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (_level_x(lod, level, mid) < value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+
+// Index of the first point of a level with x > value.
+static uint32_t _upper_bound(DvzLod* lod, uint32_t level, double value)
+{
+    uint32_t lo = 0;
+    uint32_t hi = lod->levels[level].count;
+    uint32_t mid = 0;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (_level_x(lod, level, mid) <= value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+
+// Keep the first, last, min and max points of the source points [a, b), in the original order.
+// Return the number of points written to the destination arrays (at most 4).
+static uint32_t _m4_bucket(
+    const dvec3* src_pos, const uint32_t* src_idx, uint32_t a, uint32_t b, //
+    dvec3* dst_pos, uint32_t* dst_idx)
+{
+    ASSERT(a < b);
+    uint32_t jmin = a, jmax = a;
+    for (uint32_t j = a + 1; j < b; j++)
+    {
+        if (src_pos[j][1] < src_pos[jmin][1])
+            jmin = j;
+        if (src_pos[j][1] > src_pos[jmax][1])
+            jmax = j;
+    }
+
+    uint32_t kept[4] = {a, MIN(jmin, jmax), MAX(jmin, jmax), b - 1};
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        // The candidates are sorted, so duplicates are consecutive.
+        if (i > 0 && kept[i] == kept[i - 1])
+            continue;
+        _dvec3_copy(src_pos[kept[i]], dst_pos[n]);
+        dst_idx[n] = src_idx != NULL ? src_idx[kept[i]] : kept[i];
+        n++;
+    }
+    return n;
+}
+
+
+
+// Decimate a range of buckets of the original data into the first level. Each thread writes
+// its points in its own chunk.
+static void _lod_chunk(uint64_t first, uint64_t count, uint32_t thread_idx, void* user_data)
+{
+    DvzLodChunk* chunk = &((DvzLodChunk*)user_data)[thread_idx];
+    DvzLod* lod = chunk->lod;
+    ASSERT(lod != NULL);
+
+    chunk->pos = (dvec3*)calloc(4 * count + 1, sizeof(dvec3));
+    chunk->idx = (uint32_t*)calloc(4 * count + 1, sizeof(uint32_t));
+
+    const uint64_t bucket = DVZ_LOD_FACTOR;
+    uint64_t a = 0, b = 0;
+    for (uint64_t i = first; i < first + count; i++)
+    {
+        if (atomic_load(&lod->to_stop))
+            break;
+        a = i * bucket;
+        b = MIN(a + bucket, lod->sample_count);
+        chunk->count += _m4_bucket(
+            lod->pos, NULL, (uint32_t)a, (uint32_t)b, //
+            &chunk->pos[chunk->count], &chunk->idx[chunk->count]);
+    }
+}
+
+
+
+// Build the first level from the original data, splitting the work between several threads.
+static void _lod_level_first(DvzLod* lod)
+{
+    ASSERT(lod != NULL);
+    uint64_t n_buckets = (lod->sample_count + DVZ_LOD_FACTOR - 1) / DVZ_LOD_FACTOR;
+
+    DvzLodChunk chunks[DVZ_LOD_THREADS] = {0};
+    for (uint32_t t = 0; t < DVZ_LOD_THREADS; t++)
+        chunks[t].lod = lod;
+    uint32_t n_threads = dvz_parallel(
+        n_buckets, DVZ_LOD_MIN_CHUNK / DVZ_LOD_FACTOR, DVZ_LOD_THREADS, _lod_chunk, chunks);
+
+    // Concatenate the chunks.
+    uint32_t count = 0;
+    for (uint32_t t = 0; t < n_threads; t++)
+        count += chunks[t].count;
+
+    DvzLodLevel* level = &lod->levels[1];
+    level->bucket = DVZ_LOD_FACTOR;
+    level->pos = (dvec3*)calloc(count, sizeof(dvec3));
+    level->idx = (uint32_t*)calloc(count, sizeof(uint32_t));
+    for (uint32_t t = 0; t < n_threads; t++)
+    {
+        memcpy(&level->pos[level->count], chunks[t].pos, chunks[t].count * sizeof(dvec3));
+        memcpy(&level->idx[level->count], chunks[t].idx, chunks[t].count * sizeof(uint32_t));
+        level->count += chunks[t].count;
+        FREE(chunks[t].pos);
+        FREE(chunks[t].idx);
+    }
+    ASSERT(level->count == count);
+}
+
+
+
+// Build a level from the previous one. Buckets are defined on the original sample indices, so
+// that the min/max of each bucket is exact.
+static void _lod_level_next(DvzLod* lod, uint32_t k)
+{
+    ASSERT(lod != NULL);
+    ASSERT(k >= 2);
+    DvzLodLevel* prev = &lod->levels[k - 1];
+    DvzLodLevel* level = &lod->levels[k];
+
+    level->bucket = prev->bucket * DVZ_LOD_FACTOR;
+    // At most 4 points per bucket, and at most as many points as in the previous level.
+    uint64_t n_buckets = (lod->sample_count + level->bucket - 1) / level->bucket;
+    uint32_t capacity = (uint32_t)MIN(4 * n_buckets, prev->count);
+    level->pos = (dvec3*)calloc(capacity, sizeof(dvec3));
+    level->idx = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+
+    uint32_t a = 0, b = 0;
+    uint64_t bucket = 0;
+    while (a < prev->count)
+    {
+        if (atomic_load(&lod->to_stop))
+            return;
+        bucket = prev->idx[a] / level->bucket;
+        for (b = a + 1; b < prev->count && prev->idx[b] / level->bucket == bucket; b++)
+            ;
+        level->count += _m4_bucket(
+            (const dvec3*)prev->pos, prev->idx, a, b, //
+            &level->pos[level->count], &level->idx[level->count]);
+        a = b;
+    }
+    ASSERT(level->count <= capacity);
+}
+
+
+
+static void* _lod_build(void* user_data)
+{
+    DvzLod* lod = (DvzLod*)user_data;
+    ASSERT(lod != NULL);
+
+    uint32_t k = 1;
+    _lod_level_first(lod);
+    while (!atomic_load(&lod->to_stop) && k < DVZ_LOD_MAX_LEVELS - 1 &&
+           lod->levels[k].count > DVZ_LOD_FACTOR * 4)
+    {
+        k++;
+        _lod_level_next(lod, k);
+    }
+    if (atomic_load(&lod->to_stop))
+        return NULL;
+
+    lod->level_count = k + 1;
+    atomic_store(&lod->is_ready, true);
+
+    log_debug(
+        "built %d-level decimation pyramid of %d samples", lod->level_count, lod->sample_count);
+    return NULL;
+}
+
+
+
+static void _lod_free_levels(DvzLod* lod)
+{
+    ASSERT(lod != NULL);
+    for (uint32_t k = 1; k < DVZ_LOD_MAX_LEVELS; k++)
+    {
+        FREE(lod->levels[k].pos);
+        FREE(lod->levels[k].idx);
+        memset(&lod->levels[k], 0, sizeof(DvzLodLevel));
+    }
+    lod->level_count = lod->sample_count > 0 ? 1 : 0;
+}
+
+
+
+// Choose the level to use for a given visible range, and the stride to use at level 0 while the
+// pyramid is not ready yet.
+static void _lod_choose(
+    DvzLod* lod, double xmin, double xmax, uint32_t width, uint32_t* level, uint32_t* stride)
+{
+    ASSERT(lod != NULL);
+    ASSERT(level != NULL);
+    ASSERT(stride != NULL);
+    width = MAX(width, 1);
+
+    // Number of original samples in the visible range.
+    uint64_t n = _upper_bound(lod, 0, xmax) - _lower_bound(lod, 0, xmin);
+
+    *level = 0;
+    *stride = 1;
+    if (n <= width)
+        return;
+
+    if (!dvz_lod_ready(lod))
+    {
+        // Preview: plain subsampling of the original data, about 4 points per pixel like M4.
+        *stride = (uint32_t)((n + 4 * width - 1) / (4 * width));
+        return;
+    }
+
+    // Coarsest level with at least one bucket per pixel, so that the min/max envelope is exact
+    // at the pixel level.
+    for (uint32_t k = 1; k < lod->level_count; k++)
+    {
+        if (n / lod->levels[k].bucket < width)
+            break;
+        *level = k;
+    }
+}
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+DvzLod* dvz_lod(void)
+{
+    DvzLod* lod = calloc(1, sizeof(DvzLod));
+    atomic_init(&lod->is_building, false);
+    atomic_init(&lod->is_ready, false);
+    atomic_init(&lod->to_stop, false);
+    dvz_obj_init(&lod->obj);
+    dvz_obj_created(&lod->obj);
+    return lod;
+}
+
+
+
+void dvz_lod_data(DvzLod* lod, uint32_t count, const dvec3* pos)
+{
+    ASSERT(lod != NULL);
+    dvz_lod_stop(lod);
+    _lod_free_levels(lod);
+
+    lod->sample_count = count;
+    lod->pos = pos;
+    memset(&lod->window, 0, sizeof(DvzLodWindow));
+
+    lod->level_count = count > 0 ? 1 : 0;
+    lod->levels[0].bucket = 1;
+    lod->levels[0].count = count;
+
+    // Small signals do not need to be decimated.
+    if (count <= DVZ_LOD_FACTOR * 4)
+    {
+        atomic_store(&lod->is_ready, true);
+        return;
+    }
+
+    log_trace("start building the decimation pyramid of %d samples", count);
+    atomic_store(&lod->is_ready, false);
+    atomic_store(&lod->to_stop, false);
+    atomic_store(&lod->is_building, true);
+    lod->thread = dvz_thread(_lod_build, lod);
+}
+
+
+
+void dvz_lod_stop(DvzLod* lod)
+{
+    ASSERT(lod != NULL);
+    if (!atomic_load(&lod->is_building))
+        return;
+    atomic_store(&lod->to_stop, true);
+    dvz_thread_join(&lod->thread);
+    atomic_store(&lod->is_building, false);
+    atomic_store(&lod->to_stop, false);
+}
+
+
+
+bool dvz_lod_ready(DvzLod* lod)
+{
+    ASSERT(lod != NULL);
+    return atomic_load(&lod->is_ready);
+}
+
+
+
+DvzLodWindow dvz_lod_window(DvzLod* lod, double xmin, double xmax, uint32_t width)
+{
+    ASSERT(lod != NULL);
+    ASSERT(xmin <= xmax);
+
+    DvzLodWindow window = {0};
+    if (lod->sample_count == 0)
+        return window;
+
+    _lod_choose(lod, xmin, xmax, width, &window.level, &window.stride);
+
+    // Extend the window on both sides of the visible range.
+    double pad = DVZ_LOD_WINDOW_PADDING * (xmax - xmin);
+    window.xmin = xmin - pad;
+    window.xmax = xmax + pad;
+
+    // Also keep the points just outside the window so that the line reaches the edges.
+    uint32_t n = lod->levels[window.level].count;
+    uint32_t first = _lower_bound(lod, window.level, window.xmin);
+    uint32_t last = _upper_bound(lod, window.level, window.xmax);
+    first = first > 0 ? first - 1 : 0;
+    last = MIN(last + 1, n);
+    ASSERT(first <= last);
+
+    window.first = first;
+    window.count = (last - first + window.stride - 1) / window.stride;
+
+    lod->window = window;
+    return window;
+}
+
+
+
+bool dvz_lod_covers(DvzLod* lod, DvzLodWindow window, double xmin, double xmax, uint32_t width)
+{
+    ASSERT(lod != NULL);
+    if (window.count == 0 || xmin < window.xmin || xmax > window.xmax)
+        return false;
+    uint32_t level = 0, stride = 0;
+    _lod_choose(lod, xmin, xmax, width, &level, &stride);
+    return level == window.level && stride == window.stride;
+}
+
+
+
+void dvz_lod_copy(DvzLod* lod, DvzLodWindow window, dvec3* pos, uint32_t* idx)
+{
+    ASSERT(lod != NULL);
+    ASSERT(pos != NULL);
+    ASSERT(window.level < lod->level_count);
+
+    DvzLodLevel* level = &lod->levels[window.level];
+    ASSERT(window.first + (window.count > 0 ? (window.count - 1) * window.stride : 0) <
+           MAX(level->count, 1));
+
+    if (window.level == 0)
+    {
+        uint32_t stride = MAX(window.stride, 1);
+        uint32_t j = 0;
+        for (uint32_t i = 0; i < window.count; i++)
+        {
+            j = window.first + i * stride;
+            _dvec3_copy(lod->pos[j], pos[i]);
+            if (idx != NULL)
+                idx[i] = j;
+        }
+    }
+    else
+    {
+        memcpy(pos, &level->pos[window.first], window.count * sizeof(dvec3));
+        if (idx != NULL)
+            memcpy(idx, &level->idx[window.first], window.count * sizeof(uint32_t));
+    }
+}
+
+
+
+void dvz_lod_destroy(DvzLod* lod)
+{
+    if (lod == NULL)
+        return;
+    dvz_lod_stop(lod);
+    _lod_free_levels(lod);
+    dvz_obj_destroyed(&lod->obj);
+    FREE(lod);
+}
@@ -1,10 +1,13 @@
+#include <sys/stat.h>
+
 #include "../include/datoviz/mesh.h"
 #include "../include/datoviz/common.h"
+#include "../include/datoviz/npy.h"
 
 
 
 /*************************************************************************************************/
-/*  Mesh transforms                                                                              */
+/*  Utils                                                                                        */
 /*************************************************************************************************/
 
 DVZ_INLINE void texture_color(usvec2 ij, usvec2 nm, void* color)
@@ -34,17 +37,147 @@ DVZ_INLINE void transform_pos(DvzMesh* mesh, vec3 pos)
 
 
 
-DVZ_INLINE void transform_normal(DvzMesh* mesh, vec3 normal)
+// The normals are transformed by the inverse transpose of the transformation matrix.
+DVZ_INLINE void normal_matrix(DvzMesh* mesh, mat4 tr)
 {
-    mat4 tr;
     glm_mat4_copy(mesh->transform, tr);
     glm_mat4_inv(tr, tr);
     glm_mat4_transpose(tr);
-    glm_mat4_mulv3(tr, normal, 1, normal);
 }
 
 
 
+DVZ_INLINE void transform_normal(mat4 tr, vec3 normal) { glm_mat4_mulv3(tr, normal, 1, normal); }
+
+
+
+/*************************************************************************************************/
+/*  Mesh threads                                                                                 */
+/*************************************************************************************************/
+
+typedef struct DvzMeshChunk DvzMeshChunk;
+
+struct DvzMeshChunk
+{
+    DvzMesh* mesh;
+    mat4 normal_tr;
+
+    // Normals.
+    vec3* face_normals;     // normal of each face
+    uint32_t* face_offsets; // offset of the face list of each vertex in vertex_faces
+    uint32_t* vertex_faces; // faces touching each vertex
+};
+
+
+
+static void _transform_chunk(uint64_t first, uint64_t count, uint32_t thread_idx, void* user_data)
+{
+    DvzMeshChunk* chunk = (DvzMeshChunk*)user_data;
+    ASSERT(chunk != NULL);
+    DvzMesh* mesh = chunk->mesh;
+    DvzGraphicsMeshVertex* vertex = NULL;
+    for (uint32_t i = (uint32_t)first; i < first + count; i++)
+    {
+        vertex = dvz_array_item(&mesh->vertices, i);
+        transform_pos(mesh, vertex->pos);
+        transform_normal(chunk->normal_tr, vertex->normal);
+    }
+}
+
+
+
+// Compute the normals of a range of faces.
+static void
+_face_normals_chunk(uint64_t first, uint64_t count, uint32_t thread_idx, void* user_data)
+{
+    DvzMeshChunk* chunk = (DvzMeshChunk*)user_data;
+    ASSERT(chunk != NULL);
+    ASSERT(chunk->face_normals != NULL);
+    DvzMesh* mesh = chunk->mesh;
+
+    DvzIndex* indices = (DvzIndex*)mesh->indices.data;
+    DvzGraphicsMeshVertex* vertices = (DvzGraphicsMeshVertex*)mesh->vertices.data;
+    DvzGraphicsMeshVertex *v0, *v1, *v2;
+    vec3 u, v;
+    for (uint32_t i = (uint32_t)first; i < first + count; i++)
+    {
+        v0 = &vertices[indices[3 * i + 0]];
+        v1 = &vertices[indices[3 * i + 1]];
+        v2 = &vertices[indices[3 * i + 2]];
+
+        glm_vec3_sub(v1->pos, v0->pos, u);
+        glm_vec3_sub(v2->pos, v0->pos, v);
+        // normalized vector orthogonal to the face
+        glm_vec3_crossn(u, v, chunk->face_normals[i]);
+    }
+}
+
+
+
+// Accumulate the normals of the faces touching a range of vertices, in the face order, and
+// normalize them.
+static void _normals_chunk(uint64_t first, uint64_t count, uint32_t thread_idx, void* user_data)
+{
+    DvzMeshChunk* chunk = (DvzMeshChunk*)user_data;
+    ASSERT(chunk != NULL);
+    ASSERT(chunk->face_offsets != NULL);
+    ASSERT(chunk->vertex_faces != NULL);
+    DvzGraphicsMeshVertex* vertices = (DvzGraphicsMeshVertex*)chunk->mesh->vertices.data;
+
+    for (uint32_t i = (uint32_t)first; i < first + count; i++)
+    {
+        for (uint32_t j = chunk->face_offsets[i]; j < chunk->face_offsets[i + 1]; j++)
+            glm_vec3_add(
+                vertices[i].normal, chunk->face_normals[chunk->vertex_faces[j]],
+                vertices[i].normal);
+
+        // Normalize all normals since every vertex might contain the sum of many normals.
+        glm_vec3_normalize(vertices[i].normal);
+    }
+}
+
+
+
+// Build the lists of the faces touching each vertex, in the face order: the faces of vertex i are
+// vertex_faces[face_offsets[i]] to vertex_faces[face_offsets[i + 1] - 1].
+static void _vertex_faces(DvzMesh* mesh, uint32_t* face_offsets, uint32_t* vertex_faces)
+{
+    ASSERT(mesh != NULL);
+    ASSERT(face_offsets != NULL);
+    ASSERT(vertex_faces != NULL);
+
+    DvzIndex* indices = (DvzIndex*)mesh->indices.data;
+    uint32_t vertex_count = mesh->vertices.item_count;
+    uint32_t index_count = 3 * (mesh->indices.item_count / 3);
+
+    // Number of faces per vertex, then prefix sum.
+    memset(face_offsets, 0, (vertex_count + 1) * sizeof(uint32_t));
+    for (uint32_t k = 0; k < index_count; k++)
+    {
+        ASSERT(indices[k] < vertex_count);
+        face_offsets[indices[k] + 1]++;
+    }
+    for (uint32_t i = 0; i < vertex_count; i++)
+        face_offsets[i + 1] += face_offsets[i];
+
+    // Go through the faces in order, so that each list is sorted.
+    uint32_t* cursor = calloc(vertex_count > 0 ? vertex_count : 1, sizeof(uint32_t));
+    ASSERT(cursor != NULL);
+    DvzIndex idx = 0;
+    for (uint32_t k = 0; k < index_count; k++)
+    {
+        idx = indices[k];
+        vertex_faces[face_offsets[idx] + cursor[idx]++] = k / 3;
+    }
+    FREE(cursor);
+}
+
+
+
+/*************************************************************************************************/
+/*  Mesh transformation                                                                          */
+/*************************************************************************************************/
+
 void dvz_mesh_transform_reset(DvzMesh* mesh) { glm_mat4_identity(mesh->transform); }
 
 
@@ -86,13 +219,12 @@ void dvz_mesh_rotate(DvzMesh* mesh, float angle, vec3 axis)
 void dvz_mesh_transform(DvzMesh* mesh)
 {
     ASSERT(mesh != NULL);
-    DvzGraphicsMeshVertex* vertex = NULL;
-    for (uint32_t i = 0; i < mesh->vertices.item_count; i++)
-    {
-        vertex = dvz_array_item(&mesh->vertices, i);
-        transform_pos(mesh, vertex->pos);
-        transform_normal(mesh, vertex->normal);
-    }
+    DvzMeshChunk chunk = {0};
+    chunk.mesh = mesh;
+    normal_matrix(mesh, chunk.normal_tr);
+    dvz_parallel(
+        mesh->vertices.item_count, DVZ_MESH_THREAD_MIN, DVZ_MESH_THREADS, _transform_chunk,
+        &chunk);
 }
 
 
@@ -149,43 +281,27 @@ void dvz_mesh_normals(DvzMesh* mesh)
 {
     ASSERT(mesh != NULL);
     log_debug("recompute mesh normals");
-
-    DvzIndex i0, i1, i2;
-    DvzGraphicsMeshVertex *v0, *v1, *v2;
-    vec3 u, v, n;
-
     uint32_t vertex_count = mesh->vertices.item_count;
     uint32_t face_count = mesh->indices.item_count / 3;
 
-    // Go through all triangle faces.
-    for (uint32_t i = 0; i < face_count; i++)
-    {
-        i0 = ((DvzIndex*)mesh->indices.data)[3 * i + 0];
-        i1 = ((DvzIndex*)mesh->indices.data)[3 * i + 1];
-        i2 = ((DvzIndex*)mesh->indices.data)[3 * i + 2];
-
-        v0 = &((DvzGraphicsMeshVertex*)mesh->vertices.data)[i0];
-        v1 = &((DvzGraphicsMeshVertex*)mesh->vertices.data)[i1];
-        v2 = &((DvzGraphicsMeshVertex*)mesh->vertices.data)[i2];
-
-        glm_vec3_sub(v1->pos, v0->pos, u);
-        glm_vec3_sub(v2->pos, v0->pos, v);
-        // n is the normalized vector orthogonal to the current face
-        glm_vec3_crossn(u, v, n);
-
-        // Add the face normal to the current vertex normal.
-        glm_vec3_add(v0->normal, n, v0->normal);
-        glm_vec3_add(v1->normal, n, v1->normal);
-        glm_vec3_add(v2->normal, n, v2->normal);
-    }
-
-    // Normalize all normals since every vertex might contain the sum of many normals.
-    vec3* normal = NULL;
-    for (uint32_t i = 0; i < vertex_count; i++)
-    {
-        normal = &((DvzGraphicsMeshVertex*)dvz_array_item(&mesh->vertices, i))->normal;
-        glm_vec3_normalize(*normal);
-    }
+    // The faces are split between the threads to compute their normals, then the vertices are
+    // split between the threads to sum the normals of their faces, so that there is no race.
+    DvzMeshChunk chunk = {0};
+    chunk.mesh = mesh;
+    chunk.face_normals = calloc(face_count > 0 ? face_count : 1, sizeof(vec3));
+    chunk.face_offsets = calloc(vertex_count + 1, sizeof(uint32_t));
+    chunk.vertex_faces = calloc(face_count > 0 ? 3 * face_count : 1, sizeof(uint32_t));
+    ASSERT(chunk.face_normals != NULL);
+    ASSERT(chunk.face_offsets != NULL);
+    ASSERT(chunk.vertex_faces != NULL);
+
+    _vertex_faces(mesh, chunk.face_offsets, chunk.vertex_faces);
+    dvz_parallel(face_count, DVZ_MESH_THREAD_MIN, DVZ_MESH_THREADS, _face_normals_chunk, &chunk);
+    dvz_parallel(vertex_count, DVZ_MESH_THREAD_MIN, DVZ_MESH_THREADS, _normals_chunk, &chunk);
+
+    FREE(chunk.face_normals);
+    FREE(chunk.face_offsets);
+    FREE(chunk.vertex_faces);
 }
 
 
@@ -293,11 +409,13 @@ dvz_mesh_grid(uint32_t row_count, uint32_t col_count, const vec3* positions, con
     }
 
     // Second pass for the transformation.
+    mat4 tr;
+    normal_matrix(&mesh, tr);
     for (uint32_t i = 0; i < nv; i++)
     {
         vertex = &vertices[first_vertex + i];
         transform_pos(&mesh, vertex->pos);
-        transform_normal(&mesh, vertex->normal);
+        transform_normal(tr, vertex->normal);
     }
 
     return mesh;
@@ -396,10 +514,12 @@ DvzMesh dvz_mesh_cube()
         {{-x, +x, -x}, {0, +1, 0}, {0, 0}, 255}, //
         {{-x, +x, +x}, {0, +1, 0}, {0, 1}, 255}, //
     };
+    mat4 tr;
+    normal_matrix(&mesh, tr);
     for (uint32_t i = 0; i < nv; i++)
     {
         transform_pos(&mesh, vertices[i].pos);
-        transform_normal(&mesh, vertices[i].normal);
+        transform_normal(tr, vertices[i].normal);
     }
     memcpy(vertex, vertices, sizeof(vertices));
     return mesh;
@@ -507,10 +627,12 @@ DvzMesh dvz_mesh_square()
         {{-x, +x, 0}, {0, 0, +1}, {0, 0}, 255}, //
         {{-x, -x, 0}, {0, 0, +1}, {0, 1}, 255}, //
     };
+    mat4 tr;
+    normal_matrix(&mesh, tr);
     for (uint32_t i = 0; i < nv; i++)
     {
         transform_pos(&mesh, vertices[i].pos);
-        transform_normal(&mesh, vertices[i].normal);
+        transform_normal(tr, vertices[i].normal);
     }
     memcpy(vertex, vertices, sizeof(vertices));
     return mesh;
@@ -543,8 +665,10 @@ DvzMesh dvz_mesh_disc(uint32_t count)
     _vec3_copy(normal, vertex->normal);
     vertex->uv[0] = 0.5;
     vertex->uv[1] = 0;
+    mat4 tr;
+    normal_matrix(&mesh, tr);
     transform_pos(&mesh, vertex->pos);
-    transform_normal(&mesh, vertex->normal);
+    transform_normal(tr, vertex->normal);
 
     // Transform, colors, indices.
     for (uint32_t i = 0; i < count; i++)
@@ -569,7 +693,7 @@ DvzMesh dvz_mesh_disc(uint32_t count)
 
         // Transform.
         transform_pos(&mesh, vertex->pos);
-        transform_normal(&mesh, vertex->normal);
+        transform_normal(tr, vertex->normal);
 
         // Indices.
         memcpy(
@@ -587,6 +711,189 @@ DvzMesh dvz_mesh_disc(uint32_t count)
 void dvz_mesh_destroy(DvzMesh* mesh)
 {
     ASSERT(mesh != NULL);
+    // The arrays of a mesh loaded from a file point to the file mapping.
+    if (mesh->file != NULL)
+    {
+        mesh->vertices.data = NULL;
+        mesh->indices.data = NULL;
+        dvz_npy_destroy(mesh->file);
+        mesh->file = NULL;
+    }
     dvz_array_destroy(&mesh->vertices);
     dvz_array_destroy(&mesh->indices);
 }
+
+
+
+/*************************************************************************************************/
+/*  Binary mesh cache                                                                            */
+/*************************************************************************************************/
+
+#define DVZ_MESH_CACHE_MAGIC   0x48534d44 // "DMSH"
+#define DVZ_MESH_CACHE_VERSION 2
+
+typedef struct DvzMeshCacheHeader DvzMeshCacheHeader;
+
+struct DvzMeshCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_size; // size of DvzGraphicsMeshVertex, to detect layout changes
+    uint32_t index_size;
+    uint64_t vertex_count;
+    uint64_t index_count;
+
+    // Source file of the mesh, to detect changes, or 0.
+    uint64_t source_size;
+    int64_t source_mtime;
+};
+
+
+
+// Write the mesh to a temporary file renamed at the end, so that the file is never seen half
+// written, for example by another process loading the same cache.
+static int _mesh_save(DvzMesh* mesh, const char* path, DvzMeshCacheHeader* header)
+{
+    ASSERT(mesh != NULL);
+    ASSERT(path != NULL);
+    ASSERT(header != NULL);
+
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* fp = fopen(tmp_path, "wb");
+    if (fp == NULL)
+    {
+        log_error("unable to write the mesh file %s", path);
+        return 1;
+    }
+    header->magic = DVZ_MESH_CACHE_MAGIC;
+    header->version = DVZ_MESH_CACHE_VERSION;
+    header->vertex_size = sizeof(DvzGraphicsMeshVertex);
+    header->index_size = sizeof(DvzIndex);
+    header->vertex_count = mesh->vertices.item_count;
+    header->index_count = mesh->indices.item_count;
+
+    bool ok = fwrite(header, sizeof(DvzMeshCacheHeader), 1, fp) == 1;
+    if (ok && header->vertex_count > 0)
+        ok = fwrite(mesh->vertices.data, header->vertex_size, header->vertex_count, fp) ==
+             header->vertex_count;
+    if (ok && header->index_count > 0)
+        ok = fwrite(mesh->indices.data, header->index_size, header->index_count, fp) ==
+             header->index_count;
+    ok = fclose(fp) == 0 && ok;
+
+#if OS_WIN32
+    // NOTE: rename() does not replace an existing file on Windows.
+    if (ok)
+        remove(path);
+#endif
+    if (!ok || rename(tmp_path, path) != 0)
+    {
+        log_error("unable to write the mesh file %s", path);
+        remove(tmp_path);
+        return 1;
+    }
+    return 0;
+}
+
+
+
+static DvzMesh _mesh_load(const char* path, DvzMeshCacheHeader* header)
+{
+    ASSERT(path != NULL);
+    ASSERT(header != NULL);
+    DvzMesh mesh = dvz_mesh();
+
+    DvzNpy* file = dvz_npy_raw(path, DVZ_DTYPE_CHAR, 0);
+    if (file == NULL)
+        return mesh;
+
+    memset(header, 0, sizeof(DvzMeshCacheHeader));
+    if (file->size >= sizeof(DvzMeshCacheHeader))
+        memcpy(header, file->data, sizeof(DvzMeshCacheHeader));
+    // NOTE: the counts are checked first, so that the sizes below do not overflow.
+    bool ok = header->magic == DVZ_MESH_CACHE_MAGIC &&
+              header->version == DVZ_MESH_CACHE_VERSION &&
+              header->vertex_size == sizeof(DvzGraphicsMeshVertex) &&
+              header->index_size == sizeof(DvzIndex) && header->vertex_count <= UINT32_MAX &&
+              header->index_count <= UINT32_MAX;
+    uint64_t vertex_bytes = ok ? header->vertex_count * sizeof(DvzGraphicsMeshVertex) : 0;
+    uint64_t index_bytes = ok ? header->index_count * sizeof(DvzIndex) : 0;
+    if (!ok || file->size != sizeof(DvzMeshCacheHeader) + vertex_bytes + index_bytes)
+    {
+        log_warn("invalid mesh file %s", path);
+        dvz_npy_destroy(file);
+        return mesh;
+    }
+
+    // The arrays point to the mapping, which is destroyed with the mesh.
+    uint8_t* data = (uint8_t*)file->data + sizeof(DvzMeshCacheHeader);
+    if (header->vertex_count > 0)
+    {
+        mesh.vertices.data = data;
+        mesh.vertices.item_count = (uint32_t)header->vertex_count;
+        mesh.vertices.buffer_size = vertex_bytes;
+    }
+    if (header->index_count > 0)
+    {
+        mesh.indices.data = data + vertex_bytes;
+        mesh.indices.item_count = (uint32_t)header->index_count;
+        mesh.indices.buffer_size = index_bytes;
+    }
+    mesh.file = file;
+    return mesh;
+}
+
+
+
+int dvz_mesh_save(DvzMesh* mesh, const char* path)
+{
+    DvzMeshCacheHeader header = {0};
+    return _mesh_save(mesh, path, &header);
+}
+
+
+
+DvzMesh dvz_mesh_load(const char* path)
+{
+    DvzMeshCacheHeader header = {0};
+    return _mesh_load(path, &header);
+}
+
+
+
+DvzMesh dvz_mesh_obj_cached(const char* file_path)
+{
+    ASSERT(file_path != NULL);
+    char cache_path[1024];
+    snprintf(cache_path, sizeof(cache_path), "%s.dvzmesh", file_path);
+
+    // Use the cache if the OBJ file has not changed since the cache was written.
+    DvzMeshCacheHeader header = {0};
+    struct stat obj_stat = {0}, cache_stat = {0};
+    bool has_obj = stat(file_path, &obj_stat) == 0;
+    if (stat(cache_path, &cache_stat) == 0)
+    {
+        DvzMesh mesh = _mesh_load(cache_path, &header);
+        if (mesh.vertices.item_count > 0 &&
+            (!has_obj || (header.source_size == (uint64_t)obj_stat.st_size &&
+                          header.source_mtime == (int64_t)obj_stat.st_mtime)))
+        {
+            log_debug("loaded mesh cache %s", cache_path);
+            return mesh;
+        }
+        log_debug("mesh cache %s is out of date", cache_path);
+        dvz_mesh_destroy(&mesh);
+    }
+
+    DvzMesh mesh = dvz_mesh_obj(file_path);
+    if (mesh.vertices.item_count > 0 && has_obj)
+    {
+        log_debug("saving mesh cache %s", cache_path);
+        memset(&header, 0, sizeof(header));
+        header.source_size = (uint64_t)obj_stat.st_size;
+        header.source_mtime = (int64_t)obj_stat.st_mtime;
+        _mesh_save(&mesh, cache_path, &header);
+    }
+    return mesh;
+}
@@ -1,10 +1,39 @@
 #include "../include/datoviz/mesh.h"
 
+#include <unordered_map>
+
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
 
 
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+// An OBJ vertex is a combination of position, normal and texture coordinate indices.
+struct ObjVertexKey
+{
+    int v, n, t;
+    bool operator==(const ObjVertexKey& other) const
+    {
+        return v == other.v && n == other.n && t == other.t;
+    }
+};
+
+struct ObjVertexHash
+{
+    size_t operator()(const ObjVertexKey& key) const
+    {
+        uint64_t h = (uint64_t)(uint32_t)key.v;
+        h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uint32_t)key.n;
+        h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uint32_t)key.t;
+        return (size_t)(h ^ (h >> 32));
+    }
+};
+
+
+
 /*************************************************************************************************/
 /*  Tiny Obj loader                                                                              */
 /*************************************************************************************************/
@@ -21,7 +50,8 @@ DvzMesh dvz_mesh_obj(const char* file_path)
     std::string warn;
     std::string err;
 
-    // Load the file.
+    // Load the file, polygonal faces are triangulated by the loader, which also handles concave
+    // polygons.
     bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, file_path);
     if (!warn.empty())
         log_warn(warn.c_str());
@@ -33,128 +63,121 @@ DvzMesh dvz_mesh_obj(const char* file_path)
         return mesh;
     }
 
-    // Number of vertices.
-    uint32_t nv = attrib.vertices.size() / 3; // 3 floats per vertex
-    ASSERT(nv > 0);
-
-    // Number of indices.
-    uint32_t ni = 0;
-
-    // Number of shapes in the OBJ file.
-    uint32_t ns = shapes.size();
+    size_t nv_obj = attrib.vertices.size() / 3;
+    size_t nn_obj = attrib.normals.size() / 3;
+    size_t nt_obj = attrib.texcoords.size() / 2;
+    size_t nc_obj = attrib.colors.size() / 3;
+    ASSERT(nv_obj > 0);
 
     // Count the number of indices.
-    // TODO: do not count in a first pass, use C++ resizable containers directly.
-    uint32_t s, f, fv, v;
-    for (s = 0; s < ns; s++) // loop over shapes
+    uint32_t ns = shapes.size();
+    uint32_t s = 0, f = 0, fv = 0, v = 0;
+    size_t ni = 0;
+    for (s = 0; s < ns; s++)
     {
-        for (f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) // loop over faces
+        for (f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++)
         {
-            fv = shapes[s].mesh.num_face_vertices[f]; // number of indices per face
-            // NOTE: Only triangle faces for now.
-            if (fv != 3)
-            {
-                log_error("non-triangular OBJ faces (%d vertices) not yet implemented", fv);
-                continue;
-            }
-            ni += fv;
+            // NOTE: the loader skips the faces with less than 3 vertices.
+            fv = shapes[s].mesh.num_face_vertices[f];
+            ASSERT(fv == 3);
+            ni += 3;
         }
     }
     ASSERT(ni > 0);
-    log_debug("loading shape %d: %d shape(s), %d vertices, %d indices", s, ns, nv, ni);
 
-    // Create the mesh object and allocate the vertex and index arrays.
-    dvz_array_resize(&mesh.vertices, nv);
-    dvz_array_resize(&mesh.indices, ni);
-
-    // Pointers to the current vertex and index.
-    DvzGraphicsMeshVertex* vertex = (DvzGraphicsMeshVertex*)mesh.vertices.data;
+    // The vertex array may be larger than the number of positions, as the same position may have
+    // several normals or texture coordinates.
+    std::unordered_map<ObjVertexKey, DvzIndex, ObjVertexHash> vertex_map;
+    vertex_map.reserve(nv_obj);
+    std::vector<DvzGraphicsMeshVertex> vertices;
+    vertices.reserve(nv_obj);
+    dvz_array_resize(&mesh.indices, (uint32_t)ni);
     DvzIndex* index = (DvzIndex*)mesh.indices.data;
-
-    ASSERT(vertex != NULL);
     ASSERT(index != NULL);
 
-    // Loop over shapes
-    uint32_t i, index_offset, nf;
+    bool has_normals = true;
+    uint32_t index_offset = 0;
     tinyobj::index_t idx;
-    cvec3 color;
-
-    // Vertices
-    log_debug("loading %d vertices", nv);
-    size_t nv_obj = attrib.vertices.size();
-    size_t nn_obj = attrib.normals.size();
-    size_t nt_obj = attrib.texcoords.size();
-    size_t nc_obj = attrib.colors.size();
-
-    for (i = 0; i < nv; i++)
-    {
-        // Vertex position.
-        ASSERT(3 * i + 2 < nv_obj);
-        vertex->pos[0] = attrib.vertices[3 * i + 0];
-        vertex->pos[1] = attrib.vertices[3 * i + 1];
-        vertex->pos[2] = attrib.vertices[3 * i + 2];
-
-        // Vertex normal.
-        ASSERT(3 * i + 2 < nn_obj);
-        vertex->normal[0] = attrib.normals[3 * i + 0];
-        vertex->normal[1] = attrib.normals[3 * i + 1];
-        vertex->normal[2] = attrib.normals[3 * i + 2];
-
-        // Vertex tex coords.
-        if (nt_obj > 0)
-        {
-            ASSERT(2 * i + 1 < nt_obj);
-            vertex->uv[0] = attrib.texcoords[2 * i + 0];
-            vertex->uv[1] = attrib.texcoords[2 * i + 1];
-        }
-        else if (nc_obj > 0)
-        {
-            color[0] = TO_BYTE(attrib.colors[3 * i + 0]);
-            color[1] = TO_BYTE(attrib.colors[3 * i + 1]);
-            color[2] = TO_BYTE(attrib.colors[3 * i + 2]);
-            dvz_colormap_packuv(color, vertex->uv);
-        }
-
-        // Alpha value.
-        vertex->alpha = 255;
-
-        // Go to next vertex.
-        vertex++;
-    }
-    ASSERT(
-        (int64_t)vertex - (int64_t)mesh.vertices.data ==
-        (int64_t)(nv * sizeof(DvzGraphicsMeshVertex)));
-
-    // Shapes.
+    DvzGraphicsMeshVertex vertex = {0};
+    cvec3 color = {0};
     for (s = 0; s < ns; s++)
     {
-        // Faces.
+        const tinyobj::mesh_t& shape = shapes[s].mesh;
         index_offset = 0;
-        nf = shapes[s].mesh.num_face_vertices.size(); // number of faces in the current shape
-        log_debug("shape #%d: loading %d indices", s, nf);
-
-        for (f = 0; f < nf; f++) // loop over faces
+        log_debug("shape #%d: loading %d faces", s, (uint32_t)shape.num_face_vertices.size());
+        for (f = 0; f < shape.num_face_vertices.size(); f++)
         {
-            fv = shapes[s].mesh.num_face_vertices[f]; // number of vertices in the face
-
-            // HACK: skip non-triangular faces for now (need to be triangulated)
-            if (fv != 3)
-                continue;
-
-            // Indices in each face.
+            fv = shape.num_face_vertices[f];
             for (v = 0; v < fv; v++)
             {
-                idx = shapes[s].mesh.indices[index_offset + v];
-                *index = (DvzIndex)idx.vertex_index;
-                index++;
+                idx = shape.indices[index_offset + v];
+                ASSERT(0 <= idx.vertex_index && (size_t)idx.vertex_index < nv_obj);
+                ObjVertexKey key = {idx.vertex_index, idx.normal_index, idx.texcoord_index};
+                auto it = vertex_map.find(key);
+                if (it != vertex_map.end())
+                {
+                    index[v] = it->second;
+                }
+                else
+                {
+                    memset(&vertex, 0, sizeof(vertex));
+
+                    // Vertex position.
+                    memcpy(vertex.pos, &attrib.vertices[3 * idx.vertex_index], sizeof(vec3));
+
+                    // Vertex normal, computed from the faces if missing.
+                    if (0 <= idx.normal_index && (size_t)idx.normal_index < nn_obj)
+                        memcpy(
+                            vertex.normal, &attrib.normals[3 * idx.normal_index], sizeof(vec3));
+                    else
+                        has_normals = false;
+
+                    // Vertex tex coords.
+                    if (0 <= idx.texcoord_index && (size_t)idx.texcoord_index < nt_obj)
+                    {
+                        vertex.uv[0] = attrib.texcoords[2 * idx.texcoord_index + 0];
+                        vertex.uv[1] = attrib.texcoords[2 * idx.texcoord_index + 1];
+                    }
+                    else if (nt_obj == 0 && (size_t)idx.vertex_index < nc_obj)
+                    {
+                        color[0] = TO_BYTE(attrib.colors[3 * idx.vertex_index + 0]);
+                        color[1] = TO_BYTE(attrib.colors[3 * idx.vertex_index + 1]);
+                        color[2] = TO_BYTE(attrib.colors[3 * idx.vertex_index + 2]);
+                        dvz_colormap_packuv(color, vertex.uv);
+                    }
+
+                    // Alpha value.
+                    vertex.alpha = 255;
+
+                    index[v] = (DvzIndex)vertices.size();
+                    vertex_map.emplace(key, index[v]);
+                    vertices.push_back(vertex);
+                }
             }
+            index += fv;
             index_offset += fv;
         }
     }
     ASSERT((int64_t)index - (int64_t)mesh.indices.data == (int64_t)(ni * sizeof(DvzIndex)));
 
+    uint32_t nv = (uint32_t)vertices.size();
+    log_debug("loaded %d shape(s), %d vertices, %d indices", ns, nv, (uint32_t)ni);
+    dvz_array_resize(&mesh.vertices, nv);
+    memcpy(mesh.vertices.data, vertices.data(), nv * sizeof(DvzGraphicsMeshVertex));
+
     // Mesh normalization.
     dvz_mesh_normalize(&mesh);
 
+    // Compute the missing normals once here, rather than every time the mesh visual is baked.
+    // NOTE: the face normals are added to the existing normals, which must be reset first.
+    if (!has_normals)
+    {
+        log_debug("no normals in the OBJ file, computing them from the faces");
+        DvzGraphicsMeshVertex* vertex_ptr = (DvzGraphicsMeshVertex*)mesh.vertices.data;
+        for (uint32_t i = 0; i < nv; i++)
+            memset(vertex_ptr[i].normal, 0, sizeof(vec3));
+        dvz_mesh_normals(&mesh);
+    }
+
     return mesh;
 }
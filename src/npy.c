@@ -0,0 +1,470 @@
+#include <inttypes.h>
+
+#include "../include/datoviz/npy.h"
+
+#if !OS_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+static const char NPY_MAGIC[] = "\x93NUMPY";
+#define NPY_MAGIC_SIZE 6
+
+
+
+// Map a whole file in memory, or read it on platforms without mmap().
+static int _npy_map(DvzNpy* npy, const char* path)
+{
+    ASSERT(npy != NULL);
+    ASSERT(path != NULL);
+
+#if !OS_WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        log_error("could not open %s", path);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        log_error("could not determine the size of %s", path);
+        close(fd);
+        return 1;
+    }
+    npy->map_size = (VkDeviceSize)st.st_size;
+    if (npy->map_size > 0)
+    {
+        // NOTE: the mapping remains valid after the file descriptor is closed. It is private and
+        // copy-on-write, so that the data can be modified in place without changing the file.
+        void* map = mmap(NULL, npy->map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            log_error("could not map %s in memory", path);
+            close(fd);
+            return 1;
+        }
+        // The payload is typically read once, from the beginning to the end.
+        madvise(map, npy->map_size, MADV_SEQUENTIAL);
+        npy->map = map;
+        npy->is_mapped = true;
+    }
+    close(fd);
+#else
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        log_error("could not open %s", path);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    npy->map_size = (VkDeviceSize)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (npy->map_size > 0)
+    {
+        npy->map = malloc(npy->map_size);
+        ASSERT(npy->map != NULL);
+        if (fread(npy->map, 1, npy->map_size, f) != npy->map_size)
+        {
+            log_error("could not read %s", path);
+            fclose(f);
+            return 1;
+        }
+    }
+    fclose(f);
+#endif
+
+    log_trace("opened %s (%s)", path, pretty_size(npy->map_size));
+    return 0;
+}
+
+
+
+static void _npy_unmap(DvzNpy* npy)
+{
+    ASSERT(npy != NULL);
+    if (npy->map == NULL)
+        return;
+#if !OS_WIN32
+    munmap(npy->map, npy->map_size);
+#else
+    FREE(npy->map);
+#endif
+    npy->map = NULL;
+    npy->is_mapped = false;
+}
+
+
+
+// Return a pointer to the value of a key in the header dictionary, or NULL.
+static const char* _header_value(const char* header, const char* key)
+{
+    ASSERT(header != NULL);
+    ASSERT(key != NULL);
+    char quoted[32] = {0};
+    snprintf(quoted, sizeof(quoted), "'%s'", key);
+    const char* s = strstr(header, quoted);
+    if (s == NULL)
+        return NULL;
+    s = strchr(s + strlen(quoted), ':');
+    if (s == NULL)
+        return NULL;
+    s++;
+    while (*s == ' ')
+        s++;
+    return s;
+}
+
+
+
+// Parse the dtype description, either a quoted string like '<f4' or a list of fields.
+static int _parse_descr(DvzNpy* npy, const char* value)
+{
+    ASSERT(npy != NULL);
+    ASSERT(value != NULL);
+
+    const char* end = NULL;
+    if (*value == '\'')
+    {
+        value++;
+        end = strchr(value, '\'');
+    }
+    else if (*value == '[')
+    {
+        // Structured dtype: keep the description up to the matching bracket.
+        int depth = 0;
+        for (end = value; *end != 0; end++)
+        {
+            depth += (*end == '[') - (*end == ']');
+            if (depth == 0)
+            {
+                end++;
+                break;
+            }
+        }
+    }
+    if (end == NULL || end == value || end - value >= DVZ_NPY_DESCR_SIZE)
+        return 1;
+    memcpy(npy->descr, value, (size_t)(end - value));
+    npy->descr[end - value] = 0;
+
+    // The payload is used as is, so it must be in the byte order of the host.
+    if (strchr(npy->descr, '>') != NULL)
+    {
+        log_error("big-endian dtype %s is not supported", npy->descr);
+        return 1;
+    }
+
+    npy->dtype = DVZ_DTYPE_CUSTOM;
+    if (npy->descr[0] == '[')
+        return 0;
+
+    // Simple dtype: byte order, kind, and size in bytes.
+    char kind = npy->descr[1];
+    int size = atoi(&npy->descr[2]);
+    if (size <= 0)
+        return 1;
+    npy->item_size = (VkDeviceSize)size;
+    switch (kind)
+    {
+    case 'b':
+    case 'i':
+    case 'u':
+        if (size == 1)
+            npy->dtype = DVZ_DTYPE_CHAR;
+        else if (size == 2)
+            npy->dtype = kind == 'u' ? DVZ_DTYPE_USHORT : DVZ_DTYPE_SHORT;
+        else if (size == 4)
+            npy->dtype = kind == 'u' ? DVZ_DTYPE_UINT : DVZ_DTYPE_INT;
+        break;
+    case 'f':
+        if (size == 4)
+            npy->dtype = DVZ_DTYPE_FLOAT;
+        else if (size == 8)
+            npy->dtype = DVZ_DTYPE_DOUBLE;
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+
+
+// Parse the shape tuple, like (10, 3) or ().
+static int _parse_shape(DvzNpy* npy, const char* value)
+{
+    ASSERT(npy != NULL);
+    ASSERT(value != NULL);
+    if (*value != '(')
+        return 1;
+    value++;
+
+    npy->ndims = 0;
+    npy->item_count = 1;
+    char* end = NULL;
+    while (true)
+    {
+        while (*value == ' ' || *value == ',')
+            value++;
+        if (*value == ')')
+            break;
+        if (npy->ndims >= DVZ_NPY_MAX_DIMS)
+        {
+            log_error(
+                "NPY arrays with more than %d dimensions are not supported", DVZ_NPY_MAX_DIMS);
+            return 1;
+        }
+        uint64_t dim = strtoull(value, &end, 10);
+        if (end == value)
+            return 1;
+        npy->shape[npy->ndims++] = dim;
+        npy->item_count *= dim;
+        value = end;
+    }
+    return 0;
+}
+
+
+
+// Parse the NPY header at the beginning of the mapped file.
+static int _parse_header(DvzNpy* npy)
+{
+    ASSERT(npy != NULL);
+    const uint8_t* buf = (const uint8_t*)npy->map;
+
+    // Magic string and version.
+    if (npy->map_size < NPY_MAGIC_SIZE + 4 || memcmp(buf, NPY_MAGIC, NPY_MAGIC_SIZE) != 0)
+    {
+        log_error("invalid NPY magic string");
+        return 1;
+    }
+    npy->version = buf[NPY_MAGIC_SIZE];
+    if (npy->version < 1 || npy->version > 3)
+    {
+        log_error("unsupported NPY format version %d.%d", buf[6], buf[7]);
+        return 1;
+    }
+
+    // Header size: 16 bits in version 1, 32 bits in versions 2 and 3, little-endian.
+    VkDeviceSize header_len = 0;
+    VkDeviceSize prefix = 0;
+    if (npy->version == 1)
+    {
+        header_len = (VkDeviceSize)buf[8] | ((VkDeviceSize)buf[9] << 8);
+        prefix = 10;
+    }
+    else
+    {
+        if (npy->map_size < 12)
+            return 1;
+        header_len = (VkDeviceSize)buf[8] | ((VkDeviceSize)buf[9] << 8) |
+                     ((VkDeviceSize)buf[10] << 16) | ((VkDeviceSize)buf[11] << 24);
+        prefix = 12;
+    }
+    if (header_len == 0 || header_len > DVZ_NPY_MAX_HEADER || prefix + header_len > npy->map_size)
+    {
+        log_error("invalid NPY header size %d", (int)header_len);
+        return 1;
+    }
+    log_trace("npy file header size is %d bytes", (int)header_len);
+
+    // Null-terminated copy of the header dictionary.
+    char* header = calloc(header_len + 1, 1);
+    memcpy(header, buf + prefix, header_len);
+
+    int err = 0;
+    const char* value = _header_value(header, "descr");
+    if (value == NULL || _parse_descr(npy, value) != 0)
+    {
+        log_error("invalid NPY dtype description");
+        err = 1;
+        goto end;
+    }
+
+    value = _header_value(header, "fortran_order");
+    npy->fortran_order = value != NULL && strncmp(value, "True", 4) == 0;
+
+    value = _header_value(header, "shape");
+    if (value == NULL || _parse_shape(npy, value) != 0)
+    {
+        log_error("invalid NPY shape");
+        err = 1;
+        goto end;
+    }
+
+    // Payload.
+    npy->offset = prefix + header_len;
+    npy->size = npy->map_size - npy->offset;
+    if (npy->dtype == DVZ_DTYPE_CUSTOM && npy->descr[0] == '[')
+        npy->item_size = npy->item_count > 0 ? npy->size / npy->item_count : 0;
+    if (npy->item_count * npy->item_size > npy->size)
+    {
+        log_error("truncated NPY payload (%s)", pretty_size(npy->size));
+        err = 1;
+        goto end;
+    }
+    npy->size = npy->item_count * npy->item_size;
+
+end:
+    FREE(header);
+    return err;
+}
+
+
+
+// Return the page-aligned region of the mapping covering a region of the payload.
+static void* _npy_pages(DvzNpy* npy, VkDeviceSize offset, VkDeviceSize* size)
+{
+    ASSERT(npy != NULL);
+    ASSERT(size != NULL);
+#if !OS_WIN32
+    if (!npy->is_mapped || offset >= npy->size)
+        return NULL;
+    *size = MIN(*size, npy->size - offset);
+    VkDeviceSize page = (VkDeviceSize)sysconf(_SC_PAGESIZE);
+    VkDeviceSize start = npy->offset + offset;
+    VkDeviceSize aligned = start - (start % page);
+    *size += start - aligned;
+    return (uint8_t*)npy->map + aligned;
+#else
+    return NULL;
+#endif
+}
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+DvzNpy* dvz_npy(const char* path)
+{
+    ASSERT(path != NULL);
+    DvzNpy* npy = calloc(1, sizeof(DvzNpy));
+    if (_npy_map(npy, path) != 0 || _parse_header(npy) != 0)
+    {
+        log_error("unable to read the NPY file %s", path);
+        _npy_unmap(npy);
+        FREE(npy);
+        return NULL;
+    }
+    npy->data = (const uint8_t*)npy->map + npy->offset;
+    dvz_obj_created(&npy->obj);
+
+    log_debug(
+        "opened NPY file %s with dtype %s, %d dimension(s), %" PRIu64 " elements", path,
+        npy->descr, npy->ndims, npy->item_count);
+    return npy;
+}
+
+
+
+DvzNpy* dvz_npy_raw(const char* path, DvzDataType dtype, VkDeviceSize offset)
+{
+    ASSERT(path != NULL);
+    ASSERT(dtype != DVZ_DTYPE_NONE);
+    ASSERT(dtype != DVZ_DTYPE_CUSTOM);
+
+    DvzNpy* npy = calloc(1, sizeof(DvzNpy));
+    if (_npy_map(npy, path) != 0)
+    {
+        FREE(npy);
+        return NULL;
+    }
+    if (offset > npy->map_size)
+    {
+        log_error("the header of %s is larger than the file", path);
+        _npy_unmap(npy);
+        FREE(npy);
+        return NULL;
+    }
+
+    npy->dtype = dtype;
+    npy->item_size = _get_dtype_size(dtype);
+    ASSERT(npy->item_size > 0);
+    npy->offset = offset;
+    npy->item_count = (npy->map_size - offset) / npy->item_size;
+    npy->size = npy->item_count * npy->item_size;
+    if (npy->size < npy->map_size - offset)
+        log_warn("ignoring the trailing bytes of %s", path);
+    npy->ndims = 1;
+    npy->shape[0] = npy->item_count;
+    npy->data = npy->map != NULL ? (const uint8_t*)npy->map + offset : NULL;
+    dvz_obj_created(&npy->obj);
+    return npy;
+}
+
+
+
+const void* dvz_npy_item(DvzNpy* npy, uint64_t idx)
+{
+    ASSERT(npy != NULL);
+    ASSERT(idx < npy->item_count);
+    return (const uint8_t*)npy->data + idx * npy->item_size;
+}
+
+
+
+void dvz_npy_prefetch(DvzNpy* npy, VkDeviceSize offset, VkDeviceSize size)
+{
+    ASSERT(npy != NULL);
+    void* pages = _npy_pages(npy, offset, &size);
+    if (pages == NULL)
+        return;
+#if !OS_WIN32
+    madvise(pages, size, MADV_WILLNEED);
+#endif
+}
+
+
+
+void dvz_npy_release(DvzNpy* npy, VkDeviceSize offset, VkDeviceSize size)
+{
+    ASSERT(npy != NULL);
+    void* pages = _npy_pages(npy, offset, &size);
+    if (pages == NULL)
+        return;
+#if !OS_WIN32
+    // NOTE: the mapping is private, so the pages are dropped and read again from the file on the
+    // next access. Pages modified in place would lose their changes.
+    madvise(pages, size, MADV_DONTNEED);
+#endif
+}
+
+
+
+char* dvz_read_npy(const char* filename, size_t* size)
+{
+    /* The returned pointer must be freed by the caller. */
+    DvzNpy* npy = dvz_npy(filename);
+    if (npy == NULL)
+        return NULL;
+
+    char* buffer = calloc(npy->size > 0 ? npy->size : 1, 1);
+    ASSERT(buffer != NULL);
+    if (npy->size > 0)
+        memcpy(buffer, npy->data, npy->size);
+    if (size != NULL)
+        *size = npy->size;
+    dvz_npy_destroy(npy);
+    return buffer;
+}
+
+
+
+void dvz_npy_destroy(DvzNpy* npy)
+{
+    if (npy == NULL)
+        return;
+    _npy_unmap(npy);
+    dvz_obj_destroyed(&npy->obj);
+    FREE(npy);
+}
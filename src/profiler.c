@@ -0,0 +1,413 @@
+#include <inttypes.h>
+
+#include "../include/datoviz/profiler.h"
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+static inline DvzProfilerFrame* _current_frame(DvzProfiler* profiler)
+{
+    ASSERT(profiler != NULL);
+    return &profiler->frames[profiler->frame_count % DVZ_PROFILER_MAX_FRAMES];
+}
+
+
+
+static inline void _scope_name(char* dst, const char* name)
+{
+    ASSERT(dst != NULL);
+    ASSERT(name != NULL);
+    strncpy(dst, name, DVZ_PROFILER_NAME_SIZE - 1);
+    dst[DVZ_PROFILER_NAME_SIZE - 1] = 0;
+}
+
+
+
+// Find a recorded frame, the current one included, from the most recent.
+static DvzProfilerFrame* _find_frame(DvzProfiler* profiler, uint64_t frame_idx)
+{
+    ASSERT(profiler != NULL);
+    uint64_t n = profiler->frame_count + (profiler->in_frame ? 1 : 0);
+    DvzProfilerFrame* frame = NULL;
+    for (uint64_t i = 0; i < MIN(n, DVZ_PROFILER_MAX_FRAMES); i++)
+    {
+        frame = &profiler->frames[(n - 1 - i) % DVZ_PROFILER_MAX_FRAMES];
+        if (frame->frame_idx == frame_idx)
+            return frame;
+    }
+    return NULL;
+}
+
+
+
+static DvzProfilerScope* _add_scope(DvzProfilerFrame* frame, const char* name)
+{
+    ASSERT(frame != NULL);
+    if (frame->scope_count >= DVZ_PROFILER_MAX_SCOPES)
+        return NULL;
+    DvzProfilerScope* scope = &frame->scopes[frame->scope_count++];
+    memset(scope, 0, sizeof(DvzProfilerScope));
+    _scope_name(scope->name, name);
+    return scope;
+}
+
+
+
+static void _write_json_string(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for (; *s != 0; s++)
+    {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', f);
+        if ((unsigned char)*s >= 0x20)
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+
+
+/*************************************************************************************************/
+/*  Profiler                                                                                     */
+/*************************************************************************************************/
+
+DvzProfiler* dvz_profiler(void)
+{
+    DvzProfiler* profiler = calloc(1, sizeof(DvzProfiler));
+    profiler->frames = calloc(DVZ_PROFILER_MAX_FRAMES, sizeof(DvzProfilerFrame));
+    _clock_init(&profiler->clock);
+    dvz_obj_init(&profiler->obj);
+    dvz_obj_created(&profiler->obj);
+    return profiler;
+}
+
+
+
+double dvz_profiler_time(DvzProfiler* profiler)
+{
+    ASSERT(profiler != NULL);
+    return _clock_get(&profiler->clock);
+}
+
+
+
+void dvz_profiler_frame_begin(DvzProfiler* profiler, uint64_t frame_idx)
+{
+    if (profiler == NULL)
+        return;
+    if (profiler->in_frame)
+        dvz_profiler_frame_end(profiler);
+
+    DvzProfilerFrame* frame = _current_frame(profiler);
+    frame->frame_idx = frame_idx;
+    frame->scope_count = 0;
+    frame->start = dvz_profiler_time(profiler);
+    frame->end = frame->start;
+    profiler->depth = 0;
+    profiler->in_frame = true;
+}
+
+
+
+void dvz_profiler_frame_end(DvzProfiler* profiler)
+{
+    if (profiler == NULL)
+        return;
+    if (!profiler->in_frame)
+        return;
+    while (profiler->depth > 0)
+        dvz_profiler_end(profiler);
+
+    _current_frame(profiler)->end = dvz_profiler_time(profiler);
+    profiler->in_frame = false;
+    profiler->frame_count++;
+}
+
+
+
+void dvz_profiler_begin(DvzProfiler* profiler, const char* name)
+{
+    if (profiler == NULL)
+        return;
+    if (!profiler->in_frame)
+        return;
+    DvzProfilerFrame* frame = _current_frame(profiler);
+
+    // NOTE: when there are too many scopes, the scope is ignored but still counted in the stack
+    // so that the next dvz_profiler_end() closes the right scope.
+    uint32_t idx = UINT32_MAX;
+    DvzProfilerScope* scope = NULL;
+    if (profiler->depth < DVZ_PROFILER_MAX_DEPTH)
+        scope = _add_scope(frame, name);
+    if (scope != NULL)
+    {
+        scope->domain = DVZ_PROFILER_DOMAIN_CPU;
+        scope->depth = profiler->depth;
+        scope->start = dvz_profiler_time(profiler);
+        scope->end = scope->start;
+        idx = frame->scope_count - 1;
+    }
+    if (profiler->depth < DVZ_PROFILER_MAX_DEPTH)
+        profiler->stack[profiler->depth] = idx;
+    profiler->depth++;
+}
+
+
+
+void dvz_profiler_end(DvzProfiler* profiler)
+{
+    if (profiler == NULL)
+        return;
+    if (!profiler->in_frame || profiler->depth == 0)
+        return;
+    profiler->depth--;
+    if (profiler->depth >= DVZ_PROFILER_MAX_DEPTH)
+        return;
+    uint32_t idx = profiler->stack[profiler->depth];
+    if (idx == UINT32_MAX)
+        return;
+    DvzProfilerFrame* frame = _current_frame(profiler);
+    ASSERT(idx < frame->scope_count);
+    frame->scopes[idx].end = dvz_profiler_time(profiler);
+}
+
+
+
+void dvz_profiler_scope(
+    DvzProfiler* profiler, uint64_t frame_idx, DvzProfilerDomain domain, const char* name,
+    double start, double end)
+{
+    ASSERT(profiler != NULL);
+    DvzProfilerFrame* frame = _find_frame(profiler, frame_idx);
+    if (frame == NULL)
+        return;
+    DvzProfilerScope* scope = _add_scope(frame, name);
+    if (scope == NULL)
+        return;
+    scope->domain = domain;
+    scope->start = start;
+    scope->end = end;
+}
+
+
+
+uint32_t dvz_profiler_frame_count(DvzProfiler* profiler)
+{
+    ASSERT(profiler != NULL);
+    return (uint32_t)MIN(profiler->frame_count, DVZ_PROFILER_MAX_FRAMES);
+}
+
+
+
+DvzProfilerFrame* dvz_profiler_frame(DvzProfiler* profiler, uint32_t idx)
+{
+    ASSERT(profiler != NULL);
+    uint32_t n = dvz_profiler_frame_count(profiler);
+    ASSERT(idx < n);
+    return &profiler->frames[(profiler->frame_count - n + idx) % DVZ_PROFILER_MAX_FRAMES];
+}
+
+
+
+double dvz_profiler_stats(
+    DvzProfiler* profiler, DvzProfilerDomain domain, const char* name, double* max)
+{
+    ASSERT(profiler != NULL);
+    ASSERT(name != NULL);
+
+    double sum = 0, d = 0, m = 0;
+    uint32_t count = 0;
+    uint32_t n = dvz_profiler_frame_count(profiler);
+    DvzProfilerFrame* frame = NULL;
+    DvzProfilerScope* scope = NULL;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        frame = dvz_profiler_frame(profiler, i);
+        for (uint32_t j = 0; j < frame->scope_count; j++)
+        {
+            scope = &frame->scopes[j];
+            if (scope->domain != domain || strncmp(scope->name, name, DVZ_PROFILER_NAME_SIZE))
+                continue;
+            d = scope->end - scope->start;
+            sum += d;
+            m = MAX(m, d);
+            count++;
+        }
+    }
+    if (max != NULL)
+        *max = m;
+    return count > 0 ? sum / count : 0;
+}
+
+
+
+int dvz_profiler_export(DvzProfiler* profiler, const char* path)
+{
+    ASSERT(profiler != NULL);
+    ASSERT(path != NULL);
+
+    FILE* f = fopen(path, "w");
+    if (f == NULL)
+    {
+        log_error("unable to open %s for writing", path);
+        return 1;
+    }
+
+    // One track per domain, with the durations in microseconds.
+    fprintf(f, "{\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+               "\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,"
+               "\"args\":{\"name\":\"GPU\"}}");
+
+    uint32_t n = dvz_profiler_frame_count(profiler);
+    DvzProfilerFrame* frame = NULL;
+    DvzProfilerScope* scope = NULL;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        frame = dvz_profiler_frame(profiler, i);
+        fprintf(
+            f,
+            ",\n{\"name\":\"frame\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+            "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%" PRIu64 "}}",
+            frame->start * 1e6, (frame->end - frame->start) * 1e6, frame->frame_idx);
+
+        for (uint32_t j = 0; j < frame->scope_count; j++)
+        {
+            scope = &frame->scopes[j];
+            bool gpu = scope->domain == DVZ_PROFILER_DOMAIN_GPU;
+            fprintf(f, ",\n{\"name\":");
+            _write_json_string(f, scope->name);
+            fprintf(
+                f,
+                ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"frame\":%" PRIu64 "}}",
+                gpu ? "gpu" : "cpu", gpu ? 2 : 1, scope->start * 1e6,
+                (scope->end - scope->start) * 1e6, frame->frame_idx);
+        }
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    int res = ferror(f);
+    fclose(f);
+    if (res != 0)
+        log_error("error while writing %s", path);
+    else
+        log_debug("exported %d profiler frames to %s", n, path);
+    return res;
+}
+
+
+
+void dvz_profiler_destroy(DvzProfiler* profiler)
+{
+    if (profiler == NULL)
+        return;
+    FREE(profiler->frames);
+    dvz_obj_destroyed(&profiler->obj);
+    FREE(profiler);
+}
+
+
+
+/*************************************************************************************************/
+/*  GPU scopes                                                                                   */
+/*************************************************************************************************/
+
+uint32_t dvz_profiler_gpu_query(uint32_t img_idx, DvzProfilerCmds cmds, uint32_t scope, bool end)
+{
+    ASSERT(img_idx < DVZ_PROFILER_MAX_IMAGES);
+    ASSERT(cmds < DVZ_PROFILER_CMDS_COUNT);
+    ASSERT(scope < DVZ_PROFILER_GPU_SCOPES);
+    return ((img_idx * DVZ_PROFILER_CMDS_COUNT + cmds) * DVZ_PROFILER_GPU_SCOPES + scope) * 2 +
+           (end ? 1 : 0);
+}
+
+
+
+void dvz_profiler_gpu_reset(DvzProfiler* profiler, uint32_t img_idx, DvzProfilerCmds cmds)
+{
+    ASSERT(profiler != NULL);
+    ASSERT(img_idx < DVZ_PROFILER_MAX_IMAGES);
+    ASSERT(cmds < DVZ_PROFILER_CMDS_COUNT);
+    profiler->gpu_scopes[img_idx][cmds].count = 0;
+}
+
+
+
+uint32_t dvz_profiler_gpu_begin(
+    DvzProfiler* profiler, uint32_t img_idx, DvzProfilerCmds cmds, const char* name)
+{
+    ASSERT(profiler != NULL);
+    ASSERT(img_idx < DVZ_PROFILER_MAX_IMAGES);
+    ASSERT(cmds < DVZ_PROFILER_CMDS_COUNT);
+    DvzProfilerGpuScopes* scopes = &profiler->gpu_scopes[img_idx][cmds];
+    if (scopes->count >= DVZ_PROFILER_GPU_SCOPES)
+        return UINT32_MAX;
+    _scope_name(scopes->names[scopes->count], name);
+    return scopes->count++;
+}
+
+
+
+void dvz_profiler_gpu_submit(DvzProfiler* profiler, uint32_t img_idx)
+{
+    ASSERT(profiler != NULL);
+    ASSERT(img_idx < DVZ_PROFILER_MAX_IMAGES);
+    if (!profiler->in_frame)
+        return;
+    profiler->gpu_pending[img_idx] = true;
+    profiler->gpu_frame[img_idx] = _current_frame(profiler)->frame_idx;
+    profiler->gpu_submit[img_idx] = dvz_profiler_time(profiler);
+}
+
+
+
+void dvz_profiler_gpu_resolve(
+    DvzProfiler* profiler, uint32_t img_idx, const uint64_t* timestamps, double period)
+{
+    ASSERT(profiler != NULL);
+    ASSERT(img_idx < DVZ_PROFILER_MAX_IMAGES);
+    if (!profiler->gpu_pending[img_idx])
+        return;
+    profiler->gpu_pending[img_idx] = false;
+    if (timestamps == NULL)
+        return;
+
+    // Earliest timestamp of the submission, aligned on the CPU submission time.
+    uint64_t t0 = UINT64_MAX;
+    DvzProfilerGpuScopes* scopes = NULL;
+    uint32_t q = 0;
+    for (uint32_t c = 0; c < DVZ_PROFILER_CMDS_COUNT; c++)
+    {
+        scopes = &profiler->gpu_scopes[img_idx][c];
+        for (uint32_t k = 0; k < scopes->count; k++)
+        {
+            q = dvz_profiler_gpu_query(0, (DvzProfilerCmds)c, k, false);
+            t0 = MIN(t0, timestamps[q]);
+        }
+    }
+    if (t0 == UINT64_MAX)
+        return;
+
+    double t_submit = profiler->gpu_submit[img_idx];
+    uint64_t frame_idx = profiler->gpu_frame[img_idx];
+    double start = 0, end = 0;
+    for (uint32_t c = 0; c < DVZ_PROFILER_CMDS_COUNT; c++)
+    {
+        scopes = &profiler->gpu_scopes[img_idx][c];
+        for (uint32_t k = 0; k < scopes->count; k++)
+        {
+            q = dvz_profiler_gpu_query(0, (DvzProfilerCmds)c, k, false);
+            start = t_submit + (timestamps[q] - t0) * period * 1e-9;
+            end = t_submit + (timestamps[q + 1] - t0) * period * 1e-9;
+            dvz_profiler_scope(
+                profiler, frame_idx, DVZ_PROFILER_DOMAIN_GPU, scopes->names[k], start,
+                MAX(start, end));
+        }
+    }
+}
@@ -34,6 +34,9 @@ DvzScene* dvz_scene(DvzCanvas* canvas, uint32_t n_rows, uint32_t n_cols)
     // Scene update FIFO queue.
     canvas->scene->update_fifo = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
 
+    // Background bake jobs FIFO queue, the worker threads are started with the first job.
+    canvas->scene->bake_fifo = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+
     // INIT callback
     dvz_event_callback(canvas, DVZ_EVENT_INIT, 0, DVZ_EVENT_MODE_SYNC, _scene_init, canvas->scene);
 
@@ -58,6 +61,10 @@ DvzScene* dvz_scene(DvzCanvas* canvas, uint32_t n_rows, uint32_t n_cols)
     dvz_event_callback(
         canvas, DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _upload_mvp, canvas->scene);
 
+    // PRE_SEND callback: GPU binning of the histogram samples, and GPU density of the points.
+    dvz_event_callback(
+        canvas, DVZ_EVENT_PRE_SEND, 0, DVZ_EVENT_MODE_SYNC, _compute_visuals, canvas->scene);
+
 
     return canvas->scene;
 }
@@ -270,6 +277,72 @@ DvzVisual* dvz_scene_visual(DvzPanel* panel, DvzVisualType type, int flags)
     // Builtin visual.
     dvz_visual_builtin(visual, type, flags);
 
+    // Decimation pyramid, built when the POS prop is set.
+    if ((flags & DVZ_VISUAL_FLAGS_LOD) != 0 &&
+        (type == DVZ_VISUAL_LINE_STRIP || type == DVZ_VISUAL_PATH))
+        visual->lod = dvz_lod();
+
+    // Tiled mip pyramid, built when the image is set.
+    if ((flags & DVZ_VISUAL_FLAGS_TILED) != 0 &&
+        (type == DVZ_VISUAL_IMAGE || type == DVZ_VISUAL_IMAGE_CMAP))
+    {
+        visual->tiles = dvz_tiles();
+
+        // Atlas texture holding the tile cache, RGBA for images and single-channel for the
+        // colormapped images.
+        uint32_t size = DVZ_TILES_SLOT_SIZE * DVZ_TILES_ATLAS_SLOTS;
+        VkFormat format =
+            type == DVZ_VISUAL_IMAGE_CMAP ? VK_FORMAT_R8_UNORM : VK_FORMAT_R8G8B8A8_UNORM;
+        DvzTexture* atlas =
+            dvz_ctx_texture(visual->canvas->gpu->context, 2, (uvec3){size, size, 1}, format);
+        // NOTE: the tile gutters make linear interpolation seamless across tiles.
+        dvz_texture_filter(atlas, DVZ_FILTER_MAG, VK_FILTER_LINEAR);
+        dvz_texture_filter(atlas, DVZ_FILTER_MIN, VK_FILTER_LINEAR);
+        dvz_visual_texture(visual, DVZ_SOURCE_TYPE_IMAGE, 0, atlas);
+    }
+
+    // Bricked volume, built when the volume is set.
+    if ((flags & DVZ_VISUAL_FLAGS_BRICKED) != 0 && type == DVZ_VISUAL_VOLUME)
+    {
+        visual->bricks = dvz_bricks();
+        DvzContext* ctx = visual->canvas->gpu->context;
+
+        // Atlas texture holding the brick cache, all volumes are stored with 16 bits.
+        uvec3 shape = {
+            DVZ_BRICKS_ATLAS_X * DVZ_BRICKS_SLOT_SIZE, DVZ_BRICKS_ATLAS_Y * DVZ_BRICKS_SLOT_SIZE,
+            DVZ_BRICKS_ATLAS_Z * DVZ_BRICKS_SLOT_SIZE};
+        DvzTexture* atlas = dvz_ctx_texture(ctx, 3, shape, VK_FORMAT_R16_UNORM);
+        // NOTE: the brick gutters make linear interpolation seamless across bricks.
+        dvz_texture_filter(atlas, DVZ_FILTER_MAG, VK_FILTER_LINEAR);
+        dvz_texture_filter(atlas, DVZ_FILTER_MIN, VK_FILTER_LINEAR);
+        dvz_visual_texture(visual, DVZ_SOURCE_TYPE_VOLUME, 0, atlas);
+
+        // Page table, resized when the volume is set.
+        DvzTexture* page = dvz_ctx_texture(ctx, 3, (uvec3){1, 1, 1}, VK_FORMAT_R8G8B8A8_UNORM);
+        dvz_visual_texture(visual, DVZ_SOURCE_TYPE_VOLUME, 1, page);
+    }
+
+    // GPU viewport culling.
+    if ((flags & DVZ_VISUAL_FLAGS_CULLING) != 0)
+    {
+        if (type == DVZ_VISUAL_MARKER)
+        {
+            dvz_visual_culling(visual, DVZ_CULLING_MARGIN);
+            visual->culling->size_offset = offsetof(DvzGraphicsMarkerVertex, size);
+            visual->culling->mode_offset = offsetof(DvzGraphicsMarkerVertex, transform);
+        }
+        else if (type == DVZ_VISUAL_MARKER_CMAP)
+        {
+            dvz_visual_culling(visual, DVZ_CULLING_MARGIN);
+            visual->culling->size_offset = offsetof(DvzGraphicsMarkerCmapVertex, size);
+            visual->culling->mode_offset = offsetof(DvzGraphicsMarkerCmapVertex, transform);
+        }
+        else if (type == DVZ_VISUAL_POINT)
+            dvz_visual_culling(visual, DVZ_CULLING_MARGIN);
+        else
+            log_warn("GPU culling is only supported for MARKER, MARKER_CMAP and POINT visuals");
+    }
+
     // Add it to the panel.
     _add_visual(panel, visual);
 
@@ -410,6 +483,9 @@ void dvz_scene_destroy(DvzScene* scene)
     DvzGrid* grid = &scene->grid;
     ASSERT(grid != NULL);
 
+    // Stop the bake worker threads, after the pending jobs.
+    _bake_stop(scene);
+
     // Destroy all panels.
     DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
     DvzPanel* panel = NULL;
@@ -428,6 +504,7 @@ void dvz_scene_destroy(DvzScene* scene)
     dvz_container_destroy(&scene->controllers);
 
     dvz_fifo_destroy(&scene->update_fifo);
+    dvz_fifo_destroy(&scene->bake_fifo);
 
     dvz_container_destroy(&scene->visuals);
     dvz_obj_destroyed(&scene->obj);
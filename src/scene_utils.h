@@ -54,6 +54,14 @@ static bool _has_item_count_changed(DvzVisual* visual)
             has_changed = true;
             visual->prev_index_count[pidx] = source->arr.item_count;
         }
+
+        // Detect a change in instance_count.
+        source = dvz_source_get(visual, DVZ_SOURCE_TYPE_INSTANCE, pidx);
+        if (source != NULL && source->arr.item_count != visual->prev_instance_count[pidx])
+        {
+            has_changed = true;
+            visual->prev_instance_count[pidx] = source->arr.item_count;
+        }
     }
     return has_changed;
 }
@@ -196,7 +204,7 @@ static void _init_item_count_change_detection(DvzVisual* visual)
     ASSERT(visual != NULL);
 
     DvzSource* source = NULL;
-    // Initialize prev_vertex_count and prev_index_count.
+    // Initialize prev_vertex_count, prev_index_count and prev_instance_count.
     for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
     {
         source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, pidx);
@@ -205,6 +213,10 @@ static void _init_item_count_change_detection(DvzVisual* visual)
         source = dvz_source_get(visual, DVZ_SOURCE_TYPE_INDEX, pidx);
         if (source != NULL)
             visual->prev_index_count[pidx] = source->arr.item_count;
+
+        source = dvz_source_get(visual, DVZ_SOURCE_TYPE_INSTANCE, pidx);
+        if (source != NULL)
+            visual->prev_instance_count[pidx] = source->arr.item_count;
     }
 }
 
@@ -220,6 +232,7 @@ static void _update_visual_viewport(DvzPanel* panel, DvzVisual* visual)
     {
         visual->viewport.interact_axis = (int32_t)visual->interact_axis[pidx];
         visual->viewport.clip = visual->clip[pidx];
+        visual->viewport.pick_id = visual->pick_id;
         ASSERT(visual->viewport.viewport.minDepth < visual->viewport.viewport.maxDepth);
         // NOTE: here we make the assumption that there is exactly 1 viewport per graphics
         // pipeline, such that the source idx corresponds to the pipeline idx.
@@ -264,6 +277,416 @@ static int _transform_flags(DvzControllerType type, int flags)
 
 
 
+/*************************************************************************************************/
+/*  Level of detail                                                                              */
+/*************************************************************************************************/
+
+// Region visible in a panel, in normalized coordinates: xmin, ymin, xmax, ymax.
+static void _panel_visible_box(DvzPanel* panel, dvec4 box)
+{
+    ASSERT(panel != NULL);
+    box[0] = box[1] = -1;
+    box[2] = box[3] = +1;
+
+    DvzController* controller = panel->controller;
+    if (controller == NULL || controller->interact_count == 0)
+        return;
+    DvzInteract* interact = &controller->interacts[0];
+    if (interact->type != DVZ_INTERACT_PANZOOM &&
+        interact->type != DVZ_INTERACT_PANZOOM_FIXED_ASPECT)
+        return;
+
+    // The panzoom projection spans [-1/zoom, +1/zoom] around the camera position.
+    DvzPanzoom* panzoom = &interact->u.p;
+    ASSERT(panzoom->zoom[0] > 0);
+    ASSERT(panzoom->zoom[1] > 0);
+    box[0] = panzoom->camera_pos[0] - 1.0 / panzoom->zoom[0];
+    box[1] = panzoom->camera_pos[1] - 1.0 / panzoom->zoom[1];
+    box[2] = panzoom->camera_pos[0] + 1.0 / panzoom->zoom[0];
+    box[3] = panzoom->camera_pos[1] + 1.0 / panzoom->zoom[1];
+}
+
+
+
+// Rebuild the decimation pyramid of a visual after its POS prop has changed (and has been
+// renormalized if the visual is transformed).
+static void _lod_data(DvzVisual* visual, DvzProp* prop)
+{
+    ASSERT(visual != NULL);
+    ASSERT(prop != NULL);
+    if (visual->lod == NULL || prop->prop_type != DVZ_PROP_POS || prop->prop_idx != 0)
+        return;
+
+    // NOTE: the staging array holds the previous window, so we take the full data here.
+    DvzArray* arr = prop->arr_trans.item_count > 0 ? &prop->arr_trans : &prop->arr_orig;
+    ASSERT(arr->dtype == DVZ_DTYPE_DVEC3);
+    dvz_lod_data(visual->lod, arr->item_count, (const dvec3*)arr->data);
+}
+
+
+
+// Replace the POS and COLOR props by the window of the decimation pyramid that matches the
+// visible range, if it has changed.
+static void _lod_update(DvzPanel* panel, DvzVisual* visual, bool force)
+{
+    ASSERT(panel != NULL);
+    ASSERT(visual != NULL);
+    DvzLod* lod = visual->lod;
+    if (lod == NULL || lod->sample_count == 0)
+        return;
+
+    // Line strips made of several strips are not decimated.
+    DvzArray* arr_length = dvz_prop_array(visual, DVZ_PROP_LENGTH, 0);
+    if (arr_length != NULL && arr_length->item_count > 1)
+        return;
+
+    DvzProp* prop_pos = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    DvzProp* prop_color = dvz_prop_get(visual, DVZ_PROP_COLOR, 0);
+    ASSERT(prop_pos != NULL);
+    bool color_changed =
+        prop_color != NULL && prop_color->obj.request == DVZ_VISUAL_REQUEST_UPLOAD;
+
+    // Number of pixels along the x axis, without the margins.
+    DvzViewport* viewport = &panel->viewport;
+    uint32_t width = (uint32_t)MAX(
+        1, (float)viewport->size_framebuffer[0] - viewport->margins[1] - viewport->margins[3]);
+
+    dvec4 box = {0};
+    _panel_visible_box(panel, box);
+    double xmin = box[0], xmax = box[2];
+    if (!force && !color_changed && dvz_lod_covers(lod, lod->window, xmin, xmax, width))
+        return;
+
+    DvzLodWindow window = dvz_lod_window(lod, xmin, xmax, width);
+    ASSERT(window.count > 0);
+    log_trace(
+        "upload LOD window level %d, %d points (stride %d)", window.level, window.count,
+        window.stride);
+
+    // POS prop: the staging array takes precedence over the transformed array during baking.
+    DvzArray* arr = &prop_pos->arr_staging;
+    if (arr->item_size == 0)
+        *arr = dvz_array(window.count, DVZ_DTYPE_DVEC3);
+    dvz_array_resize(arr, window.count);
+    uint32_t* idx = (uint32_t*)calloc(window.count, sizeof(uint32_t));
+    dvz_lod_copy(lod, window, (dvec3*)arr->data, idx);
+
+    // COLOR prop: take the colors of the kept points.
+    if (prop_color != NULL && prop_color->arr_orig.item_count == lod->sample_count)
+    {
+        arr = &prop_color->arr_staging;
+        if (arr->item_size == 0)
+            *arr = dvz_array(window.count, prop_color->arr_orig.dtype);
+        dvz_array_resize(arr, window.count);
+        for (uint32_t i = 0; i < window.count; i++)
+            memcpy(
+                dvz_array_item(arr, i), dvz_array_item(&prop_color->arr_orig, idx[i]),
+                arr->item_size);
+    }
+    if (color_changed)
+        prop_color->obj.request = DVZ_VISUAL_REQUEST_SET;
+    FREE(idx);
+
+    // Mark the visual as needing a new upload.
+    ASSERT(prop_pos->source != NULL);
+    _source_set_changed(prop_pos->source, true);
+}
+
+
+
+// Update the decimated windows of all visuals, as a function of the current panzoom.
+static void _update_lods(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzGrid* grid = &scene->grid;
+
+    DvzPanel* panel = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        for (uint32_t j = 0; j < panel->visual_count; j++)
+            _lod_update(panel, panel->visuals[j], false);
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+/*************************************************************************************************/
+/*  Tiled images                                                                                 */
+/*************************************************************************************************/
+
+// Set the staging array of a prop with a given number of items.
+static void* _tiles_staging(DvzVisual* visual, DvzPropType type, uint32_t idx, uint32_t count)
+{
+    DvzProp* prop = dvz_prop_get(visual, type, idx);
+    ASSERT(prop != NULL);
+    DvzArray* arr = &prop->arr_staging;
+    if (arr->item_size == 0)
+        *arr = dvz_array(count, prop->dtype);
+    dvz_array_resize(arr, count);
+    return arr->data;
+}
+
+
+
+// Upload the missing visible tiles of a tiled image visual, and replace the POS and TEXCOORDS
+// props by one quad per visible tile.
+static void _tiles_update(DvzPanel* panel, DvzVisual* visual)
+{
+    ASSERT(panel != NULL);
+    ASSERT(visual != NULL);
+    DvzTiles* tiles = visual->tiles;
+    if (tiles == NULL || tiles->level_count == 0)
+        return;
+
+    // The image is placed between its top left and bottom right corners.
+    DvzProp* prop0 = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    DvzProp* prop2 = dvz_prop_get(visual, DVZ_PROP_POS, 2);
+    ASSERT(prop0 != NULL);
+    ASSERT(prop2 != NULL);
+    DvzArray* arr0 = prop0->arr_trans.item_count > 0 ? &prop0->arr_trans : &prop0->arr_orig;
+    DvzArray* arr2 = prop2->arr_trans.item_count > 0 ? &prop2->arr_trans : &prop2->arr_orig;
+    if (arr0->item_count != 1 || arr2->item_count != 1)
+        return;
+    double* p0 = (double*)dvz_array_item(arr0, 0);
+    double* p2 = (double*)dvz_array_item(arr2, 0);
+    double dx = p2[0] - p0[0], dy = p2[1] - p0[1];
+    if (dx == 0 || dy == 0)
+        return;
+
+    // Visible region in normalized image coordinates, v going from the top to the bottom.
+    dvec4 visible = {0};
+    _panel_visible_box(panel, visible);
+    double u0 = (visible[0] - p0[0]) / dx, u1 = (visible[2] - p0[0]) / dx;
+    double v0 = (visible[3] - p0[1]) / dy, v1 = (visible[1] - p0[1]) / dy;
+    dvec4 box = {MIN(u0, u1), MIN(v0, v1), MAX(u0, u1), MAX(v0, v1)};
+
+    // Number of screen pixels spanned by the whole image.
+    DvzViewport* viewport = &panel->viewport;
+    double width = MAX(
+        1, (double)viewport->size_framebuffer[0] - viewport->margins[1] - viewport->margins[3]);
+    double height = MAX(
+        1, (double)viewport->size_framebuffer[1] - viewport->margins[0] - viewport->margins[2]);
+    dvec2 scale = {
+        width * fabs(dx) / (visible[2] - visible[0]),
+        height * fabs(dy) / (visible[3] - visible[1])};
+
+    if (!dvz_tiles_changed(tiles, box, scale))
+        return;
+    uint32_t n = dvz_tiles_update(tiles, box, scale);
+    if (n == 0)
+        return;
+
+    // Stream the new tiles to the atlas created with the visual, through the canvas transfers.
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_IMAGE, 0);
+    ASSERT(source != NULL);
+    DvzTexture* texture = source->u.tex;
+    ASSERT(texture != NULL);
+    ASSERT(texture->image != NULL);
+    ASSERT(tiles->channels == (texture->image->format == VK_FORMAT_R8_UNORM ? 1 : 4));
+    uvec3 offset = {0};
+    VkDeviceSize size = DVZ_TILES_SLOT_SIZE * DVZ_TILES_SLOT_SIZE * tiles->channels;
+    for (uint32_t i = 0; i < tiles->upload_count; i++)
+    {
+        dvz_tiles_slot_offset(tiles->uploads[i], offset);
+        dvz_upload_texture(
+            visual->canvas, texture, offset, (uvec3){DVZ_TILES_SLOT_SIZE, DVZ_TILES_SLOT_SIZE, 1},
+            size, dvz_tiles_slot_pixels(tiles, tiles->uploads[i]));
+    }
+    log_trace("draw %d tiles, upload %d tiles", n, tiles->upload_count);
+
+    // One quad per tile: top left, top right, bottom right, bottom left.
+    dvec3* pos[4] = {0};
+    vec2* uv[4] = {0};
+    for (uint32_t k = 0; k < 4; k++)
+    {
+        pos[k] = (dvec3*)_tiles_staging(visual, DVZ_PROP_POS, k, n);
+        uv[k] = (vec2*)_tiles_staging(visual, DVZ_PROP_TEXCOORDS, k, n);
+    }
+    DvzTilesQuad* quad = NULL;
+    const uint32_t corners[4][2] = {{0, 1}, {2, 1}, {2, 3}, {0, 3}};
+    for (uint32_t i = 0; i < n; i++)
+    {
+        quad = &tiles->quads[i];
+        for (uint32_t k = 0; k < 4; k++)
+        {
+            pos[k][i][0] = p0[0] + quad->box[corners[k][0]] * dx;
+            pos[k][i][1] = p0[1] + quad->box[corners[k][1]] * dy;
+            pos[k][i][2] = p0[2];
+            uv[k][i][0] = quad->uv[corners[k][0]];
+            uv[k][i][1] = quad->uv[corners[k][1]];
+        }
+    }
+
+    // Mark the visual as needing a new upload.
+    ASSERT(prop0->source != NULL);
+    _source_set_changed(prop0->source, true);
+}
+
+
+
+// Update the visible tiles of all tiled image visuals, as a function of the current panzoom.
+static void _update_tiles(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzGrid* grid = &scene->grid;
+
+    DvzPanel* panel = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        for (uint32_t j = 0; j < panel->visual_count; j++)
+            _tiles_update(panel, panel->visuals[j]);
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+/*************************************************************************************************/
+/*  Bricked volumes                                                                              */
+/*************************************************************************************************/
+
+// Keep the empty-space skipping of a bricked volume visual in sync with its transfer function:
+// the range, and the values of the transfer texture whenever the texture changes.
+static void _bricks_transfer(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzBricks* bricks = visual->bricks;
+    ASSERT(bricks != NULL);
+
+    DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_TRANSFER_X, 0);
+    ASSERT(prop != NULL);
+    vec2 xrange = {0};
+    if (dvz_prop_item(prop, 0) != NULL)
+        memcpy(xrange, dvz_prop_item(prop, 0), sizeof(vec2));
+
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_TRANSFER, 0);
+    ASSERT(source != NULL);
+    DvzTexture* texture = source->u.tex;
+    if (texture == NULL)
+        texture = visual->canvas->gpu->context->transfer_texture;
+    ASSERT(texture != NULL);
+    ASSERT(texture->image != NULL);
+    if (texture == bricks->transfer_texture && texture->version == bricks->transfer_version)
+    {
+        dvz_bricks_transfer(bricks, xrange, 0, NULL);
+        return;
+    }
+
+    // Download the transfer texture, only when it has changed.
+    uint32_t count = texture->image->width;
+    VkFormat format = texture->image->format;
+    float* values = (float*)calloc(count, sizeof(float));
+    if (format == VK_FORMAT_R32_SFLOAT)
+    {
+        dvz_texture_download(
+            texture, DVZ_ZERO_OFFSET, (uvec3){count, 1, 1}, count * sizeof(float), values);
+    }
+    else if (format == VK_FORMAT_R8_UNORM)
+    {
+        uint8_t* bytes = (uint8_t*)calloc(count, sizeof(uint8_t));
+        dvz_texture_download(texture, DVZ_ZERO_OFFSET, (uvec3){count, 1, 1}, count, bytes);
+        for (uint32_t i = 0; i < count; i++)
+            values[i] = bytes[i] / 255.0f;
+        FREE(bytes);
+    }
+    else
+    {
+        // Conservative: no brick is skipped.
+        log_warn("unsupported transfer texture format %d for empty-space skipping", format);
+        for (uint32_t i = 0; i < count; i++)
+            values[i] = 1;
+    }
+    dvz_bricks_transfer(bricks, xrange, count, values);
+    FREE(values);
+
+    bricks->transfer_texture = texture;
+    bricks->transfer_version = texture->version;
+}
+
+
+
+// Upload the missing non-empty bricks of a bricked volume visual, and its page table.
+static void _bricks_update(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzBricks* bricks = visual->bricks;
+    if (bricks == NULL || bricks->level_count == 0)
+        return;
+
+    _bricks_transfer(visual);
+    if (!dvz_bricks_update(bricks))
+        return;
+    DvzBricksLevel* level = &bricks->levels[bricks->level];
+
+    // Stream the new bricks to the atlas created with the visual, through the canvas transfers.
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VOLUME, 0);
+    ASSERT(source != NULL);
+    DvzTexture* atlas = source->u.tex;
+    ASSERT(atlas != NULL);
+    uvec3 offset = {0};
+    for (uint32_t i = 0; i < bricks->upload_count; i++)
+    {
+        dvz_bricks_slot_offset(bricks->uploads[i], offset);
+        dvz_upload_texture(
+            visual->canvas, atlas, offset,
+            (uvec3){DVZ_BRICKS_SLOT_SIZE, DVZ_BRICKS_SLOT_SIZE, DVZ_BRICKS_SLOT_SIZE},
+            DVZ_BRICKS_SLOT_VOXELS * sizeof(uint16_t),
+            dvz_bricks_slot_voxels(bricks, bricks->uploads[i]));
+    }
+    log_trace(
+        "upload %d bricks, level %d, %d non-empty bricks", bricks->upload_count, bricks->level,
+        level->filled_count);
+
+    // The page table texture has the size of the finest level, the largest one.
+    source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VOLUME, 1);
+    ASSERT(source != NULL);
+    DvzTexture* page = source->u.tex;
+    ASSERT(page != NULL);
+    ASSERT(page->image != NULL);
+    DvzBricksLevel* finest = &bricks->levels[0];
+    if (page->image->width != finest->cols || page->image->height != finest->rows ||
+        page->image->depth != finest->layers)
+    {
+        dvz_texture_resize(page, (uvec3){finest->cols, finest->rows, finest->layers});
+        dvz_visual_texture(visual, DVZ_SOURCE_TYPE_VOLUME, 1, page);
+    }
+    dvz_upload_texture(
+        visual->canvas, page, DVZ_ZERO_OFFSET, (uvec3){level->cols, level->rows, level->layers},
+        level->brick_count * 4, dvz_bricks_page(bricks));
+
+    // Current level shape and brick grid.
+    dvz_visual_data(
+        visual, DVZ_PROP_LENGTH, 1, 1, (vec4){level->width, level->height, level->depth, 0});
+    dvz_visual_data(
+        visual, DVZ_PROP_LENGTH, 2, 1, (vec4){level->cols, level->rows, level->layers, 1});
+}
+
+
+
+// Update the resident bricks of all bricked volume visuals.
+static void _update_bricks(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzGrid* grid = &scene->grid;
+
+    DvzPanel* panel = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        for (uint32_t j = 0; j < panel->visual_count; j++)
+            _bricks_update(panel->visuals[j]);
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
 /*************************************************************************************************/
 /*  Scene update enqueueing                                                                      */
 /*************************************************************************************************/
@@ -395,6 +818,177 @@ static void _enqueue_coords_changed(DvzPanel* panel)
 
 
 
+/*************************************************************************************************/
+/*  Background baking                                                                            */
+/*************************************************************************************************/
+
+static inline bool _is_bake_async(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    // The decimation pyramid and the tiled and bricked storages stream their own data.
+    return (visual->flags & DVZ_VISUAL_FLAGS_BAKE_ASYNC) != 0 && visual->lod == NULL &&
+           visual->tiles == NULL && visual->bricks == NULL;
+}
+
+
+
+static inline bool _is_baking(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    return atomic_load(&visual->bake.state) != DVZ_VISUAL_BAKE_NONE;
+}
+
+
+
+// Renormalize the POS props and bake the visual, in a worker thread.
+static void _bake_visual(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzVisualBake* bake = &visual->bake;
+
+    if (bake->normalize != 0)
+    {
+        DvzProp* prop = NULL;
+        for (uint32_t i = 0; i < 32; i++)
+        {
+            prop = dvz_prop_get(visual, DVZ_PROP_POS, i);
+            if (prop == NULL)
+                break;
+            if ((bake->normalize & (1u << i)) != 0)
+                _transform_pos_prop(bake->coords, prop);
+        }
+
+        // The main thread checks whether the panel box must change once the bake is done.
+        bake->box = _visual_box(visual);
+        if (_is_aspect_fixed(&bake->coords))
+            bake->box = _box_cube(bake->box);
+    }
+
+    // Fill the source arrays, which are the back arrays until the bake is done.
+    dvz_visual_bake(visual, bake->viewport, bake->coords, NULL);
+}
+
+
+
+static void* _bake_thread(void* user_data)
+{
+    DvzScene* scene = (DvzScene*)user_data;
+    ASSERT(scene != NULL);
+    DvzVisual* visual = NULL;
+    while (true)
+    {
+        // A NULL item stops the thread.
+        visual = (DvzVisual*)dvz_fifo_dequeue(&scene->bake_fifo, true);
+        if (visual == NULL)
+            break;
+        _bake_visual(visual);
+        pthread_mutex_lock(&visual->bake.lock);
+        atomic_store(&visual->bake.state, DVZ_VISUAL_BAKE_DONE);
+        pthread_cond_broadcast(&visual->bake.cond);
+        pthread_mutex_unlock(&visual->bake.lock);
+
+        // The baked arrays are swapped at the next frame.
+        dvz_canvas_redraw(scene->canvas);
+    }
+    return NULL;
+}
+
+
+
+static void _bake_start(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    if (dvz_obj_is_created(&scene->bake_threads[0].obj))
+        return;
+    log_debug("starting %d bake worker threads", DVZ_SCENE_BAKE_THREADS);
+    for (uint32_t i = 0; i < DVZ_SCENE_BAKE_THREADS; i++)
+        scene->bake_threads[i] = dvz_thread(_bake_thread, scene);
+}
+
+
+
+static void _bake_stop(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    if (!dvz_obj_is_created(&scene->bake_threads[0].obj))
+        return;
+    for (uint32_t i = 0; i < DVZ_SCENE_BAKE_THREADS; i++)
+        dvz_fifo_enqueue(&scene->bake_fifo, NULL);
+    for (uint32_t i = 0; i < DVZ_SCENE_BAKE_THREADS; i++)
+        dvz_thread_join(&scene->bake_threads[i]);
+}
+
+
+
+// Swap the front and back arrays of the sources that are baked, or that were baked if the bake
+// is cancelled.
+static void _bake_swap(DvzVisual* visual, bool is_baking)
+{
+    ASSERT(visual != NULL);
+    DvzSource* source = NULL;
+    DvzArray arr = {0};
+    DvzContainerIterator iter = dvz_container_iterator(&visual->sources);
+    while (iter.item != NULL)
+    {
+        source = iter.item;
+        if (is_baking ? source->origin == DVZ_SOURCE_ORIGIN_LIB && _source_has_changed(source)
+                      : source->is_baking)
+        {
+            arr = source->arr;
+            source->arr = source->arr_back;
+            source->arr_back = arr;
+            source->is_baking = is_baking;
+        }
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+// Start the background bake of a visual.
+static void _bake_enqueue(DvzPanel* panel, DvzVisual* visual)
+{
+    ASSERT(panel != NULL);
+    ASSERT(visual != NULL);
+    DvzScene* scene = panel->scene;
+    ASSERT(scene != NULL);
+    DvzVisualBake* bake = &visual->bake;
+
+    // The visual is already being baked, it will be baked again when the bake is done.
+    if (_is_baking(visual))
+        return;
+    _bake_start(scene);
+
+    log_debug("start the background bake of the visual");
+    bake->viewport = panel->viewport;
+    bake->coords = panel->data_coords;
+    bake->normalize = _is_visual_to_transform(visual) ? bake->to_normalize : 0;
+    bake->to_normalize = 0;
+
+    // The props changed from now on will be baked again.
+    DvzProp* prop = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        if (prop->obj.request == DVZ_VISUAL_REQUEST_UPLOAD)
+            prop->obj.request = DVZ_VISUAL_REQUEST_SET;
+        dvz_container_iter(&iter);
+    }
+
+    // The worker thread fills the back arrays, the front arrays still match the GPU data.
+    _bake_swap(visual, true);
+
+    // The uniform sources are small and are baked now in the back arrays, rather than by the
+    // worker thread, see dvz_visual_bake().
+    _bake_uniforms(visual);
+
+    atomic_store(&bake->state, DVZ_VISUAL_BAKE_PENDING);
+    dvz_fifo_enqueue(&scene->bake_fifo, visual);
+}
+
+
+
 /*************************************************************************************************/
 /*  Processing scene updates                                                                     */
 /*************************************************************************************************/
@@ -403,15 +997,38 @@ static void _enqueue_coords_changed(DvzPanel* panel)
 // Change the visual and source request, to be picked up by dvz_visual_data() later.
 static void _process_prop_changed(DvzSceneUpdate up)
 {
+    ASSERT(up.canvas != NULL);
     ASSERT(up.panel != NULL);
     DvzDataCoords coords = up.panel->data_coords;
 
     // if POS prop, we do data normalization
     ASSERT(up.prop != NULL);
     ASSERT(up.visual != NULL);
-    if (up.prop->prop_type == DVZ_PROP_POS && _is_visual_to_transform(up.visual))
+
+    // Background baking: the normalization happens in the worker thread. The sources must not
+    // change while the visual is baked, they will be marked once the bake is done.
+    if (_is_bake_async(up.visual))
+    {
+        if (up.prop->prop_type == DVZ_PROP_POS && up.prop->prop_idx < 32)
+            up.visual->bake.to_normalize |= 1u << up.prop->prop_idx;
+        if (!_is_baking(up.visual))
+            _source_set_changed(up.source, true);
+        return;
+    }
+
+    bool is_pos = up.prop->prop_type == DVZ_PROP_POS;
+
+    // The decimation pyramid refers to the POS array, which is about to change.
+    if (is_pos && up.visual->lod != NULL)
+        dvz_lod_stop(up.visual->lod);
+
+    if (is_pos && _is_visual_to_transform(up.visual))
     {
+        dvz_profiler_begin(up.canvas->profiler, "normalize");
         _transform_pos_prop(coords, up.prop);
+        dvz_profiler_end(up.canvas->profiler);
+        if (up.visual->tiles != NULL)
+            up.visual->tiles->is_complete = false;
 
         if ((up.visual->flags & DVZ_VISUAL_FLAGS_TRANSFORM_BOX_INIT) == 0)
         {
@@ -432,6 +1049,14 @@ static void _process_prop_changed(DvzSceneUpdate up)
         }
     }
 
+    // The decimation pyramid is built from the final positions, whether they have been
+    // transformed or not (DVZ_VISUAL_FLAGS_TRANSFORM_NONE).
+    if (is_pos && up.visual->lod != NULL)
+    {
+        _lod_data(up.visual, up.prop);
+        _lod_update(up.panel, up.visual, true);
+    }
+
     // Mark the visual and source has needing update, for dvz_visual_update()
     ASSERT(up.source != NULL);
     _source_set_changed(up.source, true);
@@ -544,9 +1169,19 @@ static void _process_visual_changed(DvzSceneUpdate up)
     ASSERT(visual != NULL);
     DvzPanel* panel = up.panel;
     ASSERT(panel != NULL);
+    ASSERT(up.canvas != NULL);
+
+    // Background baking, the upload happens once the bake is done.
+    if (_is_bake_async(visual))
+    {
+        _bake_enqueue(panel, visual);
+        return;
+    }
 
     // Visual data GPU upload.
+    dvz_profiler_begin(up.canvas->profiler, "bake");
     dvz_visual_update(visual, panel->viewport, panel->data_coords, NULL);
+    dvz_profiler_end(up.canvas->profiler);
 
     // Detect whether the number of vertices/indices has changed, in which case a command buffer
     // refill will be needed.
@@ -745,6 +1380,10 @@ static void _enqueue_all_visuals_changed(DvzScene* scene)
         {
             visual = panel->visuals[j];
 
+            // The visuals baked in the background are processed once the bake is done.
+            if (_is_baking(visual))
+                continue;
+
             // Process visual upload.
             if (visual->obj.request == DVZ_VISUAL_REQUEST_UPLOAD)
             {
@@ -771,6 +1410,131 @@ static void _enqueue_all_visuals_changed(DvzScene* scene)
 
 
 
+// Mark the sources of the props changed during the bake of a visual, to bake them again.
+static void _bake_mark_changed(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    uint32_t to_normalize = visual->bake.to_normalize;
+    DvzProp* prop = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        if (prop->source != NULL &&
+            (prop->obj.request == DVZ_VISUAL_REQUEST_UPLOAD ||
+             (prop->prop_type == DVZ_PROP_POS && prop->prop_idx < 32 &&
+              (to_normalize & (1u << prop->prop_idx)) != 0)))
+            _source_set_changed(prop->source, true);
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+// Swap and upload the source arrays of a visual once its background bake is done.
+static void _bake_finish(DvzPanel* panel, DvzVisual* visual)
+{
+    ASSERT(panel != NULL);
+    ASSERT(visual != NULL);
+    DvzVisualBake* bake = &visual->bake;
+    ASSERT(atomic_load(&bake->state) == DVZ_VISUAL_BAKE_DONE);
+
+    // The normalization is outdated if the panel box has changed during the bake, or if it must
+    // change with the new data. In both cases, the previous data remains visible.
+    bool is_outdated =
+        bake->normalize != 0 && _has_coords_changed(&panel->data_coords, &bake->coords.box);
+    if (!is_outdated && bake->normalize != 0 &&
+        (visual->flags & DVZ_VISUAL_FLAGS_TRANSFORM_BOX_INIT) == 0 &&
+        _has_coords_changed(&panel->data_coords, &bake->box))
+    {
+        panel->data_coords.box = bake->box;
+        _enqueue_coords_changed(panel);
+        is_outdated = true;
+    }
+    if (is_outdated)
+    {
+        log_debug("discard the outdated background bake of the visual");
+        _bake_swap(visual, false);
+        atomic_store(&bake->state, DVZ_VISUAL_BAKE_NONE);
+        bake->to_normalize |= bake->normalize;
+        _bake_mark_changed(visual);
+        visual->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+        return;
+    }
+
+    // The baked arrays become the front arrays, and the previous front arrays are kept as the
+    // back arrays of the next bake.
+    log_debug("swap and upload the background bake of the visual");
+    DvzSource* source = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->sources);
+    while (iter.item != NULL)
+    {
+        source = iter.item;
+        source->is_baking = false;
+        dvz_container_iter(&iter);
+    }
+    atomic_store(&bake->state, DVZ_VISUAL_BAKE_NONE);
+
+    // The upload is processed by the canvas before the frame is submitted.
+    dvz_visual_upload(visual);
+    if (_has_item_count_changed(visual))
+        _enqueue_item_count_changed(panel, visual);
+
+    // Bake again the props that changed in the meantime.
+    _bake_mark_changed(visual);
+}
+
+
+
+static void _update_bakes(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzGrid* grid = &scene->grid;
+    DvzPanel* panel = NULL;
+    DvzVisual* visual = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        for (uint32_t j = 0; j < panel->visual_count; j++)
+        {
+            visual = panel->visuals[j];
+            if (atomic_load(&visual->bake.state) == DVZ_VISUAL_BAKE_DONE)
+                _bake_finish(panel, visual);
+        }
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+/*************************************************************************************************/
+/*  Streamed sources                                                                             */
+/*************************************************************************************************/
+
+// Upload the next chunk of the streamed sources, the visuals then draw the new items.
+static void _update_streams(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzGrid* grid = &scene->grid;
+    DvzPanel* panel = NULL;
+    DvzVisual* visual = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        for (uint32_t j = 0; j < panel->visual_count; j++)
+        {
+            visual = panel->visuals[j];
+            if (dvz_visual_stream(visual) && _has_item_count_changed(visual))
+                _enqueue_item_count_changed(panel, visual);
+        }
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
 // Dequeue a scene update.
 static DvzSceneUpdate _scene_update_dequeue(DvzScene* scene)
 {
@@ -881,6 +1645,8 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
     DvzContainerIterator iter;
     DvzVisual* visual = NULL;
     uint32_t img_idx = 0;
+    uint32_t scope = 0;
+    char name[DVZ_PROFILER_NAME_SIZE] = {0};
 
     // Go through all the current command buffers.
     for (uint32_t i = 0; i < ev.u.rf.cmd_count; i++)
@@ -889,12 +1655,36 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
         img_idx = ev.u.rf.img_idx;
 
         log_trace("visual fill cmd %d begin %d", i, img_idx);
-        dvz_visual_fill_begin(canvas, cmds, img_idx);
+        dvz_cmd_begin(cmds, img_idx);
+        dvz_canvas_profile_reset(canvas, cmds, img_idx, DVZ_PROFILER_CMDS_RENDER);
+
+        // The GPU culling passes are recorded before the render pass. The density passes are
+        // submitted before the frame, for the panel viewport set here.
+        scope = dvz_canvas_profile_begin(
+            canvas, cmds, img_idx, DVZ_PROFILER_CMDS_RENDER, "compute");
+        iter = dvz_container_iterator(&grid->panels);
+        while (iter.item != NULL)
+        {
+            panel = iter.item;
+            viewport = dvz_panel_viewport(panel);
+            for (uint32_t k = 0; k < panel->visual_count; k++)
+            {
+                dvz_visual_cull(panel->visuals[k], cmds, img_idx);
+                dvz_visual_density_viewport(panel->visuals[k], viewport);
+            }
+            dvz_container_iter(&iter);
+        }
+        dvz_canvas_profile_end(canvas, cmds, img_idx, DVZ_PROFILER_CMDS_RENDER, scope);
+
+        dvz_cmd_begin_renderpass(cmds, img_idx, &canvas->renderpass, &canvas->framebuffers);
 
         iter = dvz_container_iterator(&grid->panels);
         while (iter.item != NULL)
         {
             panel = iter.item;
+            snprintf(name, sizeof(name), "panel %u,%u", panel->row, panel->col);
+            scope =
+                dvz_canvas_profile_begin(canvas, cmds, img_idx, DVZ_PROFILER_CMDS_RENDER, name);
 
             // Find the panel viewport.
             viewport = dvz_panel_viewport(panel);
@@ -915,6 +1705,7 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
                 }
             }
 
+            dvz_canvas_profile_end(canvas, cmds, img_idx, DVZ_PROFILER_CMDS_RENDER, scope);
             dvz_container_iter(&iter);
         }
         dvz_visual_fill_end(canvas, cmds, img_idx);
@@ -959,12 +1750,39 @@ static void _scene_frame(DvzCanvas* canvas, DvzEvent ev)
 
     DvzScene* scene = (DvzScene*)ev.user_data;
     ASSERT(scene != NULL);
+    DvzProfiler* profiler = canvas->profiler;
+    dvz_profiler_begin(profiler, "scene");
 
     // Call the controller callbacks of all panels.
+    dvz_profiler_begin(profiler, "controllers");
     _callback_controllers(scene);
+    dvz_profiler_end(profiler);
+
+    dvz_profiler_begin(profiler, "streaming");
+
+    // Upload the decimated data matching the new panzoom, if needed.
+    _update_lods(scene);
+
+    // Stream the visible tiles of the tiled images.
+    _update_tiles(scene);
+
+    // Stream the non-empty bricks of the bricked volumes.
+    _update_bricks(scene);
+
+    // Stream the next chunks of the sources fed from external memory, such as mapped files.
+    _update_streams(scene);
+
+    dvz_profiler_end(profiler);
+
+    // Swap and upload the visuals baked in the background.
+    dvz_profiler_begin(profiler, "scene updates");
+    _update_bakes(scene);
 
     // Process the scene updates.
     _process_scene_updates(scene);
+    dvz_profiler_end(profiler);
+
+    dvz_profiler_end(profiler);
 }
 
 
@@ -989,7 +1807,10 @@ static void _upload_mvp(DvzCanvas* canvas, DvzEvent ev)
     {
         panel = iter.item;
         if (panel->controller == NULL)
+        {
+            dvz_container_iter(&iter);
             continue;
+        }
         controller = panel->controller;
 
         // Go through all interact of the controllers.
@@ -1003,14 +1824,39 @@ static void _upload_mvp(DvzCanvas* canvas, DvzEvent ev)
             // NOTE: update MVP.time here.
             interact->mvp.time = canvas->clock.elapsed;
 
-            // NOTE: we need to update the uniform buffer at every frame
+            // NOTE: we need to update the uniform buffer at every frame. The MVP is written
+            // directly in the region of the mapped buffer corresponding to the swapchain image
+            // being recorded, without going through the transfer queue.
+            dvz_update_uniforms(canvas, panel->br_mvp, 0, sizeof(DvzMVP), &interact->mvp);
+        }
+        dvz_container_iter(&iter);
+    }
+}
+
 
-            // NOTE: this is implemented with a FIFO queue even when using a single thread,
-            // which is overkill here. An optimization would be to use a function that updates the
-            // buffer region directly here, although one should make sure that GPU synchronization
-            // is properly taken care of.
 
-            dvz_upload_buffers(canvas, panel->br_mvp, 0, panel->br_mvp.size, &interact->mvp);
+// Submit the binning and density compute passes of the visuals whose data has changed, before
+// the submission of the frame that draws them.
+static void _compute_visuals(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(ev.user_data != NULL);
+    DvzScene* scene = (DvzScene*)ev.user_data;
+    ASSERT(scene != NULL);
+    DvzGrid* grid = &scene->grid;
+    ASSERT(grid != NULL);
+
+    DvzPanel* panel = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&grid->panels);
+    while (iter.item != NULL)
+    {
+        panel = iter.item;
+        for (uint32_t j = 0; j < panel->visual_count; j++)
+        {
+            if (panel->visuals[j]->binning != NULL)
+                dvz_visual_bin(panel->visuals[j]);
+            if (panel->visuals[j]->density != NULL)
+                dvz_visual_accumulate(panel->visuals[j]);
         }
         dvz_container_iter(&iter);
     }
@@ -1,16 +1,254 @@
 #include "spirv.h"
 #include "../include/datoviz/vklite.h"
 
+#include <inttypes.h>
+#include <stdlib.h>
+
 
 #if HAS_GLSLANG
 #include <StandAlone/resource_limits_c.h>
 #include <glslang/Include/glslang_c_interface.h>
+// The version header is generated by the recent versions of glslang only.
+#if defined(__has_include)
+#if __has_include(<glslang/build_info.h>)
+#include <glslang/build_info.h>
+#endif
+#endif
 #endif
 
 
-VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFlagBits stage)
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_SPIRV_CACHE_MAGIC 0x56505344 // "DSPV"
+#define DVZ_SPIRV_MAGIC       0x07230203
+
+
+
+/*************************************************************************************************/
+/*  Shader cache                                                                                 */
+/*************************************************************************************************/
+
+typedef struct DvzSpirvCacheEntry DvzSpirvCacheEntry;
+typedef struct DvzSpirvCacheHeader DvzSpirvCacheHeader;
+typedef struct DvzSpirvOptions DvzSpirvOptions;
+
+struct DvzSpirvCacheEntry
 {
-    VkShaderModule module = {0};
+    uint64_t key;
+    size_t size; // in bytes
+    uint32_t* code;
+};
+
+// Header of the cached SPIR-V files, followed by the SPIR-V code.
+struct DvzSpirvCacheHeader
+{
+    uint32_t magic;
+    uint32_t stage;
+    uint64_t key;
+    uint64_t source_size; // to detect hash collisions
+};
+
+// Compiler version and compilation options.
+struct DvzSpirvOptions
+{
+    uint32_t compiler[3]; // glslang version, if known
+    uint32_t client_version;
+    uint32_t target_version;
+    uint32_t default_version;
+    uint32_t messages;
+    uint32_t link_messages;
+};
+
+static const DvzSpirvOptions SPIRV_OPTIONS = {
+#if HAS_GLSLANG
+#ifdef GLSLANG_VERSION_MAJOR
+    .compiler = {GLSLANG_VERSION_MAJOR, GLSLANG_VERSION_MINOR, GLSLANG_VERSION_PATCH},
+#endif
+    .client_version = GLSLANG_TARGET_VULKAN_1_0,
+    .target_version = GLSLANG_TARGET_SPV_1_0,
+    .default_version = 100,
+    .messages = GLSLANG_MSG_DEFAULT_BIT,
+    .link_messages = GLSLANG_MSG_SPV_RULES_BIT | GLSLANG_MSG_VULKAN_RULES_BIT,
+#else
+    .compiler = {0},
+#endif
+};
+
+// In-memory cache of the compiled shaders, shared by all GPUs.
+static DvzSpirvCacheEntry* SPIRV_CACHE;
+static uint32_t SPIRV_CACHE_COUNT;
+static uint32_t SPIRV_CACHE_CAPACITY;
+static uint64_t SPIRV_COMPILE_COUNT; // number of shaders compiled by glslang
+static pthread_mutex_t SPIRV_CACHE_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+static uint64_t _fnv1a(uint64_t h, const void* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        h = (h ^ ((const uint8_t*)data)[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+// FNV-1a hash of the compiler version and options, the shader stage, and the source. The source
+// contains the #define directives, so that shader variants have different keys, and the cached
+// shaders are compiled again when the compiler or its options change.
+static uint64_t _spirv_key(const char* code, VkShaderStageFlagBits stage)
+{
+    ASSERT(code != NULL);
+    uint64_t h = 0xcbf29ce484222325ULL;
+    uint32_t stage_ = (uint32_t)stage;
+    h = _fnv1a(h, &SPIRV_OPTIONS, sizeof(SPIRV_OPTIONS));
+    h = _fnv1a(h, &stage_, sizeof(stage_));
+    h = _fnv1a(h, code, strlen(code));
+    return h;
+}
+
+
+
+// Return a copy of the cached SPIR-V code, or NULL. Must be called with the lock held.
+static uint32_t* _spirv_cache_get(uint64_t key, size_t* size)
+{
+    for (uint32_t i = 0; i < SPIRV_CACHE_COUNT; i++)
+    {
+        if (SPIRV_CACHE[i].key == key)
+        {
+            *size = SPIRV_CACHE[i].size;
+            uint32_t* code = (uint32_t*)malloc(*size);
+            memcpy(code, SPIRV_CACHE[i].code, *size);
+            return code;
+        }
+    }
+    return NULL;
+}
+
+
+
+// Add a copy of the SPIR-V code to the cache, unless another thread has already added it. Must be
+// called with the lock held.
+static void _spirv_cache_put(uint64_t key, size_t size, const uint32_t* code)
+{
+    ASSERT(code != NULL);
+    ASSERT(size > 0);
+    for (uint32_t i = 0; i < SPIRV_CACHE_COUNT; i++)
+    {
+        if (SPIRV_CACHE[i].key == key)
+            return;
+    }
+    if (SPIRV_CACHE_COUNT == SPIRV_CACHE_CAPACITY)
+    {
+        SPIRV_CACHE_CAPACITY = SPIRV_CACHE_CAPACITY == 0 ? 64 : 2 * SPIRV_CACHE_CAPACITY;
+        SPIRV_CACHE = (DvzSpirvCacheEntry*)realloc(
+            SPIRV_CACHE, SPIRV_CACHE_CAPACITY * sizeof(DvzSpirvCacheEntry));
+    }
+    DvzSpirvCacheEntry* entry = &SPIRV_CACHE[SPIRV_CACHE_COUNT++];
+    entry->key = key;
+    entry->size = size;
+    entry->code = (uint32_t*)malloc(size);
+    memcpy(entry->code, code, size);
+}
+
+
+
+// The on-disk cache, in the user cache directory, can be disabled with DVZ_SHADER_CACHE=0.
+static bool _spirv_disk_cache(char* path, size_t path_size, uint64_t key)
+{
+    const char* env = getenv("DVZ_SHADER_CACHE");
+    if (env != NULL && strcmp(env, "0") == 0)
+        return false;
+    char name[64];
+    snprintf(name, sizeof(name), "shader_%016" PRIx64 ".spv", key);
+    return dvz_cache_path(name, path, path_size) == 0;
+}
+
+
+
+static uint32_t* _spirv_disk_load(
+    const char* path, uint64_t key, VkShaderStageFlagBits stage, size_t source_size, size_t* size)
+{
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    DvzSpirvCacheHeader header = {0};
+    uint32_t* code = NULL;
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (file_size > (long)sizeof(header) && fread(&header, sizeof(header), 1, fp) == 1 &&
+        header.magic == DVZ_SPIRV_CACHE_MAGIC && header.key == key &&
+        header.stage == (uint32_t)stage && header.source_size == source_size)
+    {
+        *size = (size_t)file_size - sizeof(header);
+        code = (uint32_t*)malloc(*size);
+        if (*size % 4 != 0 || fread(code, 1, *size, fp) != *size || code[0] != DVZ_SPIRV_MAGIC)
+            FREE(code);
+    }
+    fclose(fp);
+    return code;
+}
+
+
+
+static void _spirv_disk_save(
+    const char* path, uint64_t key, VkShaderStageFlagBits stage, size_t source_size, size_t size,
+    const uint32_t* code)
+{
+    // The file is written to a temporary file renamed at the end, so that another process never
+    // loads a file half written. The cache directory may be read-only, the cache is then simply
+    // not used.
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* fp = fopen(tmp_path, "wb");
+    if (fp == NULL)
+    {
+        log_debug("unable to write the shader cache %s", path);
+        return;
+    }
+    DvzSpirvCacheHeader header = {DVZ_SPIRV_CACHE_MAGIC, (uint32_t)stage, key, source_size};
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(code, 1, size, fp) == size;
+    ok = fclose(fp) == 0 && ok;
+#if OS_WIN32
+    // NOTE: rename() does not replace an existing file on Windows.
+    if (ok)
+        remove(path);
+#endif
+    if (!ok || rename(tmp_path, path) != 0)
+    {
+        log_debug("unable to write the shader cache %s", path);
+        remove(tmp_path);
+    }
+}
+
+
+
+/*************************************************************************************************/
+/*  Compilation                                                                                  */
+/*************************************************************************************************/
+
+#if HAS_GLSLANG
+static pthread_once_t GLSLANG_ONCE = PTHREAD_ONCE_INIT;
+
+static void _glslang_finalize(void) { glslang_finalize_process(); }
+
+// glslang must be initialized once per process, not once per shader.
+static void _glslang_initialize(void)
+{
+    log_trace("initialize glslang");
+    glslang_initialize_process();
+    atexit(_glslang_finalize);
+}
+#endif
+
+
+
+// Compile GLSL code to SPIR-V, return the SPIR-V code (to be freed by the caller) or NULL.
+static uint32_t* _spirv_compile(const char* code, VkShaderStageFlagBits stage, size_t* size)
+{
+    uint32_t* spirv = NULL;
 
 #if HAS_GLSLANG
     glslang_stage_t glslang_stage = GLSLANG_STAGE_VERTEX;
@@ -42,38 +280,46 @@ VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFl
         .language = GLSLANG_SOURCE_GLSL,
         .stage = glslang_stage,
         .client = GLSLANG_CLIENT_VULKAN,
-        .client_version = GLSLANG_TARGET_VULKAN_1_0,
+        .client_version = (glslang_target_client_version_t)SPIRV_OPTIONS.client_version,
         .target_language = GLSLANG_TARGET_SPV,
-        .target_language_version = GLSLANG_TARGET_SPV_1_0,
+        .target_language_version =
+            (glslang_target_language_version_t)SPIRV_OPTIONS.target_version,
         .code = code,
-        .default_version = 100,
+        .default_version = (int)SPIRV_OPTIONS.default_version,
         .default_profile = GLSLANG_NO_PROFILE,
         .force_default_version_and_profile = false,
         .forward_compatible = false,
-        .messages = GLSLANG_MSG_DEFAULT_BIT,
+        .messages = (glslang_messages_t)SPIRV_OPTIONS.messages,
         .resource = glslang_default_resource(),
     };
 
-    glslang_initialize_process();
+    pthread_once(&GLSLANG_ONCE, _glslang_initialize);
+    pthread_mutex_lock(&SPIRV_CACHE_LOCK);
+    SPIRV_COMPILE_COUNT++;
+    pthread_mutex_unlock(&SPIRV_CACHE_LOCK);
 
     glslang_shader_t* shader = glslang_shader_create(&input);
+    glslang_program_t* program = NULL;
 
     if (!glslang_shader_preprocess(shader, &input))
     {
-        // use glslang_shader_get_info_log() and glslang_shader_get_info_debug_log()
+        log_error("shader preprocessing failed: %s", glslang_shader_get_info_log(shader));
+        goto cleanup;
     }
 
     if (!glslang_shader_parse(shader, &input))
     {
-        // use glslang_shader_get_info_log() and glslang_shader_get_info_debug_log()
+        log_error("shader parsing failed: %s", glslang_shader_get_info_log(shader));
+        goto cleanup;
     }
 
-    glslang_program_t* program = glslang_program_create();
+    program = glslang_program_create();
     glslang_program_add_shader(program, shader);
 
-    if (!glslang_program_link(program, GLSLANG_MSG_SPV_RULES_BIT | GLSLANG_MSG_VULKAN_RULES_BIT))
+    if (!glslang_program_link(program, (int)SPIRV_OPTIONS.link_messages))
     {
-        // use glslang_program_get_info_log() and glslang_program_get_info_debug_log();
+        log_error("shader linking failed: %s", glslang_program_get_info_log(program));
+        goto cleanup;
     }
 
     glslang_program_SPIRV_generate(program, input.stage);
@@ -83,12 +329,74 @@ VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFl
         log_debug("%s", glslang_program_SPIRV_get_messages(program));
     }
 
+    *size = glslang_program_SPIRV_get_size(program) * sizeof(unsigned int);
+    if (*size > 0)
+    {
+        spirv = (uint32_t*)malloc(*size);
+        memcpy(spirv, glslang_program_SPIRV_get_ptr(program), *size);
+    }
+
+cleanup:
+    if (program != NULL)
+        glslang_program_delete(program);
     glslang_shader_delete(shader);
 
+#else
+    log_error("unable to compile shader to SPIRV, Datoviz was not built with glslang support");
+#endif
+
+    return spirv;
+}
+
+
+
+VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFlagBits stage)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(code != NULL);
+    VkShaderModule module = {0};
+
+    // Look for the SPIR-V code in the memory cache, then in the disk cache, and compile the
+    // shader as a last resort.
+    uint64_t key = _spirv_key(code, stage);
+    size_t source_size = strlen(code);
+    size_t size = 0;
+    char path[1024];
+
+    pthread_mutex_lock(&SPIRV_CACHE_LOCK);
+    uint32_t* spirv = _spirv_cache_get(key, &size);
+    pthread_mutex_unlock(&SPIRV_CACHE_LOCK);
+
+    if (spirv == NULL)
+    {
+        bool disk = _spirv_disk_cache(path, sizeof(path), key);
+        if (disk)
+            spirv = _spirv_disk_load(path, key, stage, source_size, &size);
+        if (spirv != NULL)
+        {
+            log_trace("load cached shader %016" PRIx64 " from disk", key);
+        }
+        else
+        {
+            log_debug("compile shader %016" PRIx64, key);
+            spirv = _spirv_compile(code, stage, &size);
+            if (spirv != NULL && disk)
+                _spirv_disk_save(path, key, stage, source_size, size, spirv);
+        }
+        if (spirv == NULL)
+            return module;
+
+        pthread_mutex_lock(&SPIRV_CACHE_LOCK);
+        _spirv_cache_put(key, size, spirv);
+        pthread_mutex_unlock(&SPIRV_CACHE_LOCK);
+    }
+    ASSERT(spirv != NULL);
+    ASSERT(size > 0);
+
     VkShaderModuleCreateInfo createInfo = {0};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = glslang_program_SPIRV_get_size(program) * sizeof(unsigned int);
-    createInfo.pCode = glslang_program_SPIRV_get_ptr(program);
+    createInfo.codeSize = size;
+    createInfo.pCode = spirv;
 
     VkResult res = vkCreateShaderModule(gpu->device, &createInfo, NULL, &module);
     if (res != VK_SUCCESS)
@@ -96,11 +404,39 @@ VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFl
         log_error("unable to create shader module");
     }
 
-    glslang_program_delete(program);
+    FREE(spirv);
+    return module;
+}
 
-#else
-    log_error("unable to compile shader to SPIRV, Datoviz was not built with glslang support");
-#endif
 
-    return module;
+
+uint32_t dvz_shader_cache_count(void)
+{
+    pthread_mutex_lock(&SPIRV_CACHE_LOCK);
+    uint32_t count = SPIRV_CACHE_COUNT;
+    pthread_mutex_unlock(&SPIRV_CACHE_LOCK);
+    return count;
+}
+
+
+
+uint64_t dvz_shader_compile_count(void)
+{
+    pthread_mutex_lock(&SPIRV_CACHE_LOCK);
+    uint64_t count = SPIRV_COMPILE_COUNT;
+    pthread_mutex_unlock(&SPIRV_CACHE_LOCK);
+    return count;
+}
+
+
+
+void dvz_shader_cache_clear(void)
+{
+    pthread_mutex_lock(&SPIRV_CACHE_LOCK);
+    for (uint32_t i = 0; i < SPIRV_CACHE_COUNT; i++)
+        FREE(SPIRV_CACHE[i].code);
+    FREE(SPIRV_CACHE);
+    SPIRV_CACHE_COUNT = 0;
+    SPIRV_CACHE_CAPACITY = 0;
+    pthread_mutex_unlock(&SPIRV_CACHE_LOCK);
 }
@@ -8,9 +8,43 @@ typedef struct DvzGpu DvzGpu;
 
 
 
+/**
+ * Compile a GLSL shader into a shader module.
+ *
+ * The compiled SPIR-V code is cached in memory and on disk, in the user cache directory (see
+ * `dvz_cache_path()`), keyed by a hash of the compiler version and options, the shader stage, and
+ * the source (including its #define directives). The disk cache can be disabled by setting the
+ * DVZ_SHADER_CACHE environment variable to 0.
+ *
+ * @param gpu the GPU
+ * @param code the GLSL source code
+ * @param stage the shader stage
+ * @returns the shader module, or a null handle if the compilation failed
+ */
 DVZ_EXPORT VkShaderModule
 dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFlagBits stage);
 
+/**
+ * Return the number of compiled shaders in the memory cache.
+ *
+ * @returns the number of cached shaders
+ */
+DVZ_EXPORT uint32_t dvz_shader_cache_count(void);
+
+/**
+ * Return the number of shaders compiled by glslang since the start of the process.
+ *
+ * The shaders found in the memory or disk cache are not compiled and not counted.
+ *
+ * @returns the number of compiled shaders
+ */
+DVZ_EXPORT uint64_t dvz_shader_compile_count(void);
+
+/**
+ * Clear the memory cache of compiled shaders. The disk cache is kept.
+ */
+DVZ_EXPORT void dvz_shader_cache_clear(void);
+
 
 
 #endif
@@ -700,4 +700,204 @@ static void dvz_ticks_destroy(DvzAxesTicks* ticks)
 
 
 
+// Copy ticks, reusing the value and label buffers of the destination.
+static void dvz_ticks_copy(DvzAxesTicks* src, DvzAxesTicks* dst)
+{
+    ASSERT(src != NULL);
+    ASSERT(dst != NULL);
+    ASSERT(src != dst);
+    uint32_t n = src->value_count;
+    ASSERT(n > 0);
+
+    double* values = (double*)realloc(dst->values, n * sizeof(double));
+    char* labels = (char*)realloc(dst->labels, n * MAX_GLYPHS_PER_TICK);
+    ASSERT(values != NULL);
+    ASSERT(labels != NULL);
+    memcpy(values, src->values, n * sizeof(double));
+    memcpy(labels, src->labels, n * MAX_GLYPHS_PER_TICK);
+
+    *dst = *src;
+    dst->values = values;
+    dst->labels = labels;
+}
+
+
+
+// Whether two tick computations yield the same tick values and labels.
+static bool dvz_ticks_equal(DvzAxesTicks* a, DvzAxesTicks* b)
+{
+    ASSERT(a != NULL);
+    ASSERT(b != NULL);
+    if (a->values == NULL || b->values == NULL)
+        return false;
+    return a->value_count == b->value_count && a->lstep == b->lstep &&
+           a->lmin_in == b->lmin_in && a->format == b->format && a->precision == b->precision;
+}
+
+
+
+// Shift the ticks by a whole number of steps when panning, keeping the step, format, and
+// precision. Only the labels of the new values are formatted.
+static void dvz_ticks_shift(DvzAxesTicks* ticks, int32_t shift)
+{
+    ASSERT(ticks != NULL);
+    ASSERT(ticks->values != NULL);
+    ASSERT(ticks->labels != NULL);
+    if (shift == 0)
+        return;
+
+    uint32_t n = ticks->value_count;
+    double lstep = ticks->lstep;
+    ASSERT(lstep > 0);
+    double offset = shift * lstep;
+    ticks->dmin += offset;
+    ticks->dmax += offset;
+    ticks->lmin_in += offset;
+    ticks->lmax_in += offset;
+    ticks->lmin_ex += offset;
+    ticks->lmax_ex += offset;
+
+    // Move the labels of the values that remain, the first new label is at index i0 and the
+    // last one at index i1 - 1.
+    uint32_t s = (uint32_t)abs(shift);
+    uint32_t kept = s < n ? n - s : 0;
+    uint32_t i0 = 0, i1 = n;
+    if (kept > 0 && shift > 0)
+    {
+        memmove(
+            ticks->labels, &ticks->labels[s * MAX_GLYPHS_PER_TICK], kept * MAX_GLYPHS_PER_TICK);
+        i0 = kept;
+    }
+    else if (kept > 0)
+    {
+        memmove(
+            &ticks->labels[s * MAX_GLYPHS_PER_TICK], ticks->labels, kept * MAX_GLYPHS_PER_TICK);
+        i1 = s;
+    }
+
+    char tick_format[12] = {0};
+    _get_tick_format(ticks->format, ticks->precision, tick_format);
+    double x = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        x = ticks->lmin_in + i * lstep;
+        // Avoid labelling the rounding error when a tick crosses zero.
+        if (fabs(x) < 1e-9 * lstep)
+            x = 0;
+        ticks->values[i] = x;
+        if (i >= i0 && i < i1)
+            _tick_label(x, tick_format, &ticks->labels[i * MAX_GLYPHS_PER_TICK]);
+    }
+}
+
+
+
+/*************************************************************************************************/
+/*  Cache                                                                                        */
+/*************************************************************************************************/
+
+// Quantize the requested range to 1/128th of the power of two above its length, so that nearby
+// ranges share the same key. Return false if the range cannot be quantized.
+static bool _ticks_cache_key(double* dmin, double* dmax, DvzAxesContext* ctx, int64_t* key)
+{
+    ASSERT(dmin != NULL);
+    ASSERT(dmax != NULL);
+    ASSERT(ctx != NULL);
+    ASSERT(key != NULL);
+    ASSERT(*dmin < *dmax);
+
+    int e = 0;
+    frexp(*dmax - *dmin, &e);
+    double quantum = ldexp(1, e - 7);
+    double k0 = floor(*dmin / quantum);
+    double k1 = ceil(*dmax / quantum);
+    if (fabs(k0) > 1e15 || fabs(k1) > 1e15 || k0 >= k1)
+        return false;
+
+    key[0] = (int64_t)ctx->coord | ((int64_t)ctx->extensions << 8);
+    key[1] = e;
+    key[2] = (int64_t)k0;
+    key[3] = (int64_t)k1;
+    key[4] = (int64_t)round(ctx->size_viewport);
+    key[5] = (int64_t)round(64 * ctx->size_glyph);
+
+    *dmin = k0 * quantum;
+    *dmax = k1 * quantum;
+    return true;
+}
+
+
+
+// Return the ticks for a given range, from the cache if a nearby range was already computed.
+// The returned ticks are owned by the cache.
+static DvzAxesTicks*
+dvz_ticks_cached(DvzAxesTicksCache* cache, double dmin, double dmax, DvzAxesContext ctx)
+{
+    ASSERT(cache != NULL);
+    ASSERT(dmin < dmax);
+
+    int64_t key[DVZ_TICKS_CACHE_KEY] = {0};
+    double vmin = dmin, vmax = dmax;
+    bool quantized = _ticks_cache_key(&dmin, &dmax, &ctx, key);
+    cache->clock++;
+
+    DvzAxesTicksCacheItem* item = NULL;
+    if (quantized)
+    {
+        for (uint32_t i = 0; i < cache->count; i++)
+        {
+            item = &cache->items[i];
+            if (memcmp(item->key, key, sizeof(key)) != 0)
+                continue;
+            item->last_used = cache->clock;
+            // The ticks computed on a nearby range must still cover the requested range,
+            // otherwise they are computed again on the requested range.
+            if (vmin <= item->ticks.lmin_in || vmax >= item->ticks.lmax_in)
+            {
+                cache->misses++;
+                dvz_ticks_destroy(&item->ticks);
+                item->ticks = dvz_ticks(vmin, vmax, ctx);
+                return &item->ticks;
+            }
+            cache->hits++;
+            return &item->ticks;
+        }
+    }
+    cache->misses++;
+
+    // Take a free item or evict the least recently used one.
+    if (cache->count < DVZ_TICKS_CACHE_SIZE)
+    {
+        item = &cache->items[cache->count++];
+    }
+    else
+    {
+        item = &cache->items[0];
+        for (uint32_t i = 1; i < DVZ_TICKS_CACHE_SIZE; i++)
+            if (cache->items[i].last_used < item->last_used)
+                item = &cache->items[i];
+        dvz_ticks_destroy(&item->ticks);
+    }
+
+    item->ticks = dvz_ticks(dmin, dmax, ctx);
+    // Unquantized ranges are never looked up.
+    memcpy(item->key, key, sizeof(key));
+    if (!quantized)
+        memset(item->key, 0xff, sizeof(key));
+    item->last_used = cache->clock;
+    return &item->ticks;
+}
+
+
+
+static void dvz_ticks_cache_destroy(DvzAxesTicksCache* cache)
+{
+    ASSERT(cache != NULL);
+    for (uint32_t i = 0; i < cache->count; i++)
+        dvz_ticks_destroy(&cache->items[i].ticks);
+    cache->count = 0;
+}
+
+
+
 #endif
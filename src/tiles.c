@@ -0,0 +1,647 @@
+#include "../include/datoviz/tiles.h"
+
+#if !OS_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+typedef struct DvzTilesChunk DvzTilesChunk;
+
+struct DvzTilesChunk
+{
+    DvzTiles* tiles;
+    uint32_t level;
+    uint32_t first; // first row of the band being built
+};
+
+
+
+static inline const uint8_t* _level_pixels(DvzTiles* tiles, uint32_t level)
+{
+    ASSERT(tiles != NULL);
+    ASSERT(level < tiles->level_count);
+    return level == 0 ? tiles->pixels : tiles->levels[level].pixels;
+}
+
+
+
+static inline bool _tile_equal(DvzTile a, DvzTile b)
+{
+    return a.level == b.level && a.col == b.col && a.row == b.row;
+}
+
+
+
+// Allocate a level image in a scratch file mapped in memory, so that the system can write its
+// pages back to disk and drop them from the host memory, or on the heap without mmap().
+static void _level_alloc(DvzTiles* tiles, uint32_t k)
+{
+    ASSERT(tiles != NULL);
+    ASSERT(k >= 1);
+    DvzTilesLevel* level = &tiles->levels[k];
+    level->size = (uint64_t)level->width * level->height * tiles->channels;
+    level->is_mapped = false;
+    ASSERT(level->size > 0);
+
+#if !OS_WIN32
+    // NOTE: /tmp is often a RAM-backed tmpfs, unlike /var/tmp.
+    const char* dir = getenv("TMPDIR");
+    char path[1024] = {0};
+    snprintf(path, sizeof(path), "%s/datoviz-tiles-XXXXXX", dir != NULL ? dir : "/var/tmp");
+    int fd = mkstemp(path);
+    if (fd >= 0)
+    {
+        // The file is deleted as soon as it is unmapped.
+        unlink(path);
+        void* map = MAP_FAILED;
+        if (ftruncate(fd, (off_t)level->size) == 0)
+            map = mmap(NULL, level->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map != MAP_FAILED)
+        {
+            level->pixels = (uint8_t*)map;
+            level->is_mapped = true;
+            return;
+        }
+    }
+    log_warn("could not map a scratch file for level %d of the mip pyramid, using the heap", k);
+#endif
+
+    level->pixels = (uint8_t*)calloc(level->size, 1);
+}
+
+
+
+static void _level_free(DvzTilesLevel* level)
+{
+    ASSERT(level != NULL);
+    if (level->pixels == NULL)
+        return;
+#if !OS_WIN32
+    if (level->is_mapped)
+    {
+        munmap(level->pixels, level->size);
+        level->pixels = NULL;
+    }
+#endif
+    FREE(level->pixels);
+}
+
+
+
+// Release the host pages of a region of a level image, in bytes. The pages are read again from
+// the file if they are accessed later. The original image is only released when it comes from a
+// mapped NPY file.
+static void _level_release(DvzTiles* tiles, uint32_t k, uint64_t offset, uint64_t size)
+{
+    ASSERT(tiles != NULL);
+    if (k == 0)
+    {
+        if (tiles->npy != NULL)
+            dvz_npy_release(tiles->npy, offset, size);
+        return;
+    }
+
+#if !OS_WIN32
+    DvzTilesLevel* level = &tiles->levels[k];
+    if (!level->is_mapped || offset >= level->size)
+        return;
+    size = MIN(size, level->size - offset);
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t aligned = offset - (offset % page);
+    // NOTE: the mapping is shared, so the written pages are kept in the file.
+    madvise(level->pixels + aligned, size + offset - aligned, MADV_DONTNEED);
+#endif
+}
+
+
+
+// Downsample a range of rows of a level, each texel is the mean of 2x2 texels of the previous
+// level (clamped at the right and bottom edges).
+static void _tiles_chunk(uint64_t first, uint64_t count, uint32_t thread_idx, void* user_data)
+{
+    DvzTilesChunk* chunk = (DvzTilesChunk*)user_data;
+    ASSERT(chunk != NULL);
+    DvzTiles* tiles = chunk->tiles;
+    ASSERT(tiles != NULL);
+    ASSERT(chunk->level >= 1);
+
+    DvzTilesLevel* prev = &tiles->levels[chunk->level - 1];
+    DvzTilesLevel* level = &tiles->levels[chunk->level];
+    const uint8_t* src = _level_pixels(tiles, chunk->level - 1);
+    uint8_t* dst = level->pixels;
+    uint32_t ch = tiles->channels;
+
+    uint32_t x0 = 0, x1 = 0, y0 = 0, y1 = 0, sum = 0;
+    uint32_t y_end = chunk->first + (uint32_t)(first + count);
+    for (uint32_t y = chunk->first + (uint32_t)first; y < y_end; y++)
+    {
+        if (atomic_load(&tiles->to_stop))
+            break;
+        y0 = 2 * y;
+        y1 = MIN(y0 + 1, prev->height - 1);
+        for (uint32_t x = 0; x < level->width; x++)
+        {
+            x0 = 2 * x;
+            x1 = MIN(x0 + 1, prev->width - 1);
+            for (uint32_t c = 0; c < ch; c++)
+            {
+                sum = (uint32_t)src[((uint64_t)y0 * prev->width + x0) * ch + c] +
+                      (uint32_t)src[((uint64_t)y0 * prev->width + x1) * ch + c] +
+                      (uint32_t)src[((uint64_t)y1 * prev->width + x0) * ch + c] +
+                      (uint32_t)src[((uint64_t)y1 * prev->width + x1) * ch + c];
+                dst[((uint64_t)y * level->width + x) * ch + c] = (uint8_t)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+
+
+// Build a level from the previous one, by bands of rows split between several threads. The pages
+// of each band are released once it is built, so that the resident host memory does not depend
+// on the image size.
+static void _tiles_level(DvzTiles* tiles, uint32_t k)
+{
+    ASSERT(tiles != NULL);
+    ASSERT(k >= 1);
+    _level_alloc(tiles, k);
+    DvzTilesLevel* prev = &tiles->levels[k - 1];
+    DvzTilesLevel* level = &tiles->levels[k];
+    uint64_t prev_row = (uint64_t)prev->width * tiles->channels;
+    uint64_t row = (uint64_t)level->width * tiles->channels;
+
+    DvzTilesChunk chunk = {tiles, k, 0};
+    uint32_t count = 0;
+    for (uint32_t y = 0; y < level->height; y += DVZ_TILES_BAND)
+    {
+        if (atomic_load(&tiles->to_stop))
+            return;
+        count = MIN(DVZ_TILES_BAND, level->height - y);
+        chunk.first = y;
+        dvz_parallel(count, 64, DVZ_TILES_THREADS, _tiles_chunk, &chunk);
+        _level_release(tiles, k - 1, 2 * y * prev_row, 2 * count * prev_row);
+        _level_release(tiles, k, y * row, count * row);
+    }
+}
+
+
+
+static void* _tiles_build(void* user_data)
+{
+    DvzTiles* tiles = (DvzTiles*)user_data;
+    ASSERT(tiles != NULL);
+
+    // From the finest to the coarsest level, each level is usable as soon as it is built.
+    for (uint32_t k = 1; k < tiles->level_count; k++)
+    {
+        _tiles_level(tiles, k);
+        if (atomic_load(&tiles->to_stop))
+            return NULL;
+        atomic_store(&tiles->levels_ready, k + 1);
+    }
+
+    log_debug(
+        "built %d-level mip pyramid of %dx%d image", tiles->level_count, tiles->width,
+        tiles->height);
+    return NULL;
+}
+
+
+
+static void _tiles_free_levels(DvzTiles* tiles)
+{
+    ASSERT(tiles != NULL);
+    for (uint32_t k = 1; k < DVZ_TILES_MAX_LEVELS; k++)
+        _level_free(&tiles->levels[k]);
+    memset(tiles->levels, 0, sizeof(tiles->levels));
+    tiles->level_count = 0;
+}
+
+
+
+// Slot containing a tile, or -1.
+static int32_t _slot_find(DvzTiles* tiles, DvzTile tile)
+{
+    ASSERT(tiles != NULL);
+    for (uint32_t i = 0; i < DVZ_TILES_SLOT_COUNT; i++)
+    {
+        if (tiles->slots[i].is_used && _tile_equal(tiles->slots[i].tile, tile))
+            return (int32_t)i;
+    }
+    return -1;
+}
+
+
+
+// Free slot, or least recently used slot that is not drawn in the current frame, or -1.
+static int32_t _slot_evict(DvzTiles* tiles)
+{
+    ASSERT(tiles != NULL);
+    int32_t lru = -1;
+    for (uint32_t i = 0; i < DVZ_TILES_SLOT_COUNT; i++)
+    {
+        if (!tiles->slots[i].is_used)
+            return (int32_t)i;
+        if (tiles->slots[i].frame < tiles->frame &&
+            (lru < 0 || tiles->slots[i].frame < tiles->slots[lru].frame))
+            lru = (int32_t)i;
+    }
+    return lru;
+}
+
+
+
+// Copy the texels of a tile, with its gutter, into the CPU copy of a slot.
+static void _slot_fill(DvzTiles* tiles, uint32_t slot, DvzTile tile)
+{
+    ASSERT(tiles != NULL);
+    ASSERT(slot < DVZ_TILES_SLOT_COUNT);
+    ASSERT(tile.level < atomic_load(&tiles->levels_ready));
+
+    DvzTilesLevel* level = &tiles->levels[tile.level];
+    const uint8_t* src = _level_pixels(tiles, tile.level);
+    uint8_t* dst = dvz_tiles_slot_pixels(tiles, slot);
+    uint32_t ch = tiles->channels;
+
+    int64_t x0 = (int64_t)tile.col * DVZ_TILES_SIZE - DVZ_TILES_GUTTER;
+    int64_t y0 = (int64_t)tile.row * DVZ_TILES_SIZE - DVZ_TILES_GUTTER;
+    int64_t x = 0, y = 0;
+    for (uint32_t j = 0; j < DVZ_TILES_SLOT_SIZE; j++)
+    {
+        y = CLIP(y0 + j, 0, (int64_t)level->height - 1);
+        for (uint32_t i = 0; i < DVZ_TILES_SLOT_SIZE; i++)
+        {
+            x = CLIP(x0 + i, 0, (int64_t)level->width - 1);
+            memcpy(
+                &dst[((uint64_t)j * DVZ_TILES_SLOT_SIZE + i) * ch],
+                &src[((uint64_t)y * level->width + x) * ch], ch);
+        }
+    }
+
+    // The tile is now in the cache, release the pages it was read from.
+    int64_t x1 = CLIP(x0 + DVZ_TILES_SLOT_SIZE - 1, 0, (int64_t)level->width - 1);
+    int64_t y1 = CLIP(y0 + DVZ_TILES_SLOT_SIZE - 1, 0, (int64_t)level->height - 1);
+    x0 = CLIP(x0, 0, (int64_t)level->width - 1);
+    y0 = CLIP(y0, 0, (int64_t)level->height - 1);
+    for (y = y0; y <= y1; y++)
+    {
+        _level_release(
+            tiles, tile.level, ((uint64_t)y * level->width + (uint64_t)x0) * ch,
+            (uint64_t)(x1 - x0 + 1) * ch);
+    }
+
+    tiles->slots[slot].tile = tile;
+    tiles->slots[slot].is_used = true;
+}
+
+
+
+// Region of the image covered by a tile, in normalized image coordinates.
+static void _tile_box(DvzTiles* tiles, DvzTile tile, dvec4 box)
+{
+    ASSERT(tiles != NULL);
+    DvzTilesLevel* level = &tiles->levels[tile.level];
+    box[0] = (double)tile.col * DVZ_TILES_SIZE / level->width;
+    box[1] = (double)tile.row * DVZ_TILES_SIZE / level->height;
+    box[2] = (double)MIN((tile.col + 1) * DVZ_TILES_SIZE, level->width) / level->width;
+    box[3] = (double)MIN((tile.row + 1) * DVZ_TILES_SIZE, level->height) / level->height;
+}
+
+
+
+// Add a quad drawing a tile with the texels of a resident tile, which is the tile itself or one
+// of its ancestors.
+static void _tiles_quad(DvzTiles* tiles, DvzTile tile, DvzTile source, uint32_t slot)
+{
+    ASSERT(tiles != NULL);
+    ASSERT(tiles->quad_count < DVZ_TILES_MAX_VISIBLE);
+    DvzTilesQuad* quad = &tiles->quads[tiles->quad_count++];
+    _tile_box(tiles, tile, quad->box);
+
+    DvzTilesLevel* level = &tiles->levels[source.level];
+    uvec3 offset = {0};
+    dvz_tiles_slot_offset(slot, offset);
+    const double atlas = DVZ_TILES_SLOT_SIZE * DVZ_TILES_ATLAS_SLOTS;
+
+    // Texel coordinates within the source level, then within the atlas.
+    double x0 = (double)source.col * DVZ_TILES_SIZE - DVZ_TILES_GUTTER - offset[0];
+    double y0 = (double)source.row * DVZ_TILES_SIZE - DVZ_TILES_GUTTER - offset[1];
+    quad->uv[0] = (float)((quad->box[0] * level->width - x0) / atlas);
+    quad->uv[1] = (float)((quad->box[1] * level->height - y0) / atlas);
+    quad->uv[2] = (float)((quad->box[2] * level->width - x0) / atlas);
+    quad->uv[3] = (float)((quad->box[3] * level->height - y0) / atlas);
+}
+
+
+
+static void _tiles_data(
+    DvzTiles* tiles, uint32_t width, uint32_t height, uint32_t channels, const uint8_t* pixels,
+    DvzNpy* npy)
+{
+    ASSERT(tiles != NULL);
+    ASSERT(channels == 1 || channels == 4);
+    dvz_tiles_stop(tiles);
+    _tiles_free_levels(tiles);
+
+    // The cache content refers to the previous image.
+    memset(tiles->slots, 0, sizeof(tiles->slots));
+    if (tiles->channels != channels)
+        FREE(tiles->slot_pixels);
+    tiles->frame = 0;
+    tiles->quad_count = 0;
+    tiles->upload_count = 0;
+    tiles->is_complete = false;
+
+    tiles->width = width;
+    tiles->height = height;
+    tiles->channels = channels;
+    tiles->pixels = pixels;
+    tiles->npy = npy;
+    atomic_store(&tiles->levels_ready, 0);
+    if (width == 0 || height == 0 || pixels == NULL)
+        return;
+
+    if (tiles->slot_pixels == NULL)
+        tiles->slot_pixels = (uint8_t*)calloc(
+            (uint64_t)DVZ_TILES_SLOT_COUNT * DVZ_TILES_SLOT_SIZE * DVZ_TILES_SLOT_SIZE * channels,
+            1);
+
+    // Level sizes, down to a single tile.
+    uint32_t k = 0;
+    uint32_t w = width, h = height;
+    while (true)
+    {
+        tiles->levels[k].width = w;
+        tiles->levels[k].height = h;
+        tiles->levels[k].cols = (w + DVZ_TILES_SIZE - 1) / DVZ_TILES_SIZE;
+        tiles->levels[k].rows = (h + DVZ_TILES_SIZE - 1) / DVZ_TILES_SIZE;
+        k++;
+        if ((w <= DVZ_TILES_SIZE && h <= DVZ_TILES_SIZE) || k == DVZ_TILES_MAX_LEVELS)
+            break;
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+    tiles->level_count = k;
+    atomic_store(&tiles->levels_ready, 1);
+    if (tiles->level_count == 1)
+        return;
+
+    log_trace("start building the mip pyramid of a %dx%d image", width, height);
+    atomic_store(&tiles->to_stop, false);
+    atomic_store(&tiles->is_building, true);
+    tiles->thread = dvz_thread(_tiles_build, tiles);
+}
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+DvzTiles* dvz_tiles(void)
+{
+    DvzTiles* tiles = calloc(1, sizeof(DvzTiles));
+    atomic_init(&tiles->levels_ready, 0);
+    atomic_init(&tiles->is_building, false);
+    atomic_init(&tiles->to_stop, false);
+    dvz_obj_init(&tiles->obj);
+    dvz_obj_created(&tiles->obj);
+    return tiles;
+}
+
+
+
+void dvz_tiles_data(
+    DvzTiles* tiles, uint32_t width, uint32_t height, uint32_t channels, const uint8_t* pixels)
+{
+    ASSERT(tiles != NULL);
+    _tiles_data(tiles, width, height, channels, pixels, NULL);
+}
+
+
+
+int dvz_tiles_npy(DvzTiles* tiles, DvzNpy* npy)
+{
+    ASSERT(tiles != NULL);
+    ASSERT(npy != NULL);
+
+    uint32_t channels = npy->ndims == 3 ? (uint32_t)npy->shape[2] : 1;
+    if (npy->dtype != DVZ_DTYPE_CHAR || npy->descr[1] != 'u' || npy->fortran_order ||
+        npy->ndims < 2 || npy->ndims > 3 || (channels != 1 && channels != 4) ||
+        npy->shape[0] > UINT32_MAX || npy->shape[1] > UINT32_MAX)
+    {
+        log_error(
+            "the NPY array is not a C-ordered uint8 image with 1 or 4 channels (dtype %s)",
+            npy->descr);
+        return 1;
+    }
+    _tiles_data(
+        tiles, (uint32_t)npy->shape[1], (uint32_t)npy->shape[0], channels,
+        (const uint8_t*)npy->data, npy);
+    return 0;
+}
+
+
+
+void dvz_tiles_stop(DvzTiles* tiles)
+{
+    ASSERT(tiles != NULL);
+    if (!atomic_load(&tiles->is_building))
+        return;
+    atomic_store(&tiles->to_stop, true);
+    dvz_thread_join(&tiles->thread);
+    atomic_store(&tiles->is_building, false);
+    atomic_store(&tiles->to_stop, false);
+}
+
+
+
+bool dvz_tiles_ready(DvzTiles* tiles)
+{
+    ASSERT(tiles != NULL);
+    return tiles->level_count > 0 && atomic_load(&tiles->levels_ready) == tiles->level_count;
+}
+
+
+
+uint32_t dvz_tiles_level(DvzTiles* tiles, dvec2 scale)
+{
+    ASSERT(tiles != NULL);
+    uint32_t ready = atomic_load(&tiles->levels_ready);
+    if (ready == 0)
+        return 0;
+
+    // Number of image texels per screen pixel, along the most demanding axis.
+    double texels = MIN(tiles->width / MAX(scale[0], 1), tiles->height / MAX(scale[1], 1));
+    uint32_t level = 0;
+    while (level + 1 < ready && texels >= 2)
+    {
+        texels /= 2;
+        level++;
+    }
+    return level;
+}
+
+
+
+uint32_t
+dvz_tiles_visible(DvzTiles* tiles, uint32_t level, dvec4 box, uint32_t max_count, DvzTile* out)
+{
+    ASSERT(tiles != NULL);
+    ASSERT(level < tiles->level_count);
+    DvzTilesLevel* lvl = &tiles->levels[level];
+    ASSERT(lvl->cols > 0);
+    ASSERT(lvl->rows > 0);
+
+    double u0 = CLIP(box[0], 0, 1), v0 = CLIP(box[1], 0, 1);
+    double u1 = CLIP(box[2], 0, 1), v1 = CLIP(box[3], 0, 1);
+    if (u1 <= u0 || v1 <= v0)
+        return 0;
+
+    uint32_t c0 = MIN((uint32_t)(u0 * lvl->width / DVZ_TILES_SIZE), lvl->cols - 1);
+    uint32_t c1 = MIN((uint32_t)(u1 * lvl->width / DVZ_TILES_SIZE), lvl->cols - 1);
+    uint32_t r0 = MIN((uint32_t)(v0 * lvl->height / DVZ_TILES_SIZE), lvl->rows - 1);
+    uint32_t r1 = MIN((uint32_t)(v1 * lvl->height / DVZ_TILES_SIZE), lvl->rows - 1);
+
+    uint32_t n = 0;
+    for (uint32_t row = r0; row <= r1; row++)
+    {
+        for (uint32_t col = c0; col <= c1; col++)
+        {
+            if (out != NULL && n < max_count)
+                out[n] = (DvzTile){level, col, row};
+            n++;
+        }
+    }
+    return n;
+}
+
+
+
+bool dvz_tiles_changed(DvzTiles* tiles, dvec4 box, dvec2 scale)
+{
+    ASSERT(tiles != NULL);
+    if (tiles->level_count == 0)
+        return false;
+    return !tiles->is_complete ||
+           atomic_load(&tiles->levels_ready) != tiles->last_levels_ready ||
+           memcmp(box, tiles->box, sizeof(dvec4)) != 0 ||
+           memcmp(scale, tiles->scale, sizeof(dvec2)) != 0;
+}
+
+
+
+uint32_t dvz_tiles_update(DvzTiles* tiles, dvec4 box, dvec2 scale)
+{
+    ASSERT(tiles != NULL);
+    tiles->frame++;
+    tiles->upload_count = 0;
+    tiles->quad_count = 0;
+    tiles->is_complete = true;
+    memcpy(tiles->box, box, sizeof(dvec4));
+    memcpy(tiles->scale, scale, sizeof(dvec2));
+    tiles->last_levels_ready = atomic_load(&tiles->levels_ready);
+    if (tiles->last_levels_ready == 0)
+        return 0;
+
+    // Use a coarser level if there are too many visible tiles.
+    uint32_t level = dvz_tiles_level(tiles, scale);
+    uint32_t n = dvz_tiles_visible(tiles, level, box, 0, NULL);
+    while (n > DVZ_TILES_MAX_VISIBLE && level + 1 < tiles->last_levels_ready)
+        n = dvz_tiles_visible(tiles, ++level, box, 0, NULL);
+    if (n > DVZ_TILES_MAX_VISIBLE)
+    {
+        // Only while the coarse levels are being built.
+        log_debug("too many visible tiles (%d), truncating", n);
+        tiles->is_complete = false;
+    }
+
+    DvzTile visible[DVZ_TILES_MAX_VISIBLE] = {0};
+    n = MIN(dvz_tiles_visible(tiles, level, box, DVZ_TILES_MAX_VISIBLE, visible),
+            DVZ_TILES_MAX_VISIBLE);
+
+    DvzTile tile = {0}, ancestor = {0};
+    int32_t slot = 0;
+    uint32_t shift = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        tile = visible[i];
+        slot = _slot_find(tiles, tile);
+
+        // Load the missing tile, within the per-frame upload budget.
+        if (slot < 0 && tiles->upload_count < DVZ_TILES_MAX_UPLOADS)
+        {
+            slot = _slot_evict(tiles);
+            if (slot >= 0)
+            {
+                _slot_fill(tiles, (uint32_t)slot, tile);
+                tiles->uploads[tiles->upload_count++] = (uint32_t)slot;
+            }
+        }
+        if (slot >= 0)
+        {
+            tiles->slots[slot].frame = tiles->frame;
+            _tiles_quad(tiles, tile, tile, (uint32_t)slot);
+            continue;
+        }
+
+        // Otherwise, draw the closest resident ancestor.
+        tiles->is_complete = false;
+        for (uint32_t k = level + 1; k < tiles->last_levels_ready; k++)
+        {
+            shift = k - level;
+            ancestor = (DvzTile){k, tile.col >> shift, tile.row >> shift};
+            slot = _slot_find(tiles, ancestor);
+            if (slot >= 0)
+            {
+                tiles->slots[slot].frame = tiles->frame;
+                _tiles_quad(tiles, tile, ancestor, (uint32_t)slot);
+                break;
+            }
+        }
+    }
+
+    return tiles->quad_count;
+}
+
+
+
+void dvz_tiles_slot_offset(uint32_t slot, uvec3 offset)
+{
+    ASSERT(slot < DVZ_TILES_SLOT_COUNT);
+    offset[0] = (slot % DVZ_TILES_ATLAS_SLOTS) * DVZ_TILES_SLOT_SIZE;
+    offset[1] = (slot / DVZ_TILES_ATLAS_SLOTS) * DVZ_TILES_SLOT_SIZE;
+    offset[2] = 0;
+}
+
+
+
+uint8_t* dvz_tiles_slot_pixels(DvzTiles* tiles, uint32_t slot)
+{
+    ASSERT(tiles != NULL);
+    ASSERT(tiles->slot_pixels != NULL);
+    ASSERT(slot < DVZ_TILES_SLOT_COUNT);
+    return &tiles->slot_pixels
+                [(uint64_t)slot * DVZ_TILES_SLOT_SIZE * DVZ_TILES_SLOT_SIZE * tiles->channels];
+}
+
+
+
+void dvz_tiles_destroy(DvzTiles* tiles)
+{
+    if (tiles == NULL)
+        return;
+    dvz_tiles_stop(tiles);
+    _tiles_free_levels(tiles);
+    FREE(tiles->slot_pixels);
+    dvz_obj_destroyed(&tiles->obj);
+    FREE(tiles);
+}
@@ -252,7 +252,9 @@ void dvz_process_transfers(DvzCanvas* canvas)
     if (fifo->is_empty)
         return;
 
-    // Process all pending transfer tasks.
+    // Process all pending transfer tasks. The staging buffer and the transfer command buffer are
+    // shared by the canvases of the GPU, which may process their frames in parallel.
+    pthread_mutex_lock(&context->lock);
     DvzTransfer tr = {0};
     while (true)
     {
@@ -283,6 +285,7 @@ void dvz_process_transfers(DvzCanvas* canvas)
 
         fifo->is_processing = false;
     }
+    pthread_mutex_unlock(&context->lock);
 }
 
 
@@ -319,6 +322,9 @@ static void _enqueue_buffers_transfer(
     tr.u.buf.update_all_buffers = !canvas->app->is_running;
 
     _transfer_enqueue(&canvas->transfers, tr);
+
+    // The transfer is processed at the next frame, even if the canvas renders on demand.
+    dvz_canvas_redraw(canvas);
 }
 
 
@@ -335,6 +341,65 @@ void dvz_upload_buffers(
 
 
 
+void dvz_update_uniforms(
+    DvzCanvas* canvas, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size,
+    const void* data)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(br.buffer != NULL);
+    ASSERT(data != NULL);
+    ASSERT(size > 0);
+    ASSERT(offset + size <= br.size);
+
+    // The mappable uniform buffer is permanently mapped and host-coherent, so that the data can
+    // be written directly without any staging copy or flush.
+    ASSERT(br.buffer->type == DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE);
+    ASSERT(br.buffer->mmap != NULL);
+    ASSERT(br.count == canvas->swapchain.img_count);
+
+    // NOTE: the region of the current swapchain image is not in use by the GPU, as the frame
+    // callbacks are called after the swapchain image acquisition and the fence wait. This is the
+    // same synchronization as for the mappable uniforms going through the transfer queue.
+    if (canvas->app->is_running)
+    {
+        uint32_t idx = canvas->swapchain.img_idx;
+        ASSERT(idx < br.count);
+        memcpy((uint8_t*)br.buffer->mmap + br.offsets[idx] + offset, data, size);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < br.count; i++)
+            memcpy((uint8_t*)br.buffer->mmap + br.offsets[i] + offset, data, size);
+    }
+}
+
+
+
+void dvz_upload_uniforms(
+    DvzCanvas* canvas, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size,
+    const void* data)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(br.buffer != NULL);
+    ASSERT(data != NULL);
+    ASSERT(size > 0);
+    ASSERT(offset + size <= br.size);
+    ASSERT(br.buffer->type == DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE);
+    ASSERT(br.buffer->mmap != NULL);
+
+    // NOTE: the regions of the other swapchain images may be read by the frames in flight, which
+    // must finish first. The fences are only reset when the next frame is submitted.
+    if (canvas->app->is_running)
+    {
+        for (uint32_t i = 0; i < canvas->fences_render_finished.count; i++)
+            dvz_fences_wait(&canvas->fences_render_finished, i);
+    }
+    for (uint32_t i = 0; i < br.count; i++)
+        memcpy((uint8_t*)br.buffer->mmap + br.offsets[i] + offset, data, size);
+}
+
+
+
 void dvz_download_buffers(
     DvzCanvas* canvas, DvzBufferRegions br, VkDeviceSize offset, VkDeviceSize size, void* data)
 {
@@ -414,6 +479,7 @@ static void _enqueue_texture_transfer(
     tr.u.tex.texture = texture;
 
     _transfer_enqueue(&canvas->transfers, tr);
+    dvz_canvas_redraw(canvas);
 }
 
 
@@ -15,6 +15,8 @@ DvzVisual dvz_visual(DvzCanvas* canvas)
 
     DvzVisual visual = {0};
     visual.canvas = canvas;
+    // NOTE: 0 is reserved for the background in the picking attachment.
+    visual.pick_id = ++canvas->pick.id_count;
     visual.props =
         dvz_container(DVZ_CONTAINER_DEFAULT_COUNT, sizeof(DvzProp), DVZ_OBJECT_TYPE_PROP);
     visual.sources =
@@ -28,6 +30,12 @@ DvzVisual dvz_visual(DvzCanvas* canvas)
     visual.callback_fill = _default_visual_fill;
     visual.callback_bake = _default_visual_bake;
 
+    // Background bake.
+    if (pthread_mutex_init(&visual.bake.lock, NULL) != 0)
+        log_error("mutex creation failed");
+    if (pthread_cond_init(&visual.bake.cond, NULL) != 0)
+        log_error("cond creation failed");
+
     dvz_obj_created(&visual.obj);
     return visual;
 }
@@ -38,6 +46,17 @@ void dvz_visual_destroy(DvzVisual* visual)
 {
     ASSERT(visual != NULL);
 
+    // The worker thread may still be baking the visual.
+    dvz_visual_bake_wait(visual);
+
+    // The decimation pyramid refers to the POS prop data, so it must be destroyed first.
+    dvz_lod_destroy(visual->lod);
+    visual->lod = NULL;
+    dvz_tiles_destroy(visual->tiles);
+    visual->tiles = NULL;
+    dvz_bricks_destroy(visual->bricks);
+    visual->bricks = NULL;
+
     // Free the props.
     DvzProp* prop = NULL;
     DvzContainerIterator iter = dvz_container_iterator(&visual->props);
@@ -63,6 +82,7 @@ void dvz_visual_destroy(DvzVisual* visual)
     {
         source = iter.item;
         dvz_array_destroy(&source->arr);
+        dvz_array_destroy(&source->arr_back);
         dvz_obj_destroyed(&source->obj);
         dvz_container_iter(&iter);
     }
@@ -71,6 +91,40 @@ void dvz_visual_destroy(DvzVisual* visual)
     CONTAINER_DESTROY_ITEMS(DvzBindings, visual->bindings, dvz_bindings_destroy)
     CONTAINER_DESTROY_ITEMS(DvzBindings, visual->bindings_comp, dvz_bindings_destroy)
 
+    // GPU culling objects.
+    if (visual->culling != NULL)
+    {
+        dvz_bindings_destroy(&visual->culling->bindings);
+        dvz_compute_destroy(visual->culling->compute);
+        FREE(visual->culling);
+    }
+
+    // GPU binning objects.
+    if (visual->binning != NULL)
+    {
+        dvz_fences_wait(&visual->binning->fence, 0);
+        dvz_commands_destroy(&visual->binning->cmds);
+        dvz_fences_destroy(&visual->binning->fence);
+        dvz_bindings_destroy(&visual->binning->bindings);
+        dvz_compute_destroy(visual->binning->compute);
+        FREE(visual->binning);
+    }
+
+    // GPU density objects.
+    if (visual->density != NULL)
+    {
+        for (uint32_t i = 0; i < visual->density->fence.count; i++)
+            dvz_fences_wait(&visual->density->fence, i);
+        dvz_commands_destroy(&visual->density->cmds);
+        dvz_fences_destroy(&visual->density->fence);
+        dvz_bindings_destroy(&visual->density->bindings);
+        dvz_compute_destroy(visual->density->compute);
+        FREE(visual->density);
+    }
+
+    pthread_cond_destroy(&visual->bake.cond);
+    pthread_mutex_destroy(&visual->bake.lock);
+
     dvz_obj_destroyed(&visual->obj);
 }
 
@@ -98,14 +152,21 @@ void dvz_visual_source(
     source->pipeline_idx = pipeline_idx;
     source->slot_idx = slot_idx;
     source->flags = flags;
+    // The parameters are small uniforms, written directly in the mapped uniform buffer.
+    if (source_type == DVZ_SOURCE_TYPE_PARAM)
+        source->flags |= DVZ_SOURCE_FLAG_MAPPABLE;
 
     if (source->source_kind < DVZ_SOURCE_KIND_TEXTURE_1D)
+    {
         source->arr = dvz_array_struct(0, item_size);
+        source->arr_back = dvz_array_struct(0, item_size);
+    }
     else
     {
         // Textures.
         uint32_t ndims = _get_texture_ndims(source->source_kind);
         source->arr = dvz_array_3D(ndims, 0, 0, 0, item_size);
+        source->arr_back = dvz_array_3D(ndims, 0, 0, 0, item_size);
     }
 
     // source origin (GPU object) not set yet
@@ -292,6 +353,9 @@ void dvz_visual_data_partial(
     ASSERT(count > 0);
     ASSERT(data_item_count > 0);
 
+    // The props must not change while the worker thread bakes the visual.
+    dvz_visual_bake_wait(visual);
+
     // Get the associated prop.
     DvzProp* prop = dvz_prop_get(visual, prop_type, prop_idx);
     ASSERT(prop != NULL);
@@ -311,17 +375,24 @@ void dvz_visual_data_partial(
     }
 
     // Make sure the array has the right size.
+    uint32_t prev_count = prop->arr_orig.item_count;
     dvz_array_resize(&prop->arr_orig, count);
 
     // Copy the specified array to the prop array.
     dvz_array_data(&prop->arr_orig, first_item, item_count, data_item_count, data);
+    if (prev_count != count)
+        _prop_set_changed(prop, 0, count);
+    else
+        _prop_set_changed(prop, first_item, item_count);
 
     prop->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+    dvz_canvas_redraw(visual->canvas);
 
     if (source != NULL)
     {
         log_trace("source type %d #%d handled by lib", source->source_type, source->source_idx);
         source->origin = DVZ_SOURCE_ORIGIN_LIB;
+        source->stream = NULL;
         // source->obj.status = DVZ_OBJECT_STATUS_NEED_UPDATE;
         // visual->obj.status = DVZ_OBJECT_STATUS_NEED_UPDATE;
         _source_set_changed(source, true);
@@ -395,6 +466,7 @@ void dvz_visual_data_source(
     dvz_array_data(&source->arr, first_item, item_count, data_item_count, data);
 
     source->origin = DVZ_SOURCE_ORIGIN_NOBAKE;
+    source->stream = NULL;
     // source->obj.status = DVZ_OBJECT_STATUS_NEED_UPDATE;
     // visual->obj.status = DVZ_OBJECT_STATUS_NEED_UPDATE;
     _source_set_changed(source, true);
@@ -402,6 +474,135 @@ void dvz_visual_data_source(
 
 
 
+void dvz_visual_data_stream(
+    DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx, //
+    uint32_t item_count, uint32_t chunk_count, const void* data)
+{
+    ASSERT(visual != NULL);
+    ASSERT(item_count > 0);
+    ASSERT(chunk_count > 0);
+    ASSERT(data != NULL);
+
+    // The source arrays must not change while the worker thread bakes the visual.
+    dvz_visual_bake_wait(visual);
+
+    DvzSource* source = _assert_source_exists(visual, source_type, source_idx);
+    ASSERT(source != NULL);
+    ASSERT(_source_is_buffer(source->source_kind));
+    ASSERT(source->source_kind != DVZ_SOURCE_KIND_UNIFORM);
+
+    // The streamed items are not copied in the source array, which only keeps track of the
+    // number of items already uploaded.
+    DvzArray* arr = &source->arr;
+    ASSERT(arr->item_size > 0);
+    FREE(arr->data);
+    arr->buffer_size = 0;
+    arr->item_count = 0;
+
+    source->stream = data;
+    source->stream_count = item_count;
+    source->stream_chunk = chunk_count;
+    source->stream_npy = NULL;
+    source->stream_released = 0;
+    source->origin = DVZ_SOURCE_ORIGIN_NOBAKE;
+    _source_set(source);
+
+    // Allocate the GPU buffer for all items, so that it is not reallocated during the stream.
+    VkDeviceSize size = item_count * arr->item_size;
+    if (source->u.br.buffer == NULL || source->u.br.size < size)
+    {
+        log_debug(
+            "allocate buffer region for %d streamed items (%s)", item_count, pretty_size(size));
+        _create_source_buffer(visual->canvas, source, size);
+        _set_source_bindings(visual, source);
+    }
+}
+
+
+
+void dvz_visual_npy(DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx, DvzNpy* npy)
+{
+    ASSERT(visual != NULL);
+    ASSERT(npy != NULL);
+    DvzSource* source = _assert_source_exists(visual, source_type, source_idx);
+    ASSERT(source != NULL);
+
+    VkDeviceSize item_size = source->arr.item_size;
+    ASSERT(item_size > 0);
+    if (npy->size == 0 || npy->size % item_size != 0)
+    {
+        log_error(
+            "file payload of %s is not a multiple of the source item size (%d bytes)",
+            pretty_size(npy->size), (int)item_size);
+        return;
+    }
+    // The items are uploaded as they are in the file, so the array must be in C order.
+    if (npy->fortran_order && npy->ndims > 1)
+    {
+        log_error("cannot stream a %d-dimensional array in Fortran order", npy->ndims);
+        return;
+    }
+    if (npy->size / item_size > UINT32_MAX)
+    {
+        log_error("too many items to stream in a source: %s", pretty_size(npy->size));
+        return;
+    }
+    uint32_t item_count = (uint32_t)(npy->size / item_size);
+    uint32_t chunk_count = MAX(1, (uint32_t)(DVZ_NPY_CHUNK_SIZE / item_size));
+    dvz_visual_data_stream(visual, source_type, source_idx, item_count, chunk_count, npy->data);
+    source->stream_npy = npy;
+}
+
+
+
+bool dvz_visual_stream(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+
+    bool has_uploaded = false;
+    DvzArray* arr = NULL;
+    DvzSource* source = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->sources);
+    while (iter.item != NULL)
+    {
+        source = iter.item;
+        arr = &source->arr;
+
+        // The chunks uploaded by the previous calls have been transferred by now, their file
+        // pages are no longer needed.
+        if (source->stream != NULL && source->stream_npy != NULL &&
+            source->stream_released < arr->item_count)
+        {
+            dvz_npy_release(
+                source->stream_npy, source->stream_released * arr->item_size,
+                (arr->item_count - source->stream_released) * arr->item_size);
+            source->stream_released = arr->item_count;
+        }
+
+        if (source->stream != NULL && arr->item_count < source->stream_count)
+        {
+            uint32_t count = MIN(source->stream_chunk, source->stream_count - arr->item_count);
+            VkDeviceSize offset = arr->item_count * arr->item_size;
+            VkDeviceSize size = count * arr->item_size;
+            log_trace(
+                "stream %d items to source %d #%d (%d/%d)", count, source->source_type,
+                source->source_idx, arr->item_count + count, source->stream_count);
+
+            // NOTE: the transfer reads the streamed region directly, there is no copy.
+            dvz_upload_buffers(
+                canvas, source->u.br, offset, size, (uint8_t*)source->stream + offset);
+            arr->item_count += count;
+            has_uploaded = true;
+        }
+        dvz_container_iter(&iter);
+    }
+    return has_uploaded;
+}
+
+
+
 // Means that no data updates will be done by datoviz, it is up to the user to update the bound
 // buffer
 void dvz_visual_buffer(
@@ -418,6 +619,7 @@ void dvz_visual_buffer(
 
     source->u.br = br;
     source->origin = DVZ_SOURCE_ORIGIN_USER;
+    source->stream = NULL;
     _source_set_changed(source, true);
     // source->obj.status = DVZ_OBJECT_STATUS_NEED_UPDATE;
     // visual->obj.status = DVZ_OBJECT_STATUS_NEED_UPDATE;
@@ -522,6 +724,777 @@ void dvz_visual_fill_end(DvzCanvas* canvas, DvzCommands* cmds, uint32_t idx)
 
 
 
+/*************************************************************************************************/
+/*  GPU culling                                                                                  */
+/*************************************************************************************************/
+
+#define DVZ_CULLING_WORKGROUP_SIZE 64 // must match the local size in compute_cull.comp
+
+// Push constant of compute_cull.comp.
+typedef struct
+{
+    uint32_t count;       // number of vertices
+    uint32_t stride;      // vertex stride, in floats
+    uint32_t first;       // offset of the first vertex within the bound region, in floats
+    uint32_t size_offset; // in floats
+    uint32_t mode_offset; // in bytes
+    float margin;         // in pixels
+} DvzCullingPush;
+
+
+
+static bool _br_equal(DvzBufferRegions* a, DvzBufferRegions* b)
+{
+    ASSERT(a != NULL);
+    ASSERT(b != NULL);
+    return a->buffer == b->buffer && a->count == b->count && a->size == b->size &&
+           a->offsets[0] == b->offsets[0];
+}
+
+
+
+// Bind a buffer to a compute shader, only if it has changed.
+static bool _compute_bind(DvzBindings* bindings, uint32_t idx, DvzBufferRegions br)
+{
+    ASSERT(bindings != NULL);
+    if (_br_equal(&bindings->br[idx], &br))
+        return false;
+    dvz_bindings_buffer(bindings, idx, br);
+    return true;
+}
+
+
+
+void dvz_visual_culling(DvzVisual* visual, float margin)
+{
+    ASSERT(visual != NULL);
+    ASSERT(margin >= 0);
+    if (visual->culling != NULL)
+    {
+        visual->culling->margin = margin;
+        return;
+    }
+    if (visual->graphics_count != 1)
+    {
+        log_error("GPU culling is only supported for visuals with a single graphics pipeline");
+        return;
+    }
+
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzGpu* gpu = canvas->gpu;
+    ASSERT(gpu != NULL);
+    DvzContext* ctx = gpu->context;
+    ASSERT(ctx != NULL);
+    uint32_t img_count = canvas->swapchain.img_count;
+
+    DvzVisualCulling* culling = calloc(1, sizeof(DvzVisualCulling));
+    culling->margin = margin;
+
+    // Compute pipeline with the builtin culling shader.
+    culling->compute = dvz_ctx_compute(ctx, "");
+    DvzCompute* compute = culling->compute;
+    dvz_compute_slot(compute, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER); // MVP
+    dvz_compute_slot(compute, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER); // viewport
+    dvz_compute_slot(compute, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER); // vertices
+    dvz_compute_slot(compute, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER); // visible indices
+    dvz_compute_slot(compute, 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER); // indirect draw command
+    dvz_compute_push(compute, 0, sizeof(DvzCullingPush), VK_SHADER_STAGE_COMPUTE_BIT);
+
+    culling->bindings = dvz_bindings(&compute->slots, img_count);
+    dvz_compute_bindings(compute, &culling->bindings);
+
+    unsigned long size = 0;
+    unsigned char* buffer = dvz_resource_shader("compute_cull_comp", &size);
+    ASSERT(buffer != NULL);
+    ASSERT(size > 0 && size % 4 == 0);
+    uint32_t* code = (uint32_t*)calloc(size, 1);
+    memcpy(code, buffer, size);
+    dvz_compute_spirv(compute, size, code);
+    FREE(code);
+    dvz_compute_create(compute);
+
+    // One indirect draw command per swapchain image, the index regions are allocated lazily.
+    culling->br_indirect = dvz_ctx_buffers(
+        ctx, DVZ_BUFFER_TYPE_STORAGE, img_count, sizeof(VkDrawIndexedIndirectCommand));
+    dvz_bindings_buffer(&culling->bindings, 4, culling->br_indirect);
+
+    visual->culling = culling;
+}
+
+
+
+void dvz_visual_cull(DvzVisual* visual, DvzCommands* cmds, uint32_t idx)
+{
+    ASSERT(visual != NULL);
+    ASSERT(cmds != NULL);
+    if (!_culling_ready(visual))
+        return;
+
+    DvzVisualCulling* culling = visual->culling;
+    ASSERT(culling != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzGpu* gpu = canvas->gpu;
+    ASSERT(gpu != NULL);
+
+    DvzSource* vertex_source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    ASSERT(vertex_source != NULL);
+    uint32_t count = vertex_source->arr.item_count;
+    VkDeviceSize item_size = vertex_source->arr.item_size;
+    ASSERT(count > 0);
+    ASSERT(item_size % 4 == 0);
+
+    // Grow the index regions if needed. As elsewhere, the previous regions are not reused.
+    if (count > culling->capacity)
+    {
+        culling->capacity = (uint32_t)dvz_next_pow2(count);
+        log_debug("allocate %d indices for GPU culling", culling->capacity);
+        culling->br_index = dvz_ctx_buffers(
+            gpu->context, DVZ_BUFFER_TYPE_STORAGE, canvas->swapchain.img_count,
+            culling->capacity * sizeof(DvzIndex));
+    }
+
+    // The vertex region is bound from an aligned offset, the shift is passed to the shader.
+    DvzBufferRegions br_vertex = vertex_source->u.br;
+    ASSERT(br_vertex.count == 1);
+    VkDeviceSize alignment = gpu->device_properties.limits.minStorageBufferOffsetAlignment;
+    VkDeviceSize shift = alignment > 0 ? br_vertex.offsets[0] % alignment : 0;
+    ASSERT(shift % 4 == 0);
+    br_vertex.offsets[0] -= shift;
+    br_vertex.size += shift;
+
+    // Update the bindings if the buffer regions have changed.
+    bool changed = false;
+    DvzBindings* bindings = &culling->bindings;
+    changed |= _compute_bind(bindings, 0, dvz_source_get(visual, DVZ_SOURCE_TYPE_MVP, 0)->u.br);
+    changed |=
+        _compute_bind(bindings, 1, dvz_source_get(visual, DVZ_SOURCE_TYPE_VIEWPORT, 0)->u.br);
+    changed |= _compute_bind(bindings, 2, br_vertex);
+    changed |= _compute_bind(bindings, 3, culling->br_index);
+    if (changed || culling->bindings.obj.status == DVZ_OBJECT_STATUS_NEED_UPDATE)
+        dvz_bindings_update(&culling->bindings);
+
+    // Reset the indirect draw command: no index yet, a single instance.
+    dvz_cmd_fill_buffer(cmds, idx, culling->br_indirect, 0, 4, 0);
+    dvz_cmd_fill_buffer(cmds, idx, culling->br_indirect, 4, 4, 1);
+    dvz_cmd_fill_buffer(
+        cmds, idx, culling->br_indirect, 8, sizeof(VkDrawIndexedIndirectCommand) - 8, 0);
+
+    DvzBarrier barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    dvz_barrier_buffer(&barrier, culling->br_indirect);
+    dvz_barrier_buffer_access(
+        &barrier, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    dvz_cmd_barrier(cmds, idx, &barrier);
+
+    // Culling pass, with a 2D dispatch when there are too many workgroups for one dimension.
+    DvzCullingPush push = {0};
+    push.count = count;
+    push.stride = item_size / 4;
+    push.first = shift / 4;
+    push.size_offset = culling->size_offset / 4;
+    push.mode_offset = culling->mode_offset;
+    push.margin = culling->margin;
+    dvz_cmd_push(
+        cmds, idx, &culling->compute->slots, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push),
+        &push);
+
+    uint32_t groups = (count + DVZ_CULLING_WORKGROUP_SIZE - 1) / DVZ_CULLING_WORKGROUP_SIZE;
+    uint32_t gx = MIN(groups, gpu->device_properties.limits.maxComputeWorkGroupCount[0]);
+    uint32_t gy = (groups + gx - 1) / gx;
+    dvz_cmd_compute(cmds, idx, culling->compute, (uvec3){gx, gy, 1});
+
+    // The draw call waits for the indices and the indirect command.
+    barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+    dvz_barrier_buffer(&barrier, culling->br_indirect);
+    dvz_barrier_buffer_access(
+        &barrier, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    dvz_barrier_buffer(&barrier, culling->br_index);
+    dvz_barrier_buffer_access(&barrier, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDEX_READ_BIT);
+    dvz_cmd_barrier(cmds, idx, &barrier);
+}
+
+
+
+/*************************************************************************************************/
+/*  GPU binning                                                                                  */
+/*************************************************************************************************/
+
+// Must match compute_histogram.comp.
+#define DVZ_BINNING_WORKGROUP_SIZE         256
+#define DVZ_BINNING_SAMPLES_PER_INVOCATION 16
+
+typedef enum
+{
+    DVZ_BINNING_PASS_BIN, // count the samples into the bins
+    DVZ_BINNING_PASS_MAX, // reduce the bin counts to the largest count
+} DvzBinningPass;
+
+// Push constant of compute_histogram.comp.
+typedef struct
+{
+    vec2 range;         // range of the sample values covered by the bins
+    uint32_t count;     // number of samples
+    uint32_t first;     // offset of the first sample within the bound region, in floats
+    uint32_t bin_count; // number of bins
+    uint32_t pass;      // DvzBinningPass
+} DvzBinningPush;
+
+
+
+void dvz_visual_binning(DvzVisual* visual, uint32_t bin_count, vec2 range)
+{
+    ASSERT(visual != NULL);
+    ASSERT(bin_count > 0);
+
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzGpu* gpu = canvas->gpu;
+    ASSERT(gpu != NULL);
+    DvzContext* ctx = gpu->context;
+    ASSERT(ctx != NULL);
+
+    if (visual->binning == NULL)
+    {
+        DvzVisualBinning* binning = calloc(1, sizeof(DvzVisualBinning));
+
+        // Compute pipeline with the builtin binning shader.
+        binning->compute = dvz_ctx_compute(ctx, "");
+        DvzCompute* compute = binning->compute;
+        dvz_compute_slot(compute, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER); // samples
+        dvz_compute_slot(compute, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER); // bin counts
+        dvz_compute_push(compute, 0, sizeof(DvzBinningPush), VK_SHADER_STAGE_COMPUTE_BIT);
+
+        binning->bindings = dvz_bindings(&compute->slots, 1);
+        dvz_compute_bindings(compute, &binning->bindings);
+
+        unsigned long size = 0;
+        unsigned char* buffer = dvz_resource_shader("compute_histogram_comp", &size);
+        ASSERT(buffer != NULL);
+        ASSERT(size > 0 && size % 4 == 0);
+        uint32_t* code = (uint32_t*)calloc(size, 1);
+        memcpy(code, buffer, size);
+        dvz_compute_spirv(compute, size, code);
+        FREE(code);
+        dvz_compute_create(compute);
+
+        // The binning pass is submitted to the render queue, before the frames that use it.
+        binning->cmds = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_RENDER, 1);
+        binning->fence = dvz_fences(gpu, 1, true);
+        binning->submit = dvz_submit(gpu);
+
+        visual->binning = binning;
+    }
+    DvzVisualBinning* binning = visual->binning;
+    ASSERT(binning != NULL);
+
+    // Grow the bin counts region if needed. As elsewhere, the previous region is not reused.
+    if (bin_count > binning->capacity)
+    {
+        binning->capacity = (uint32_t)dvz_next_pow2(bin_count);
+        log_debug("allocate %d bins for GPU binning", binning->capacity);
+        binning->br_counts = dvz_ctx_buffers(
+            ctx, DVZ_BUFFER_TYPE_STORAGE, 1, (1 + binning->capacity) * sizeof(uint32_t));
+        dvz_bindings_buffer(&binning->bindings, 1, binning->br_counts);
+        dvz_visual_buffer(visual, DVZ_SOURCE_TYPE_COUNTS, 0, binning->br_counts);
+        atomic_store(&binning->dirty, true);
+    }
+
+    if (bin_count != binning->bin_count || //
+        range[0] != binning->range[0] || range[1] != binning->range[1])
+    {
+        binning->bin_count = bin_count;
+        binning->range[0] = range[0];
+        binning->range[1] = range[1];
+        atomic_store(&binning->dirty, true);
+    }
+}
+
+
+
+void dvz_visual_bin(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzVisualBinning* binning = visual->binning;
+    if (binning == NULL || binning->bin_count == 0)
+        return;
+
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_SAMPLES, 0);
+    if (source == NULL || source->u.br.buffer == NULL)
+        return;
+
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzGpu* gpu = canvas->gpu;
+    ASSERT(gpu != NULL);
+
+    // The samples set by the user with dvz_visual_buffer() fill the whole region.
+    DvzBufferRegions br_samples = source->u.br;
+    ASSERT(br_samples.count == 1);
+    uint32_t count = source->origin == DVZ_SOURCE_ORIGIN_USER
+                         ? (uint32_t)(br_samples.size / sizeof(float))
+                         : source->arr.item_count;
+    if (count == 0)
+        return;
+
+    // The samples region is bound from an aligned offset, the shift is passed to the shader.
+    VkDeviceSize alignment = gpu->device_properties.limits.minStorageBufferOffsetAlignment;
+    VkDeviceSize shift = alignment > 0 ? br_samples.offsets[0] % alignment : 0;
+    ASSERT(shift % 4 == 0);
+    br_samples.offsets[0] -= shift;
+    br_samples.size += shift;
+    if (!_br_equal(&binning->br_samples, &br_samples))
+    {
+        binning->br_samples = br_samples;
+        atomic_store(&binning->dirty, true);
+    }
+
+    if (!atomic_load(&binning->dirty))
+        return;
+    log_debug("bin %d samples into %d bins", count, binning->bin_count);
+
+    // Wait for the previous binning pass before recording the command buffer again.
+    dvz_fences_wait(&binning->fence, 0);
+    _compute_bind(&binning->bindings, 0, br_samples);
+    if (binning->bindings.obj.status == DVZ_OBJECT_STATUS_NEED_UPDATE)
+        dvz_bindings_update(&binning->bindings);
+
+    DvzCommands* cmds = &binning->cmds;
+    dvz_cmd_reset(cmds, 0);
+    dvz_cmd_begin(cmds, 0);
+
+    // Reset the maximum count and the bin counts, once the previous frames have read them.
+    DvzBarrier barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_buffer(&barrier, binning->br_counts);
+    dvz_barrier_buffer_access(&barrier, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    dvz_cmd_barrier(cmds, 0, &barrier);
+
+    dvz_cmd_fill_buffer(
+        cmds, 0, binning->br_counts, 0, (1 + binning->bin_count) * sizeof(uint32_t), 0);
+
+    barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    dvz_barrier_buffer(&barrier, binning->br_counts);
+    dvz_barrier_buffer_access(
+        &barrier, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    dvz_cmd_barrier(cmds, 0, &barrier);
+
+    // Binning pass, with a 2D dispatch when there are too many workgroups for one dimension.
+    DvzBinningPush push = {0};
+    push.range[0] = binning->range[0];
+    push.range[1] = binning->range[1];
+    push.count = count;
+    push.first = shift / 4;
+    push.bin_count = binning->bin_count;
+    push.pass = DVZ_BINNING_PASS_BIN;
+    dvz_cmd_push(
+        cmds, 0, &binning->compute->slots, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+
+    const uint32_t per_group = DVZ_BINNING_WORKGROUP_SIZE * DVZ_BINNING_SAMPLES_PER_INVOCATION;
+    uint32_t groups = (uint32_t)(((uint64_t)count + per_group - 1) / per_group);
+    uint32_t gx = MIN(groups, gpu->device_properties.limits.maxComputeWorkGroupCount[0]);
+    uint32_t gy = (groups + gx - 1) / gx;
+    dvz_cmd_compute(cmds, 0, binning->compute, (uvec3){gx, gy, 1});
+
+    // Largest count, reduced over the bins by a single workgroup once all samples are binned.
+    barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    dvz_barrier_buffer(&barrier, binning->br_counts);
+    dvz_barrier_buffer_access(
+        &barrier, VK_ACCESS_SHADER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    dvz_cmd_barrier(cmds, 0, &barrier);
+
+    push.pass = DVZ_BINNING_PASS_MAX;
+    dvz_cmd_push(
+        cmds, 0, &binning->compute->slots, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    dvz_cmd_compute(cmds, 0, binning->compute, (uvec3){1, 1, 1});
+
+    // The bars of the next frames read the bin counts in the vertex shader.
+    barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+    dvz_barrier_buffer(&barrier, binning->br_counts);
+    dvz_barrier_buffer_access(&barrier, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    dvz_cmd_barrier(cmds, 0, &barrier);
+
+    dvz_cmd_end(cmds, 0);
+
+    dvz_submit_reset(&binning->submit);
+    dvz_submit_commands(&binning->submit, cmds);
+    dvz_submit_send(&binning->submit, 0, &binning->fence, 0);
+    atomic_store(&binning->dirty, false);
+}
+
+
+
+/*************************************************************************************************/
+/*  GPU density                                                                                  */
+/*************************************************************************************************/
+
+#define DVZ_DENSITY_WORKGROUP_SIZE 64  // must match the local size in compute_density.comp
+#define DVZ_DENSITY_HIST_SIZE      256 // must match HIST_SIZE in the density shaders
+// Number of uint32 words before the density image: max value, norm, width, height, histogram.
+#define DVZ_DENSITY_HEADER_SIZE (4 + DVZ_DENSITY_HIST_SIZE)
+
+// Passes of compute_density.comp.
+typedef enum
+{
+    DVZ_DENSITY_PASS_ACCUMULATE, // sum the weights of the points in the pixels
+    DVZ_DENSITY_PASS_MAX,        // reduce the pixels to the largest value
+    DVZ_DENSITY_PASS_HIST,       // histogram of the non-empty pixels
+    DVZ_DENSITY_PASS_CDF,        // cumulative histogram
+} DvzDensityPass;
+
+// Push constant of compute_density.comp.
+typedef struct
+{
+    uint32_t pass;        // DvzDensityPass
+    uint32_t count;       // number of points
+    uint32_t first;       // offset of the first point within the bound region, in floats
+    uint32_t pixel_count; // number of pixels in the density image
+} DvzDensityPush;
+
+
+
+// Allocate the density image and bind it to both pipelines.
+static void _density_alloc(DvzVisual* visual, uint32_t pixel_count)
+{
+    ASSERT(visual != NULL);
+    DvzVisualDensity* density = visual->density;
+    ASSERT(density != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+
+    // As elsewhere, the previous region is not reused.
+    density->capacity = (uint32_t)dvz_next_pow2(pixel_count);
+    log_debug("allocate %d pixels for the GPU density", density->capacity);
+    density->br_density = dvz_ctx_buffers(
+        canvas->gpu->context, DVZ_BUFFER_TYPE_STORAGE, 1,
+        (DVZ_DENSITY_HEADER_SIZE + density->capacity) * sizeof(uint32_t));
+
+    dvz_bindings_buffer(&density->bindings, 3, density->br_density);
+    dvz_visual_buffer(visual, DVZ_SOURCE_TYPE_COUNTS, 0, density->br_density);
+    atomic_store(&density->dirty, true);
+}
+
+
+
+// Record a compute pass of the density shader.
+static void _density_pass(
+    DvzVisualDensity* density, uint32_t idx, DvzDensityPush* push, uint32_t item_count)
+{
+    ASSERT(density != NULL);
+    ASSERT(push != NULL);
+    DvzCommands* cmds = &density->cmds;
+    DvzGpu* gpu = cmds->gpu;
+    ASSERT(gpu != NULL);
+
+    dvz_cmd_push(
+        cmds, idx, &density->compute->slots, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(*push), push);
+
+    // 2D dispatch when there are too many workgroups for one dimension.
+    ASSERT(item_count > 0);
+    uint32_t groups = (item_count + DVZ_DENSITY_WORKGROUP_SIZE - 1) / DVZ_DENSITY_WORKGROUP_SIZE;
+    uint32_t gx = MIN(groups, gpu->device_properties.limits.maxComputeWorkGroupCount[0]);
+    uint32_t gy = (groups + gx - 1) / gx;
+    dvz_cmd_compute(cmds, idx, density->compute, (uvec3){gx, gy, 1});
+}
+
+
+
+// Record a barrier between two compute passes of the density shader.
+static void _density_barrier(DvzVisualDensity* density, uint32_t idx)
+{
+    ASSERT(density != NULL);
+    DvzBarrier barrier = dvz_barrier(density->cmds.gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    dvz_barrier_buffer(&barrier, density->br_density);
+    dvz_barrier_buffer_access(
+        &barrier, VK_ACCESS_SHADER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    dvz_cmd_barrier(&density->cmds, idx, &barrier);
+}
+
+
+
+void dvz_visual_density(DvzVisual* visual, DvzDensityNorm norm)
+{
+    ASSERT(visual != NULL);
+    if (visual->density != NULL)
+    {
+        // The normalization is written in the header of the density image.
+        if (visual->density->norm != norm)
+        {
+            visual->density->norm = norm;
+            atomic_store(&visual->density->dirty, true);
+        }
+        return;
+    }
+
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzGpu* gpu = canvas->gpu;
+    ASSERT(gpu != NULL);
+    DvzContext* ctx = gpu->context;
+    ASSERT(ctx != NULL);
+    uint32_t img_count = canvas->swapchain.img_count;
+
+    DvzVisualDensity* density = calloc(1, sizeof(DvzVisualDensity));
+    density->norm = norm;
+
+    // Compute pipeline with the builtin density shader.
+    density->compute = dvz_ctx_compute(ctx, "");
+    DvzCompute* compute = density->compute;
+    dvz_compute_slot(compute, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER); // MVP
+    dvz_compute_slot(compute, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER); // viewport
+    dvz_compute_slot(compute, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER); // points
+    dvz_compute_slot(compute, 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER); // density image
+    dvz_compute_push(compute, 0, sizeof(DvzDensityPush), VK_SHADER_STAGE_COMPUTE_BIT);
+
+    // NOTE: one descriptor set per swapchain image, as the MVP uniform is written in the region
+    // of the swapchain image being rendered.
+    density->bindings = dvz_bindings(&compute->slots, img_count);
+    dvz_compute_bindings(compute, &density->bindings);
+
+    unsigned long size = 0;
+    unsigned char* buffer = dvz_resource_shader("compute_density_comp", &size);
+    ASSERT(buffer != NULL);
+    ASSERT(size > 0 && size % 4 == 0);
+    uint32_t* code = (uint32_t*)calloc(size, 1);
+    memcpy(code, buffer, size);
+    dvz_compute_spirv(compute, size, code);
+    FREE(code);
+    dvz_compute_create(compute);
+
+    // The density passes are submitted to the render queue, before the frames that use them.
+    density->cmds = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_RENDER, img_count);
+    density->fence = dvz_fences(gpu, img_count, true);
+    density->submit = dvz_submit(gpu);
+
+    visual->density = density;
+
+    // The density image is bound before the first upload, with the size of the canvas that
+    // contains all panel viewports.
+    uvec2 fb_size = {0};
+    dvz_canvas_size(canvas, DVZ_CANVAS_SIZE_FRAMEBUFFER, fb_size);
+    _density_alloc(visual, MAX(1, fb_size[0] * fb_size[1]));
+}
+
+
+
+void dvz_visual_density_viewport(DvzVisual* visual, DvzViewport viewport)
+{
+    ASSERT(visual != NULL);
+    DvzVisualDensity* density = visual->density;
+    if (density == NULL)
+        return;
+
+    // Grow the density image if needed. The graphics bindings are used by the render pass
+    // recorded right after this call, they must be updated now.
+    uint32_t pixel_count = (uint32_t)viewport.viewport.width * (uint32_t)viewport.viewport.height;
+    if (pixel_count > density->capacity)
+    {
+        _density_alloc(visual, pixel_count);
+        DvzBindings* bindings = dvz_container_get(&visual->bindings, 0);
+        ASSERT(bindings != NULL);
+        dvz_bindings_update(bindings);
+    }
+
+    if (memcmp(&density->viewport, &viewport, sizeof(DvzViewport)) != 0)
+    {
+        density->viewport = viewport;
+        atomic_store(&density->dirty, true);
+    }
+}
+
+
+
+void dvz_visual_accumulate(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzVisualDensity* density = visual->density;
+    if (density == NULL)
+        return;
+
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzGpu* gpu = canvas->gpu;
+    ASSERT(gpu != NULL);
+
+    // The density image covers the panel viewport, in framebuffer pixels.
+    uint32_t width = (uint32_t)density->viewport.viewport.width;
+    uint32_t height = (uint32_t)density->viewport.viewport.height;
+    uint32_t pixel_count = width * height;
+    if (pixel_count == 0)
+        return;
+    ASSERT(pixel_count <= density->capacity);
+
+    // Number of points. The points set by the user with dvz_visual_buffer() fill the region.
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_SAMPLES, 0);
+    DvzBufferRegions br_points = {0};
+    uint32_t count = 0;
+    if (source != NULL && source->u.br.buffer != NULL)
+    {
+        br_points = source->u.br;
+        count = source->origin == DVZ_SOURCE_ORIGIN_USER
+                    ? (uint32_t)(br_points.size / sizeof(DvzGraphicsDensityPoint))
+                    : source->arr.item_count;
+    }
+    if (count != density->count)
+    {
+        density->count = count;
+        atomic_store(&density->dirty, true);
+    }
+
+    // The points region is bound from an aligned offset, the shift is passed to the shader.
+    VkDeviceSize shift = 0;
+    if (count > 0)
+    {
+        ASSERT(br_points.count == 1);
+        VkDeviceSize alignment = gpu->device_properties.limits.minStorageBufferOffsetAlignment;
+        shift = alignment > 0 ? br_points.offsets[0] % alignment : 0;
+        ASSERT(shift % 4 == 0);
+        br_points.offsets[0] -= shift;
+        br_points.size += shift;
+    }
+
+    // The MVP is written at every frame in the region of the current swapchain image. Only the
+    // matrices matter, not the time.
+    uint32_t img_idx = canvas->swapchain.img_idx;
+    DvzBufferRegions br_mvp = dvz_source_get(visual, DVZ_SOURCE_TYPE_MVP, 0)->u.br;
+    if (br_mvp.buffer == NULL)
+        return;
+    if (br_mvp.buffer->mmap != NULL)
+    {
+        const DvzMVP* mvp = (const DvzMVP*)(
+            (const uint8_t*)br_mvp.buffer->mmap + br_mvp.offsets[MIN(img_idx, br_mvp.count - 1)]);
+        if (memcmp(mvp, &density->mvp, offsetof(DvzMVP, time)) != 0)
+        {
+            memcpy(&density->mvp, mvp, sizeof(DvzMVP));
+            atomic_store(&density->dirty, true);
+        }
+    }
+    else
+    {
+        // The MVP cannot be compared, the points are accumulated again at every frame.
+        atomic_store(&density->dirty, true);
+    }
+
+    if (!atomic_load(&density->dirty))
+        return;
+    log_trace("accumulate %d points into %dx%d pixels", count, width, height);
+
+    // Update the bindings if the buffer regions have changed, once the passes using them have
+    // completed.
+    DvzBindings* bindings = &density->bindings;
+    bool changed = false;
+    changed |= _compute_bind(bindings, 0, br_mvp);
+    changed |=
+        _compute_bind(bindings, 1, dvz_source_get(visual, DVZ_SOURCE_TYPE_VIEWPORT, 0)->u.br);
+    if (count > 0)
+        changed |= _compute_bind(bindings, 2, br_points);
+    changed |= _compute_bind(bindings, 3, density->br_density);
+    if (changed || bindings->obj.status == DVZ_OBJECT_STATUS_NEED_UPDATE)
+    {
+        for (uint32_t i = 0; i < density->fence.count; i++)
+            dvz_fences_wait(&density->fence, i);
+        dvz_bindings_update(bindings);
+    }
+
+    // Wait for the previous pass of this swapchain image before recording its command buffer
+    // again.
+    uint32_t idx = MIN(img_idx, density->cmds.count - 1);
+    dvz_fences_wait(&density->fence, idx);
+    DvzCommands* cmds = &density->cmds;
+    dvz_cmd_reset(cmds, idx);
+    dvz_cmd_begin(cmds, idx);
+
+    // Reset the header and the density image, once the previous frames have read them, and set
+    // the normalization and the image size.
+    DvzBufferRegions br = density->br_density;
+    DvzBarrier barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_buffer(&barrier, br);
+    dvz_barrier_buffer_access(&barrier, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    dvz_cmd_barrier(cmds, idx, &barrier);
+
+    dvz_cmd_fill_buffer(
+        cmds, idx, br, 0, (DVZ_DENSITY_HEADER_SIZE + pixel_count) * sizeof(uint32_t), 0);
+    dvz_cmd_fill_buffer(cmds, idx, br, 4, 4, (uint32_t)density->norm);
+    dvz_cmd_fill_buffer(cmds, idx, br, 8, 4, width);
+    dvz_cmd_fill_buffer(cmds, idx, br, 12, 4, height);
+
+    barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    dvz_barrier_buffer(&barrier, br);
+    dvz_barrier_buffer_access(
+        &barrier, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    dvz_cmd_barrier(cmds, idx, &barrier);
+
+    if (count > 0)
+    {
+        DvzDensityPush push = {0};
+        push.count = count;
+        push.first = shift / 4;
+        push.pixel_count = pixel_count;
+
+        // Accumulation pass, then the largest value with a reduction over the pixels.
+        push.pass = DVZ_DENSITY_PASS_ACCUMULATE;
+        _density_pass(density, idx, &push, count);
+        _density_barrier(density, idx);
+        push.pass = DVZ_DENSITY_PASS_MAX;
+        _density_pass(density, idx, &push, pixel_count);
+
+        // Histogram equalization: histogram of the pixel values, then cumulative histogram.
+        if (density->norm == DVZ_DENSITY_NORM_EQ_HIST)
+        {
+            _density_barrier(density, idx);
+            push.pass = DVZ_DENSITY_PASS_HIST;
+            _density_pass(density, idx, &push, pixel_count);
+            _density_barrier(density, idx);
+            push.pass = DVZ_DENSITY_PASS_CDF;
+            _density_pass(density, idx, &push, 1);
+        }
+    }
+
+    // The fragment shader of the next frames reads the density image.
+    barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    dvz_barrier_buffer(&barrier, br);
+    dvz_barrier_buffer_access(
+        &barrier, VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT);
+    dvz_cmd_barrier(cmds, idx, &barrier);
+
+    dvz_cmd_end(cmds, idx);
+
+    dvz_submit_reset(&density->submit);
+    dvz_submit_commands(&density->submit, cmds);
+    dvz_submit_send(&density->submit, idx, &density->fence, idx);
+    density->accumulate_count++;
+    atomic_store(&density->dirty, false);
+}
+
+
+
 /*************************************************************************************************/
 /*  Baking helpers                                                                               */
 /*************************************************************************************************/
@@ -618,11 +1591,11 @@ void* dvz_prop_item(DvzProp* prop, uint32_t prop_idx)
 /*  Data update                                                                                  */
 /*************************************************************************************************/
 
-void dvz_visual_update(
+void dvz_visual_bake(
     DvzVisual* visual, DvzViewport viewport, DvzDataCoords coords, const void* user_data)
 {
     ASSERT(visual != NULL);
-    log_debug("visual update");
+    log_debug("visual bake");
 
     DvzVisualDataEvent ev = {0};
     ev.viewport = viewport;
@@ -640,8 +1613,30 @@ void dvz_visual_update(
         // 4. Take the props and fill the array sources.
         visual->callback_bake(visual, ev);
     }
-    // NOTE: we bake the UNIFORM sources here.
-    _bake_uniforms(visual);
+    // NOTE: we bake the UNIFORM sources here, except in the worker thread. They are then baked by
+    // the main thread when the background bake starts, so that they are never written while the
+    // main thread reads them.
+    if (atomic_load(&visual->bake.state) != DVZ_VISUAL_BAKE_PENDING)
+        _bake_uniforms(visual);
+
+    // The props are now in sync with the source arrays.
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    DvzProp* prop = NULL;
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        prop->changed_first = 0;
+        prop->changed_count = 0;
+        dvz_container_iter(&iter);
+    }
+}
+
+
+
+void dvz_visual_upload(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    log_debug("visual upload");
 
     // Here, we assume that all sources are correctly allocated, which includes VERTEX and INDEX
     // arrays, and that they have their data ready for upload.
@@ -720,6 +1715,16 @@ void dvz_visual_update(
             continue;
         }
 
+        // Streamed sources are uploaded in chunks by dvz_visual_stream().
+        if (source->stream != NULL)
+        {
+            log_trace(
+                "skip data upload for streamed source type %d #%d", //
+                source->source_type, source->source_idx);
+            dvz_container_iter(&iter);
+            continue;
+        }
+
         // Upload only for sources manages by datoviz.
         to_upload =
             source->origin == DVZ_SOURCE_ORIGIN_LIB || source->origin == DVZ_SOURCE_ORIGIN_NOBAKE;
@@ -766,14 +1771,27 @@ void dvz_visual_update(
             ASSERT(arr->item_count > 0);
             ASSERT(arr->item_size > 0);
 
-            // Make sure the GPU buffer exists and is allocated with the right size.
+            // Make sure the GPU buffer exists and is allocated with the right size. A new buffer
+            // is always uploaded entirely.
+            VkDeviceSize size = arr->item_count * arr->item_size;
+            bool is_new = br->buffer == NULL || br->size < size;
             _source_buffer(visual, source);
 
             ASSERT(br->size > 0);
-            VkDeviceSize size = arr->item_count * arr->item_size;
             ASSERT(br->size >= size);
             ASSERT(arr->buffer_size >= size);
 
+            // Only upload the range changed by the baking callback, if any.
+            VkDeviceSize offset = 0;
+            if (!is_new && source->upload_count > 0)
+            {
+                ASSERT(source->upload_first + source->upload_count <= arr->item_count);
+                offset = source->upload_first * arr->item_size;
+                size = source->upload_count * arr->item_size;
+            }
+            source->upload_first = 0;
+            source->upload_count = 0;
+
             ASSERT(br->buffer != VK_NULL_HANDLE);
 
             log_trace(
@@ -781,8 +1799,19 @@ void dvz_visual_update(
                 "%d #%d", //
                 arr->item_count, br->size, source->source_type, source->source_idx);
 
-            dvz_upload_buffers(canvas, *br, 0, size, arr->data);
+            // Mappable uniforms are written directly in the mapped buffer. The sources are not
+            // uploaded at every frame, so all swapchain images must get the new data.
+            if (br->buffer->type == DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE)
+                dvz_upload_uniforms(canvas, *br, offset, size, (char*)arr->data + offset);
+            else
+                dvz_upload_buffers(canvas, *br, offset, size, (char*)arr->data + offset);
             _source_set(source);
+
+            // New samples must be binned or accumulated again.
+            if (source->source_type == DVZ_SOURCE_TYPE_SAMPLES && visual->binning != NULL)
+                atomic_store(&visual->binning->dirty, true);
+            if (source->source_type == DVZ_SOURCE_TYPE_SAMPLES && visual->density != NULL)
+                atomic_store(&visual->density->dirty, true);
             // source->obj.status = DVZ_OBJECT_STATUS_CREATED;
             // visual->obj.status = DVZ_OBJECT_STATUS_CREATED;
         }
@@ -833,3 +1862,28 @@ void dvz_visual_update(
             dvz_bindings_update(bindings);
     }
 }
+
+
+
+void dvz_visual_update(
+    DvzVisual* visual, DvzViewport viewport, DvzDataCoords coords, const void* user_data)
+{
+    ASSERT(visual != NULL);
+    log_debug("visual update");
+    dvz_visual_bake(visual, viewport, coords, user_data);
+    dvz_visual_upload(visual);
+}
+
+
+
+void dvz_visual_bake_wait(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (atomic_load(&visual->bake.state) != DVZ_VISUAL_BAKE_PENDING)
+        return;
+    // The worker thread signals the condition at the end of the bake.
+    pthread_mutex_lock(&visual->bake.lock);
+    while (atomic_load(&visual->bake.state) == DVZ_VISUAL_BAKE_PENDING)
+        pthread_cond_wait(&visual->bake.cond, &visual->bake.lock);
+    pthread_mutex_unlock(&visual->bake.lock);
+}
@@ -54,11 +54,18 @@ static DvzSourceKind _get_source_kind(DvzSourceType type)
         break;
 
     case DVZ_SOURCE_TYPE_VERTEX:
+    case DVZ_SOURCE_TYPE_INSTANCE:
+    // NOTE: the samples are only read by the binning compute shader, which binds the buffer
+    // itself like the culling compute shader does with the vertex buffer.
+    case DVZ_SOURCE_TYPE_SAMPLES:
         return DVZ_SOURCE_KIND_VERTEX;
 
     case DVZ_SOURCE_TYPE_INDEX:
         return DVZ_SOURCE_KIND_INDEX;
 
+    case DVZ_SOURCE_TYPE_COUNTS:
+        return DVZ_SOURCE_KIND_STORAGE;
+
     case DVZ_SOURCE_TYPE_TRANSFER:
         return DVZ_SOURCE_KIND_TEXTURE_1D;
 
@@ -91,6 +98,22 @@ static void _source_set_changed(DvzSource* source, bool value)
 
 
 
+// Extend the range of the items changed since the last bake.
+static void _prop_set_changed(DvzProp* prop, uint32_t first, uint32_t count)
+{
+    ASSERT(prop != NULL);
+    uint32_t last = first + count;
+    if (prop->changed_count > 0)
+    {
+        first = MIN(first, prop->changed_first);
+        last = MAX(last, prop->changed_first + prop->changed_count);
+    }
+    prop->changed_first = first;
+    prop->changed_count = last - first;
+}
+
+
+
 static void _source_set(DvzSource* source)
 {
     ASSERT(source != NULL);
@@ -101,6 +124,16 @@ static void _source_set(DvzSource* source)
 
 
 
+// Return the source array matching the GPU data, which is the back array while the visual is
+// baked in the background.
+static DvzArray* _source_front(DvzSource* source)
+{
+    ASSERT(source != NULL);
+    return source->is_baking ? &source->arr_back : &source->arr;
+}
+
+
+
 static bool _source_has_changed(DvzSource* source)
 {
     ASSERT(source != NULL);
@@ -220,7 +253,7 @@ static DvzTexture* _default_source_texture(DvzContext* ctx, DvzSourceKind kind)
         tex = ctx->color_texture.texture;
         break;
     case 3:
-        log_warn("not implemented yet: default 3D texture");
+        tex = ctx->volume_texture;
         break;
     default:
         break;
@@ -343,7 +376,7 @@ static void _create_source_buffer(DvzCanvas* canvas, DvzSource* source, VkDevice
         return;
         break;
     }
-    uint32_t buf_count = source->source_type == mappable ? canvas->swapchain.img_count : 1;
+    uint32_t buf_count = mappable ? canvas->swapchain.img_count : 1;
     source->u.br = dvz_ctx_buffers(ctx, type, buf_count, size);
 }
 
@@ -596,6 +629,34 @@ static void _bake_uniforms(DvzVisual* visual)
 
 
 
+/*************************************************************************************************/
+/*  GPU culling                                                                                  */
+/*************************************************************************************************/
+
+// Whether the culling pass can be recorded, in which case the visual is drawn indirectly.
+static bool _culling_ready(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    if (visual->culling == NULL)
+        return false;
+
+    DvzSource* vertex_source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    DvzSource* mvp_source = dvz_source_get(visual, DVZ_SOURCE_TYPE_MVP, 0);
+    DvzSource* viewport_source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VIEWPORT, 0);
+    if (vertex_source == NULL || mvp_source == NULL || viewport_source == NULL)
+        return false;
+
+    // Indexed visuals are drawn normally.
+    DvzSource* index_source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_INDEX, 0);
+    if (index_source != NULL && _source_front(index_source)->item_count > 0)
+        return false;
+
+    return _source_front(vertex_source)->item_count > 0 && vertex_source->u.br.buffer != NULL &&
+           mvp_source->u.br.buffer != NULL && viewport_source->u.br.buffer != NULL;
+}
+
+
+
 /*************************************************************************************************/
 /*  Visual default callbacks                                                                     */
 /*************************************************************************************************/
@@ -611,6 +672,10 @@ static void _default_visual_bake(DvzVisual* visual, DvzVisualDataEvent ev)
     // INDEX source.
     source = dvz_source_get(visual, DVZ_SOURCE_TYPE_INDEX, 0);
     _bake_source(visual, source);
+
+    // INSTANCE source.
+    source = dvz_source_get(visual, DVZ_SOURCE_TYPE_INSTANCE, 0);
+    _bake_source(visual, source);
 }
 
 
@@ -642,7 +707,10 @@ static void _default_visual_fill(DvzVisual* visual, DvzVisualFillEvent ev)
         ASSERT(vertex_source != NULL);
         ASSERT(vertex_source->pipeline_idx == pipeline_idx);
 
-        uint32_t vertex_count = vertex_source->arr.item_count;
+        // NOTE: the source arrays may be baked in the background, the draw commands must match
+        // the GPU data.
+        DvzArray* vertex_arr = _source_front(vertex_source);
+        uint32_t vertex_count = vertex_arr->item_count;
         if (vertex_count == 0)
         {
             log_warn("skip this graphics pipeline as the vertex buffer is empty");
@@ -662,7 +730,7 @@ static void _default_visual_fill(DvzVisual* visual, DvzVisualFillEvent ev)
         DvzBufferRegions* index_buf = NULL;
         if (index_source != NULL)
         {
-            index_count = index_source->arr.item_count;
+            index_count = _source_front(index_source)->item_count;
             if (index_count > 0)
             {
                 index_buf = &index_source->u.br;
@@ -671,14 +739,48 @@ static void _default_visual_fill(DvzVisual* visual, DvzVisualFillEvent ev)
             }
         }
 
+        // Instance buffer?
+        DvzSource* instance_source =
+            _get_pipeline_source(visual, DVZ_SOURCE_TYPE_INSTANCE, pipeline_idx);
+        uint32_t instance_count = 0;
+        if (instance_source != NULL)
+        {
+            instance_count = _source_front(instance_source)->item_count;
+            if (instance_count == 0)
+            {
+                log_debug("skip this graphics pipeline as the instance buffer is empty");
+                continue;
+            }
+            dvz_cmd_bind_instance_buffer(cmds, idx, 1, instance_source->u.br, 0);
+        }
+
         // Draw command.
         dvz_cmd_bind_graphics(cmds, idx, visual->graphics[pipeline_idx], bindings, 0);
 
-        if (index_count == 0)
+        // Instanced draw: the whole vertex or index buffer is drawn once per instance.
+        if (instance_count > 0)
+        {
+            log_debug(
+                "draw %d %s for %d instances", index_count > 0 ? index_count : vertex_count,
+                index_count > 0 ? "indices" : "vertices", instance_count);
+            if (index_count == 0)
+                dvz_cmd_draw_instanced(cmds, idx, 0, vertex_count, 0, instance_count);
+            else
+                dvz_cmd_draw_indexed_instanced(cmds, idx, 0, 0, index_count, 0, instance_count);
+        }
+        // GPU culling: draw the compacted indices written by the culling pass.
+        else if (pipeline_idx == 0 && _culling_ready(visual) &&
+            visual->culling->capacity >= vertex_count)
+        {
+            log_debug("indirect draw of the visible vertices among %d", vertex_count);
+            dvz_cmd_bind_index_buffer(cmds, idx, visual->culling->br_index, 0);
+            dvz_cmd_draw_indexed_indirect(cmds, idx, visual->culling->br_indirect);
+        }
+        else if (index_count == 0)
         {
             log_debug("draw %d vertices", vertex_count);
             // Make sure the bound vertex buffer is large enough.
-            ASSERT(vertex_buf->size >= vertex_count * vertex_source->arr.item_size);
+            ASSERT(vertex_buf->size >= vertex_count * vertex_arr->item_size);
             dvz_cmd_draw(cmds, idx, 0, vertex_count);
         }
         else
@@ -21,6 +21,10 @@ DvzApp* dvz_app(DvzBackend backend)
     // Initialize the global clock.
     _clock_init(&app->clock);
 
+    // Used to wake up the idle main loop.
+    pthread_mutex_init(&app->idle_lock, NULL);
+    pthread_cond_init(&app->idle_cond, NULL);
+
     app->gpus = dvz_container(DVZ_CONTAINER_DEFAULT_COUNT, sizeof(DvzGpu), DVZ_OBJECT_TYPE_GPU);
     app->windows =
         dvz_container(DVZ_CONTAINER_DEFAULT_COUNT, sizeof(DvzWindow), DVZ_OBJECT_TYPE_WINDOW);
@@ -103,6 +107,9 @@ int dvz_app_destroy(DvzApp* app)
         app->instance = 0;
     }
 
+    pthread_cond_destroy(&app->idle_cond);
+    pthread_mutex_destroy(&app->idle_lock);
+
     // Free the App memory.
     int res = (int)app->n_errors;
     FREE(app);
@@ -161,6 +168,8 @@ void dvz_gpu_create(DvzGpu* gpu, VkSurfaceKHR surface)
     log_trace(
         "starting creation of GPU #%d WITH%s surface...", gpu->idx,
         surface != VK_NULL_HANDLE ? "" : "OUT");
+    if (pthread_mutex_init(&gpu->queue_lock, NULL) != 0)
+        log_error("mutex creation failed");
     create_device(gpu, surface);
 
     DvzQueues* q = &gpu->queues;
@@ -191,7 +200,9 @@ void dvz_queue_wait(DvzGpu* gpu, uint32_t queue_idx)
     ASSERT(gpu != NULL);
     ASSERT(queue_idx < gpu->queues.queue_count);
     // log_trace("waiting for queue #%d", queue_idx);
+    pthread_mutex_lock(&gpu->queue_lock);
     vkQueueWaitIdle(gpu->queues.queues[queue_idx]);
+    pthread_mutex_unlock(&gpu->queue_lock);
 }
 
 
@@ -201,7 +212,11 @@ void dvz_gpu_wait(DvzGpu* gpu)
     ASSERT(gpu != NULL);
     log_trace("waiting for device");
     if (gpu->device != VK_NULL_HANDLE)
+    {
+        pthread_mutex_lock(&gpu->queue_lock);
         vkDeviceWaitIdle(gpu->device);
+        pthread_mutex_unlock(&gpu->queue_lock);
+    }
 }
 
 
@@ -269,6 +284,7 @@ void dvz_gpu_destroy(DvzGpu* gpu)
         vkDestroyDevice(gpu->device, NULL);
         gpu->device = VK_NULL_HANDLE;
     }
+    pthread_mutex_destroy(&gpu->queue_lock);
 
 
     dvz_obj_destroyed(&gpu->obj);
@@ -548,7 +564,9 @@ void dvz_swapchain_present(
     info.pSwapchains = &swapchain->swapchain;
     info.pImageIndices = &swapchain->img_idx;
 
+    pthread_mutex_lock(&swapchain->gpu->queue_lock);
     VkResult res = vkQueuePresentKHR(swapchain->gpu->queues.queues[queue_idx], &info);
+    pthread_mutex_unlock(&swapchain->gpu->queue_lock);
 
     switch (res)
     {
@@ -687,6 +705,7 @@ void dvz_cmd_submit_sync(DvzCommands* cmds, uint32_t idx)
     DvzQueues* q = &cmds->gpu->queues;
     VkQueue queue = q->queues[cmds->queue_idx];
 
+    pthread_mutex_lock(&cmds->gpu->queue_lock);
     vkQueueWaitIdle(queue);
     VkSubmitInfo info = {0};
     info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -694,6 +713,7 @@ void dvz_cmd_submit_sync(DvzCommands* cmds, uint32_t idx)
     info.pCommandBuffers = cmds->cmds;
     vkQueueSubmit(queue, 1, &info, VK_NULL_HANDLE);
     vkQueueWaitIdle(queue);
+    pthread_mutex_unlock(&cmds->gpu->queue_lock);
 }
 
 
@@ -889,9 +909,8 @@ void dvz_buffer_resize(DvzBuffer* buffer, VkDeviceSize size, DvzCommands* cmds)
         dvz_cmd_copy_buffer(cmds, 0, buffer, 0, &new_buffer, 0, buffer->size);
         dvz_cmd_end(cmds, 0);
 
-        VkQueue queue = gpu->queues.queues[queue_idx];
         dvz_cmd_submit_sync(cmds, 0);
-        vkQueueWaitIdle(queue);
+        dvz_queue_wait(gpu, queue_idx);
     }
 
     // Delete the old buffer after the transfer has finished.
@@ -1147,6 +1166,7 @@ DvzImages dvz_images(DvzGpu* gpu, VkImageType type, uint32_t count)
     images.count = count;
 
     // Default options.
+    images.samples = VK_SAMPLE_COUNT_1_BIT;
     images.tiling = VK_IMAGE_TILING_OPTIMAL;
     images.memory = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
     images.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -1186,6 +1206,15 @@ void dvz_images_size(DvzImages* images, uint32_t width, uint32_t height, uint32_
 
 
 
+void dvz_images_samples(DvzImages* images, VkSampleCountFlagBits samples)
+{
+    ASSERT(images != NULL);
+    ASSERT(samples > 0);
+    images->samples = samples;
+}
+
+
+
 void dvz_images_tiling(DvzImages* images, VkImageTiling tiling)
 {
     ASSERT(images != NULL);
@@ -1235,9 +1264,9 @@ static void _images_create(DvzImages* images)
         if (!images->is_swapchain)
             create_image2(
                 gpu->device, &gpu->queues, images->queue_count, images->queues, images->image_type,
-                images->width, images->height, images->depth, images->format, images->tiling,
-                images->usage, images->memory, gpu->memory_properties, &images->images[i],
-                &images->memories[i]);
+                images->width, images->height, images->depth, images->format, images->samples,
+                images->tiling, images->usage, images->memory, gpu->memory_properties,
+                &images->images[i], &images->memories[i]);
 
         // HACK: staging images do not require an image view
         if (images->tiling != VK_IMAGE_TILING_LINEAR)
@@ -1732,6 +1761,19 @@ void dvz_compute_code(DvzCompute* compute, const char* code)
 
 
 
+void dvz_compute_spirv(DvzCompute* compute, VkDeviceSize size, const uint32_t* buffer)
+{
+    ASSERT(compute != NULL);
+    ASSERT(compute->gpu != NULL);
+    ASSERT(compute->gpu->device != VK_NULL_HANDLE);
+    ASSERT(size > 0);
+    ASSERT(buffer != NULL);
+
+    compute->shader_module = create_shader_module(compute->gpu->device, size, buffer);
+}
+
+
+
 void dvz_compute_slot(DvzCompute* compute, uint32_t idx, VkDescriptorType type)
 {
     ASSERT(compute != NULL);
@@ -1775,7 +1817,12 @@ void dvz_compute_create(DvzCompute* compute)
 
     log_trace("starting creation of compute...");
 
-    if (compute->shader_code != NULL)
+    // The shader module may have already been created from SPIRV code.
+    if (compute->shader_module != VK_NULL_HANDLE)
+    {
+        log_trace("compute shader module already created");
+    }
+    else if (compute->shader_code != NULL)
     {
         compute->shader_module =
             dvz_shader_compile(compute->gpu, compute->shader_code, VK_SHADER_STAGE_COMPUTE_BIT);
@@ -1915,6 +1962,18 @@ void dvz_graphics_vertex_binding(DvzGraphics* graphics, uint32_t binding, VkDevi
     DvzVertexBinding* vb = &graphics->vertex_bindings[graphics->vertex_binding_count++];
     vb->binding = binding;
     vb->stride = stride;
+    vb->input_rate = VK_VERTEX_INPUT_RATE_VERTEX;
+}
+
+
+
+void dvz_graphics_instance_binding(DvzGraphics* graphics, uint32_t binding, VkDeviceSize stride)
+{
+    ASSERT(graphics != NULL);
+    DvzVertexBinding* vb = &graphics->vertex_bindings[graphics->vertex_binding_count++];
+    vb->binding = binding;
+    vb->stride = stride;
+    vb->input_rate = VK_VERTEX_INPUT_RATE_INSTANCE;
 }
 
 
@@ -1975,6 +2034,14 @@ void dvz_graphics_front_face(DvzGraphics* graphics, VkFrontFace front_face)
 
 
 
+void dvz_graphics_pick(DvzGraphics* graphics, bool pick)
+{
+    ASSERT(graphics != NULL);
+    graphics->pick = pick;
+}
+
+
+
 void dvz_graphics_slot(DvzGraphics* graphics, uint32_t idx, VkDescriptorType type)
 {
     ASSERT(graphics != NULL);
@@ -1992,6 +2059,43 @@ void dvz_graphics_push(
 
 
 
+// Sample count of the attachments used by a subpass.
+static VkSampleCountFlagBits _subpass_samples(DvzRenderpass* renderpass, uint32_t subpass)
+{
+    ASSERT(renderpass != NULL);
+    ASSERT(subpass < renderpass->subpass_count);
+    uint32_t attachment = 0;
+    for (uint32_t j = 0; j < renderpass->subpasses[subpass].attachment_count; j++)
+    {
+        attachment = renderpass->subpasses[subpass].attachments[j];
+        // The resolve attachments are always single-sampled.
+        if (renderpass->attachments[attachment].type != DVZ_RENDERPASS_ATTACHMENT_RESOLVE)
+            return renderpass->attachments[attachment].samples;
+    }
+    return VK_SAMPLE_COUNT_1_BIT;
+}
+
+
+
+// Number of color attachments used by a subpass.
+static uint32_t _subpass_color_count(DvzRenderpass* renderpass, uint32_t subpass)
+{
+    ASSERT(renderpass != NULL);
+    ASSERT(subpass < renderpass->subpass_count);
+    uint32_t attachment = 0;
+    uint32_t count = 0;
+    for (uint32_t j = 0; j < renderpass->subpasses[subpass].attachment_count; j++)
+    {
+        attachment = renderpass->subpasses[subpass].attachments[j];
+        if (renderpass->attachments[attachment].type == DVZ_RENDERPASS_ATTACHMENT_COLOR)
+            count++;
+    }
+    // NOTE: at least one blend attachment state, as before.
+    return MAX(count, 1);
+}
+
+
+
 void dvz_graphics_create(DvzGraphics* graphics)
 {
     ASSERT(graphics != NULL);
@@ -2012,7 +2116,7 @@ void dvz_graphics_create(DvzGraphics* graphics)
     {
         bindings_info[i].binding = graphics->vertex_bindings[i].binding;
         bindings_info[i].stride = graphics->vertex_bindings[i].stride;
-        bindings_info[i].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        bindings_info[i].inputRate = graphics->vertex_bindings[i].input_rate;
     }
     vertex_input_info.vertexBindingDescriptionCount = graphics->vertex_binding_count;
     vertex_input_info.pVertexBindingDescriptions = bindings_info;
@@ -2046,12 +2150,24 @@ void dvz_graphics_create(DvzGraphics* graphics)
         create_input_assembly(graphics->topology);
     VkPipelineRasterizationStateCreateInfo rasterizer =
         create_rasterizer(graphics->cull_mode, graphics->front_face);
-    VkPipelineMultisampleStateCreateInfo multisampling = create_multisampling();
-
-    // Blend attachments.
-    VkPipelineColorBlendAttachmentState color_attachment = create_color_blend_attachment();
+    VkPipelineMultisampleStateCreateInfo multisampling =
+        create_multisampling(_subpass_samples(graphics->renderpass, graphics->subpass));
+
+    // Blend attachments, one per color attachment of the subpass. The first one is the color
+    // output, the next ones are integer attachments (object picking) that cannot be blended. Only
+    // the graphics whose fragment shader writes the picking ids (or 0 for opaque graphics that
+    // are not pickable) may write them.
+    VkPipelineColorBlendAttachmentState blends[DVZ_MAX_ATTACHMENTS_PER_RENDERPASS] = {0};
+    uint32_t color_count = _subpass_color_count(graphics->renderpass, graphics->subpass);
+    blends[0] = create_color_blend_attachment();
+    for (uint32_t i = 1; i < color_count; i++)
+    {
+        blends[i].blendEnable = VK_FALSE;
+        blends[i].colorWriteMask =
+            graphics->pick ? (VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT) : 0;
+    }
     VkPipelineColorBlendStateCreateInfo color_blending =
-        create_color_blending(1, (VkPipelineColorBlendAttachmentState[]){color_attachment});
+        create_color_blending(color_count, blends);
 
     VkPipelineDepthStencilStateCreateInfo depth_stencil =
         create_depth_stencil((bool)graphics->depth_test);
@@ -2417,6 +2533,70 @@ void dvz_fences_destroy(DvzFences* fences)
 
 
 
+/*************************************************************************************************/
+/*  Queries                                                                                      */
+/*************************************************************************************************/
+
+DvzQueries dvz_queries(DvzGpu* gpu, VkQueryType type, uint32_t count)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(dvz_obj_is_created(&gpu->obj));
+    ASSERT(count > 0);
+    log_trace("create pool of %d queries", count);
+
+    DvzQueries queries = {0};
+    queries.gpu = gpu;
+    queries.type = type;
+    queries.count = count;
+
+    VkQueryPoolCreateInfo info = {0};
+    info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    info.queryType = type;
+    info.queryCount = count;
+    VK_CHECK_RESULT(vkCreateQueryPool(gpu->device, &info, NULL, &queries.pool));
+
+    dvz_obj_created(&queries.obj);
+    return queries;
+}
+
+
+
+bool dvz_queries_results(DvzQueries* queries, uint32_t first, uint32_t count, uint64_t* results)
+{
+    ASSERT(queries != NULL);
+    ASSERT(dvz_obj_is_created(&queries->obj));
+    ASSERT(first + count <= queries->count);
+    ASSERT(results != NULL);
+    if (count == 0)
+        return true;
+
+    VkResult res = vkGetQueryPoolResults(
+        queries->gpu->device, queries->pool, first, count, count * sizeof(uint64_t), results,
+        sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    return res == VK_SUCCESS;
+}
+
+
+
+void dvz_queries_destroy(DvzQueries* queries)
+{
+    ASSERT(queries != NULL);
+    if (!dvz_obj_is_created(&queries->obj))
+    {
+        log_trace("skip destruction of already-destroyed queries");
+        return;
+    }
+    log_trace("destroy pool of %d queries", queries->count);
+    if (queries->pool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(queries->gpu->device, queries->pool, NULL);
+        queries->pool = VK_NULL_HANDLE;
+    }
+    dvz_obj_destroyed(&queries->obj);
+}
+
+
+
 /*************************************************************************************************/
 /*  Renderpass                                                                                   */
 /*************************************************************************************************/
@@ -2450,6 +2630,7 @@ void dvz_renderpass_attachment(
     renderpass->attachments[idx].ref_layout = ref_layout;
     renderpass->attachments[idx].type = type;
     renderpass->attachments[idx].format = format;
+    renderpass->attachments[idx].samples = VK_SAMPLE_COUNT_1_BIT;
     renderpass->attachment_count = MAX(renderpass->attachment_count, idx + 1);
 }
 
@@ -2478,6 +2659,17 @@ void dvz_renderpass_attachment_ops(
 
 
 
+void dvz_renderpass_attachment_samples(
+    DvzRenderpass* renderpass, uint32_t idx, VkSampleCountFlagBits samples)
+{
+    ASSERT(renderpass != NULL);
+    ASSERT(samples > 0);
+    renderpass->attachments[idx].samples = samples;
+    renderpass->attachment_count = MAX(renderpass->attachment_count, idx + 1);
+}
+
+
+
 void dvz_renderpass_subpass_attachment(
     DvzRenderpass* renderpass, uint32_t subpass_idx, uint32_t attachment_idx)
 {
@@ -2537,7 +2729,7 @@ void dvz_renderpass_create(DvzRenderpass* renderpass)
     for (uint32_t i = 0; i < renderpass->attachment_count; i++)
     {
         attachments[i] = create_attachment(
-            renderpass->attachments[i].format,                                           //
+            renderpass->attachments[i].format, renderpass->attachments[i].samples,       //
             renderpass->attachments[i].load_op, renderpass->attachments[i].store_op,     //
             renderpass->attachments[i].src_layout, renderpass->attachments[i].dst_layout //
         );
@@ -2548,29 +2740,40 @@ void dvz_renderpass_create(DvzRenderpass* renderpass)
     VkSubpassDescription subpasses[DVZ_MAX_SUBPASSES_PER_RENDERPASS] = {0};
     VkAttachmentReference attachment_refs_matrix[DVZ_MAX_ATTACHMENTS_PER_RENDERPASS]
                                                 [DVZ_MAX_ATTACHMENTS_PER_RENDERPASS] = {0};
+    VkAttachmentReference resolve_refs_matrix[DVZ_MAX_ATTACHMENTS_PER_RENDERPASS]
+                                             [DVZ_MAX_ATTACHMENTS_PER_RENDERPASS] = {0};
     uint32_t attachment = 0;
-    uint32_t k = 0;
+    uint32_t k = 0, r = 0;
     for (uint32_t i = 0; i < renderpass->subpass_count; i++) // i is the subpass index
     {
         k = 0;
+        r = 0;
         subpasses[i].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        // j is the attachment index
+        // j is the attachment index within the subpass
         for (uint32_t j = 0; j < renderpass->subpasses[i].attachment_count; j++)
         {
             attachment = renderpass->subpasses[i].attachments[j];
             ASSERT(attachment < renderpass->attachment_count);
-            if (renderpass->attachments[attachment].type == DVZ_RENDERPASS_ATTACHMENT_DEPTH)
-            {
-                subpasses[i].pDepthStencilAttachment = &attachment_refs[j];
-            }
-            else
+            switch (renderpass->attachments[attachment].type)
             {
-                attachment_refs_matrix[i][k++] =
-                    create_attachment_ref(j, renderpass->attachments[i].ref_layout);
+            case DVZ_RENDERPASS_ATTACHMENT_DEPTH:
+                subpasses[i].pDepthStencilAttachment = &attachment_refs[attachment];
+                break;
+            case DVZ_RENDERPASS_ATTACHMENT_RESOLVE:
+                resolve_refs_matrix[i][r++] = create_attachment_ref(
+                    attachment, renderpass->attachments[attachment].ref_layout);
+                break;
+            default:
+                attachment_refs_matrix[i][k++] = create_attachment_ref(
+                    attachment, renderpass->attachments[attachment].ref_layout);
+                break;
             }
         }
         subpasses[i].colorAttachmentCount = k;
         subpasses[i].pColorAttachments = attachment_refs_matrix[i];
+        // There must be either no resolve attachment, or one per color attachment.
+        ASSERT(r == 0 || r == k);
+        subpasses[i].pResolveAttachments = r > 0 ? resolve_refs_matrix[i] : NULL;
     }
 
     // Dependencies.
@@ -2891,7 +3094,9 @@ void dvz_submit_send(DvzSubmit* submit, uint32_t cmd_idx, DvzFences* fence, uint
         dvz_fences_reset(fence, fence_idx);
     }
     // log_trace("submit queue and signal fence %d", vfence);
+    pthread_mutex_lock(&submit->gpu->queue_lock);
     VK_CHECK_RESULT(vkQueueSubmit(submit->gpu->queues.queues[queue_idx], 1, &submit_info, vfence));
+    pthread_mutex_unlock(&submit->gpu->queue_lock);
 
     // log_trace("submit done");
 }
@@ -2955,12 +3160,13 @@ void dvz_cmd_compute(DvzCommands* cmds, uint32_t idx, DvzCompute* compute, uvec3
     ASSERT(compute->pipeline != VK_NULL_HANDLE);
     ASSERT(compute->slots.pipeline_layout != VK_NULL_HANDLE);
 
-    CMD_START
+    // NOTE: use the descriptor set of the current swapchain image if there is one per image.
+    CMD_START_CLIP(compute->bindings->dset_count)
 
     vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, compute->pipeline);
     vkCmdBindDescriptorSets(
         cb, VK_PIPELINE_BIND_POINT_COMPUTE, compute->slots.pipeline_layout, 0, 1,
-        compute->bindings->dsets, 0, 0);
+        &compute->bindings->dsets[iclip], 0, 0);
     vkCmdDispatch(cb, size[0], size[1], size[2]);
     CMD_END
 }
@@ -2983,7 +3189,7 @@ void dvz_cmd_barrier(DvzCommands* cmds, uint32_t idx, DvzBarrier* barrier)
         buffer_barrier = &buffer_barriers[j];
         buffer_info = &barrier->buffer_barriers[j];
 
-        buffer_barrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        buffer_barrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
         buffer_barrier->buffer = buffer_info->br.buffer->buffer;
         buffer_barrier->size = buffer_info->br.size;
         ASSERT(i < buffer_info->br.count);
@@ -3114,6 +3320,47 @@ void dvz_cmd_copy_image_to_buffer(
 
 
 
+void dvz_cmd_copy_image_region_to_buffer(
+    DvzCommands* cmds, uint32_t idx, DvzImages* images, ivec3 offset, uvec3 shape,
+    DvzBuffer* buffer, VkDeviceSize buf_offset)
+{
+    ASSERT(images != NULL);
+    ASSERT(buffer != NULL);
+    ASSERT(shape[0] > 0 && shape[1] > 0 && shape[2] > 0);
+    ASSERT(offset[0] >= 0 && offset[1] >= 0 && offset[2] >= 0);
+    ASSERT((uint32_t)offset[0] + shape[0] <= images->width);
+    ASSERT((uint32_t)offset[1] + shape[1] <= images->height);
+    ASSERT((uint32_t)offset[2] + shape[2] <= images->depth);
+
+    CMD_START_CLIP(images->count)
+
+    VkBufferImageCopy region = {0};
+    region.bufferOffset = buf_offset;
+    region.bufferRowLength = 0; // tightly packed
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+
+    region.imageOffset.x = offset[0];
+    region.imageOffset.y = offset[1];
+    region.imageOffset.z = offset[2];
+
+    region.imageExtent.width = shape[0];
+    region.imageExtent.height = shape[1];
+    region.imageExtent.depth = shape[2];
+
+    vkCmdCopyImageToBuffer(
+        cb, images->images[iclip], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, //
+        buffer->buffer, 1, &region);
+
+    CMD_END
+}
+
+
+
 void dvz_cmd_copy_image(DvzCommands* cmds, uint32_t idx, DvzImages* src_img, DvzImages* dst_img)
 {
     ASSERT(src_img != NULL);
@@ -3207,6 +3454,17 @@ void dvz_cmd_bind_vertex_buffer(
 
 
 
+void dvz_cmd_bind_instance_buffer(
+    DvzCommands* cmds, uint32_t idx, uint32_t binding, DvzBufferRegions br, VkDeviceSize offset)
+{
+    CMD_START_CLIP(br.count)
+    VkDeviceSize offsets[] = {br.offsets[iclip] + offset};
+    vkCmdBindVertexBuffers(cb, binding, 1, &br.buffer->buffer, offsets);
+    CMD_END
+}
+
+
+
 void dvz_cmd_bind_index_buffer(
     DvzCommands* cmds, uint32_t idx, DvzBufferRegions br, VkDeviceSize offset)
 {
@@ -3239,6 +3497,33 @@ void dvz_cmd_draw_indexed(
 
 
 
+void dvz_cmd_draw_instanced(
+    DvzCommands* cmds, uint32_t idx, uint32_t first_vertex, uint32_t vertex_count,
+    uint32_t first_instance, uint32_t instance_count)
+{
+    ASSERT(vertex_count > 0);
+    ASSERT(instance_count > 0);
+    CMD_START
+    vkCmdDraw(cb, vertex_count, instance_count, first_vertex, first_instance);
+    CMD_END
+}
+
+
+
+void dvz_cmd_draw_indexed_instanced(
+    DvzCommands* cmds, uint32_t idx, uint32_t first_index, uint32_t vertex_offset,
+    uint32_t index_count, uint32_t first_instance, uint32_t instance_count)
+{
+    ASSERT(index_count > 0);
+    ASSERT(instance_count > 0);
+    CMD_START
+    vkCmdDrawIndexed(
+        cb, index_count, instance_count, first_index, (int32_t)vertex_offset, first_instance);
+    CMD_END
+}
+
+
+
 void dvz_cmd_draw_indirect(DvzCommands* cmds, uint32_t idx, DvzBufferRegions indirect)
 {
     CMD_START_CLIP(indirect.count)
@@ -3257,6 +3542,23 @@ void dvz_cmd_draw_indexed_indirect(DvzCommands* cmds, uint32_t idx, DvzBufferReg
 
 
 
+void dvz_cmd_fill_buffer(
+    DvzCommands* cmds, uint32_t idx, DvzBufferRegions br, //
+    VkDeviceSize offset, VkDeviceSize size, uint32_t value)
+{
+    ASSERT(br.buffer != NULL);
+    ASSERT(size > 0);
+    ASSERT(offset % 4 == 0);
+    ASSERT(size % 4 == 0);
+    ASSERT(offset + size <= br.size);
+
+    CMD_START_CLIP(br.count)
+    vkCmdFillBuffer(cb, br.buffer->buffer, br.offsets[iclip] + offset, size, value);
+    CMD_END
+}
+
+
+
 void dvz_cmd_copy_buffer(
     DvzCommands* cmds, uint32_t idx,             //
     DvzBuffer* src_buf, VkDeviceSize src_offset, //
@@ -3289,3 +3591,29 @@ void dvz_cmd_push(
     vkCmdPushConstants(cb, slots->pipeline_layout, shaders, offset, size, data);
     CMD_END
 }
+
+
+
+void dvz_cmd_reset_queries(
+    DvzCommands* cmds, uint32_t idx, DvzQueries* queries, uint32_t first, uint32_t count)
+{
+    ASSERT(queries != NULL);
+    ASSERT(first + count <= queries->count);
+    CMD_START
+    vkCmdResetQueryPool(cb, queries->pool, first, count);
+    CMD_END
+}
+
+
+
+void dvz_cmd_timestamp(
+    DvzCommands* cmds, uint32_t idx, VkPipelineStageFlagBits stage, DvzQueries* queries,
+    uint32_t query)
+{
+    ASSERT(queries != NULL);
+    ASSERT(queries->type == VK_QUERY_TYPE_TIMESTAMP);
+    ASSERT(query < queries->count);
+    CMD_START
+    vkCmdWriteTimestamp(cb, stage, queries->pool, query);
+    CMD_END
+}
@@ -372,6 +372,36 @@ static void backend_poll_events(DvzBackend backend, DvzWindow* window)
 
 
 
+// Block until an event is received, or until the timeout (in seconds) expires.
+static void backend_wait_events(DvzBackend backend, double timeout)
+{
+    switch (backend)
+    {
+    case DVZ_BACKEND_GLFW:
+        glfwWaitEventsTimeout(timeout);
+        break;
+    default:
+        break;
+    }
+}
+
+
+
+// Wake up backend_wait_events(), may be called from any thread.
+static void backend_post_empty_event(DvzBackend backend)
+{
+    switch (backend)
+    {
+    case DVZ_BACKEND_GLFW:
+        glfwPostEmptyEvent();
+        break;
+    default:
+        break;
+    }
+}
+
+
+
 static void
 backend_window_destroy(VkInstance instance, DvzBackend backend, void* window, VkSurfaceKHR surface)
 {
@@ -1135,8 +1165,8 @@ static void check_dims(VkImageType image_type, uint32_t width, uint32_t height,
 static void create_image2(
     VkDevice device, DvzQueues* queues, uint32_t queue_count, uint32_t* queue_indices,        //
     VkImageType image_type, uint32_t width, uint32_t height, uint32_t depth, VkFormat format, //
-    VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties,          //
-    VkPhysicalDeviceMemoryProperties memory_properties,                                       //
+    VkSampleCountFlagBits samples, VkImageTiling tiling, VkImageUsageFlags usage,             //
+    VkMemoryPropertyFlags properties, VkPhysicalDeviceMemoryProperties memory_properties,     //
     VkImage* image, VkDeviceMemory* imageMemory)                                              //
 {
     log_trace("create image %dD %dx%dx%d", image_type + 1, width, height, depth);
@@ -1154,7 +1184,7 @@ static void create_image2(
     info.tiling = tiling;
     info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     info.usage = usage;
-    info.samples = VK_SAMPLE_COUNT_1_BIT;
+    info.samples = samples;
 
     // Sharing mode, depending on the queues that need to access the image.
     uint32_t queue_families[DVZ_MAX_QUEUE_FAMILIES];
@@ -1523,16 +1553,31 @@ create_rasterizer(VkCullModeFlags cull_mode, VkFrontFace front_face)
 }
 
 
-static VkPipelineMultisampleStateCreateInfo create_multisampling()
+static VkPipelineMultisampleStateCreateInfo create_multisampling(VkSampleCountFlagBits samples)
 {
     VkPipelineMultisampleStateCreateInfo multisampling = {0};
     multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
     multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.rasterizationSamples = samples;
     return multisampling;
 }
 
 
+// Highest sample count supported by the device for both color and depth attachments, that does
+// not exceed the requested sample count.
+static VkSampleCountFlagBits
+max_sample_count(VkPhysicalDeviceProperties* properties, VkSampleCountFlagBits requested)
+{
+    ASSERT(properties != NULL);
+    VkSampleCountFlags supported = properties->limits.framebufferColorSampleCounts &
+                                   properties->limits.framebufferDepthSampleCounts;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_64_BIT;
+    while (samples > VK_SAMPLE_COUNT_1_BIT && (samples > requested || !(supported & samples)))
+        samples = (VkSampleCountFlagBits)(samples >> 1);
+    return samples;
+}
+
+
 static VkPipelineColorBlendAttachmentState create_color_blend_attachment()
 {
     VkPipelineColorBlendAttachmentState attachment = {0};
@@ -1612,12 +1657,12 @@ create_dynamic_states(uint32_t count, VkDynamicState* dynamic_states)
 /*************************************************************************************************/
 
 static VkAttachmentDescription create_attachment(
-    VkFormat format, VkAttachmentLoadOp load_op, VkAttachmentStoreOp store_op,
-    VkImageLayout src_layout, VkImageLayout dst_layout)
+    VkFormat format, VkSampleCountFlagBits samples, VkAttachmentLoadOp load_op,
+    VkAttachmentStoreOp store_op, VkImageLayout src_layout, VkImageLayout dst_layout)
 {
     VkAttachmentDescription attachment = {0};
     attachment.format = format;
-    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.samples = samples;
     attachment.loadOp = load_op;
     attachment.storeOp = store_op;
     attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;